@@ -32,6 +32,10 @@
     #define FLT_MAX 3.402823466e+38
 #endif //FLT_MAX
 
+#ifndef DBL_MAX
+    #define DBL_MAX 1.7976931348623157e+308
+#endif //DBL_MAX
+
 #ifndef NUMARGS
     #define NUMARGS(...) (sizeof((float[]){__VA_ARGS__})/sizeof(int))
 #endif
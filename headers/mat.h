@@ -0,0 +1,155 @@
+#ifndef MAT_H
+#define MAT_H
+#include <cmath.h>
+#include <stddef.h>
+#include <vec.h>
+#include <vec_view.h>
+
+/**
+ * @brief Storage order of a matrix. Row-major keeps each row contiguous,
+ *        column-major each column (the BLAS / Fortran order).
+ */
+typedef enum {
+    MAT_ROW_MAJOR = 0,
+    MAT_COL_MAJOR = 1
+} mat_layout_t;
+
+/**
+ * @brief A dense rows x cols matrix of floats.
+ *
+ * Element (i, j) lives at data[i * ld + j] (row-major) or data[i + j * ld]
+ * (column-major). `ld`, the leading dimension, may exceed cols (rows), so
+ * a matrix can describe a block of a bigger one without copying.
+ *
+ * Matrices from matrix_alloc and friends own their data like vectors do:
+ * it comes from the thread's active allocator and matrix_free returns it.
+ * matrix_view / matrix_wrap / matrix_transpose return borrowed matrices
+ * that alias someone else's data; freeing one only clears it.
+ *
+ * @members
+ *   rows, cols - dimensions
+ *   data       - element (0, 0)
+ *   ld         - distance between consecutive rows (row-major) or
+ *                columns (column-major), in elements
+ *   layout     - MAT_ROW_MAJOR or MAT_COL_MAJOR
+ *   allocator  - allocator that owns `data`
+**/
+typedef struct {
+    size_t rows;
+    size_t cols;
+    float *data;
+    size_t ld;
+    mat_layout_t layout;
+    const vec_allocator_t *allocator;
+} matrix_t;
+
+typedef struct {
+    size_t rows;
+    size_t cols;
+    double *data;
+    size_t ld;
+    mat_layout_t layout;
+    const vec_allocator_t *allocator;
+} dmatrix_t;
+
+extern const matrix_t MAT_UNDEFINED;
+extern const dmatrix_t DMAT_UNDEFINED;
+
+/**
+ * @brief GEMM / GEMV engine.
+ *
+ * matrix_gemm computes C = alpha * A * B + beta * C the way optimized BLAS
+ * libraries do: B is packed into KC x NC panels, A into MC x KC blocks,
+ * and a register-blocked microkernel updates an MR x NR tile of C from one
+ * sliver of each with FMA instructions (AVX2+FMA: 6x16 floats / 6x8
+ * doubles, AVX-512: 8x32 / 8x16). Every element of C is accumulated in k
+ * order, one fused multiply-add per step, in blocks of MAT_KC, and each
+ * block is folded into C as fma(alpha, block, beta * C). The scalar and
+ * SSE2 levels use fmaf / fma for the same steps, so all levels give the
+ * same bits, and so does any number of threads: products of at least
+ * MAT_PARALLEL_WORK multiply-adds are spread over the vec_parallel pool by
+ * blocks of C.
+ *
+ * matrix_gemv computes y = alpha * A * x + beta * y. For row-major A every
+ * y[i] is a dot product accumulated in MAT_GEMV_LANES fused lanes (four
+ * rows share each load of x); for column-major A, y is built up column by
+ * column with one fused multiply-add per element, like a chain of axpys.
+ *
+ * beta == 0 overwrites C / y without reading it (NaNs there are dropped),
+ * as in BLAS. A transposed operand is a matrix_transpose view, which costs
+ * nothing. C must not overlap A or B; y must not overlap A or x.
+ *
+ * matrix_gemm returns false on a shape mismatch, leaving C alone, and also
+ * when its packing buffers cannot be allocated. That can happen after some
+ * blocks of C have been updated, so C is then partly written.
+**/
+#ifndef MAT_KC
+    #define MAT_KC 256                  // k block: multiply-adds per element between updates of C
+#endif
+
+#ifndef MAT_MC
+    #define MAT_MC 144                  // rows of A packed per block (about 144 KiB of floats, L2)
+#endif
+
+#ifndef MAT_NC
+    #define MAT_NC 4096                 // columns of B packed per panel (L3)
+#endif
+
+#ifndef MAT_PARALLEL_WORK
+    #define MAT_PARALLEL_WORK (1u << 21) // multiply-adds below which products stay on one thread
+#endif
+
+#define MAT_GEMV_LANES 16               // float dot lanes of row-major matrix_gemv (8 for double)
+
+/**
+ * @brief Address of element (i, j) (no bounds check).
+ */
+static inline float *matrix_at(matrix_t m, size_t i, size_t j)
+{
+    return m.layout == MAT_ROW_MAJOR ? m.data + i * m.ld + j : m.data + i + j * m.ld;
+}
+
+static inline double *dmat_at(dmatrix_t m, size_t i, size_t j)
+{
+    return m.layout == MAT_ROW_MAJOR ? m.data + i * m.ld + j : m.data + i + j * m.ld;
+}
+
+matrix_t matrix_alloc(size_t rows, size_t cols, mat_layout_t layout); // Uninitialized matrix; MAT_UNDEFINED on failure
+matrix_t matrix_create(size_t rows, size_t cols, mat_layout_t layout); // Matrix of zeros
+matrix_t matrix_from_array(size_t rows, size_t cols, mat_layout_t layout, const float *data); // Copy of a packed array in `layout` order
+matrix_t matrix_identity(size_t n, mat_layout_t layout); // n x n identity
+matrix_t matrix_wrap(float *data, size_t rows, size_t cols, size_t ld, mat_layout_t layout); // Borrow an existing buffer
+void matrix_free(matrix_t *m); // Free an owned matrix (borrowed ones are only cleared)
+matrix_t matrix_copy(matrix_t m); // Packed copy in the same layout
+matrix_t matrix_view(matrix_t m, size_t row, size_t col, size_t rows, size_t cols); // Borrowed block; MAT_UNDEFINED if out of range
+matrix_t matrix_transpose(matrix_t m); // Borrowed transpose (same data, other layout)
+vec_view_t matrix_row(matrix_t m, size_t i); // Row i as a vector view
+vec_view_t matrix_col(matrix_t m, size_t j); // Column j as a vector view
+bool matrix_equals(matrix_t a, matrix_t b); // Same shape and element-wise ==
+
+bool matrix_gemm(float alpha, matrix_t a, matrix_t b, float beta, matrix_t c); // c = alpha*a*b + beta*c; false on shape mismatch or out of memory
+matrix_t matrix_mul(matrix_t a, matrix_t b); // a * b into a new matrix in a's layout; MAT_UNDEFINED on failure
+bool matrix_gemv(float alpha, matrix_t a, vector_t x, float beta, vector_t y); // y = alpha*a*x + beta*y; false on shape mismatch
+vector_t matrix_mul_vector(matrix_t a, vector_t x); // a * x into a new vector
+void print_matrix(const char *label, matrix_t m); // Print a matrix to stdout
+
+dmatrix_t dmat_alloc(size_t rows, size_t cols, mat_layout_t layout); // Uninitialized double matrix
+dmatrix_t dmat_create(size_t rows, size_t cols, mat_layout_t layout); // Double matrix of zeros
+dmatrix_t dmat_from_array(size_t rows, size_t cols, mat_layout_t layout, const double *data); // Copy of a packed array
+dmatrix_t dmat_identity(size_t n, mat_layout_t layout); // n x n identity
+dmatrix_t dmat_wrap(double *data, size_t rows, size_t cols, size_t ld, mat_layout_t layout); // Borrow an existing buffer
+void dmat_free(dmatrix_t *m); // Free an owned double matrix
+dmatrix_t dmat_copy(dmatrix_t m); // Packed copy in the same layout
+dmatrix_t dmat_view(dmatrix_t m, size_t row, size_t col, size_t rows, size_t cols); // Borrowed block
+dmatrix_t dmat_transpose(dmatrix_t m); // Borrowed transpose
+dvec_view_t dmat_row(dmatrix_t m, size_t i); // Row i as a vector view
+dvec_view_t dmat_col(dmatrix_t m, size_t j); // Column j as a vector view
+bool dmat_equals(dmatrix_t a, dmatrix_t b); // Same shape and element-wise ==
+
+bool dmat_gemm(double alpha, dmatrix_t a, dmatrix_t b, double beta, dmatrix_t c); // c = alpha*a*b + beta*c; false on shape mismatch or out of memory
+dmatrix_t dmat_mul(dmatrix_t a, dmatrix_t b); // a * b into a new double matrix; DMAT_UNDEFINED on failure
+bool dmat_gemv(double alpha, dmatrix_t a, dvector_t x, double beta, dvector_t y); // y = alpha*a*x + beta*y
+dvector_t dmat_mul_vector(dmatrix_t a, dvector_t x); // a * x into a new double vector
+void print_dmatrix(const char *label, dmatrix_t m); // Print a double matrix to stdout
+
+#endif // MAT_H
@@ -0,0 +1,87 @@
+#ifndef MATH_BATCH_H
+#define MATH_BATCH_H
+#include <cmath.h>
+#include <math_core.h>
+
+/*
+ * Array versions of the math_core.h fast approximations.
+ *
+ * Each call computes dst[i] = f(src[i]) for i < n, 8-16 lanes at a time on
+ * AVX2/AVX-512 (bit tricks done with SIMD integer ops), and returns exactly
+ * what the scalar function returns for every element, including the domain
+ * special cases (NaN results compare as NaN, not by payload). dst may be
+ * exactly src for in-place use. Levels follow vec_isa_active(); without
+ * AVX2 the scalar functions are looped.
+ */
+
+void fast_inv_sqrt_array(float *dst, const float *src, size_t n); // dst[i] = fast_inv_sqrt(src[i])
+void fast_sqrt_array(float *dst, const float *src, size_t n); // dst[i] = fast_sqrt(src[i])
+void fast_log2f_array(float *dst, const float *src, size_t n); // dst[i] = fast_log2f(src[i])
+void fast_exp2f_array(float *dst, const float *src, size_t n); // dst[i] = fast_exp2f(src[i])
+void fast_powf_array(float *dst, const float *src, float y, size_t n); // dst[i] = fast_powf(src[i], y)
+void cbrt_f_array(float *dst, const float *src, size_t n); // dst[i] = cbrt_f(src[i])
+void hypot_f_array(float *dst, const float *x, const float *y, size_t n); // dst[i] = hypot_f(x[i], y[i])
+
+void fast_inv_sqrtd_array(double *dst, const double *src, size_t n); // dst[i] = fast_inv_sqrtd(src[i])
+void fast_sqrtd_array(double *dst, const double *src, size_t n); // dst[i] = fast_sqrtd(src[i])
+void fast_log2d_array(double *dst, const double *src, size_t n); // dst[i] = fast_log2d(src[i])
+void fast_exp2d_array(double *dst, const double *src, size_t n); // dst[i] = fast_exp2d(src[i])
+void fast_powd_array(double *dst, const double *src, double y, size_t n); // dst[i] = fast_powd(src[i], y)
+void cbrt_d_array(double *dst, const double *src, size_t n); // dst[i] = cbrt_d(src[i])
+void hypot_d_array(double *dst, const double *x, const double *y, size_t n); // dst[i] = hypot_d(x[i], y[i])
+
+void fast_log2f_poly_array(float *dst, const float *src, size_t n); // dst[i] = fast_log2f_poly(src[i])
+void fast_exp2f_poly_array(float *dst, const float *src, size_t n); // dst[i] = fast_exp2f_poly(src[i])
+void fast_powf_poly_array(float *dst, const float *src, float y, size_t n); // dst[i] = fast_powf_poly(src[i], y)
+void sqrt_exact_f_array(float *dst, const float *src, size_t n); // dst[i] = sqrt_exact_f(src[i])
+void sqrt_exact_d_array(double *dst, const double *src, size_t n); // dst[i] = sqrt_exact_d(src[i])
+void fast_sincosf_poly_array(float *s, float *c, const float *x, size_t n); // fast_sincosf_poly(x[i], &s[i], &c[i]) (s or c may be x)
+
+#ifndef POW_PLAN_MAX_INT
+    #define POW_PLAN_MAX_INT 64     // largest |y| (or |y| - 1/2) taken by the multiply chains
+#endif
+
+typedef enum {
+    POW_PLAN_ONE,       // y == 0: every result is 1, NaN included
+    POW_PLAN_INT,       // integral |y| <= POW_PLAN_MAX_INT: square-and-multiply chain
+    POW_PLAN_HALF_INT,  // |y| = k + 1/2, k < POW_PLAN_MAX_INT: chain times correctly rounded sqrt
+    POW_PLAN_GENERAL    // anything else: exp2(y * log2(x))
+} pow_plan_kind_t;
+
+/**
+ * @brief Kernel choice for x^y over an array with one y, made once by
+ *        pow_plan_f / pow_plan_d and reused for every element.
+ *
+ * The multiply chains return exactly pow_fi(x, (int)y) (pow_di for double),
+ * i.e. the same products in the same order, one pass of SIMD multiplies
+ * per step over L1-sized blocks; y = 2 is one pass, y = 3 and 4 two (the
+ * square, then x * x^2 or x^2 * x^2). A negative y takes the reciprocal of
+ * the |y| result. A half-integral y multiplies in sqrt_exact(x + 0), so a
+ * negative x, -inf included, gives NaN as on the general path, and -0
+ * keeps the sign of (-0)^k: -0, or -inf for y < 0, when k is odd. The
+ * general case runs the vectorized POLY tier (fast_powf_poly_array, ~150
+ * ulp worst case at y = 2.2) unless FAST_MATH_TIER is FAST_MATH_PRECISE;
+ * the RAW tier's few-percent error is never used here. The double general
+ * case uses fast_powd_precise.
+ *
+ * @members
+ *   kind       - which kernel runs
+ *   k          - integer part of |y| for the chains
+ *   reciprocal - y < 0 (chains only)
+ *   y          - the exponent, for the general case
+**/
+typedef struct {
+    pow_plan_kind_t kind;
+    unsigned int k;
+    bool reciprocal;
+    double y;
+} pow_plan_t;
+
+pow_plan_t pow_plan_f(float y); // Classify a float exponent
+pow_plan_t pow_plan_d(double y); // Classify a double exponent
+void pow_plan_apply_f(const pow_plan_t *plan, float *dst, const float *src, size_t n); // dst[i] = src[i]^y (dst may be src)
+void pow_plan_apply_d(const pow_plan_t *plan, double *dst, const double *src, size_t n); // dst[i] = src[i]^y (dst may be src)
+void pow_f_array(float *dst, const float *src, float y, size_t n); // pow_plan_f + pow_plan_apply_f
+void pow_d_array(double *dst, const double *src, double y, size_t n); // pow_plan_d + pow_plan_apply_d
+
+#endif // MATH_BATCH_H
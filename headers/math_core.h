@@ -1,6 +1,9 @@
 #ifndef MATH_CORE_H
 #define MATH_CORE_H
 #include <cmath.h>
+#if !defined(__GNUC__)
+    #include <math.h>   // sqrtf/sqrt for sqrt_exact_* without compiler builtins
+#endif
 
 #ifndef MAX
     #define MAX(a, b) ((a) > (b) ? (a) : (b))
@@ -64,43 +67,37 @@ static inline int pow_i(int base, int exp)
 }
 
 /**
- * @brief pow_fi: float base, integer exponent. 
- *        Negative exponent => 1 / (base^-exp). 
- *        If base=0 and exp<0 => return INFINITY (div by zero).
+ * @brief pow_fi: float base, integer exponent, by squaring (O(log |exp|)
+ *        multiplies). Negative exponent => 1 / (base^-exp), so base=0 and
+ *        exp<0 gives +-INFINITY.
  */
 static inline float pow_fi(float base, int exp)
 {
-    if (exp < 0) {
-        if (base == 0.0f) return INFINITY; // or handle error
-        int ePos = -exp;
-        float result = 1.0f;
-        while (ePos-- > 0) result *= base;
-        return 1.0f / result;
-    } else {
-        float result = 1.0f;
-        while (exp-- > 0) {
-            result *= base;
-        }
-        return result;
+    unsigned int e = exp < 0 ? 0u - (unsigned int)exp : (unsigned int)exp;
+    float result = 1.0f;
+    float current = base;
+    while (e > 0) {
+        if (e & 1) result *= current;
+        e >>= 1;
+        if (e) current *= current;
     }
+    return exp < 0 ? 1.0f / result : result;
 }
 
 /**
- * @brief pow_di: double base, integer exponent. 
+ * @brief pow_di: double base, integer exponent. Same scheme as pow_fi.
  */
 static inline double pow_di(double base, int exp)
 {
-    if (exp < 0) {
-        if (base == 0.0) return INFINITY;
-        int ePos = -exp;
-        double result = 1.0;
-        while (ePos-- > 0) result *= base;
-        return 1.0 / result;
-    } else {
-        double result = 1.0;
-        while (exp-- > 0) result *= base;
-        return result;
+    unsigned int e = exp < 0 ? 0u - (unsigned int)exp : (unsigned int)exp;
+    double result = 1.0;
+    double current = base;
+    while (e > 0) {
+        if (e & 1) result *= current;
+        e >>= 1;
+        if (e) current *= current;
     }
+    return exp < 0 ? 1.0 / result : result;
 }
 
 //-------------------------
@@ -117,9 +114,12 @@ static inline float fast_inv_sqrt(float x)
     if (x <= 0.0f) return NAN; // domain error or handle differently
 
     float xhalf = 0.5f * x;
-    int i = *(int *)&x;            // reinterpret float bits as int
-    i = 0x5f3759df - (i >> 1);     // initial guess
-    x = *(float *)&i;
+    union {
+        float f;
+        int i;
+    } vx = { x };                  // reinterpret float bits as int
+    vx.i = 0x5f3759df - (vx.i >> 1); // initial guess
+    x = vx.f;
     // One iteration
     x = x * (1.5f - xhalf * x * x);
     // optional second iteration for better accuracy:
@@ -135,9 +135,12 @@ static inline double fast_inv_sqrtd(double x)
     if (x <= 0.0) return NAN;
 
     double xhalf = 0.5 * x;
-    long long i = *(long long *)&x;  
-    i = 0x5fe6ec85e7de30daLL - (i >> 1);
-    x = *(double *)&i;
+    union {
+        double f;
+        long long i;
+    } vx = { x };
+    vx.i = 0x5fe6ec85e7de30daLL - (vx.i >> 1);
+    x = vx.f;
     x = x * (1.5 - xhalf * x * x);
     // optional second iteration
     // x = x * (1.5 - xhalf * x * x);
@@ -188,17 +191,20 @@ static inline double fast_log2d(double x)
         uint64_t i;
     } vx = { x };
 
-    double y = (double)vx.i * 5.42101086242752217e-20; // 1/(2^64)
-    return y - 1023.0;
+    // same bit-cast scheme as fast_log2f: bits * 2^-52 minus the biased
+    // exponent, with the 0.0573 offset that centres the error around zero
+    double y = (double)vx.i * 2.220446049250313e-16; // 1/(2^52)
+    return y - 1022.94269504;
 }
 
 /**
  * @brief fast_exp2f: approximate 2^p. 
- *        Clamps p to [0,255].
+ *        Clamps p to [0,255]. NaN input clamps to 0.
  */
 static inline float fast_exp2f(float p)
 {
     float t = p + 126.94269504f;
+    if (t != t) t = 0.0f;
     CLAMP_INPLACE(t, 0.0f, 255.0f);
     union {
         uint32_t i;
@@ -210,11 +216,12 @@ static inline float fast_exp2f(float p)
 
 /**
  * @brief fast_exp2d: approximate 2^p for double. 
- *        Clamps p to [0, 2047].
+ *        Clamps p to [0, 2047]. NaN input clamps to 0.
  */
 static inline double fast_exp2d(double p)
 {
-    double t = p + 1023.0;
+    double t = p + 1022.94269504;
+    if (t != t) t = 0.0;
     if (t < 0.0) t = 0.0;
     else if (t > 2047.0) t = 2047.0;
 
@@ -279,6 +286,29 @@ static inline double sqrt_d(double x) {
     return fast_sqrtd(x);
 }
 
+/**
+ * @brief sqrt_exact_f: correctly rounded sqrt (hardware instruction on
+ *        GCC/Clang). Use it where sqrt_f's approximation error is too large.
+ */
+static inline float sqrt_exact_f(float x) {
+#if defined(__GNUC__)
+    return __builtin_sqrtf(x);
+#else
+    return sqrtf(x);
+#endif
+}
+
+/**
+ * @brief sqrt_exact_d: correctly rounded sqrt in double
+ */
+static inline double sqrt_exact_d(double x) {
+#if defined(__GNUC__)
+    return __builtin_sqrt(x);
+#else
+    return sqrt(x);
+#endif
+}
+
 /**
  * @brief cbrt_f: approximate cube root of x>0 using fast_powf
  *        For negative x, we can do sign handling if desired.
@@ -317,5 +347,363 @@ static inline double hypot_d(double x, double y)
     return fast_sqrtd(x * x + y * y);
 }
 
+//-------------------------
+// 6) Accuracy tiers
+//-------------------------
+
+/*
+ * The fast_* functions above are the RAW tier: a bit-cast plus at most one
+ * Newton step. Two more tiers trade speed for accuracy:
+ *
+ *   FAST_MATH_POLY    - exponent/mantissa split plus a short minimax-style
+ *                       polynomial (log2 deg 5, exp2 deg 4), two Newton steps
+ *                       for inv_sqrt
+ *   FAST_MATH_PRECISE - double-precision reduction and series, rounded once
+ *                       to float: within 1 ulp of the IEEE result
+ *
+ * Pick per call with the *_tier() functions, or globally at compile time with
+ * -DFAST_MATH_TIER=FAST_MATH_POLY and the log2_f/exp2_f/pow_f/inv_sqrt_f
+ * aliases. Error against libm rounded to float and latency-bound cost, as
+ * printed by `fastmath_ulp` with its defaults (--step 97: every 97th bit
+ * pattern of the domain) from the default Release build (GCC -O3, x86-64,
+ * scalar calls through a pointer); exp2 merges the tool's two half-domain
+ * rows. Rerun the tool on your box:
+ *
+ *   function         tier      max ulp    mean ulp   ns/elem
+ *   log2 (x > 0)     raw       2.5e11     7.8e4       4.1   (abs err < 0.06, normal x)
+ *                    poly      127        0.83        5.4
+ *                    precise   0          0          11.9
+ *   exp2 [-126,127]  raw       4.8e5      2.5e5       3.4
+ *                    poly      38         8.6        11.1
+ *                    precise   0          0          11.8
+ *   inv_sqrt         raw       2.8e4      1.1e4       4.1
+ *                    poly      73         21          6.4
+ *                    precise   0          0           4.4
+ *   pow (y = 2.2)    raw       1.3e6      4.2e5       3.8
+ *                    poly      150        29         12.7
+ *                    precise   0          0          36.0
+ *
+ * The raw log2 error in ulps is dominated by inputs near 1 where the result
+ * is near 0; its absolute error is what the bit-cast bounds. With a hardware
+ * sqrt, the precise inv_sqrt is no slower than the poly one.
+ *
+ * Domains match the raw tier: log2 of x <= 0 is -INFINITY, inv_sqrt of
+ * x <= 0 is NAN, pow follows fast_powf. Unlike the raw tier, NaN inputs
+ * return NaN and infinities are handled.
+ */
+typedef enum {
+    FAST_MATH_RAW = 0,
+    FAST_MATH_POLY,
+    FAST_MATH_PRECISE
+} fast_math_tier_t;
+
+#ifndef FAST_MATH_TIER
+    #define FAST_MATH_TIER FAST_MATH_RAW
+#endif
+
+/**
+ * @brief fast_log2d_precise: log2(x) for x > 0 via atanh series on the mantissa
+ *        reduced to [sqrt(1/2), sqrt(2)). Relative error ~1e-16.
+ */
+static inline double fast_log2d_precise(double x)
+{
+    if (x != x) return x;
+    if (x <= 0.0) return -INFINITY;
+    if (x == INFINITY) return x;
+
+    union {
+        double f;
+        uint64_t i;
+    } v = { x };
+    int e = 0;
+    if ((v.i >> 52) == 0) {             // subnormal: scale into the normal range
+        v.f *= 18014398509481984.0;     // 2^54
+        e = -54;
+    }
+    e += (int)(v.i >> 52) - 1023;
+    v.i = (v.i & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL;
+    if (v.f > 1.4142135623730951) {
+        v.f *= 0.5;
+        e++;
+    }
+    // ln(m) = 2 atanh(t), t = (m-1)/(m+1), |t| <= 0.1716
+    double t = (v.f - 1.0) / (v.f + 1.0);
+    double t2 = t * t;
+    double s = 1.0 / 23;
+    s = s * t2 + 1.0 / 21;
+    s = s * t2 + 1.0 / 19;
+    s = s * t2 + 1.0 / 17;
+    s = s * t2 + 1.0 / 15;
+    s = s * t2 + 1.0 / 13;
+    s = s * t2 + 1.0 / 11;
+    s = s * t2 + 1.0 / 9;
+    s = s * t2 + 1.0 / 7;
+    s = s * t2 + 1.0 / 5;
+    s = s * t2 + 1.0 / 3;
+    s = s * t2 + 1.0;
+    return (double)e + 2.8853900817779268 * t * s;  // 2/ln(2)
+}
+
+/**
+ * @brief fast_exp2d_precise: 2^p via round-to-nearest split and a degree-13
+ *        Taylor polynomial on [-0.5, 0.5]. Relative error ~1e-16.
+ */
+static inline double fast_exp2d_precise(double p)
+{
+    if (p != p) return p;
+    if (p >= 1024.0) return INFINITY;
+    if (p < -1075.0) return 0.0;
+
+    int i = (int)(p >= 0.0 ? p + 0.5 : p - 0.5);
+    double f = (p - (double)i) * 0.6931471805599453;    // ln(2)
+    double r = 1.0 / 6227020800.0;                      // 1/13!
+    r = r * f + 1.0 / 479001600.0;
+    r = r * f + 1.0 / 39916800.0;
+    r = r * f + 1.0 / 3628800.0;
+    r = r * f + 1.0 / 362880.0;
+    r = r * f + 1.0 / 40320.0;
+    r = r * f + 1.0 / 5040.0;
+    r = r * f + 1.0 / 720.0;
+    r = r * f + 1.0 / 120.0;
+    r = r * f + 1.0 / 24.0;
+    r = r * f + 1.0 / 6.0;
+    r = r * f + 0.5;
+    r = r * f + 1.0;
+    r = r * f + 1.0;
+
+    union {
+        uint64_t i;
+        double f;
+    } scale;
+    if (i < -1022) {                    // subnormal result: scale in two steps
+        scale.i = (uint64_t)(i + 1023 + 64) << 52;
+        return r * scale.f * 5.421010862427522e-20;    // 2^-64
+    }
+    if (i > 1023) {                     // 2^1024 * r with r < 1
+        scale.i = (uint64_t)(i - 1 + 1023) << 52;
+        return r * scale.f * 2.0;
+    }
+    scale.i = (uint64_t)(i + 1023) << 52;
+    return r * scale.f;
+}
+
+static inline double fast_powd_precise(double x, double y)
+{
+    if (x != x || y != y) return NAN;
+    if (x < 0.0) return NAN;
+    if (x == 0.0) return y > 0.0 ? 0.0 : (y == 0.0 ? 1.0 : INFINITY);
+    return fast_exp2d_precise(y * fast_log2d_precise(x));
+}
+
+/**
+ * @brief fast_log2f_poly: exponent + degree-5 polynomial in (m - 1),
+ *        m in [sqrt(1/2), sqrt(2)).
+ */
+static inline float fast_log2f_poly(float x)
+{
+    if (x != x) return x;
+    if (x <= 0.0f) return -INFINITY;
+    if (x == INFINITY) return x;
+
+    union {
+        float f;
+        uint32_t i;
+    } v = { x };
+    int e = 0;
+    if ((v.i >> 23) == 0) {             // subnormal
+        v.f *= 16777216.0f;             // 2^24
+        e = -24;
+    }
+    e += (int)(v.i >> 23) - 127;
+    v.i = (v.i & 0x007fffff) | 0x3f800000;
+    if (v.f > 1.41421356f) {
+        v.f *= 0.5f;
+        e++;
+    }
+    float f = v.f - 1.0f;
+    float p = -0.206858124f;
+    p = p * f + 0.318407118f;
+    p = p * f - 0.366413259f;
+    p = p * f + 0.479793884f;
+    p = p * f - 0.721208468f;
+    p = p * f + 1.4427018f;
+    return (float)e + f * p;
+}
+
+/**
+ * @brief fast_exp2f_poly: 2^i by construction times a degree-4 polynomial
+ *        for 2^f, f in [-0.5, 0.5].
+ */
+static inline float fast_exp2f_poly(float p)
+{
+    if (p != p) return p;
+    if (p >= 128.0f) return INFINITY;
+    if (p < -150.0f) return 0.0f;
+
+    int i = (int)(p >= 0.0f ? p + 0.5f : p - 0.5f);
+    float f = p - (float)i;
+    float r = 0.00956051021f;
+    r = r * f + 0.0559170392f;
+    r = r * f + 0.240249811f;
+    r = r * f + 0.693121968f;
+    r = r * f + 0.999999191f;
+
+    union {
+        uint32_t i;
+        float f;
+    } scale;
+    if (i < -126) {
+        scale.i = (uint32_t)(i + 127 + 32) << 23;
+        return r * scale.f * 2.3283064365386963e-10f;  // 2^-32
+    }
+    if (i > 127) {
+        scale.i = (uint32_t)(i - 1 + 127) << 23;
+        return r * scale.f * 2.0f;
+    }
+    scale.i = (uint32_t)(i + 127) << 23;
+    return r * scale.f;
+}
+
+/**
+ * @brief fast_inv_sqrt_poly: the raw guess refined by two Newton steps.
+ */
+static inline float fast_inv_sqrt_poly(float x)
+{
+    if (x != x) return x;
+    if (x <= 0.0f) return NAN;
+    if (x == INFINITY) return 0.0f;
+    float xhalf = 0.5f * x;
+    float y = fast_inv_sqrt(x);
+    return y * (1.5f - xhalf * y * y);
+}
+
+static inline float fast_powf_poly(float x, float y)
+{
+    if (x != x || y != y) return NAN;
+    if (x < 0.0f) return NAN;
+    if (x == 0.0f) return y > 0.0f ? 0.0f : (y == 0.0f ? 1.0f : INFINITY);
+    return fast_exp2f_poly(y * fast_log2f_poly(x));
+}
+
+static inline float fast_log2f_precise(float x) { return (float)fast_log2d_precise(x); }
+static inline float fast_exp2f_precise(float p) { return (float)fast_exp2d_precise(p); }
+
+static inline float fast_inv_sqrt_precise(float x)
+{
+    if (x != x) return x;
+    if (x <= 0.0f) return NAN;
+    return (float)(1.0 / sqrt_exact_d(x));
+}
+
+static inline float fast_powf_precise(float x, float y) { return (float)fast_powd_precise(x, y); }
+
+/**
+ * @brief Per-call tier selection. With a constant tier the switch folds away.
+ */
+static inline float fast_log2f_tier(float x, fast_math_tier_t tier)
+{
+    switch (tier) {
+        case FAST_MATH_POLY: return fast_log2f_poly(x);
+        case FAST_MATH_PRECISE: return fast_log2f_precise(x);
+        default: return fast_log2f(x);
+    }
+}
+
+static inline float fast_exp2f_tier(float p, fast_math_tier_t tier)
+{
+    switch (tier) {
+        case FAST_MATH_POLY: return fast_exp2f_poly(p);
+        case FAST_MATH_PRECISE: return fast_exp2f_precise(p);
+        default: return fast_exp2f(p);
+    }
+}
+
+static inline float fast_powf_tier(float x, float y, fast_math_tier_t tier)
+{
+    switch (tier) {
+        case FAST_MATH_POLY: return fast_powf_poly(x, y);
+        case FAST_MATH_PRECISE: return fast_powf_precise(x, y);
+        default: return fast_powf(x, y);
+    }
+}
+
+static inline float fast_inv_sqrt_tier(float x, fast_math_tier_t tier)
+{
+    switch (tier) {
+        case FAST_MATH_POLY: return fast_inv_sqrt_poly(x);
+        case FAST_MATH_PRECISE: return fast_inv_sqrt_precise(x);
+        default: return fast_inv_sqrt(x);
+    }
+}
+
+/**
+ * @brief Compile-time tier aliases (see FAST_MATH_TIER).
+ */
+static inline float log2_f(float x) { return fast_log2f_tier(x, FAST_MATH_TIER); }
+static inline float exp2_f(float p) { return fast_exp2f_tier(p, FAST_MATH_TIER); }
+static inline float pow_f(float x, float y) { return fast_powf_tier(x, y, FAST_MATH_TIER); }
+static inline float inv_sqrt_f(float x) { return fast_inv_sqrt_tier(x, FAST_MATH_TIER); }
+
+//-------------------------
+// 7) sin / cos
+//-------------------------
+
+#ifndef FAST_SINCOS_MAX
+    #define FAST_SINCOS_MAX 8192.0f     // |x| up to which the reduction below stays accurate
+#endif
+
+/**
+ * @brief fast_sincosf_poly: sin and cos of x together, POLY tier.
+ *
+ * x is reduced by the nearest multiple k of pi/2 with a three-part pi/2
+ * (k * each part is exact for |x| <= FAST_SINCOS_MAX), then degree-7 sin /
+ * degree-8 cos minimax polynomials on [-pi/4, pi/4] are swapped and negated
+ * by quadrant. The error is below 8e-8 absolute over that range; there is
+ * no ulp bound, since the rounding of the reduced argument is relative to
+ * pi/2 and not to the result, so near the zeros of sin / cos (x = -3pi/2
+ * already) the relative error grows to many ulps. Larger, infinite and NaN
+ * arguments go to libm in double (NaN out for infinity and NaN).
+ * fast_sincosf_poly_array (math_batch.h) is bit-identical to this.
+ */
+static inline void fast_sincosf_poly(float x, float *s, float *c)
+{
+    if (!(x >= -FAST_SINCOS_MAX && x <= FAST_SINCOS_MAX)) {
+#if defined(__GNUC__)
+        *s = (float)__builtin_sin(x);
+        *c = (float)__builtin_cos(x);
+#else
+        *s = (float)sin(x);
+        *c = (float)cos(x);
+#endif
+        return;
+    }
+    // round to nearest by the 1.5 * 2^23 trick, so every SIMD level agrees
+    float k = (x * 0.636619772f + 12582912.0f) - 12582912.0f;
+    float r = ((x - k * 1.5703125f) - k * 4.837512969970703125e-4f) - k * 7.54978995489188216e-8f;
+    float z = r * r;
+    float sp = ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z - 1.6666654611e-1f) * z * r + r;
+    float cp = ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z + 4.166664568298827e-2f) * z * z
+               - 0.5f * z + 1.0f;
+    int q = (int)k;
+    float sv = (q & 1) ? cp : sp;
+    float cv = (q & 1) ? sp : cp;
+    *s = (q & 2) ? -sv : sv;
+    *c = ((q + 1) & 2) ? -cv : cv;
+}
+
+static inline float fast_sinf_poly(float x)
+{
+    float s, c;
+    fast_sincosf_poly(x, &s, &c);
+    return s;
+}
+
+static inline float fast_cosf_poly(float x)
+{
+    float s, c;
+    fast_sincosf_poly(x, &s, &c);
+    return c;
+}
+
 
 #endif //MATH_CORE_H
@@ -2,6 +2,7 @@
 #define VEC_H
 #include <cmath.h>
 #include <math_core.h>
+#include <vec_alloc.h>
 
 /**
  * @brief A structure representing a mathematical vector of floating-point numbers
@@ -10,12 +11,17 @@
  * to perform various vector operations and mathematical calculations.
  * 
  * @members
- *   size - The number of elements in the vector
- *   data - Pointer to the array containing the vector elements
+ *   size      - The number of elements in the vector
+ *   data      - Pointer to the array containing the vector elements
+ *   allocator - Allocator that owns `data` (NULL means malloc/free)
+ *   capacity  - Elements `data` has room for; 0 means exactly `size`, so
+ *               vectors built field by field keep working
 **/
 typedef struct {
     size_t size;
     float *data;  
+    const vec_allocator_t *allocator;
+    size_t capacity;
 } vector_t;
 
 /*
@@ -25,12 +31,63 @@ typedef struct
 {
     unsigned int size;
     double *data;
+    const vec_allocator_t *allocator;
+    unsigned int capacity;
 } dvector_t;
 
 
 extern const vector_t VEC_UNDEFINED;
 extern const dvector_t DVEC_UNDEFINED;
 
+/**
+ * @brief Accuracy mode of vector_dot_ex / vector_magnitude_ex and the
+ *        dvec_* versions (which accumulate in double throughout).
+ *
+ *   VEC_REDUCE_FAST        - 32 float accumulators combined pairwise (what
+ *                            vector_dot / vector_magnitude use)
+ *   VEC_REDUCE_COMPENSATED - adds per-accumulator TwoSum error terms; error
+ *                            close to one rounding of the exact sum of the
+ *                            rounded products, about 2x the cost
+ *   VEC_REDUCE_SCALED      - scales each chunk by a power of two taken from
+ *                            its largest element, so squares and products
+ *                            of huge or tiny values neither overflow nor
+ *                            underflow; two passes per chunk
+ *
+ * See vec_kernels_t (vec_simd.h) for the per-kernel error bounds. Measured
+ * with vec_bench (AVX-512, one core; Gelem/s at 16K elements / 4M elements):
+ *
+ *                  dot          magnitude
+ *   fast           6.5 / 1.7    8.4 / 3.0
+ *   compensated    6.2 / 1.5    5.9 / 2.3
+ *   scaled         2.6 / 1.0    4.1 / 2.1
+ *
+ * With 32 accumulators the fast kernels no longer wait on a single add
+ * chain, so compensation costs little until the loads become the limit.
+ */
+typedef enum {
+    VEC_REDUCE_FAST = 0,
+    VEC_REDUCE_COMPENSATED,
+    VEC_REDUCE_SCALED
+} vec_reduce_mode_t;
+
+/**
+ * @brief Growable vectors. vector_push / vector_append grow the buffer
+ *        geometrically (doubling, at least VEC_GROW_MIN elements), so
+ *        building a vector element by element costs amortized O(1) per
+ *        element instead of a realloc-and-copy each time. vector_reserve
+ *        makes room up front and vector_shrink gives the slack back.
+ *
+ * A grown buffer comes from the vector's own allocator, so a vector
+ * created under VEC_ALLOCATOR_SCOPE(&VEC_ALIGNED_ALLOCATOR) stays 64-byte
+ * aligned as it grows (a vector without storage takes the thread's current
+ * allocator, like vector_alloc). Growing invalidates pointers into `data`
+ * and views of it. On failure (allocation or size overflow) the vector is
+ * left as it was and false is returned.
+ */
+#ifndef VEC_GROW_MIN
+    #define VEC_GROW_MIN 16         // smallest capacity a growing vector gets (one 64-byte line of floats)
+#endif
+
 vector_t vector_alloc(unsigned int size); // Allocate memory for a vector
 void vector_free(vector_t *v); // Free memory allocated for a vector
 vector_t vector_create(unsigned int size); // Create a new vector
@@ -59,15 +116,16 @@ void vector_div_inplace(vector_t *v1, vector_t v2); // Divide one vector by anot
 float vector_dot(vector_t v1, vector_t v2); // Calculate the dot product of two vectors
 vector_t vector_cross(vector_t v1, vector_t v2); // Calculate the cross product of two vectors
 float vector_magnitude(vector_t v); // Calculate the magnitude of a vector
+float vector_dot_ex(vector_t v1, vector_t v2, vec_reduce_mode_t mode); // Dot product with a chosen accuracy mode
+float vector_magnitude_ex(vector_t v, vec_reduce_mode_t mode); // Magnitude with a chosen accuracy mode (correctly rounded sqrt)
+double vector_sum(vector_t v); // Sum of the elements (float lanes, double across chunks)
+size_t vector_capacity(vector_t v); // Elements v.data has room for
+bool vector_reserve(vector_t *v, size_t capacity); // Make room for `capacity` elements (never shrinks)
+bool vector_push(vector_t *v, float value); // Append one element
+bool vector_append(vector_t *v, const float *src, size_t n); // Append n elements (src may point into v)
+bool vector_shrink(vector_t *v); // Reallocate to exactly v->size elements
 void print_vector(const char *label, vector_t v); // Print a vector to stdout
-
-
-// TODO:
-vector_t vec_normalize(vector_t v); // Normalize a vector
-vector_t vec_abs(vector_t v); // Calculate the absolute value of a vector
-float vec_distance(vector_t v1, vector_t v2); // Calculate the distance between two vectors
-float vec_angle(vector_t v1, vector_t v2); // Calculate the angle between two vectors
-vector_t vec_map(vector_t v, float (*func)(float)); // Apply a function to each element of a vector
+vector_t vec_map(vector_t v, float (*func)(float)); // Apply a function to each element of a vector (one call per element; see vec_map.h)
 void vec_map_to(vector_t *v, float (*func)(float)); // Apply a function to each element of a vector in place
 vector_t vec_map2(vector_t v1, vector_t v2, float (*func)(float, float)); // Apply a function to corresponding elements of two vectors
 void vec_map2_to(vector_t *v1, vector_t v2, float (*func)(float, float)); // Apply a function to corresponding elements of two vectors in place
@@ -79,10 +137,8 @@ vector_t vec_map4(vector_t v1, vector_t v2, vector_t v3, vector_t v4, float (*fu
 void vec_map4_to(vector_t *v1, vector_t v2, vector_t v3, vector_t v4, float (*func)(float, float, float, float)); // Apply a function to corresponding elements of four vectors in place
 vector_t vec_map5(vector_t v1, vector_t v2, vector_t v3, vector_t v4, vector_t v5, float (*func)(float, float, float, float, float)); // Apply a function to corresponding elements of five vectors
 void vec_map5_to(vector_t *v1, vector_t v2, vector_t v3, vector_t v4, vector_t v5, float (*func)(float, float, float, float, float)); // Apply a function to corresponding elements of five vectors in place
-vector_t orthogonalize(vector_t v1, vector_t v2); // Orthogonalize two vectors
-vector_t project(vector_t v1, vector_t v2); // Project one vector onto another
-vector_t reflect(vector_t v, vector_t normal); // Reflect a vector off a surface
-vector_t refract(vector_t v, vector_t normal, float eta); // Refract a vector through a surface
+float vec_distance(vector_t v1, vector_t v2); // Calculate the distance between two vectors (collections: see vec_knn.h)
+float vec_angle(vector_t v1, vector_t v2); // Calculate the angle between two vectors
 vector_t vec_rotate(vector_t v, float angle, vector_t axis); // Rotate a vector around an axis
 vector_t vec_rotate_x(vector_t v, float angle); // Rotate a vector around the x-axis
 vector_t vec_rotate_y(vector_t v, float angle); // Rotate a vector around the y-axis
@@ -107,6 +163,15 @@ vector_t vec_transform_inverse_affine(vector_t v, float *matrix); // Transform a
 vector_t vec_transform_inverse_affine_normal(vector_t v, float *matrix); // Transform a vector as a normal using the inverse of an affine transformation matrix
 vector_t vec_transform_inverse_affine_direction(vector_t v, float *matrix); // Transform a vector as a direction using the inverse of an affine transformation matrix
 vector_t vec_transform_inverse_affine_position(vector_t v, float *matrix); // Transform a vector as a position using the inverse of an affine transformation matrix
+
+
+// TODO:
+vector_t vec_normalize(vector_t v); // Normalize a vector
+vector_t vec_abs(vector_t v); // Calculate the absolute value of a vector
+vector_t orthogonalize(vector_t v1, vector_t v2); // Orthogonalize two vectors
+vector_t project(vector_t v1, vector_t v2); // Project one vector onto another
+vector_t reflect(vector_t v, vector_t normal); // Reflect a vector off a surface
+vector_t refract(vector_t v, vector_t normal, float eta); // Refract a vector through a surface
 vector_t vec_magnitude_squared(vector_t v); // Calculate the squared magnitude of a vector
 vector_t vec_normalize_safe(vector_t v); // Normalize a vector safely
 vector_t vec_abs_safe(vector_t v); // Calculate the absolute value of a vector safely
@@ -146,9 +211,40 @@ vector_t vec_transform_inverse_affine_position_safe(vector_t v, float *matrix);
 dvector_t allocate_d(unsigned int size); // Allocate memory for a double precision vector
 void free_dvector(dvector_t *v); // Free memory allocated for a double precision vector
 dvector_t dvec_create(unsigned int size); // Create a new double precision vector
-dvector_t dvec_create_from_array(unsigned int size, double *data); // Create a new double precision vector from an array || macro exists
+dvector_t dvec_create_from_array(unsigned int size, const double *data); // Create a new double precision vector from an array || macro exists
 dvector_t dvec_copy(dvector_t v); // Create a copy of a double precision vector
 dvector_t dvec_default(unsigned int size, double value); // Create a new double precision vector with a default value
+bool dvec_equals(dvector_t v1, dvector_t v2); // Check if two double vectors are equal
+dvector_t dvec_scalar_add(dvector_t v, double scalar); // Add a scalar to a double vector
+void dvec_scalar_add_inplace(dvector_t *v, double scalar); // Add a scalar to a double vector in place
+dvector_t dvec_scalar_sub(dvector_t v, double scalar); // Subtract a scalar from a double vector
+void dvec_scalar_sub_inplace(dvector_t *v, double scalar); // Subtract a scalar from a double vector in place
+dvector_t dvec_scalar_mul(dvector_t v, double scalar); // Multiply a double vector by a scalar
+void dvec_scalar_mul_inplace(dvector_t *v, double scalar); // Multiply a double vector by a scalar in place
+dvector_t dvec_scalar_div(dvector_t v, double scalar); // Divide a double vector by a scalar
+void dvec_scalar_div_inplace(dvector_t *v, double scalar); // Divide a double vector by a scalar in place
+dvector_t dvec_pow(dvector_t v, double power); // Raise a double vector to a power
+void dvec_pow_inplace(dvector_t *v, double power); // Raise a double vector to a power in place
+dvector_t dvec_add(dvector_t v1, dvector_t v2); // Add two double vectors
+void dvec_add_inplace(dvector_t *v1, dvector_t v2); // Add two double vectors in place
+dvector_t dvec_sub(dvector_t v1, dvector_t v2); // Subtract one double vector from another
+void dvec_sub_inplace(dvector_t *v1, dvector_t v2); // Subtract one double vector from another in place
+dvector_t dvec_mul(dvector_t v1, dvector_t v2); // Multiply two double vectors
+void dvec_mul_inplace(dvector_t *v1, dvector_t v2); // Multiply two double vectors in place
+dvector_t dvec_div(dvector_t v1, dvector_t v2); // Divide one double vector by another
+void dvec_div_inplace(dvector_t *v1, dvector_t v2); // Divide one double vector by another in place
+double dvec_dot(dvector_t v1, dvector_t v2); // Dot product of two double vectors
+dvector_t dvec_cross(dvector_t v1, dvector_t v2); // Cross product of two 3D double vectors
+double dvec_magnitude(dvector_t v); // Magnitude of a double vector
+double dvec_dot_ex(dvector_t v1, dvector_t v2, vec_reduce_mode_t mode); // Dot product with a chosen accuracy mode
+double dvec_magnitude_ex(dvector_t v, vec_reduce_mode_t mode); // Magnitude with a chosen accuracy mode
+double dvec_sum(dvector_t v); // Sum of the elements
+size_t dvec_capacity(dvector_t v); // Elements v.data has room for
+bool dvec_reserve(dvector_t *v, size_t capacity); // Make room for `capacity` elements (never shrinks)
+bool dvec_push(dvector_t *v, double value); // Append one element
+bool dvec_append(dvector_t *v, const double *src, size_t n); // Append n elements (src may point into v)
+bool dvec_shrink(dvector_t *v); // Reallocate to exactly v->size elements
+void print_dvector(const char *label, dvector_t v); // Print a double vector to stdout
 
 
 #ifndef vector
@@ -0,0 +1,116 @@
+#ifndef VEC_ALLOC_H
+#define VEC_ALLOC_H
+#include <cmath.h>
+
+/**
+ * @brief Pluggable allocator backend for vector_t / dvector_t storage.
+ *
+ * vector_alloc and allocate_d ask the allocator on top of the calling
+ * thread's allocator stack for memory, and remember which allocator served
+ * the buffer so vector_free / free_dvector can hand it back to the same one.
+ * With an empty stack the system allocator (malloc/free) is used.
+ *
+ * @members
+ *   alloc - return `bytes` bytes of storage, or NULL on failure
+ *   free  - release storage previously returned by alloc (`bytes` is the
+ *           size that was requested)
+ *   ctx   - opaque state passed back to both callbacks
+**/
+typedef struct vec_allocator {
+    void *(*alloc)(void *ctx, size_t bytes);
+    void  (*free)(void *ctx, void *ptr, size_t bytes);
+    void *ctx;
+} vec_allocator_t;
+
+/**
+ * @brief Bump arena. Allocation is a pointer increment, freeing a single
+ *        vector is a no-op and vec_arena_reset releases everything at once.
+ *        Not thread-safe; use one arena per thread.
+**/
+typedef struct vec_arena_block vec_arena_block_t;
+
+typedef struct {
+    vec_arena_block_t *head;    // block currently being bumped
+    size_t block_size;          // minimum size of newly chained blocks
+    size_t used;                // bytes handed out since the last reset
+    size_t peak;                // high-water mark of `used`
+    vec_allocator_t allocator;  // front end bound to this arena
+} vec_arena_t;
+
+#ifndef VEC_POOL_CLASSES
+    #define VEC_POOL_CLASSES 16     // 64 B .. 2 MiB in powers of two
+#endif
+
+#ifndef VEC_POOL_MIN_SHIFT
+    #define VEC_POOL_MIN_SHIFT 6
+#endif
+
+/**
+ * @brief Size-class free-list pool. Requests are rounded up to a power of
+ *        two and recycled through per-class free lists; requests above the
+ *        largest class fall through to malloc. Not thread-safe.
+**/
+typedef struct vec_pool_slab vec_pool_slab_t;
+
+typedef struct {
+    void *free_lists[VEC_POOL_CLASSES];
+    vec_pool_slab_t *slabs;     // every slab carved so far, for destroy
+    size_t slab_size;           // bytes carved per refill of a class
+    vec_allocator_t allocator;  // front end bound to this pool
+} vec_pool_t;
+
+#ifndef VEC_ALLOC_ALIGN
+    #define VEC_ALLOC_ALIGN 16      // alignment of arena / pool allocations
+#endif
+
+#ifndef VEC_ALIGN
+    #define VEC_ALIGN 64            // alignment of VEC_ALIGNED_ALLOCATOR buffers
+#endif
+
+#ifndef VEC_ALLOCATOR_STACK_DEPTH
+    #define VEC_ALLOCATOR_STACK_DEPTH 16
+#endif
+
+extern const vec_allocator_t VEC_SYSTEM_ALLOCATOR;
+
+/**
+ * @brief System allocator returning VEC_ALIGN (64) byte aligned buffers:
+ *        one cache line, and one AVX-512 register, so the SIMD kernels take
+ *        their aligned-load paths and no load splits a line. Use it with
+ *        VEC_ALLOCATOR_SCOPE(&VEC_ALIGNED_ALLOCATOR) or vec_allocator_push.
+ */
+extern const vec_allocator_t VEC_ALIGNED_ALLOCATOR;
+
+const vec_allocator_t *vec_allocator_current(void); // Allocator used by vector_alloc on this thread
+bool vec_allocator_push(const vec_allocator_t *a); // Route this thread's allocations to `a`
+void vec_allocator_pop(void); // Restore the previously active allocator
+
+bool vec_arena_init(vec_arena_t *arena, size_t capacity); // Create an arena with an initial block of `capacity` bytes
+void vec_arena_reset(vec_arena_t *arena); // Release every allocation at once, keeping the memory
+void vec_arena_destroy(vec_arena_t *arena); // Return all arena memory to the system
+const vec_allocator_t *vec_arena_allocator(vec_arena_t *arena); // Allocator front end for an arena
+
+bool vec_pool_init(vec_pool_t *pool, size_t slab_size); // Create an empty pool carving `slab_size` byte slabs
+void vec_pool_destroy(vec_pool_t *pool); // Return all pooled memory to the system
+const vec_allocator_t *vec_pool_allocator(vec_pool_t *pool); // Allocator front end for a pool
+
+/**
+ * @brief Run the following statement/block with `a` as the active allocator.
+ *
+ *     VEC_ALLOCATOR_SCOPE(vec_arena_allocator(&frame)) {
+ *         vector_t t = vector_add(x, y);   // served by the arena
+ *         ...
+ *     }
+ *
+ * Do not `break`/`return` out of the block: the allocator would stay pushed.
+ * If the allocator stack is full the block still runs, on the current one.
+ */
+#define VEC_ALLOCATOR_SCOPE(a) \
+    for (int vec_scope_pushed_ = vec_allocator_push(a), vec_scope_once_ = 0; \
+         !vec_scope_once_; \
+         (vec_scope_pushed_ ? vec_allocator_pop() : (void)0), vec_scope_once_ = 1)
+
+#define VEC_ARENA_SCOPE(arena) VEC_ALLOCATOR_SCOPE(vec_arena_allocator(arena))
+#define VEC_POOL_SCOPE(pool)   VEC_ALLOCATOR_SCOPE(vec_pool_allocator(pool))
+
+#endif // VEC_ALLOC_H
@@ -0,0 +1,51 @@
+#ifndef VEC_BLAS1_H
+#define VEC_BLAS1_H
+#include <cmath.h>
+#include <stddef.h>
+#include <vec.h>
+
+/*
+ * Fused level-1 updates: one pass over memory, no temporaries.
+ *
+ * y = a*x + y written as vector_scalar_mul + vector_add_inplace reads x and
+ * y, writes and re-reads a temporary and rounds twice; vector_axpy reads x
+ * and y once and rounds once. Each element is one explicit fused
+ * multiply-add (fmaf / fma in the reference kernels, FMA instructions on
+ * AVX2+FMA and AVX-512), so every level gives the same bits:
+ *
+ *   axpy   y[i] = fma(a, x[i], y[i])
+ *   axpby  y[i] = fma(a, x[i], b * y[i])
+ *   waxpby w[i] = fma(a, x[i], b * y[i])
+ *   fma    d[i] = fma(x[i], y[i], z[i])
+ *   lerp   d[i] = fma(t, b[i] - a[i], a[i])     LERP(a, b, t), fused
+ *   clamp  d[i] = CLAMP(x[i], lo, hi)           NaN gives hi, as the macro
+ *
+ * On CPUs without FMA hardware a software fmaf per element would cost far
+ * more than the two passes it replaces, so there every level runs the same
+ * operations unfused instead (the product rounded, then the sum; SSE2
+ * vectors from that level up): still one pass and the same bits at every
+ * level, but not fused. Outside x86 the kernels are fused only when
+ * FP_FAST_FMAF and FP_FAST_FMA are defined.
+ *
+ * The outputs are caller-provided, like matrix_gemv's y: the functions
+ * write through the vector's data and return false, writing nothing, when
+ * the sizes differ. An output may be any of the inputs (pass x as dst for
+ * the in-place form); partial overlaps are undefined. Vectors of at least
+ * vec_parallel_threshold() elements are split over the vec_parallel pool.
+ */
+
+bool vector_axpy(float a, vector_t x, vector_t y); // y = a*x + y
+bool vector_axpby(float a, vector_t x, float b, vector_t y); // y = a*x + b*y
+bool vector_waxpby(vector_t w, float a, vector_t x, float b, vector_t y); // w = a*x + b*y
+bool vector_fma(vector_t dst, vector_t x, vector_t y, vector_t z); // dst = x*y + z, element-wise
+bool vector_lerp(vector_t dst, vector_t a, vector_t b, float t); // dst = a + t*(b - a)
+bool vector_clamp(vector_t dst, vector_t x, float lo, float hi); // dst = CLAMP(x, lo, hi)
+
+bool dvec_axpy(double a, dvector_t x, dvector_t y); // y = a*x + y
+bool dvec_axpby(double a, dvector_t x, double b, dvector_t y); // y = a*x + b*y
+bool dvec_waxpby(dvector_t w, double a, dvector_t x, double b, dvector_t y); // w = a*x + b*y
+bool dvec_fma(dvector_t dst, dvector_t x, dvector_t y, dvector_t z); // dst = x*y + z, element-wise
+bool dvec_lerp(dvector_t dst, dvector_t a, dvector_t b, double t); // dst = a + t*(b - a)
+bool dvec_clamp(dvector_t dst, dvector_t x, double lo, double hi); // dst = CLAMP(x, lo, hi)
+
+#endif // VEC_BLAS1_H
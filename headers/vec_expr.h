@@ -0,0 +1,89 @@
+#ifndef VEC_EXPR_H
+#define VEC_EXPR_H
+#include <vec.h>
+
+#ifndef VEC_EXPR_MAX_NODES
+    #define VEC_EXPR_MAX_NODES 64
+#endif
+
+#ifndef VEC_EXPR_MAX_SLOTS
+    #define VEC_EXPR_MAX_SLOTS 8    // scratch blocks live at once during evaluation
+#endif
+
+#ifndef VEC_EXPR_BLOCK
+    #define VEC_EXPR_BLOCK 256      // elements per fused block (1 KiB per slot)
+#endif
+
+/**
+ * @brief Handle to a node of a vec_expr_graph_t; negative means invalid.
+ */
+typedef int vec_expr_t;
+
+typedef enum {
+    VEC_EXPR_LEAF = 0,
+    VEC_EXPR_ADD,
+    VEC_EXPR_SUB,
+    VEC_EXPR_MUL,
+    VEC_EXPR_DIV,
+    VEC_EXPR_SCALAR_ADD,
+    VEC_EXPR_SCALAR_SUB,
+    VEC_EXPR_SCALAR_MUL,
+    VEC_EXPR_SCALAR_DIV,
+    VEC_EXPR_POW
+} vec_expr_op_t;
+
+typedef struct {
+    vec_expr_op_t op;
+    vec_expr_t lhs;
+    vec_expr_t rhs;
+    float scalar;           // scalar operand / power
+    const float *data;      // leaf operand
+} vec_expr_node_t;
+
+/**
+ * @brief A deferred expression over vector_t operands.
+ *
+ * Builder calls only record nodes; nothing is computed or allocated until
+ * vec_expr_eval / vec_expr_eval_to, which run the whole tree in one pass over
+ * memory, VEC_EXPR_BLOCK elements at a time, with intermediates held in small
+ * cache-resident scratch blocks instead of heap temporaries.
+ *
+ *     vec_expr_graph_t g;
+ *     vec_expr_init(&g);
+ *     vec_expr_t e = vec_expr_add(&g,
+ *         vec_expr_mul(&g, vec_expr_leaf(&g, a), vec_expr_leaf(&g, b)),
+ *         vec_expr_scalar_mul(&g, vec_expr_leaf(&g, c), k));
+ *     vector_t r = vec_expr_eval(&g, e);   // == vector_add(vector_mul(a, b), vector_scalar_mul(c, k))
+ *
+ * Results are bit-identical to the eager calls. Leaves are referenced, not
+ * copied, and must outlive evaluation; all leaves must have the same size.
+ * A node used twice is evaluated twice.
+ *
+ * @members
+ *   nodes - recorded nodes, referenced by vec_expr_t index
+ *   count - number of recorded nodes
+ *   size  - element count shared by every leaf
+ *   error - set when a node could not be recorded (graph full, size mismatch)
+**/
+typedef struct {
+    vec_expr_node_t nodes[VEC_EXPR_MAX_NODES];
+    int count;
+    size_t size;
+    bool error;
+} vec_expr_graph_t;
+
+void vec_expr_init(vec_expr_graph_t *g); // Start an empty expression graph
+vec_expr_t vec_expr_leaf(vec_expr_graph_t *g, vector_t v); // Reference a vector operand
+vec_expr_t vec_expr_add(vec_expr_graph_t *g, vec_expr_t a, vec_expr_t b); // Deferred vector_add
+vec_expr_t vec_expr_sub(vec_expr_graph_t *g, vec_expr_t a, vec_expr_t b); // Deferred vector_sub
+vec_expr_t vec_expr_mul(vec_expr_graph_t *g, vec_expr_t a, vec_expr_t b); // Deferred vector_mul
+vec_expr_t vec_expr_div(vec_expr_graph_t *g, vec_expr_t a, vec_expr_t b); // Deferred vector_div
+vec_expr_t vec_expr_scalar_add(vec_expr_graph_t *g, vec_expr_t a, float scalar); // Deferred vector_scalar_add
+vec_expr_t vec_expr_scalar_sub(vec_expr_graph_t *g, vec_expr_t a, float scalar); // Deferred vector_scalar_sub
+vec_expr_t vec_expr_scalar_mul(vec_expr_graph_t *g, vec_expr_t a, float scalar); // Deferred vector_scalar_mul
+vec_expr_t vec_expr_scalar_div(vec_expr_graph_t *g, vec_expr_t a, float scalar); // Deferred vector_scalar_div
+vec_expr_t vec_expr_pow(vec_expr_graph_t *g, vec_expr_t a, float power); // Deferred vector_pow
+vector_t vec_expr_eval(const vec_expr_graph_t *g, vec_expr_t root); // Materialize into a new vector
+bool vec_expr_eval_to(const vec_expr_graph_t *g, vec_expr_t root, vector_t *dst); // Materialize into dst (may alias a leaf)
+
+#endif // VEC_EXPR_H
@@ -0,0 +1,113 @@
+#ifndef VEC_FILE_H
+#define VEC_FILE_H
+#include <cmath.h>
+#include <vec.h>
+#include <vec_half.h>
+
+/**
+ * @brief On-disk vector format, version 1 (little-endian).
+ *
+ * Header fields and elements are written, hashed and mapped in host byte
+ * order with no swapping, so vec_file.c refuses to build on big-endian
+ * hosts rather than produce files other machines would misread.
+ *
+ * A 64-byte header followed, at `data_offset`, by `length` elements stored
+ * exactly as they are in memory. `data_offset` is a multiple of `alignment`
+ * (4096 by default), so a mapping of the file hands out page-aligned
+ * element data.
+ *
+ * @members
+ *   magic       - VEC_FILE_MAGIC
+ *   version     - VEC_FILE_VERSION
+ *   dtype       - element type, vec_file_dtype_t
+ *   length      - number of elements
+ *   data_offset - byte offset of element 0
+ *   alignment   - power of two that data_offset is a multiple of
+ *   flags       - reserved, 0
+ *   checksum    - Fletcher-64 of the element bytes (see vec_file_checksum)
+**/
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t dtype;
+    uint64_t length;
+    uint64_t data_offset;
+    uint32_t alignment;
+    uint32_t flags;
+    uint64_t checksum;
+    uint8_t reserved[16];
+} vec_file_header_t;
+
+#define VEC_FILE_MAGIC "CMVECTR"        // 7 chars + NUL fill the 8 bytes
+#define VEC_FILE_VERSION 1
+
+#ifndef VEC_FILE_ALIGN
+    #define VEC_FILE_ALIGN 4096         // default data alignment (one page)
+#endif
+
+typedef enum {
+    VEC_DTYPE_F32 = 1,
+    VEC_DTYPE_F64 = 2,
+    VEC_DTYPE_F16 = 3,
+    VEC_DTYPE_BF16 = 4
+} vec_file_dtype_t;
+
+/**
+ * @brief How a file is mapped. One of READONLY / PRIVATE / SHARED,
+ *        optionally or'ed with VEC_MAP_VERIFY.
+ *
+ *   VEC_MAP_READONLY - pages shared with the page cache; writing to the
+ *                      vector faults, so only pass it to non-inplace ops
+ *   VEC_MAP_PRIVATE  - copy-on-write: writes are allowed, touched pages get
+ *                      private copies and the file never changes
+ *   VEC_MAP_SHARED   - writes go to the file; vec_file_sync updates the
+ *                      header checksum and flushes them with msync
+ *   VEC_MAP_VERIFY   - check the checksum before returning. This reads the
+ *                      whole file, so it costs what mapping saves
+ *
+ * Nothing is read at map time beyond the header; pages come in on first
+ * touch (a 256 MiB file maps in under 0.1 ms, fread into a vector took
+ * ~360 ms here). The mapping is owned by the returned vector's allocator,
+ * so the usual vector_free / free_dvector / hvec_free / bvec_free unmaps it.
+ */
+typedef enum {
+    VEC_MAP_READONLY = 0,
+    VEC_MAP_PRIVATE = 1,
+    VEC_MAP_SHARED = 2,
+    VEC_MAP_VERIFY = 0x10
+} vec_map_mode_t;
+
+typedef enum {
+    VEC_FILE_OK = 0,
+    VEC_FILE_IO,                // open/read/write/mmap failed (see errno)
+    VEC_FILE_BAD_MAGIC,         // not a vector file
+    VEC_FILE_BAD_VERSION,       // written by a newer version
+    VEC_FILE_BAD_DTYPE,         // element type does not match the call
+    VEC_FILE_TRUNCATED,         // file shorter than the header says
+    VEC_FILE_CHECKSUM,          // VEC_MAP_VERIFY found corrupted data
+    VEC_FILE_TOO_LARGE,         // length does not fit the vector type
+    VEC_FILE_NOT_MAPPED,        // sync on a vector that is not a shared mapping
+    VEC_FILE_UNSUPPORTED,       // no mmap on this platform
+    VEC_FILE_BAD_HEADER         // alignment or data_offset out of range
+} vec_file_error_t;
+
+uint64_t vec_file_checksum(const void *data, size_t bytes); // Fletcher-64 over little-endian 32-bit words, zero padded
+vec_file_error_t vec_file_read_header(const char *path, vec_file_header_t *header); // Read and validate a header
+const char *vec_file_strerror(vec_file_error_t err); // Short description of an error code
+
+vec_file_error_t vec_file_write(const char *path, vector_t v, size_t alignment); // Write v (alignment 0 = VEC_FILE_ALIGN)
+vec_file_error_t dvec_file_write(const char *path, dvector_t v, size_t alignment); // Write a double vector
+vec_file_error_t hvec_file_write(const char *path, hvector_t v, size_t alignment); // Write a half vector
+vec_file_error_t bvec_file_write(const char *path, bvector_t v, size_t alignment); // Write a bfloat16 vector
+
+vector_t vec_file_map(const char *path, int mode, vec_file_error_t *err); // Map an f32 file; VEC_UNDEFINED on error (err may be NULL)
+dvector_t dvec_file_map(const char *path, int mode, vec_file_error_t *err); // Map an f64 file
+hvector_t hvec_file_map(const char *path, int mode, vec_file_error_t *err); // Map an f16 file
+bvector_t bvec_file_map(const char *path, int mode, vec_file_error_t *err); // Map a bf16 file
+
+vec_file_error_t vec_file_sync(vector_t v); // Write back a VEC_MAP_SHARED vector (checksum + msync)
+vec_file_error_t dvec_file_sync(dvector_t v); // Write back a shared double vector
+vec_file_error_t hvec_file_sync(hvector_t v); // Write back a shared half vector
+vec_file_error_t bvec_file_sync(bvector_t v); // Write back a shared bfloat16 vector
+
+#endif // VEC_FILE_H
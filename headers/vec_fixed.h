@@ -0,0 +1,148 @@
+#ifndef VEC_FIXED_H
+#define VEC_FIXED_H
+#include <cmath.h>
+#include <math_core.h>
+#include <vec.h>
+
+/*
+ * Fixed-size 2/3/4 component vectors passed by value. Nothing here touches
+ * the heap; all operations are static inline so they fold into the caller.
+ * Lengths use the correctly rounded sqrt (see sqrt_exact_f), not the fast
+ * approximations, so normalize() really returns unit vectors.
+ */
+
+typedef struct { float x, y; } vec2f_t;
+typedef struct { float x, y, z; } vec3f_t;
+typedef struct { float x, y, z, w; } vec4f_t;
+
+typedef struct { double x, y; } vec2d_t;
+typedef struct { double x, y, z; } vec3d_t;
+typedef struct { double x, y, z, w; } vec4d_t;
+
+/*
+ * Per-dimension generators: every type gets make/add/sub/mul/scale/neg/dot/
+ * length_sq/length/normalize/lerp. N is the type prefix (vec3f), T the
+ * scalar type and SQRT its exact square root.
+ */
+#define VEC_FIXED_COMMON_(N, T, SQRT)                                               \
+    static inline T N##_length_sq(N##_t a) { return N##_dot(a, a); }                \
+    static inline T N##_length(N##_t a) { return SQRT(N##_dot(a, a)); }             \
+    /* zero vectors are returned unchanged instead of becoming NaN */               \
+    static inline N##_t N##_normalize(N##_t a)                                      \
+    {                                                                               \
+        T len = N##_length(a);                                                      \
+        return len > (T)0 ? N##_scale(a, (T)1 / len) : a;                           \
+    }                                                                               \
+    static inline N##_t N##_lerp(N##_t a, N##_t b, T t)                             \
+    {                                                                               \
+        return N##_add(a, N##_scale(N##_sub(b, a), t));                             \
+    }
+
+#define VEC_FIXED_DEFINE2_(N, T, SQRT)                                              \
+    static inline N##_t N##_make(T x, T y) { N##_t r = { x, y }; return r; }        \
+    static inline N##_t N##_add(N##_t a, N##_t b) { return N##_make(a.x + b.x, a.y + b.y); } \
+    static inline N##_t N##_sub(N##_t a, N##_t b) { return N##_make(a.x - b.x, a.y - b.y); } \
+    static inline N##_t N##_mul(N##_t a, N##_t b) { return N##_make(a.x * b.x, a.y * b.y); } \
+    static inline N##_t N##_scale(N##_t a, T s) { return N##_make(a.x * s, a.y * s); }       \
+    static inline N##_t N##_neg(N##_t a) { return N##_make(-a.x, -a.y); }                     \
+    static inline T N##_dot(N##_t a, N##_t b) { return a.x * b.x + a.y * b.y; }               \
+    /* z component of the 3D cross product */                                       \
+    static inline T N##_cross(N##_t a, N##_t b) { return a.x * b.y - a.y * b.x; }             \
+    VEC_FIXED_COMMON_(N, T, SQRT)
+
+#define VEC_FIXED_DEFINE3_(N, T, SQRT)                                              \
+    static inline N##_t N##_make(T x, T y, T z) { N##_t r = { x, y, z }; return r; } \
+    static inline N##_t N##_add(N##_t a, N##_t b) { return N##_make(a.x + b.x, a.y + b.y, a.z + b.z); } \
+    static inline N##_t N##_sub(N##_t a, N##_t b) { return N##_make(a.x - b.x, a.y - b.y, a.z - b.z); } \
+    static inline N##_t N##_mul(N##_t a, N##_t b) { return N##_make(a.x * b.x, a.y * b.y, a.z * b.z); } \
+    static inline N##_t N##_scale(N##_t a, T s) { return N##_make(a.x * s, a.y * s, a.z * s); }         \
+    static inline N##_t N##_neg(N##_t a) { return N##_make(-a.x, -a.y, -a.z); }                          \
+    static inline T N##_dot(N##_t a, N##_t b) { return a.x * b.x + a.y * b.y + a.z * b.z; }               \
+    static inline N##_t N##_cross(N##_t a, N##_t b)                                 \
+    {                                                                               \
+        return N##_make(a.y * b.z - a.z * b.y,                                      \
+                        a.z * b.x - a.x * b.z,                                      \
+                        a.x * b.y - a.y * b.x);                                     \
+    }                                                                               \
+    VEC_FIXED_COMMON_(N, T, SQRT)
+
+#define VEC_FIXED_DEFINE4_(N, T, SQRT)                                              \
+    static inline N##_t N##_make(T x, T y, T z, T w) { N##_t r = { x, y, z, w }; return r; } \
+    static inline N##_t N##_add(N##_t a, N##_t b) { return N##_make(a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w); } \
+    static inline N##_t N##_sub(N##_t a, N##_t b) { return N##_make(a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w); } \
+    static inline N##_t N##_mul(N##_t a, N##_t b) { return N##_make(a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w); } \
+    static inline N##_t N##_scale(N##_t a, T s) { return N##_make(a.x * s, a.y * s, a.z * s, a.w * s); }           \
+    static inline N##_t N##_neg(N##_t a) { return N##_make(-a.x, -a.y, -a.z, -a.w); }                                \
+    static inline T N##_dot(N##_t a, N##_t b) { return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w; }             \
+    VEC_FIXED_COMMON_(N, T, SQRT)
+
+VEC_FIXED_DEFINE2_(vec2f, float, sqrt_exact_f)
+VEC_FIXED_DEFINE3_(vec3f, float, sqrt_exact_f)
+VEC_FIXED_DEFINE4_(vec4f, float, sqrt_exact_f)
+VEC_FIXED_DEFINE2_(vec2d, double, sqrt_exact_d)
+VEC_FIXED_DEFINE3_(vec3d, double, sqrt_exact_d)
+VEC_FIXED_DEFINE4_(vec4d, double, sqrt_exact_d)
+
+/**
+ * @brief Conversions to/from heap vectors. from_vector reads the first
+ *        components and zero-fills the rest if v is shorter.
+ */
+static inline vec3f_t vec3f_from_vector(vector_t v)
+{
+    vec3f_t r = { v.size > 0 ? v.data[0] : 0.0f,
+                  v.size > 1 ? v.data[1] : 0.0f,
+                  v.size > 2 ? v.data[2] : 0.0f };
+    return r;
+}
+
+static inline vector_t vec3f_to_vector(vec3f_t a)
+{
+    return vector_from_array(3, (const float[]){ a.x, a.y, a.z });
+}
+
+/**
+ * @brief Structure-of-arrays batch of 3-vectors: component i of element k is
+ *        stored at x[k], y[k], z[k]. The three arrays are carved from one
+ *        allocation of the active vec allocator, each 64-byte aligned.
+ *
+ * @members
+ *   count     - number of 3-vectors in the batch
+ *   x, y, z   - component arrays of `count` elements
+ *   block     - the underlying allocation (owned)
+ *   allocator - allocator that owns `block`
+**/
+typedef struct {
+    size_t count;
+    float *x;
+    float *y;
+    float *z;
+    void *block;
+    const vec_allocator_t *allocator;
+} vec3f_soa_t;
+
+typedef struct {
+    size_t count;
+    double *x;
+    double *y;
+    double *z;
+    void *block;
+    const vec_allocator_t *allocator;
+} vec3d_soa_t;
+
+vec3f_soa_t vec3f_soa_alloc(size_t count); // Allocate an uninitialized batch
+void vec3f_soa_free(vec3f_soa_t *v); // Free a batch
+vec3f_t vec3f_soa_get(const vec3f_soa_t *v, size_t i); // Read element i
+void vec3f_soa_set(vec3f_soa_t *v, size_t i, vec3f_t a); // Write element i
+void vec3f_soa_cross(vec3f_soa_t *dst, const vec3f_soa_t *a, const vec3f_soa_t *b); // dst[k] = a[k] x b[k] (dst may be a or b)
+void vec3f_soa_dot(float *dst, const vec3f_soa_t *a, const vec3f_soa_t *b); // dst[k] = a[k] . b[k]
+void vec3f_soa_magnitude(float *dst, const vec3f_soa_t *a); // dst[k] = |a[k]|
+void vec3f_soa_normalize(vec3f_soa_t *v); // v[k] = v[k] / |v[k]| in place (zero vectors untouched)
+
+vec3d_soa_t vec3d_soa_alloc(size_t count); // Allocate an uninitialized double batch
+void vec3d_soa_free(vec3d_soa_t *v); // Free a double batch
+void vec3d_soa_cross(vec3d_soa_t *dst, const vec3d_soa_t *a, const vec3d_soa_t *b); // dst[k] = a[k] x b[k] (dst may be a or b)
+void vec3d_soa_dot(double *dst, const vec3d_soa_t *a, const vec3d_soa_t *b); // dst[k] = a[k] . b[k]
+void vec3d_soa_magnitude(double *dst, const vec3d_soa_t *a); // dst[k] = |a[k]|
+void vec3d_soa_normalize(vec3d_soa_t *v); // v[k] = v[k] / |v[k]| in place (zero vectors untouched)
+
+#endif // VEC_FIXED_H
@@ -0,0 +1,94 @@
+#ifndef VEC_KNN_H
+#define VEC_KNN_H
+#include <cmath.h>
+#include <stddef.h>
+#include <vec.h>
+
+/*
+ * Collections of same-dimension vectors and exact k-nearest-neighbour
+ * search over them.
+ *
+ * Rows live in one VEC_ALIGN aligned block, each padded with zeros to
+ * `stride` floats (a multiple of VKNN_LANES), so the kernels run over whole
+ * registers with no tails. The squared norm of every row is kept next to
+ * it. All three metrics come out of one dot product per (query, row) pair,
+ * smaller meaning closer:
+ *
+ *   VKNN_L2      |q|^2 + |x|^2 - 2 q.x   squared Euclidean, clamped at 0
+ *   VKNN_IP      -q.x                    largest inner product first
+ *   VKNN_COSINE  1 - q.x / (|q| |x|)     1 when either is zero
+ *
+ * The dots are tiled like matrix_gemm: a block of VKNN_ROW_BLOCK rows stays
+ * in cache while every VKNN_QUERY_TILE queries are run against it, each row
+ * register loaded once per tile. Element d goes to lane d % VKNN_LANES and
+ * the lanes are added pairwise, so every SIMD level gives the same bits and
+ * a query's distances do not depend on the batch it is in.
+ *
+ * Top-k keeps a bounded max-heap per query; ties go to the lower index and
+ * NaN distances rank as +inf. Searches are split over the vec_parallel
+ * pool by queries and, when there are fewer queries than threads, by rows,
+ * the per-part heaps being merged at the end; the result does not depend on
+ * the split.
+ */
+
+#ifndef VKNN_LANES
+    #define VKNN_LANES 16           // dot accumulators and row padding (one AVX-512 register)
+#endif
+
+#ifndef VKNN_QUERY_TILE
+    #define VKNN_QUERY_TILE 4       // queries sharing each row load
+#endif
+
+#ifndef VKNN_ROW_BLOCK
+    #define VKNN_ROW_BLOCK 256      // rows kept in cache across the query tiles
+#endif
+
+typedef enum {
+    VKNN_L2,
+    VKNN_IP,
+    VKNN_COSINE
+} vknn_metric_t;
+
+/**
+ * @brief Vectors of one dimension in contiguous, aligned rows.
+ *
+ * @members
+ *   dim       - floats per vector
+ *   stride    - floats per row (dim rounded up to VKNN_LANES, zero padded)
+ *   count     - vectors stored
+ *   capacity  - rows the storage holds
+ *   data      - row i at data + i * stride, VEC_ALIGN aligned
+ *   norm2     - squared norm of every row
+ *   allocator - allocator that owns data and norm2
+**/
+typedef struct {
+    size_t dim;
+    size_t stride;
+    size_t count;
+    size_t capacity;
+    float *data;
+    float *norm2;
+    const vec_allocator_t *allocator;
+} vcoll_t;
+
+/**
+ * @brief One search result: a row of the collection and its distance.
+**/
+typedef struct {
+    size_t index;
+    float distance;
+} vknn_hit_t;
+
+extern const vcoll_t VCOLL_UNDEFINED;
+
+vcoll_t vcoll_alloc(size_t dim, size_t capacity); // Empty collection with room for `capacity` vectors; VCOLL_UNDEFINED on failure
+void vcoll_free(vcoll_t *c); // Return the storage to its allocator
+bool vcoll_push(vcoll_t *c, const float *v); // Append dim floats (grows); false if out of memory
+bool vcoll_push_vector(vcoll_t *c, vector_t v); // Append v; false if v.size != dim
+const float *vcoll_row(const vcoll_t *c, size_t i); // Row i (stride floats, zero padded); NULL if out of range
+
+bool vcoll_distances(const vcoll_t *c, vknn_metric_t metric, const float *query, float *out); // out[i] = distance of row i, count floats
+size_t vcoll_search(const vcoll_t *c, vknn_metric_t metric, const float *query, size_t k, vknn_hit_t *out); // k nearest, ascending; returns min(k, count)
+bool vcoll_search_batch(const vcoll_t *c, vknn_metric_t metric, const float *queries, size_t nq, size_t k, vknn_hit_t *out); // k hits per query (dim floats each) into out[q * k]; short rows end with {(size_t)-1, INFINITY}
+
+#endif // VEC_KNN_H
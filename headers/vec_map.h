@@ -0,0 +1,208 @@
+#ifndef VEC_MAP_H
+#define VEC_MAP_H
+#include <cmath.h>
+#include <stddef.h>
+#include <vec.h>
+#include <vec_parallel.h>
+
+/*
+ * Element-wise maps generated from an expression.
+ *
+ * vec_map and friends in vec.h take a function pointer, so every element
+ * costs an indirect call and the loop cannot be vectorized. The macros
+ * below instead stamp out a loop with the expression written into its
+ * body, which the compiler inlines and vectorizes like any hand-written
+ * kernel:
+ *
+ *     VEC_MAP_DEFINE(vec_softsign, x, x / (1.0f + fabsf(x)))
+ *     VEC_MAP3_DEFINE(vec_mix, a, b, t, a + t * (b - a))
+ *
+ *     vector_t r = vec_softsign(v);       // new vector
+ *     vec_mix_to(&a, b, t);               // in place, into the first operand
+ *     vec_softsign_array(dst, src, n);    // raw arrays, serial
+ *
+ * Each VEC_MAPn_DEFINE(name, params..., expr) defines, as static inline
+ * functions in the including file:
+ *
+ *   name##_array(dst, p1..pn, n)  - the serial loop; dst may be any input
+ *   name##_chunk(ctx, begin, end) - the loop as a vec_parallel_fn
+ *   name(v, v2..vn)               - map into a new vector
+ *   name##_to(&v, v2..vn)         - map into v
+ *
+ * The vector forms split inputs of at least vec_parallel_threshold()
+ * elements over the vec_parallel pool. Operands of different sizes give
+ * VEC_UNDEFINED (or leave v untouched). VEC_MAP_SCALAR_DEFINE(name, x, s,
+ * expr) maps one vector with a float s passed at the call, like
+ * vec_map_scalar.
+ *
+ * The expression is evaluated exactly as written, so a generated map gives
+ * the same bits as the function-pointer form called with a function
+ * returning that expression.
+ */
+
+// the loop writes dst[i] from the inputs at i only, so dst may alias them
+#if defined(__clang__)
+    #define VEC_MAP_IVDEP_ _Pragma("clang loop vectorize(assume_safety)")
+#elif defined(__GNUC__)
+    #define VEC_MAP_IVDEP_ _Pragma("GCC ivdep")
+#else
+    #define VEC_MAP_IVDEP_
+#endif
+
+#define VEC_MAP_ID_(...) __VA_ARGS__
+
+/**
+ * @brief Operands of one map call, handed to the generated chunk function.
+ *
+ * @members
+ *   dst - output array
+ *   in  - input arrays, in parameter order
+ *   s   - scalar operand of VEC_MAP_SCALAR_DEFINE maps
+ *   fn  - the function of the vec.h function-pointer forms
+**/
+typedef struct {
+    float *dst;
+    const float *in[5];
+    float s;
+    void (*fn)(void);
+} vec_map_ctx_t;
+
+/*
+ * The vector front ends of every arity: `params` declares the operands
+ * after v (with a leading comma), `same` checks their sizes against v and
+ * `fill` stores them into the context c. The function-pointer forms in
+ * vec_map.c use it too, with external linkage.
+ */
+#define VEC_MAP_FRONT_(storage, name, params, same, fill)                       \
+storage vector_t name(vector_t v VEC_MAP_ID_ params)                            \
+{                                                                               \
+    if (!(same)) return VEC_UNDEFINED;                                          \
+    vector_t r = vector_alloc(v.size);                                          \
+    if (!r.data && v.size) return VEC_UNDEFINED;                                \
+    vec_map_ctx_t c = { r.data, { v.data }, 0.0f, NULL };                       \
+    fill;                                                                       \
+    vec_parallel_for(v.size, name##_chunk, &c);                                 \
+    return r;                                                                   \
+}                                                                               \
+storage void name##_to(vector_t *dst VEC_MAP_ID_ params)                        \
+{                                                                               \
+    vector_t v = *dst;                                                          \
+    if (!(same)) return;                                                        \
+    vec_map_ctx_t c = { v.data, { v.data }, 0.0f, NULL };                       \
+    fill;                                                                       \
+    vec_parallel_for(v.size, name##_chunk, &c);                                 \
+}
+
+#define VEC_MAP_DEFINE(name, x, expr)                                           \
+static inline void name##_array(float *dst, const float *x##_in, size_t n)      \
+{                                                                               \
+    VEC_MAP_IVDEP_                                                              \
+    for (size_t i_ = 0; i_ < n; i_++) {                                         \
+        const float x = x##_in[i_];                                             \
+        dst[i_] = (expr);                                                       \
+    }                                                                           \
+}                                                                               \
+static inline void name##_chunk(void *ctx, size_t begin, size_t end)            \
+{                                                                               \
+    const vec_map_ctx_t *c = (const vec_map_ctx_t *)ctx;                        \
+    name##_array(c->dst + begin, c->in[0] + begin, end - begin);                \
+}                                                                               \
+VEC_MAP_FRONT_(static inline, name, (), true, (void)0)
+
+#define VEC_MAP_SCALAR_DEFINE(name, x, s, expr)                                 \
+static inline void name##_array(float *dst, const float *x##_in, float s, size_t n) \
+{                                                                               \
+    VEC_MAP_IVDEP_                                                              \
+    for (size_t i_ = 0; i_ < n; i_++) {                                         \
+        const float x = x##_in[i_];                                             \
+        dst[i_] = (expr);                                                       \
+    }                                                                           \
+}                                                                               \
+static inline void name##_chunk(void *ctx, size_t begin, size_t end)            \
+{                                                                               \
+    const vec_map_ctx_t *c = (const vec_map_ctx_t *)ctx;                        \
+    name##_array(c->dst + begin, c->in[0] + begin, c->s, end - begin);          \
+}                                                                               \
+VEC_MAP_FRONT_(static inline, name, (, float scalar), true, c.s = scalar)
+
+#define VEC_MAP2_DEFINE(name, x, y, expr)                                       \
+static inline void name##_array(float *dst, const float *x##_in, const float *y##_in, size_t n) \
+{                                                                               \
+    VEC_MAP_IVDEP_                                                              \
+    for (size_t i_ = 0; i_ < n; i_++) {                                         \
+        const float x = x##_in[i_], y = y##_in[i_];                             \
+        dst[i_] = (expr);                                                       \
+    }                                                                           \
+}                                                                               \
+static inline void name##_chunk(void *ctx, size_t begin, size_t end)            \
+{                                                                               \
+    const vec_map_ctx_t *c = (const vec_map_ctx_t *)ctx;                        \
+    name##_array(c->dst + begin, c->in[0] + begin, c->in[1] + begin, end - begin); \
+}                                                                               \
+VEC_MAP_FRONT_(static inline, name, (, vector_t v2), v2.size == v.size,         \
+               c.in[1] = v2.data)
+
+#define VEC_MAP3_DEFINE(name, x, y, z, expr)                                    \
+static inline void name##_array(float *dst, const float *x##_in, const float *y##_in, \
+                                const float *z##_in, size_t n)                  \
+{                                                                               \
+    VEC_MAP_IVDEP_                                                              \
+    for (size_t i_ = 0; i_ < n; i_++) {                                         \
+        const float x = x##_in[i_], y = y##_in[i_], z = z##_in[i_];             \
+        dst[i_] = (expr);                                                       \
+    }                                                                           \
+}                                                                               \
+static inline void name##_chunk(void *ctx, size_t begin, size_t end)            \
+{                                                                               \
+    const vec_map_ctx_t *c = (const vec_map_ctx_t *)ctx;                        \
+    name##_array(c->dst + begin, c->in[0] + begin, c->in[1] + begin,            \
+                 c->in[2] + begin, end - begin);                                \
+}                                                                               \
+VEC_MAP_FRONT_(static inline, name, (, vector_t v2, vector_t v3),               \
+               v2.size == v.size && v3.size == v.size,                          \
+               (c.in[1] = v2.data, c.in[2] = v3.data))
+
+#define VEC_MAP4_DEFINE(name, x, y, z, w, expr)                                 \
+static inline void name##_array(float *dst, const float *x##_in, const float *y##_in, \
+                                const float *z##_in, const float *w##_in, size_t n) \
+{                                                                               \
+    VEC_MAP_IVDEP_                                                              \
+    for (size_t i_ = 0; i_ < n; i_++) {                                         \
+        const float x = x##_in[i_], y = y##_in[i_], z = z##_in[i_], w = w##_in[i_]; \
+        dst[i_] = (expr);                                                       \
+    }                                                                           \
+}                                                                               \
+static inline void name##_chunk(void *ctx, size_t begin, size_t end)            \
+{                                                                               \
+    const vec_map_ctx_t *c = (const vec_map_ctx_t *)ctx;                        \
+    name##_array(c->dst + begin, c->in[0] + begin, c->in[1] + begin,            \
+                 c->in[2] + begin, c->in[3] + begin, end - begin);              \
+}                                                                               \
+VEC_MAP_FRONT_(static inline, name, (, vector_t v2, vector_t v3, vector_t v4),  \
+               v2.size == v.size && v3.size == v.size && v4.size == v.size,     \
+               (c.in[1] = v2.data, c.in[2] = v3.data, c.in[3] = v4.data))
+
+#define VEC_MAP5_DEFINE(name, x, y, z, w, u, expr)                              \
+static inline void name##_array(float *dst, const float *x##_in, const float *y##_in, \
+                                const float *z##_in, const float *w##_in,       \
+                                const float *u##_in, size_t n)                  \
+{                                                                               \
+    VEC_MAP_IVDEP_                                                              \
+    for (size_t i_ = 0; i_ < n; i_++) {                                         \
+        const float x = x##_in[i_], y = y##_in[i_], z = z##_in[i_], w = w##_in[i_], \
+                    u = u##_in[i_];                                             \
+        dst[i_] = (expr);                                                       \
+    }                                                                           \
+}                                                                               \
+static inline void name##_chunk(void *ctx, size_t begin, size_t end)            \
+{                                                                               \
+    const vec_map_ctx_t *c = (const vec_map_ctx_t *)ctx;                        \
+    name##_array(c->dst + begin, c->in[0] + begin, c->in[1] + begin,            \
+                 c->in[2] + begin, c->in[3] + begin, c->in[4] + begin, end - begin); \
+}                                                                               \
+VEC_MAP_FRONT_(static inline, name, (, vector_t v2, vector_t v3, vector_t v4, vector_t v5), \
+               v2.size == v.size && v3.size == v.size && v4.size == v.size      \
+               && v5.size == v.size,                                            \
+               (c.in[1] = v2.data, c.in[2] = v3.data, c.in[3] = v4.data, c.in[4] = v5.data))
+
+#endif // VEC_MAP_H
@@ -0,0 +1,72 @@
+#ifndef VEC_PARALLEL_H
+#define VEC_PARALLEL_H
+#include <cmath.h>
+#include <vec_simd.h>
+
+/**
+ * @brief Opt-in multithreading for the vec.c operations.
+ *
+ * Nothing runs in parallel until vec_parallel_init starts the pool. After
+ * that, element-wise ops, scalar ops and the reductions (vector_dot,
+ * vector_magnitude, vector_sum, vector_equals and their dvec_* counterparts)
+ * on vectors of at least vec_parallel_threshold() elements are split into
+ * VEC_PARALLEL_CHUNK element chunks and spread over a persistent pool of
+ * worker threads. The calling thread works too. Each worker starts on its own contiguous share
+ * of the chunks and steals half of another worker's remaining share when
+ * it runs dry.
+ *
+ * Reductions always sum per-chunk partials in a fixed pairwise order, in
+ * serial mode too, so their results do not depend on the thread count or
+ * on whether the pool is running.
+ *
+ * Only one parallel operation runs at a time. A call made while another
+ * thread owns the pool, or from inside a chunk, runs serially instead.
+**/
+
+#ifndef VEC_PARALLEL_CHUNK
+    #define VEC_PARALLEL_CHUNK 16384        // elements per chunk (64 KiB of floats per stream)
+#endif
+
+#ifndef VEC_PARALLEL_THRESHOLD
+    #define VEC_PARALLEL_THRESHOLD 262144   // default serial cut-off in elements
+#endif
+
+#ifndef VEC_PARALLEL_MAX_THREADS
+    #define VEC_PARALLEL_MAX_THREADS 256
+#endif
+
+/**
+ * @brief Pairwise (cascade) summation of partials fed in order: equal sized
+ *        subtrees are merged as soon as both exist, the leftovers are folded
+ *        right to left at the end. vec_parallel_reduce sums its chunk
+ *        partials this way; feeding it the results of vec_parallel_reduce
+ *        over consecutive blocks of VEC_PARALLEL_CHUNK * 2^k elements gives
+ *        the same bits as one call over the whole range.
+**/
+typedef struct {
+    double sum[64];
+    unsigned char level[64];
+    int top;
+} vec_cascade_t;
+
+typedef void (*vec_parallel_fn)(void *ctx, size_t begin, size_t end);
+typedef double (*vec_parallel_reduce_fn)(void *ctx, size_t begin, size_t end);
+
+bool vec_parallel_init(unsigned int threads); // Start the pool; 0 = $CMATH_THREADS or all online CPUs
+void vec_parallel_shutdown(void); // Stop and join the pool; later calls run serially
+unsigned int vec_parallel_threads(void); // Threads working on a parallel call (1 when the pool is off)
+unsigned int vec_parallel_worker(void); // Calling thread's index in the pool (< VEC_PARALLEL_MAX_THREADS; 0 off the pool)
+void vec_parallel_set_threshold(size_t elements); // Run serially below this many elements
+size_t vec_parallel_threshold(void); // Current serial cut-off
+
+void vec_parallel_for(size_t n, vec_parallel_fn fn, void *ctx); // fn over [0, n) in chunks, in parallel when enabled
+void vec_parallel_tasks(size_t tasks, vec_parallel_fn fn, void *ctx); // fn over tasks [t, t+1) in parallel when enabled, no threshold
+double vec_parallel_reduce(size_t n, vec_parallel_reduce_fn fn, void *ctx); // Deterministic pairwise sum of fn over the chunks of [0, n)
+void vec_parallel_binary(vec_binary_kernel_f k, float *dst, const float *a, const float *b, size_t n); // k split over the pool
+void vec_parallel_scalar(vec_scalar_kernel_f k, float *dst, const float *a, float s, size_t n); // k split over the pool
+void vec_parallel_dbinary(vec_dbinary_kernel_f k, double *dst, const double *a, const double *b, size_t n); // double k split over the pool
+void vec_parallel_dscalar(vec_dscalar_kernel_f k, double *dst, const double *a, double s, size_t n); // double k split over the pool
+void vec_cascade_push(vec_cascade_t *c, double v); // Add the next partial
+double vec_cascade_finish(const vec_cascade_t *c); // Sum of everything pushed (0 if nothing)
+
+#endif // VEC_PARALLEL_H
@@ -0,0 +1,82 @@
+#ifndef VEC_QUAT_H
+#define VEC_QUAT_H
+#include <cmath.h>
+#include <stddef.h>
+#include <vec.h>
+#include <vec_xform.h>
+
+/*
+ * Rotations as unit quaternions and 3x3 matrices.
+ *
+ * Angles are in radians; a positive angle turns counterclockwise when the
+ * axis points at the viewer (right-handed). Angles are converted once, with
+ * fast_sincosf_poly (math_core.h), when a quaternion is built; rotating
+ * then costs only multiplies and adds. Rotating a batch by one quaternion
+ * turns it into a matrix and runs the vec_xform.h direction kernels, in
+ * place. The per-element batches (_soa) process the arrays in blocks of
+ * QUAT_BLOCK: the angles of a block go through fast_sincosf_poly_array in
+ * one call, the rest is straight-line arithmetic, so each element gets
+ * exactly the bits of the single-quaternion function at every SIMD level.
+ * Batches of at least vec_parallel_threshold() elements use the pool.
+ *
+ * quat_from_euler(pitch, yaw, roll) rotates by roll about z first, then
+ * pitch about x, then yaw about y: q = qy(yaw) * qx(pitch) * qz(roll).
+ */
+
+#ifndef QUAT_BLOCK
+    #define QUAT_BLOCK 256              // elements per block of the _soa kernels (stays in L1)
+#endif
+
+#ifndef QUAT_SLERP_LINEAR
+    #define QUAT_SLERP_LINEAR 0.9995f   // |cos| above which slerp falls back to nlerp
+#endif
+
+/**
+ * @brief Quaternion w + xi + yj + zk. Rotations use unit quaternions.
+ */
+typedef struct {
+    float x;
+    float y;
+    float z;
+    float w;
+} quat_t;
+
+/**
+ * @brief 3x3 rotation matrix, row-major, acting on column vectors.
+ */
+typedef struct {
+    float m[9];
+} rot3_t;
+
+/**
+ * @brief Quaternions as four parallel arrays (structure of arrays).
+ */
+typedef struct {
+    float *x;
+    float *y;
+    float *z;
+    float *w;
+} quat_soa_t;
+
+quat_t quat_identity(void); // (0, 0, 0, 1)
+quat_t quat_from_axis_angle(float x, float y, float z, float angle); // Rotation about (x, y, z) (any length; zero gives the identity)
+quat_t quat_from_euler(float pitch, float yaw, float roll); // qy(yaw) * qx(pitch) * qz(roll)
+quat_t quat_from_rot3(const rot3_t *r); // Unit quaternion of a rotation matrix
+quat_t quat_mul(quat_t a, quat_t b); // Rotation b, then a
+quat_t quat_conjugate(quat_t q); // Inverse of a unit quaternion
+quat_t quat_normalize(quat_t q); // Unit length (identity for a zero quaternion)
+float quat_dot(quat_t a, quat_t b); // 4D dot product
+quat_t quat_nlerp(quat_t a, quat_t b, float t); // Normalized lerp along the shorter arc
+quat_t quat_slerp(quat_t a, quat_t b, float t); // Spherical lerp along the shorter arc (nlerp when nearly equal)
+rot3_t rot3_from_quat(quat_t q); // Rotation matrix of a unit quaternion
+void quat_rotate_point(quat_t q, float *v); // Rotate one xyz triple in place
+
+void quat_rotate_aos(quat_t q, float *v, size_t n); // Rotate n AoS xyz triples in place
+void quat_rotate_soa(quat_t q, vec3_soa_t v, size_t n); // Rotate n SoA vectors in place
+void rot3_rotate_soa(const rot3_t *r, vec3_soa_t v, size_t n); // Same with a matrix
+void quat_rotate_each_soa(quat_soa_t q, vec3_soa_t v, size_t n); // v[i] rotated by q[i], in place
+void quat_from_axis_angle_soa(quat_soa_t dst, vec3_soa_t axis, const float *angle, size_t n); // dst[i] = quat_from_axis_angle(axis[i], angle[i])
+void quat_nlerp_soa(quat_soa_t dst, quat_soa_t a, quat_soa_t b, float t, size_t n); // dst[i] = quat_nlerp(a[i], b[i], t) (dst may be a or b)
+void quat_slerp_soa(quat_soa_t dst, quat_soa_t a, quat_soa_t b, float t, size_t n); // dst[i] = quat_slerp(a[i], b[i], t) (dst may be a or b)
+
+#endif // VEC_QUAT_H
@@ -0,0 +1,129 @@
+#ifndef VEC_SIMD_H
+#define VEC_SIMD_H
+#include <cmath.h>
+#include <stddef.h>
+
+/**
+ * @brief Instruction set levels the element-wise kernels are built for.
+ *        Ordered, so `a >= VEC_ISA_AVX2` means "AVX2 or better".
+ */
+typedef enum {
+    VEC_ISA_SCALAR = 0,
+    VEC_ISA_SSE2,
+    VEC_ISA_AVX2,
+    VEC_ISA_AVX512,
+    VEC_ISA_COUNT
+} vec_isa_t;
+
+typedef void (*vec_binary_kernel_f)(float *dst, const float *a, const float *b, size_t n);
+typedef void (*vec_scalar_kernel_f)(float *dst, const float *a, float s, size_t n);
+typedef float (*vec_dot_kernel_f)(const float *a, const float *b, size_t n);
+typedef double (*vec_dot_comp_kernel_f)(const float *a, const float *b, size_t n);
+typedef float (*vec_dot_scaled_kernel_f)(const float *a, const float *b, float sa, float sb, size_t n);
+typedef float (*vec_maxabs_kernel_f)(const float *a, size_t n);
+typedef float (*vec_sum_kernel_f)(const float *a, size_t n);
+typedef void (*vec_gather_kernel_f)(float *dst, const float *src, ptrdiff_t stride, size_t n);
+typedef void (*vec_scatter_kernel_f)(float *dst, ptrdiff_t stride, const float *src, size_t n);
+
+typedef void (*vec_dbinary_kernel_f)(double *dst, const double *a, const double *b, size_t n);
+typedef void (*vec_dscalar_kernel_f)(double *dst, const double *a, double s, size_t n);
+typedef double (*vec_ddot_kernel_f)(const double *a, const double *b, size_t n);
+typedef double (*vec_ddot_scaled_kernel_f)(const double *a, const double *b, double sa, double sb, size_t n);
+typedef double (*vec_dmaxabs_kernel_f)(const double *a, size_t n);
+typedef double (*vec_dsum_kernel_f)(const double *a, size_t n);
+typedef void (*vec_dgather_kernel_f)(double *dst, const double *src, ptrdiff_t stride, size_t n);
+typedef void (*vec_dscatter_kernel_f)(double *dst, ptrdiff_t stride, const double *src, size_t n);
+
+#ifndef VEC_REDUCE_LANES
+    #define VEC_REDUCE_LANES 32     // independent accumulators of the reduction kernels
+#endif
+
+/**
+ * @brief Table of element-wise float kernels for one instruction set.
+ *
+ * Every kernel computes dst[i] = a[i] OP b[i] (or a[i] OP s) for i < n with
+ * exactly one IEEE operation per element, so all levels are bit-identical to
+ * the scalar reference. `dst` may be exactly `a` or `b` (in-place forms);
+ * partial overlaps are not allowed. Aligned loads/stores are used when dst
+ * and the sources share an alignment, otherwise unaligned ones; the tail is
+ * handled in-kernel.
+ *
+ * The reductions spread element i over accumulator i % VEC_REDUCE_LANES
+ * (one to eight registers, depending on the level) and add the
+ * accumulators pairwise at the end. The lane layout is the same on every
+ * level, so reductions are bit-identical across levels too.
+ *
+ *   dot             - sum of a[i]*b[i] in float.
+ *                     |error| <= (n/32 + 6) * 2^-24 * sum |a[i]*b[i]|
+ *   dot_compensated - per-lane TwoSum error terms (Neumaier-style),
+ *                     lanes combined in double. |error| <= 2^-24 * sum
+ *                     |a[i]*b[i]| (rounding of the products) + 2^-53 *
+ *                     |result| + O(n * 2^-48) * sum |a[i]*b[i]|
+ *   dot_scaled      - sum of (a[i]*sa)*(b[i]*sb), used with power-of-two
+ *                     scales to keep the products in range
+ *   maxabs          - max |a[i]| (NaNs are not guaranteed to propagate)
+ *   sum             - sum of a[i], same lanes and bound as dot
+ *
+ * The strided copies move elements between a strided and a contiguous
+ * buffer (strides in elements, may be negative or zero):
+ *
+ *   gather          - dst[i] = src[i * stride] (AVX2 / AVX-512 gathers)
+ *   scatter         - dst[i * stride] = src[i], in increasing i, so the
+ *                     last write wins if elements alias (AVX-512 scatters)
+**/
+typedef struct {
+    vec_isa_t isa;
+    vec_binary_kernel_f add;
+    vec_binary_kernel_f sub;
+    vec_binary_kernel_f mul;
+    vec_binary_kernel_f div;
+    vec_scalar_kernel_f scalar_add;
+    vec_scalar_kernel_f scalar_sub;
+    vec_scalar_kernel_f scalar_mul;
+    vec_scalar_kernel_f scalar_div;
+    vec_dot_kernel_f dot;
+    vec_dot_comp_kernel_f dot_compensated;
+    vec_dot_scaled_kernel_f dot_scaled;
+    vec_maxabs_kernel_f maxabs;
+    vec_sum_kernel_f sum;
+    vec_gather_kernel_f gather;
+    vec_scatter_kernel_f scatter;
+} vec_kernels_t;
+
+/**
+ * @brief The same kernel set for double, generated from the same templates
+ *        (same lane layout, same bit-exactness across levels). The error
+ *        bounds are those of vec_kernels_t with 2^-53 for 2^-24; for
+ *        dot_compensated, whose lanes are TwoSum-combined, that is 2^-53 *
+ *        sum |a[i]*b[i]| + 2^-53 * |result| + O(n * 2^-106) * sum |a[i]*b[i]|.
+**/
+typedef struct {
+    vec_isa_t isa;
+    vec_dbinary_kernel_f add;
+    vec_dbinary_kernel_f sub;
+    vec_dbinary_kernel_f mul;
+    vec_dbinary_kernel_f div;
+    vec_dscalar_kernel_f scalar_add;
+    vec_dscalar_kernel_f scalar_sub;
+    vec_dscalar_kernel_f scalar_mul;
+    vec_dscalar_kernel_f scalar_div;
+    vec_ddot_kernel_f dot;
+    vec_ddot_kernel_f dot_compensated;
+    vec_ddot_scaled_kernel_f dot_scaled;
+    vec_dmaxabs_kernel_f maxabs;
+    vec_dsum_kernel_f sum;
+    vec_dgather_kernel_f gather;
+    vec_dscatter_kernel_f scatter;
+} vec_dkernels_t;
+
+vec_isa_t vec_isa_detect(void); // Best level supported by this CPU and build
+vec_isa_t vec_isa_active(void); // Level currently used by vec.c
+bool vec_isa_select(vec_isa_t isa); // Force a level (e.g. for testing); false if unsupported
+const char *vec_isa_name(vec_isa_t isa); // "scalar", "sse2", "avx2", "avx512"
+
+const vec_kernels_t *vec_kernels(void); // Kernels for the active level
+const vec_kernels_t *vec_kernels_for(vec_isa_t isa); // Kernels for a level, NULL if unsupported
+const vec_dkernels_t *vec_dkernels(void); // Double kernels for the active level
+const vec_dkernels_t *vec_dkernels_for(vec_isa_t isa); // Double kernels for a level, NULL if unsupported
+
+#endif // VEC_SIMD_H
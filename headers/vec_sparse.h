@@ -0,0 +1,74 @@
+#ifndef VEC_SPARSE_H
+#define VEC_SPARSE_H
+#include <cmath.h>
+#include <stddef.h>
+#include <vec.h>
+
+/*
+ * Sparse vectors: the nonzeros of a `size` element vector as sorted
+ * indices plus values, so the kernels cost O(nnz) instead of O(size).
+ *
+ *   svec_dot_dense   - gathers v[index[k]] (AVX2 / AVX-512 gathers)
+ *   svec_dot         - walks the two index lists together, galloping
+ *                      through the longer one when the other is much
+ *                      shorter (SVEC_GALLOP times or more)
+ *   svec_add         - merges the two lists into a new vector
+ *   svec_scatter_add - dst[index[k]] += alpha * value[k] (AVX-512 scatters)
+ *
+ * The dots multiply and add the matching pairs in float, pair k in lane
+ * k % SVEC_LANES, lanes added pairwise, like the vec_simd.h reductions, so
+ * every SIMD level gives the same bits. Large svec_dot_dense and
+ * svec_scatter_add calls are split over the vec_parallel pool; the dense
+ * dot's chunk partials are summed as vector_dot's are.
+ *
+ * Indices are strictly increasing and below `size`, which is at most
+ * SVEC_MAX_SIZE (the gathers take signed 32-bit indices). Storage is one
+ * block from the thread's active allocator (see vec_alloc.h), indices
+ * first, and returns to the same allocator.
+ */
+
+#ifndef SVEC_LANES
+    #define SVEC_LANES 16           // accumulators of the sparse dots (one AVX-512 register)
+#endif
+
+#ifndef SVEC_GALLOP
+    #define SVEC_GALLOP 8           // nnz ratio from which svec_dot gallops
+#endif
+
+#define SVEC_MAX_SIZE 0x7fffffffu
+
+/**
+ * @brief Sparse float vector.
+ *
+ * @members
+ *   size      - logical (dense) length
+ *   nnz       - stored entries
+ *   index     - positions of the entries, strictly increasing
+ *   value     - their values
+ *   capacity  - entries the storage holds
+ *   allocator - allocator that owns the storage
+**/
+typedef struct {
+    size_t size;
+    size_t nnz;
+    uint32_t *index;
+    float *value;
+    size_t capacity;
+    const vec_allocator_t *allocator;
+} svector_t;
+
+extern const svector_t SVEC_UNDEFINED;
+
+svector_t svec_alloc(size_t size, size_t capacity); // Empty sparse vector with room for `capacity` entries; SVEC_UNDEFINED on failure
+void svec_free(svector_t *s); // Return the storage to its allocator
+bool svec_push(svector_t *s, uint32_t index, float value); // Append an entry past the last one (grows); false if out of order / range
+svector_t svec_from_dense(vector_t v); // The entries of v that are not == 0
+svector_t svec_from_arrays(size_t size, const uint32_t *index, const float *value, size_t nnz); // Copy; SVEC_UNDEFINED unless indices increase and fit
+vector_t svec_to_dense(svector_t s); // Dense copy (zeros elsewhere)
+
+float svec_dot_dense(svector_t s, vector_t v); // Sum of value[k] * v[index[k]]; 0 if the sizes differ
+float svec_dot(svector_t a, svector_t b); // Sum over the common indices; 0 if the sizes differ
+svector_t svec_add(svector_t a, svector_t b); // Merged sum (entries of both); SVEC_UNDEFINED if the sizes differ
+bool svec_scatter_add(vector_t dst, float alpha, svector_t s); // dst[index[k]] += alpha * value[k]; false if the sizes differ
+
+#endif // VEC_SPARSE_H
@@ -0,0 +1,147 @@
+#ifndef VEC_STATS_H
+#define VEC_STATS_H
+#include <cmath.h>
+#include <stddef.h>
+
+/*
+ * Per-function counters for the vec.c API: calls, elements processed,
+ * bytes allocated and freed, and optionally time spent.
+ *
+ * The layer is compiled in only when the library is built with VEC_STATS
+ * defined to 1 (cmake -DCMATH_STATS=ON); otherwise the hooks expand to
+ * nothing, the hot paths are exactly the uninstrumented code, and the
+ * functions below report no data. VEC_STATS_TIMING=1 (-DCMATH_STATS_TIMING=ON)
+ * also totals ticks per function: the time stamp counter on x86, else
+ * CLOCK_MONOTONIC nanoseconds. Ticks are inclusive (vector_dot counts the
+ * vec_view_dot_ex it calls too) and need a compiler with
+ * __attribute__((cleanup)), GCC or Clang.
+ *
+ * Every thread counts into its own buffer, so instrumented calls never
+ * contend; vec_stats_snapshot and the dumps merge the buffers of all
+ * threads that have made an instrumented call. Buffers are never freed
+ * (pool workers live for the whole process). Bytes moved into new buffers
+ * by the growth functions are counted under vector_move / dvec_move.
+ */
+
+#ifndef VEC_STATS
+    #define VEC_STATS 0
+#endif
+
+#ifndef VEC_STATS_TIMING
+    #define VEC_STATS_TIMING 0
+#endif
+
+/*
+ * The instrumented functions, X(name). Add a name here and a
+ * VEC_STATS_SCOPE(name, elements) at the top of its body.
+ */
+#define VEC_STATS_FUNCS(X)                                                      \
+    X(vector_alloc) X(vector_free) X(vector_create) X(vector_from_array)        \
+    X(vector_copy) X(vector_default) X(vector_equals)                           \
+    X(vector_scalar_add) X(vector_scalar_add_inplace)                           \
+    X(vector_scalar_sub) X(vector_scalar_sub_inplace)                           \
+    X(vector_scalar_mul) X(vector_scalar_mul_inplace)                           \
+    X(vector_scalar_div) X(vector_scalar_div_inplace)                           \
+    X(vector_pow) X(vector_pow_inplace)                                         \
+    X(vector_add) X(vector_add_inplace) X(vector_sub) X(vector_sub_inplace)     \
+    X(vector_mul) X(vector_mul_inplace) X(vector_div) X(vector_div_inplace)     \
+    X(vec_view_dot_ex) X(vector_dot_ex) X(vector_dot) X(vector_cross)           \
+    X(vec_view_magnitude) X(vec_view_magnitude_ex)                              \
+    X(vector_magnitude) X(vector_magnitude_ex)                                  \
+    X(vec_view_sum) X(vec_view_sum_ex) X(vector_sum)                            \
+    X(vector_reserve) X(vector_push) X(vector_append) X(vector_shrink)          \
+    X(vector_move)                                                              \
+    X(allocate_d) X(free_dvector) X(dvec_create) X(dvec_create_from_array)      \
+    X(dvec_copy) X(dvec_default) X(dvec_equals)                                 \
+    X(dvec_scalar_add) X(dvec_scalar_add_inplace)                               \
+    X(dvec_scalar_sub) X(dvec_scalar_sub_inplace)                               \
+    X(dvec_scalar_mul) X(dvec_scalar_mul_inplace)                               \
+    X(dvec_scalar_div) X(dvec_scalar_div_inplace)                               \
+    X(dvec_pow) X(dvec_pow_inplace)                                             \
+    X(dvec_add) X(dvec_add_inplace) X(dvec_sub) X(dvec_sub_inplace)             \
+    X(dvec_mul) X(dvec_mul_inplace) X(dvec_div) X(dvec_div_inplace)             \
+    X(dvec_view_dot_ex) X(dvec_dot_ex) X(dvec_dot) X(dvec_cross)                \
+    X(dvec_view_magnitude) X(dvec_view_magnitude_ex)                            \
+    X(dvec_magnitude) X(dvec_magnitude_ex)                                      \
+    X(dvec_view_sum) X(dvec_view_sum_ex) X(dvec_sum)                            \
+    X(dvec_reserve) X(dvec_push) X(dvec_append) X(dvec_shrink)                  \
+    X(dvec_move)
+
+#define VEC_STATS_ENUM_(name) VEC_STATS_ID_##name,
+
+/**
+ * @brief Index of an instrumented function in a vec_stats_snapshot array.
+ */
+typedef enum {
+    VEC_STATS_FUNCS(VEC_STATS_ENUM_)
+    VEC_STATS_COUNT
+} vec_stats_id_t;
+
+/**
+ * @brief Merged counters of one function.
+ *
+ * @members
+ *   calls           - number of calls
+ *   elements        - elements processed (the size of the first operand)
+ *   bytes_allocated - bytes requested from the allocators
+ *   bytes_freed     - bytes handed back to the allocators
+ *   ticks           - time inside the function (0 unless VEC_STATS_TIMING)
+**/
+typedef struct {
+    uint64_t calls;
+    uint64_t elements;
+    uint64_t bytes_allocated;
+    uint64_t bytes_freed;
+    uint64_t ticks;
+} vec_stats_entry_t;
+
+typedef enum {
+    VEC_STATS_TABLE = 0,    // aligned text table, one row per called function
+    VEC_STATS_JSON          // one JSON object
+} vec_stats_format_t;
+
+bool vec_stats_enabled(void); // The library was built with VEC_STATS
+bool vec_stats_timing(void); // Ticks are recorded
+const char *vec_stats_tick_unit(void); // "tsc", "ns" or "none"
+const char *vec_stats_name(vec_stats_id_t id); // Function name of a counter row
+void vec_stats_snapshot(vec_stats_entry_t *out); // out[VEC_STATS_COUNT] = counters of all threads, merged
+void vec_stats_reset(void); // Zero every thread's counters (while no instrumented call runs)
+void vec_stats_dump(FILE *out, vec_stats_format_t format); // Write the merged counters of the called functions
+
+/*
+ * Hooks for the instrumented sources. VEC_STATS_SCOPE opens the counting
+ * of one call (a declaration, so at the top of the body); VEC_STATS_ALLOCATED
+ * and VEC_STATS_FREED add bytes to the same row.
+ */
+#if VEC_STATS
+typedef struct vec_stats_row vec_stats_row_t;
+
+typedef struct {
+    vec_stats_row_t *row;
+    uint64_t start;
+} vec_stats_timer_t;
+
+vec_stats_row_t *vec_stats_enter_(vec_stats_id_t id, uint64_t elements);
+void vec_stats_bytes_(vec_stats_row_t *row, uint64_t allocated, uint64_t freed);
+void vec_stats_leave_(vec_stats_timer_t *t);
+uint64_t vec_stats_ticks_(void);
+
+#if VEC_STATS_TIMING && defined(__GNUC__)
+    #define VEC_STATS_TIMER_(row) \
+        __attribute__((cleanup(vec_stats_leave_))) vec_stats_timer_t vec_stats_timer_ = { row, vec_stats_ticks_() }
+#else
+    #define VEC_STATS_TIMER_(row) (void)(row)
+#endif
+
+#define VEC_STATS_SCOPE(name, elements)                                                        \
+    vec_stats_row_t *vec_stats_row_ = vec_stats_enter_(VEC_STATS_ID_##name, (uint64_t)(elements)); \
+    VEC_STATS_TIMER_(vec_stats_row_)
+#define VEC_STATS_ALLOCATED(bytes) vec_stats_bytes_(vec_stats_row_, (uint64_t)(bytes), 0)
+#define VEC_STATS_FREED(bytes) vec_stats_bytes_(vec_stats_row_, 0, (uint64_t)(bytes))
+#else
+#define VEC_STATS_SCOPE(name, elements) (void)0
+#define VEC_STATS_ALLOCATED(bytes) (void)0
+#define VEC_STATS_FREED(bytes) (void)0
+#endif
+
+#endif // VEC_STATS_H
@@ -0,0 +1,73 @@
+#ifndef VEC_STREAM_H
+#define VEC_STREAM_H
+#include <cmath.h>
+#include <vec.h>
+
+/**
+ * @brief Chunked, double-buffered float streams for vectors that do not fit
+ *        in memory.
+ *
+ * A stream hands out its elements in chunks of a fixed size (the last one
+ * may be shorter). File descriptor and callback sources own two chunk
+ * buffers and a reader thread that fills the next buffer while the caller
+ * works on the current one, so memory use is two chunks per stream however
+ * long the source is. Vector sources (e.g. a vec_file_map mapping) hand out
+ * pointers into the vector and only advise the kernel to read ahead.
+ *
+ * The chunk size is rounded up to VEC_PARALLEL_CHUNK times a power of two.
+ * With that, the reductions below return the same bits as vector_dot /
+ * vector_magnitude / vector_sum over the whole data, and every chunk is
+ * itself spread over the vec_parallel pool when it is running.
+ *
+ * Without pthreads the reads happen synchronously in vec_stream_next.
+**/
+typedef struct vec_stream vec_stream_t;
+
+#ifndef VEC_STREAM_CHUNK
+    #define VEC_STREAM_CHUNK (1u << 20)     // default elements per chunk (4 MiB)
+#endif
+
+#define VEC_STREAM_TO_EOF (~(uint64_t)0)    // fd sources: read until end of file
+
+/**
+ * @brief Producer callback: write up to `max` elements to dst and return how
+ *        many were written; 0 ends the stream. It runs on the reader thread,
+ *        one call at a time. Short counts are fine, the stream keeps calling
+ *        until a chunk is full.
+ */
+typedef size_t (*vec_stream_read_f)(void *ctx, float *dst, size_t max);
+
+/**
+ * @brief Consumer callback for element-wise results: n elements of the next
+ *        output chunk, in order. Return false to abort the operation.
+ */
+typedef bool (*vec_stream_write_f)(void *ctx, const float *src, size_t n);
+
+typedef enum {
+    VEC_STREAM_ADD,
+    VEC_STREAM_SUB,
+    VEC_STREAM_MUL,
+    VEC_STREAM_DIV
+} vec_stream_op_t;
+
+vec_stream_t *vec_stream_open_fd(int fd, uint64_t offset, uint64_t length, size_t chunk); // length floats at byte offset (fd stays owned by the caller)
+vec_stream_t *vec_stream_open_file(const char *path, size_t chunk); // f32 file in the vec_file.h format
+vec_stream_t *vec_stream_open_callback(vec_stream_read_f read, void *ctx, size_t chunk); // Elements from a producer
+vec_stream_t *vec_stream_open_vector(vector_t v, size_t chunk); // Zero-copy chunks of a resident or mapped vector
+void vec_stream_close(vec_stream_t *s); // Stop the reader and free the buffers
+
+size_t vec_stream_next(vec_stream_t *s, const float **chunk); // Next chunk (valid until the next call); 0 at the end
+size_t vec_stream_chunk(const vec_stream_t *s); // Elements per chunk after rounding
+uint64_t vec_stream_position(const vec_stream_t *s); // Elements handed out so far
+bool vec_stream_failed(const vec_stream_t *s); // A read failed (the stream ended early)
+
+double vec_stream_sum(vec_stream_t *s); // Sum of the remaining elements
+float vec_stream_dot(vec_stream_t *a, vec_stream_t *b); // Dot product; 0 if the lengths or chunk sizes differ
+float vec_stream_magnitude(vec_stream_t *s); // Magnitude of the remaining elements
+bool vec_stream_binary(vec_stream_op_t op, vec_stream_t *a, vec_stream_t *b,
+                       vec_stream_write_f write, void *ctx); // write(a OP b) chunk by chunk
+bool vec_stream_scalar(vec_stream_op_t op, vec_stream_t *a, float s,
+                       vec_stream_write_f write, void *ctx); // write(a OP s) chunk by chunk
+bool vec_stream_write_fd(void *ctx, const float *src, size_t n); // vec_stream_write_f appending to *(int *)ctx
+
+#endif // VEC_STREAM_H
@@ -0,0 +1,170 @@
+#ifndef VEC_VIEW_H
+#define VEC_VIEW_H
+#include <cmath.h>
+#include <stddef.h>
+#include <vec.h>
+
+/**
+ * @brief Non-owning window onto float elements: element i lives at
+ *        data[i * stride]. A view aliases a vector_t, a dvector_t or any
+ *        buffer and is never freed; it stays valid as long as the memory
+ *        it points into.
+ *
+ * Views let the vector operations work on part of a vector, every k-th
+ * element, or one field of interleaved records (stride = floats per
+ * record) without copying them out first:
+ *
+ *     // x, y, z of n packed points: the y column, scaled in place
+ *     vec_view_t y = vec_view_array(points, 1, n, 3);
+ *     vec_view_scalar_mul_to(y, y, 2.0f);
+ *
+ * Views with stride 1 take the same path as the vector_* functions.
+ * Other strides go through the gather/scatter kernels (vec_simd.h): each
+ * chunk is gathered into a contiguous buffer, run through the usual
+ * kernel and, for results, scattered back. Element-wise results are
+ * therefore identical to the contiguous ones, and the reductions give
+ * exactly what the vector_* reduction of a vec_view_copy would. A strided
+ * reduction allocates one chunk-sized gather buffer per pool thread for
+ * the call; if that fails its result is NaN, and the `_ex` forms also
+ * clear their `ok` flag so that case can be told from a NaN in the data.
+ *
+ * The vector_* / dvec_* reductions are these functions applied to a
+ * whole-vector view.
+ *
+ * Operations returning a new vector give VEC_UNDEFINED / DVEC_UNDEFINED
+ * for mismatched sizes; the `_to` forms return false and leave dst alone.
+ * dst may be exactly `a` or `b` (same data and stride); any other overlap
+ * between dst and a source is not allowed.
+ *
+ * @members
+ *   size   - number of elements
+ *   data   - element 0
+ *   stride - distance between consecutive elements, in elements; may be
+ *            negative (reversed) or 0 (one element repeated)
+**/
+typedef struct {
+    size_t size;
+    float *data;
+    ptrdiff_t stride;
+} vec_view_t;
+
+typedef struct {
+    size_t size;
+    double *data;
+    ptrdiff_t stride;
+} dvec_view_t;
+
+extern const vec_view_t VIEW_UNDEFINED;
+extern const dvec_view_t DVIEW_UNDEFINED;
+
+/**
+ * @brief View of a whole vector.
+ */
+static inline vec_view_t vec_view_of(vector_t v)
+{
+    vec_view_t r = { v.size, v.data, 1 };
+    return r;
+}
+
+static inline dvec_view_t dvec_view_of(dvector_t v)
+{
+    dvec_view_t r = { v.size, v.data, 1 };
+    return r;
+}
+
+/**
+ * @brief View of `length` elements of a raw buffer, starting at
+ *        data[offset], `stride` apart. Not bounds-checked.
+ */
+static inline vec_view_t vec_view_array(float *data, size_t offset, size_t length, ptrdiff_t stride)
+{
+    vec_view_t r = { length, data + offset, stride };
+    return r;
+}
+
+static inline dvec_view_t dvec_view_array(double *data, size_t offset, size_t length, ptrdiff_t stride)
+{
+    dvec_view_t r = { length, data + offset, stride };
+    return r;
+}
+
+/**
+ * @brief Address of element i (no bounds check).
+ */
+static inline float *vec_view_at(vec_view_t v, size_t i)
+{
+    return v.data + (ptrdiff_t)i * v.stride;
+}
+
+static inline double *dvec_view_at(dvec_view_t v, size_t i)
+{
+    return v.data + (ptrdiff_t)i * v.stride;
+}
+
+vec_view_t vec_view(vector_t v, size_t offset, size_t length, ptrdiff_t stride); // v[offset + i*stride]; VIEW_UNDEFINED if any index is out of range
+vec_view_t vec_view_slice(vec_view_t v, size_t offset, size_t length, ptrdiff_t step); // v[offset + i*step] of a view, bounds-checked the same way
+bool vec_view_is_contiguous(vec_view_t v); // stride 1 (or at most one element)
+vector_t vec_view_copy(vec_view_t v); // Gather into a new vector
+bool vec_view_assign(vec_view_t dst, vec_view_t src); // dst[i] = src[i]
+bool vec_view_equals(vec_view_t a, vec_view_t b); // Same size and element-wise ==
+
+vector_t vec_view_add(vec_view_t a, vec_view_t b); // a + b into a new vector
+vector_t vec_view_sub(vec_view_t a, vec_view_t b); // a - b into a new vector
+vector_t vec_view_mul(vec_view_t a, vec_view_t b); // a * b into a new vector
+vector_t vec_view_div(vec_view_t a, vec_view_t b); // a / b into a new vector
+bool vec_view_add_to(vec_view_t dst, vec_view_t a, vec_view_t b); // dst = a + b
+bool vec_view_sub_to(vec_view_t dst, vec_view_t a, vec_view_t b); // dst = a - b
+bool vec_view_mul_to(vec_view_t dst, vec_view_t a, vec_view_t b); // dst = a * b
+bool vec_view_div_to(vec_view_t dst, vec_view_t a, vec_view_t b); // dst = a / b
+vector_t vec_view_scalar_add(vec_view_t a, float s); // a + s into a new vector
+vector_t vec_view_scalar_sub(vec_view_t a, float s); // a - s into a new vector
+vector_t vec_view_scalar_mul(vec_view_t a, float s); // a * s into a new vector
+vector_t vec_view_scalar_div(vec_view_t a, float s); // a / s into a new vector (INFINITY for s == 0, like vector_scalar_div)
+bool vec_view_scalar_add_to(vec_view_t dst, vec_view_t a, float s); // dst = a + s
+bool vec_view_scalar_sub_to(vec_view_t dst, vec_view_t a, float s); // dst = a - s
+bool vec_view_scalar_mul_to(vec_view_t dst, vec_view_t a, float s); // dst = a * s
+bool vec_view_scalar_div_to(vec_view_t dst, vec_view_t a, float s); // dst = a / s (false for s == 0)
+vector_t vec_view_pow(vec_view_t a, float power); // a ^ power into a new vector (as vector_pow)
+bool vec_view_pow_to(vec_view_t dst, vec_view_t a, float power); // dst = a ^ power
+
+float vec_view_dot(vec_view_t a, vec_view_t b); // Dot product (0 for mismatched sizes)
+float vec_view_dot_ex(vec_view_t a, vec_view_t b, vec_reduce_mode_t mode, bool *ok); // Dot product with a chosen accuracy mode; *ok false (NaN result) if gather scratch ran out
+float vec_view_magnitude(vec_view_t v); // Magnitude
+float vec_view_magnitude_ex(vec_view_t v, vec_reduce_mode_t mode, bool *ok); // Magnitude with a chosen accuracy mode; ok as for vec_view_dot_ex
+double vec_view_sum(vec_view_t v); // Sum of the elements
+double vec_view_sum_ex(vec_view_t v, bool *ok); // Sum of the elements; ok as for vec_view_dot_ex
+
+dvec_view_t dvec_view(dvector_t v, size_t offset, size_t length, ptrdiff_t stride); // v[offset + i*stride]; DVIEW_UNDEFINED if out of range
+dvec_view_t dvec_view_slice(dvec_view_t v, size_t offset, size_t length, ptrdiff_t step); // Sub-view of a double view
+bool dvec_view_is_contiguous(dvec_view_t v); // stride 1 (or at most one element)
+dvector_t dvec_view_copy(dvec_view_t v); // Gather into a new double vector
+bool dvec_view_assign(dvec_view_t dst, dvec_view_t src); // dst[i] = src[i]
+bool dvec_view_equals(dvec_view_t a, dvec_view_t b); // Same size and element-wise ==
+
+dvector_t dvec_view_add(dvec_view_t a, dvec_view_t b); // a + b into a new double vector
+dvector_t dvec_view_sub(dvec_view_t a, dvec_view_t b); // a - b into a new double vector
+dvector_t dvec_view_mul(dvec_view_t a, dvec_view_t b); // a * b into a new double vector
+dvector_t dvec_view_div(dvec_view_t a, dvec_view_t b); // a / b into a new double vector
+bool dvec_view_add_to(dvec_view_t dst, dvec_view_t a, dvec_view_t b); // dst = a + b
+bool dvec_view_sub_to(dvec_view_t dst, dvec_view_t a, dvec_view_t b); // dst = a - b
+bool dvec_view_mul_to(dvec_view_t dst, dvec_view_t a, dvec_view_t b); // dst = a * b
+bool dvec_view_div_to(dvec_view_t dst, dvec_view_t a, dvec_view_t b); // dst = a / b
+dvector_t dvec_view_scalar_add(dvec_view_t a, double s); // a + s into a new double vector
+dvector_t dvec_view_scalar_sub(dvec_view_t a, double s); // a - s into a new double vector
+dvector_t dvec_view_scalar_mul(dvec_view_t a, double s); // a * s into a new double vector
+dvector_t dvec_view_scalar_div(dvec_view_t a, double s); // a / s into a new double vector (INFINITY for s == 0)
+bool dvec_view_scalar_add_to(dvec_view_t dst, dvec_view_t a, double s); // dst = a + s
+bool dvec_view_scalar_sub_to(dvec_view_t dst, dvec_view_t a, double s); // dst = a - s
+bool dvec_view_scalar_mul_to(dvec_view_t dst, dvec_view_t a, double s); // dst = a * s
+bool dvec_view_scalar_div_to(dvec_view_t dst, dvec_view_t a, double s); // dst = a / s (false for s == 0)
+dvector_t dvec_view_pow(dvec_view_t a, double power); // a ^ power into a new double vector (as dvec_pow)
+bool dvec_view_pow_to(dvec_view_t dst, dvec_view_t a, double power); // dst = a ^ power
+
+double dvec_view_dot(dvec_view_t a, dvec_view_t b); // Dot product (0 for mismatched sizes)
+double dvec_view_dot_ex(dvec_view_t a, dvec_view_t b, vec_reduce_mode_t mode, bool *ok); // Dot product with a chosen accuracy mode; ok as for vec_view_dot_ex
+double dvec_view_magnitude(dvec_view_t v); // Magnitude (correctly rounded sqrt)
+double dvec_view_magnitude_ex(dvec_view_t v, vec_reduce_mode_t mode, bool *ok); // Magnitude with a chosen accuracy mode; ok as for vec_view_dot_ex
+double dvec_view_sum(dvec_view_t v); // Sum of the elements
+double dvec_view_sum_ex(dvec_view_t v, bool *ok); // Sum of the elements; ok as for vec_view_dot_ex
+
+#endif // VEC_VIEW_H
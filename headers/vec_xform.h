@@ -0,0 +1,108 @@
+#ifndef VEC_XFORM_H
+#define VEC_XFORM_H
+#include <cmath.h>
+#include <stddef.h>
+#include <vec.h>
+
+/*
+ * Batch transforms of 3D points, directions and normals by one matrix.
+ *
+ * Matrices are row-major and act on column vectors, as in vec.h:
+ *
+ *   x' = m[0] * x + m[1] * y + m[2]  * z + m[3]
+ *   y' = m[4] * x + m[5] * y + m[6]  * z + m[7]
+ *   z' = m[8] * x + m[9] * y + m[10] * z + m[11]
+ *   w' = m[12] * x + m[13] * y + m[14] * z + m[15]   (4x4 only)
+ *
+ * A 3x4 matrix is the first 12 floats of a 4x4 one, so the affine, direction
+ * and normal kernels take either. Points go through the full matrix and
+ * x', y', z' are multiplied by 1 / w' (which can differ from dividing by w'
+ * in the last bit) unless the bottom row is exactly (0, 0, 0, 1);
+ * directions use the upper 3x3 only; normals use its inverse transpose and
+ * are not renormalized (a uniform scale changes their length).
+ *
+ * Arrays are either AoS (x0 y0 z0 x1 y1 z1 ...) or SoA (three arrays). The
+ * output is caller-provided and may be the input itself, element for
+ * element; partial overlaps are undefined. Each output is computed with
+ * the same unfused multiplies and adds, left to right, at every SIMD
+ * level (AVX2 / AVX-512 deinterleave AoS input in registers), so results
+ * do not depend on the level. Batches of at least vec_parallel_threshold()
+ * points are split over the vec_parallel pool.
+ */
+
+/**
+ * @brief Three parallel coordinate arrays (structure of arrays).
+ */
+typedef struct {
+    float *x;
+    float *y;
+    float *z;
+} vec3_soa_t;
+
+bool mat4_is_affine(const float *m); // Bottom row of a 4x4 matrix is exactly (0, 0, 0, 1)
+bool mat4_inverse(float *dst, const float *m); // dst = m^-1 (affine m gives an exact (0, 0, 0, 1) row); false (dst untouched) if singular
+bool mat3_normal_matrix(float *dst, const float *m); // dst (3x4, translation 0) = inverse transpose of m's upper 3x3; false if singular
+
+void vec3_transform_points(const float *m, float *dst, const float *src, size_t n); // n AoS points by a 4x4 matrix (w-divide unless affine)
+void vec3_transform_points_affine(const float *m, float *dst, const float *src, size_t n); // n AoS points by a 3x4 matrix, no w-divide
+void vec3_transform_directions(const float *m, float *dst, const float *src, size_t n); // n AoS directions by the upper 3x3
+bool vec3_transform_normals(const float *m, float *dst, const float *src, size_t n); // n AoS normals by the inverse transpose; false (dst untouched) if singular
+
+void vec3_transform_points_soa(const float *m, vec3_soa_t dst, vec3_soa_t src, size_t n); // SoA form of vec3_transform_points
+void vec3_transform_points_affine_soa(const float *m, vec3_soa_t dst, vec3_soa_t src, size_t n); // SoA form of vec3_transform_points_affine
+void vec3_transform_directions_soa(const float *m, vec3_soa_t dst, vec3_soa_t src, size_t n); // SoA form of vec3_transform_directions
+bool vec3_transform_normals_soa(const float *m, vec3_soa_t dst, vec3_soa_t src, size_t n); // SoA form of vec3_transform_normals
+
+/**
+ * @brief A matrix prepared for repeated use: the inverse, both normal
+ *        matrices and the affine flag are computed once, by xform_make,
+ *        so applying the same camera or model transform over many batches
+ *        never inverts anything again.
+ *
+ * Everything is computed eagerly, in double and rounded once per element:
+ * it costs a few hundred flops, less than transforming a hundred points,
+ * and leaves the object read-only, so one xform_t can be shared by any
+ * number of threads. XFORM_NORMALS gives the same bits as
+ * vec3_transform_normals on the same matrix.
+ *
+ * @members
+ *   m           - forward 4x4 matrix (row-major, column vectors)
+ *   inv         - inverse of m (zeros unless `invertible`)
+ *   normal      - inverse transpose of m's upper 3x3, as a 3x4 matrix
+ *   inv_normal  - the same for `inv` (the transpose of m's 3x3 if affine)
+ *   affine      - bottom row of m is (0, 0, 0, 1): points skip the w-divide
+ *   invertible  - m is invertible, so the XFORM_INVERSE_* ops work
+ *   normals     - `normal` is valid (m's upper 3x3 is invertible)
+ *   inv_normals - `inv_normal` is valid
+**/
+typedef struct {
+    float m[16];
+    float inv[16];
+    float normal[12];
+    float inv_normal[12];
+    bool affine;
+    bool invertible;
+    bool normals;
+    bool inv_normals;
+} xform_t;
+
+/**
+ * @brief What xform_apply does with each element.
+ */
+typedef enum {
+    XFORM_POINTS = 0,           // m, w-divide unless affine
+    XFORM_DIRECTIONS,           // upper 3x3 of m
+    XFORM_NORMALS,              // normal matrix of m
+    XFORM_INVERSE_POINTS,       // inv, w-divide unless affine
+    XFORM_INVERSE_DIRECTIONS,   // upper 3x3 of inv
+    XFORM_INVERSE_NORMALS       // normal matrix of inv
+} xform_op_t;
+
+xform_t xform_make(const float *m); // Prepare a 4x4 matrix
+xform_t xform_make_affine(const float *m); // Prepare a 3x4 matrix (bottom row (0, 0, 0, 1))
+xform_t xform_inverse(const xform_t *t); // The inverse transform, from the caches (no inversion; zero matrix if t is singular)
+xform_t xform_compose(const xform_t *a, const xform_t *b); // a after b; the inverse is b.inv * a.inv (no inversion)
+bool xform_apply(const xform_t *t, xform_op_t op, float *dst, const float *src, size_t n); // op on n AoS vectors; false (dst untouched) if op's matrix is unavailable
+bool xform_apply_soa(const xform_t *t, xform_op_t op, vec3_soa_t dst, vec3_soa_t src, size_t n); // SoA form of xform_apply
+
+#endif // VEC_XFORM_H
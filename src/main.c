@@ -1,7 +1,951 @@
 #include <math.h>        // for printf, M_PI, etc.
 #include "vec.h"         
 #include "math_core.h"   
+#include "vec_simd.h"
+#include "vec_fixed.h"
+#include "vec_parallel.h"
+#include "vec_half.h"
+#include "vec_file.h"
+#include "vec_stream.h"
+#include "vec_view.h"
+#include "mat.h"
+#include "vec_xform.h"
+#include "vec_quat.h"
+#include "vec_map.h"
+#include "vec_stats.h"
+#include "vec_blas1.h"
+#include "vec_sparse.h"
+#include "vec_knn.h"
+#include "math_batch.h"
+#include "vec_expr.h"
 
+/**
+ * @brief Compare every element-wise, dot, dot_scaled, maxabs and sum kernel
+ *        of `isa` bit-for-bit against the scalar reference over sizes 0..67
+ *        and all head misalignments, and the strided copies over a few
+ *        strides.
+ */
+static bool check_kernels_bitexact(vec_isa_t isa)
+{
+    const vec_kernels_t *ref = vec_kernels_for(VEC_ISA_SCALAR);
+    const vec_kernels_t *k = vec_kernels_for(isa);
+    float a[80], b[80], want[80], got[80];
+    for (int i = 0; i < 80; i++) {
+        a[i] = (float)(i * 37 % 101) * 0.37f - 11.0f;
+        b[i] = (float)(i * 53 % 89) * 0.11f + 0.5f;
+    }
+    vec_binary_kernel_f kb[4][2] = {
+        { ref->add, k->add }, { ref->sub, k->sub }, { ref->mul, k->mul }, { ref->div, k->div }
+    };
+    vec_scalar_kernel_f ks[4][2] = {
+        { ref->scalar_add, k->scalar_add }, { ref->scalar_sub, k->scalar_sub },
+        { ref->scalar_mul, k->scalar_mul }, { ref->scalar_div, k->scalar_div }
+    };
+    for (size_t n = 0; n < 68; n++) {
+        for (size_t off = 0; off < 4; off++) {
+            for (int op = 0; op < 4; op++) {
+                kb[op][0](want, a + off, b, n);
+                kb[op][1](got + off, a + off, b, n);
+                if (memcmp(want, got + off, n * sizeof(float)) != 0) return false;
+                ks[op][0](want, a + off, 1.7f, n);
+                ks[op][1](got, a + off, 1.7f, n);
+                if (memcmp(want, got, n * sizeof(float)) != 0) return false;
+                // in-place form: dst aliases a
+                memcpy(got + off, a + off, n * sizeof(float));
+                ks[op][1](got + off, got + off, 1.7f, n);
+                if (memcmp(want, got + off, n * sizeof(float)) != 0) return false;
+            }
+            float x = ref->dot(a + off, b, n), y = k->dot(a + off, b, n);
+            double xc = ref->dot_compensated(a + off, b, n), yc = k->dot_compensated(a + off, b, n);
+            if (memcmp(&x, &y, sizeof x) != 0 || memcmp(&xc, &yc, sizeof xc) != 0) return false;
+            float r[3] = { ref->dot_scaled(a + off, b, 0.25f, 4.0f, n), ref->maxabs(a + off, n),
+                           ref->sum(a + off, n) };
+            float g[3] = { k->dot_scaled(a + off, b, 0.25f, 4.0f, n), k->maxabs(a + off, n),
+                           k->sum(a + off, n) };
+            if (memcmp(r, g, sizeof r) != 0) return false;
+        }
+    }
+    // strided copies around the middle of a 100-element buffer
+    static const ptrdiff_t strides[] = { 1, 3, -2, 0 };
+    float buf[100], sw[100], sg[100];
+    for (int i = 0; i < 100; i++) buf[i] = (float)i;
+    for (size_t n = 0; n < 20; n++) {
+        for (int j = 0; j < 4; j++) {
+            ref->gather(want, buf + 40, strides[j], n);
+            k->gather(got, buf + 40, strides[j], n);
+            if (memcmp(want, got, n * sizeof(float)) != 0) return false;
+            memcpy(sw, buf, sizeof buf);
+            memcpy(sg, buf, sizeof buf);
+            ref->scatter(sw + 40, strides[j], a, n);
+            k->scatter(sg + 40, strides[j], a, n);
+            if (memcmp(sw, sg, sizeof sw) != 0) return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Same check for the double kernels, including dot_scaled, maxabs,
+ *        sum and the strided copies.
+ */
+static bool check_dkernels_bitexact(vec_isa_t isa)
+{
+    const vec_dkernels_t *ref = vec_dkernels_for(VEC_ISA_SCALAR);
+    const vec_dkernels_t *k = vec_dkernels_for(isa);
+    double a[80], b[80], want[80], got[80];
+    for (int i = 0; i < 80; i++) {
+        a[i] = (double)(i * 37 % 101) * 0.37 - 11.0;
+        b[i] = (double)(i * 53 % 89) * 0.11 + 0.5;
+    }
+    vec_dbinary_kernel_f kb[4][2] = {
+        { ref->add, k->add }, { ref->sub, k->sub }, { ref->mul, k->mul }, { ref->div, k->div }
+    };
+    vec_dscalar_kernel_f ks[4][2] = {
+        { ref->scalar_add, k->scalar_add }, { ref->scalar_sub, k->scalar_sub },
+        { ref->scalar_mul, k->scalar_mul }, { ref->scalar_div, k->scalar_div }
+    };
+    for (size_t n = 0; n < 68; n++) {
+        for (size_t off = 0; off < 8; off++) {
+            for (int op = 0; op < 4; op++) {
+                kb[op][0](want, a + off, b, n);
+                kb[op][1](got + off, a + off, b, n);
+                if (memcmp(want, got + off, n * sizeof(double)) != 0) return false;
+                ks[op][0](want, a + off, 1.7, n);
+                ks[op][1](got + off, a + off, 1.7, n);
+                if (memcmp(want, got + off, n * sizeof(double)) != 0) return false;
+            }
+            double r[5] = { ref->dot(a + off, b, n), ref->dot_compensated(a + off, b, n),
+                            ref->dot_scaled(a + off, b, 0.25, 4.0, n), ref->maxabs(a + off, n),
+                            ref->sum(a + off, n) };
+            double g[5] = { k->dot(a + off, b, n), k->dot_compensated(a + off, b, n),
+                            k->dot_scaled(a + off, b, 0.25, 4.0, n), k->maxabs(a + off, n),
+                            k->sum(a + off, n) };
+            if (memcmp(r, g, sizeof r) != 0) return false;
+        }
+    }
+    static const ptrdiff_t strides[] = { 1, 3, -2, 0 };
+    double buf[100], sw[100], sg[100];
+    for (int i = 0; i < 100; i++) buf[i] = (double)i;
+    for (size_t n = 0; n < 20; n++) {
+        for (int j = 0; j < 4; j++) {
+            ref->gather(want, buf + 40, strides[j], n);
+            k->gather(got, buf + 40, strides[j], n);
+            if (memcmp(want, got, n * sizeof(double)) != 0) return false;
+            memcpy(sw, buf, sizeof buf);
+            memcpy(sg, buf, sizeof buf);
+            ref->scatter(sw + 40, strides[j], a, n);
+            k->scatter(sg + 40, strides[j], a, n);
+            if (memcmp(sw, sg, sizeof sw) != 0) return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Run the half / bfloat16 conversions at `isa` and compare them with
+ *        the scalar reference: every binary16 pattern widened, and a sweep
+ *        of floats (normal, subnormal, overflowing, NaN) rounded.
+ */
+static bool check_half_bitexact(vec_isa_t isa)
+{
+    static half_t all[65536];
+    static float wide[65536], f[4096];
+    static half_t h[4096];
+    vec_isa_t saved = vec_isa_active();
+    if (!vec_isa_select(isa)) return false;
+
+    bool ok = true;
+    for (int i = 0; i < 65536; i++) all[i] = (half_t)i;
+    half_to_float_array(wide, all, 65536);
+    for (int i = 0; i < 65536 && ok; i++) {
+        float r = half_to_float(all[i]);
+        ok = memcmp(&r, &wide[i], sizeof r) == 0;
+    }
+    bf16_to_float_array(wide, all, 65536);
+    for (int i = 0; i < 65536 && ok; i++) {
+        float r = bf16_to_float(all[i]);
+        ok = memcmp(&r, &wide[i], sizeof r) == 0;
+    }
+    uint32_t bits = 0x2f000000;                 // 2^-33, below the half subnormals
+    for (int i = 0; i < 4096; i++, bits += 0x00a3b1c7) memcpy(&f[i], &bits, sizeof bits);
+    half_from_float_array(h, f, 4096);
+    for (int i = 0; i < 4096 && ok; i++) ok = h[i] == half_from_float(f[i]);
+    bf16_from_float_array(h, f, 4096);
+    for (int i = 0; i < 4096 && ok; i++) ok = h[i] == bf16_from_float(f[i]);
+
+    vec_isa_select(saved);
+    return ok;
+}
+
+/*
+ * The *_bitexact checks from here on run the same work once at the scalar
+ * level and once at `isa`: run(ctx, 0) and run(ctx, 1) write slot 0 and 1
+ * of the check's outputs, which the check then compares.
+ */
+typedef void (*level_run_f)(void *ctx, int slot);
+
+// false if `isa` cannot be selected; the active level is restored either way
+static bool run_levels(vec_isa_t isa, level_run_f run, void *ctx)
+{
+    vec_isa_t saved = vec_isa_active();
+    vec_isa_t levels[2] = { VEC_ISA_SCALAR, isa };
+    bool ok = true;
+    for (int slot = 0; slot < 2 && ok; slot++) {
+        ok = vec_isa_select(levels[slot]);
+        if (ok) run(ctx, slot);
+    }
+    vec_isa_select(saved);
+    return ok;
+}
+
+// irregular but reproducible test data: element i of pattern `seed`
+static void fill_pattern(float *dst, int n, int seed, float scale, float bias)
+{
+    for (int i = 0; i < n; i++) dst[i] = (float)((i * 37 + seed * 11) % 101) * scale + bias;
+}
+
+enum { MC_M = 37, MC_K = MAT_KC + 45, MC_N = 29 };
+
+typedef struct {
+    float a[MC_M * MC_K], b[MC_K * MC_N], x[MC_K];
+    float c[2][MC_M * MC_N], y[2][MC_M];
+} mat_check_t;
+
+static void mat_run(void *ctx, int slot)
+{
+    mat_check_t *t = ctx;
+    for (int i = 0; i < MC_M * MC_N; i++) t->c[slot][i] = (float)(i % 7);
+    for (int i = 0; i < MC_M; i++) t->y[slot][i] = (float)(i % 5);
+    matrix_t ma = matrix_wrap(t->a, MC_M, MC_K, MC_K, MAT_ROW_MAJOR);
+    matrix_t mb = matrix_wrap(t->b, MC_K, MC_N, MC_K, MAT_COL_MAJOR);
+    matrix_gemm(0.5f, ma, mb, -2.0f, matrix_wrap(t->c[slot], MC_M, MC_N, MC_M, MAT_COL_MAJOR));
+    vector_t vx = { .size = MC_K, .data = t->x }, vy = { .size = MC_M, .data = t->y[slot] };
+    matrix_gemv(1.5f, ma, vx, 0.25f, vy);
+}
+
+/**
+ * @brief Compare matrix_gemm / matrix_gemv at `isa` bit-for-bit against the
+ *        scalar level on shapes that leave partial tiles and span two k
+ *        blocks, with mixed layouts.
+ */
+static bool check_mat_bitexact(vec_isa_t isa)
+{
+    static mat_check_t t;
+    fill_pattern(t.a, MC_M * MC_K, 0, 0.37f, -11.0f);
+    fill_pattern(t.b, MC_K * MC_N, 1, 0.11f, 0.5f);
+    fill_pattern(t.x, MC_K, 2, 0.03f, -1.0f);
+    return run_levels(isa, mat_run, &t) &&
+           memcmp(t.c[0], t.c[1], sizeof t.c[0]) == 0 && memcmp(t.y[0], t.y[1], sizeof t.y[0]) == 0;
+}
+
+/*
+ * Naive references in the order mat.h documents: every element of C
+ * accumulated in k order by fused steps in blocks of MAT_KC, each block
+ * folded in as fma(alpha, block, beta * C) with beta = 1 after the first;
+ * row-major gemv in LANES fused lanes added pairwise, column-major gemv one
+ * fused chain per row.
+ */
+#define MAT_REFERENCE(P, MT, T, VT, FMA, LANES)                                     \
+static void P##_ref_gemm(T alpha, MT a, MT b, T beta, MT c)                         \
+{                                                                                   \
+    for (size_t i = 0; i < c.rows; i++) {                                           \
+        for (size_t j = 0; j < c.cols; j++) {                                       \
+            T *cij = P##_at(c, i, j), be = beta;                                    \
+            for (size_t p0 = 0; p0 < a.cols; p0 += MAT_KC, be = 1) {                \
+                T acc = 0;                                                          \
+                for (size_t p = p0; p < a.cols && p < p0 + MAT_KC; p++) {           \
+                    acc = FMA(*P##_at(a, i, p), *P##_at(b, p, j), acc);             \
+                }                                                                   \
+                *cij = be == 0 ? alpha * acc : FMA(alpha, acc, be * *cij);          \
+            }                                                                       \
+        }                                                                           \
+    }                                                                               \
+}                                                                                   \
+                                                                                    \
+static void P##_ref_gemv(T alpha, MT a, const T *x, T beta, T *y)                   \
+{                                                                                   \
+    for (size_t i = 0; i < a.rows; i++) {                                           \
+        T s = 0, lane[LANES] = { 0 };                                               \
+        for (size_t p = 0; p < a.cols; p++) {                                       \
+            if (a.layout == MAT_ROW_MAJOR) {                                        \
+                lane[p % (LANES)] = FMA(*P##_at(a, i, p), x[p], lane[p % (LANES)]); \
+            } else {                                                                \
+                s = FMA(*P##_at(a, i, p), x[p], s);                                 \
+            }                                                                       \
+        }                                                                           \
+        if (a.layout == MAT_ROW_MAJOR) {                                            \
+            for (int w = (LANES) / 2; w > 0; w /= 2) {                              \
+                for (int l = 0; l < w; l++) lane[l] += lane[l + w];                 \
+            }                                                                       \
+            s = lane[0];                                                            \
+        }                                                                           \
+        y[i] = beta == 0 ? alpha * s : FMA(alpha, s, beta * y[i]);                  \
+    }                                                                               \
+}                                                                                   \
+                                                                                    \
+/* gemm with a transposed A into both layouts of C, *_mul, and gemv on a     */     \
+/* row-major A and its column-major transpose; all above MAT_PARALLEL_WORK   */     \
+static bool P##_matches_reference(void)                                             \
+{                                                                                   \
+    enum { M = 130, K = MAT_KC + 44, N = 70, GM = 2100, GN = 1000 };                \
+    size_t total = (size_t)K * M + (size_t)K * N + 6 * (size_t)M * N +              \
+                   (size_t)GM * GN + 5 * (size_t)GM;                                \
+    T *a = malloc(total * sizeof(T));                                               \
+    if (!a) return false;                                                           \
+    T *b = a + K * M, *c = b + K * N, *g = c + 6 * M * N, *x = g + (size_t)GM * GN; \
+    T *y = x + GM;                                                                  \
+    for (size_t i = 0; i < total; i++) a[i] = (T)(i * 37 % 101) * (T)0.01 - (T)0.5; \
+    MT ma = P##_transpose(P##_wrap(a, K, M, M, MAT_ROW_MAJOR));                     \
+    MT mb = P##_wrap(b, K, N, N, MAT_ROW_MAJOR);                                    \
+    bool ok = true;                                                                 \
+    for (int layout = MAT_ROW_MAJOR; layout <= MAT_COL_MAJOR; layout++) {           \
+        T *got = c + layout * 2 * M * N, *want = got + M * N;                       \
+        size_t ld = layout == MAT_ROW_MAJOR ? N : M;                                \
+        memcpy(want, got, M * N * sizeof(T));                                       \
+        P##_gemm((T)0.5, ma, mb, (T)-2, P##_wrap(got, M, N, ld, (mat_layout_t)layout)); \
+        P##_ref_gemm((T)0.5, ma, mb, (T)-2, P##_wrap(want, M, N, ld, (mat_layout_t)layout)); \
+        ok = ok && memcmp(got, want, M * N * sizeof(T)) == 0;                       \
+    }                                                                               \
+    MT prod = P##_mul(ma, mb), want = P##_wrap(c + 4 * M * N, M, N, M, MAT_COL_MAJOR); \
+    P##_ref_gemm(1, ma, mb, 0, want);                                               \
+    ok = ok && prod.data && prod.layout == MAT_COL_MAJOR &&                         \
+         memcmp(prod.data, want.data, M * N * sizeof(T)) == 0;                      \
+    P##_free(&prod);                                                                \
+    MT mg = P##_wrap(g, GM, GN, GN, MAT_ROW_MAJOR), mt = P##_transpose(mg);         \
+    memcpy(y + GM, y, GM * sizeof(T));                                              \
+    P##_gemv((T)1.5, mg, (VT){ .size = GN, .data = x }, (T)0.25, (VT){ .size = GM, .data = y }); \
+    P##_ref_gemv((T)1.5, mg, x, (T)0.25, y + GM);                                   \
+    ok = ok && memcmp(y, y + GM, GM * sizeof(T)) == 0;                              \
+    P##_gemv((T)1.5, mt, (VT){ .size = GM, .data = x }, 0, (VT){ .size = GN, .data = y + 2 * GM }); \
+    P##_ref_gemv((T)1.5, mt, x, 0, y + 3 * GM);                                     \
+    ok = ok && memcmp(y + 2 * GM, y + 3 * GM, GN * sizeof(T)) == 0;                 \
+    free(a);                                                                        \
+    return ok;                                                                      \
+}
+
+MAT_REFERENCE(matrix, matrix_t, float, vector_t, fmaf, MAT_GEMV_LANES)
+MAT_REFERENCE(dmat, dmatrix_t, double, dvector_t, fma, (MAT_GEMV_LANES / 2))
+
+/**
+ * @brief matrix_* and dmat_* at `isa` against the naive references, on
+ *        products big enough to go through the thread pool (started here
+ *        for the check if it is not running).
+ */
+static bool check_mat_reference(vec_isa_t isa)
+{
+    vec_isa_t saved = vec_isa_active();
+    if (!vec_isa_select(isa)) return false;
+    bool started = vec_parallel_threads() <= 1 && vec_parallel_init(4);
+    bool ok = vec_parallel_threads() > 1 && matrix_matches_reference() && dmat_matches_reference();
+    if (started) vec_parallel_shutdown();
+    vec_isa_select(saved);
+    return ok;
+}
+
+typedef struct {
+    size_t n;
+    float src[120], out[2][3][120];
+} xform_check_t;
+
+static void xform_run(void *ctx, int slot)
+{
+    static const float proj[16] = { 1.2f, 0.3f, -0.5f, 2.0f,  0.1f, 0.9f, 0.4f, -1.0f,
+                                    0.2f, -0.7f, 1.1f, 3.0f,  0.01f, 0.02f, -0.03f, 1.5f };
+    xform_check_t *t = ctx;
+    float (*out)[120] = t->out[slot];
+    vec3_soa_t soa = { out[2], out[2] + 40, out[2] + 80 };
+    vec3_soa_t in = { t->src, t->src + 40, t->src + 80 };
+    vec3_transform_points(proj, out[0], t->src, t->n);
+    vec3_transform_points_affine(proj, out[1], t->src, t->n);
+    vec3_transform_directions_soa(proj, soa, in, t->n);
+}
+
+/**
+ * @brief Run the AoS and SoA point / direction kernels at `isa` and at the
+ *        scalar level over 0..40 points and compare the bits, for an
+ *        affine and a projective matrix.
+ */
+static bool check_xform_bitexact(vec_isa_t isa)
+{
+    xform_check_t t = { 0 };
+    fill_pattern(t.src, 120, 0, 0.37f, -11.0f);
+    for (t.n = 0; t.n <= 40; t.n++) {
+        if (!run_levels(isa, xform_run, &t) ||
+            memcmp(t.out[0][0], t.out[1][0], t.n * 3 * sizeof(float)) != 0 ||
+            memcmp(t.out[0][1], t.out[1][1], t.n * 3 * sizeof(float)) != 0 ||
+            memcmp(t.out[0][2], t.out[1][2], sizeof t.out[0][2]) != 0) return false;
+    }
+    return true;
+}
+
+// expression inlined into the loop: no call per element
+VEC_MAP3_DEFINE(vec_mix, a, b, t, a + t * (b - a))
+
+static float mix(float a, float b, float t) { return a + t * (b - a); }
+
+typedef struct {
+    size_t n;
+    float src[8][40], out[2][4][40];
+} quat_check_t;
+
+static void quat_run(void *ctx, int slot)
+{
+    quat_check_t *t = ctx;
+    quat_soa_t a = { t->src[0], t->src[1], t->src[2], t->src[3] };
+    quat_soa_t b = { t->src[4], t->src[5], t->src[6], t->src[7] };
+    vec3_soa_t axis = { t->src[0], t->src[1], t->src[2] };
+    quat_soa_t dst = { t->out[slot][0], t->out[slot][1], t->out[slot][2], t->out[slot][3] };
+    quat_slerp_soa(dst, a, b, 0.3f, t->n);
+    quat_from_axis_angle_soa(dst, axis, t->src[3], t->n / 2);
+}
+
+/**
+ * @brief Slerp 0..40 pairs of unit quaternions and build quaternions from
+ *        0..40 axis-angle pairs at `isa` and at the scalar level, and
+ *        compare the bits. The pairs mix wide angles (acos and the SIMD
+ *        sincos kernels), nearly equal ones (the nlerp fallback) and
+ *        opposite signs (the short way round); both paths must be taken.
+ */
+static bool check_quat_bitexact(vec_isa_t isa)
+{
+    quat_check_t t = { 0 };
+    for (int k = 0; k < 8; k++) fill_pattern(t.src[k], 40, k, 0.07f, -3.5f);
+    int slerped = 0, nlerped = 0;
+    for (int i = 0; i < 40; i++) {
+        float (*q)[40] = t.src;
+        if (i % 4 == 1) {
+            for (int c = 0; c < 4; c++) q[4 + c][i] = q[c][i] + 0.001f * (float)(c + 1);
+        }
+        if (i % 5 == 0) {
+            for (int c = 4; c < 8; c++) q[c][i] = -q[c][i];
+        }
+        float na = 0.0f, nb = 0.0f, dot = 0.0f;
+        for (int c = 0; c < 4; c++) na += q[c][i] * q[c][i], nb += q[4 + c][i] * q[4 + c][i];
+        for (int c = 0; c < 4; c++) q[c][i] /= sqrtf(na), q[4 + c][i] /= sqrtf(nb);
+        for (int c = 0; c < 4; c++) dot += q[c][i] * q[4 + c][i];
+        if (fabsf(dot) > QUAT_SLERP_LINEAR) nlerped++;
+        else slerped++;
+    }
+    if (slerped == 0 || nlerped == 0) return false;
+    for (t.n = 0; t.n <= 40; t.n++) {
+        if (!run_levels(isa, quat_run, &t) || memcmp(t.out[0], t.out[1], sizeof t.out[0]) != 0) return false;
+    }
+    return true;
+}
+
+typedef struct {
+    unsigned int n;
+    float src[3][40], out[2][5][40];
+} blas1_check_t;
+
+static void blas1_run(void *ctx, int slot)
+{
+    blas1_check_t *t = ctx;
+    unsigned int n = t->n;
+    vector_t x = { .size = n, .data = t->src[0] }, y = { .size = n, .data = t->src[1] },
+             z = { .size = n, .data = t->src[2] };
+    vector_t o[5];
+    for (int k = 0; k < 5; k++) o[k] = (vector_t){ .size = n, .data = t->out[slot][k] };
+    memcpy(t->out[slot][0], t->src[1], sizeof t->src[1]);
+    vector_axpy(0.3f, x, o[0]);
+    vector_waxpby(o[1], 0.3f, x, -1.7f, y);
+    vector_fma(o[2], x, y, z);
+    vector_lerp(o[3], x, y, 0.25f);
+    vector_clamp(o[4], x, -5.0f, 5.0f);
+}
+
+/**
+ * @brief Run every fused level-1 update at `isa` and at the scalar level
+ *        over 0..40 elements and compare the bits.
+ */
+static bool check_blas1_bitexact(vec_isa_t isa)
+{
+    blas1_check_t t = { 0 };
+    for (int k = 0; k < 3; k++) fill_pattern(t.src[k], 40, k, 0.37f, -17.0f);
+    for (t.n = 0; t.n <= 40; t.n++) {
+        if (!run_levels(isa, blas1_run, &t) || memcmp(t.out[0], t.out[1], sizeof t.out[0]) != 0) return false;
+    }
+    return true;
+}
+
+typedef struct {
+    size_t n;
+    float dense[300], value[40], out[2][300], dot[2];
+    uint32_t index[40];
+} sparse_check_t;
+
+static void sparse_run(void *ctx, int slot)
+{
+    sparse_check_t *t = ctx;
+    vector_t v = { .size = 300, .data = t->dense };
+    svector_t s = { .size = 300, .nnz = t->n, .index = t->index, .value = t->value };
+    memcpy(t->out[slot], t->dense, sizeof t->dense);
+    t->dot[slot] = svec_dot_dense(s, v);
+    svec_scatter_add((vector_t){ .size = 300, .data = t->out[slot] }, 0.7f, s);
+}
+
+/**
+ * @brief Sparse-dense dot and scatter-add at `isa` and at the scalar level,
+ *        for 0..40 entries spread over 300 elements, compared bit for bit.
+ */
+static bool check_sparse_bitexact(vec_isa_t isa)
+{
+    sparse_check_t t = { 0 };
+    fill_pattern(t.dense, 300, 0, 0.37f, -17.0f);
+    for (int k = 0; k < 40; k++) t.index[k] = (uint32_t)(k * 7 + k % 3), t.value[k] = 0.1f * (float)k - 1.3f;
+    for (t.n = 0; t.n <= 40; t.n++) {
+        if (!run_levels(isa, sparse_run, &t) || memcmp(&t.dot[0], &t.dot[1], sizeof(float)) != 0 ||
+            memcmp(t.out[0], t.out[1], sizeof t.out[0]) != 0) return false;
+    }
+    return true;
+}
+
+typedef struct {
+    size_t n;
+    float src[3][1000], out[2][2][1000];
+} expr_check_t;
+
+static void expr_run(void *ctx, int slot)
+{
+    expr_check_t *t = ctx;
+    size_t n = t->n;
+    vector_t a = { .size = n, .data = t->src[0] }, b = { .size = n, .data = t->src[1] },
+             c = { .size = n, .data = t->src[2] };
+
+    // eager: pow((a * b + c * 1.7) / (a - 0.5), 3) / 4 - c, one temporary per step
+    vector_t t1 = vector_mul(a, b), t2 = vector_scalar_mul(c, 1.7f), t3 = vector_add(t1, t2);
+    vector_t t4 = vector_scalar_sub(a, 0.5f), t5 = vector_div(t3, t4), t6 = vector_pow(t5, 3.0f);
+    vector_t t7 = vector_scalar_div(t6, 4.0f), eager = vector_sub(t7, c);
+    memcpy(t->out[slot][0], eager.data, n * sizeof(float));
+    vector_t tmp[] = { t1, t2, t3, t4, t5, t6, t7, eager };
+    for (size_t i = 0; i < sizeof tmp / sizeof tmp[0]; i++) vector_free(&tmp[i]);
+
+    // the same tree evaluated into a copy of a that is also its leaf
+    vector_t dst = { .size = n, .data = t->out[slot][1] };
+    memcpy(dst.data, a.data, n * sizeof(float));
+    vec_expr_graph_t g;
+    vec_expr_init(&g);
+    vec_expr_t ea = vec_expr_leaf(&g, dst), ec = vec_expr_leaf(&g, c);
+    vec_expr_t e = vec_expr_add(&g, vec_expr_mul(&g, ea, vec_expr_leaf(&g, b)), vec_expr_scalar_mul(&g, ec, 1.7f));
+    e = vec_expr_div(&g, e, vec_expr_scalar_sub(&g, ea, 0.5f));
+    e = vec_expr_sub(&g, vec_expr_scalar_div(&g, vec_expr_pow(&g, e, 3.0f), 4.0f), ec);
+    if (!vec_expr_eval_to(&g, e, &dst)) memset(dst.data, 0xff, n * sizeof(float));
+}
+
+/**
+ * @brief A multi-op vec_expr evaluated into a buffer that is one of its
+ *        leaves (used twice), against the eager vector_* sequence, at the
+ *        scalar level and at `isa`, for sizes around VEC_EXPR_BLOCK.
+ */
+static bool check_expr_bitexact(vec_isa_t isa)
+{
+    static expr_check_t t;
+    static const size_t sizes[] = { 1, 7, VEC_EXPR_BLOCK - 1, VEC_EXPR_BLOCK, VEC_EXPR_BLOCK + 1, 1000 };
+    for (int k = 0; k < 3; k++) fill_pattern(t.src[k], 1000, k, 0.37f, -17.0f);
+    for (size_t j = 0; j < sizeof sizes / sizeof sizes[0]; j++) {
+        t.n = sizes[j];
+        size_t bytes = t.n * sizeof(float);
+        if (!run_levels(isa, expr_run, &t) || memcmp(t.out[0][0], t.out[0][1], bytes) != 0 ||
+            memcmp(t.out[1][0], t.out[1][1], bytes) != 0 || memcmp(t.out[0][0], t.out[1][0], bytes) != 0) return false;
+    }
+    return true;
+}
+
+// field by field: the struct has padding after `distance`
+static bool hits_equal(const vknn_hit_t *a, const vknn_hit_t *b, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        if (a[i].index != b[i].index || memcmp(&a[i].distance, &b[i].distance, sizeof(float)) != 0) return false;
+    }
+    return true;
+}
+
+typedef struct {
+    size_t dim, n;
+    vknn_metric_t metric;
+    float rows[12 * 40], queries[6 * 40], dist[2][12];
+    vknn_hit_t hits[2][6 * 5];
+} knn_check_t;
+
+static void knn_run(void *ctx, int slot)
+{
+    knn_check_t *t = ctx;
+    vcoll_t c = vcoll_alloc(t->dim, 0);
+    for (size_t i = 0; i < t->n; i++) vcoll_push(&c, t->rows + i * t->dim);
+    vcoll_distances(&c, t->metric, t->queries, t->dist[slot]);
+    vcoll_search_batch(&c, t->metric, t->queries, 6, 5, t->hits[slot]);
+    vcoll_free(&c);
+}
+
+/**
+ * @brief Collection distances and batch top-k at `isa` and at the scalar
+ *        level, for dimensions 1..40 with 0..12 rows and 6 queries, every
+ *        metric, compared bit for bit.
+ */
+static bool check_knn_bitexact(vec_isa_t isa)
+{
+    static knn_check_t t;
+    fill_pattern(t.rows, 12 * 40, 0, 0.11f, -5.0f);
+    fill_pattern(t.queries, 6 * 40, 1, 0.07f, -3.0f);
+    for (t.dim = 1; t.dim <= 40; t.dim++) {
+        for (t.n = 0; t.n <= 12; t.n++) {
+            for (int metric = VKNN_L2; metric <= VKNN_COSINE; metric++) {
+                t.metric = (vknn_metric_t)metric;
+                if (!run_levels(isa, knn_run, &t) || memcmp(t.dist[0], t.dist[1], t.n * sizeof(float)) != 0 ||
+                    !hits_equal(t.hits[0], t.hits[1], 6 * 5)) return false;
+            }
+        }
+    }
+    return true;
+}
+
+enum { MB_N = 1024 };
+
+// math_batch.h promises NaN where the scalar function gives NaN, not the same payload
+static bool same_result_f(float a, float b) { return (isnan(a) && isnan(b)) || memcmp(&a, &b, sizeof a) == 0; }
+static bool same_result_d(double a, double b) { return (isnan(a) && isnan(b)) || memcmp(&a, &b, sizeof a) == 0; }
+
+static uint64_t batch_rng(uint64_t *s)
+{
+    *s ^= *s << 13, *s ^= *s >> 7, *s ^= *s << 17;
+    return *s;
+}
+
+/*
+ * Signed zeros, subnormals of both widths, the largest values, infinities,
+ * NaN and negatives first, then alternately random bit patterns (every
+ * exponent, NaN payloads included) and random values in [-80, 80).
+ */
+static void fill_batch_inputs(float *f, double *d, int n)
+{
+    static const double special[] = { 0.0, -0.0, 1.0, -1.0, 0.5, 2.0, -2.5, 1e-40, -1e-40, 1e-310, -1e-310,
+                                      1.17549435e-38, 3.0e38, 1.7e308, INFINITY, -INFINITY, NAN, -NAN };
+    int ns = (int)(sizeof special / sizeof special[0]);
+    uint64_t s = 0x9e3779b97f4a7c15u;
+    for (int i = 0; i < n; i++) {
+        uint64_t r = batch_rng(&s);
+        uint32_t r32 = (uint32_t)(r >> 32);
+        if (i < ns) {
+            d[i] = special[i], f[i] = (float)special[i];
+        } else if (i % 2) {
+            memcpy(&d[i], &r, sizeof r), memcpy(&f[i], &r32, sizeof r32);
+        } else {
+            d[i] = (double)(r >> 11) * 0x1p-53 * 160.0 - 80.0, f[i] = (float)d[i];
+        }
+    }
+}
+
+/*
+ * Each *_array call against its scalar function over the whole input at a
+ * few head offsets (so every tail length mod 4 is hit, with src and dst
+ * misaligned to each other), once out of place and once in place.
+ */
+#define BATCH_CHECK(P, T, SAME)                                                     \
+static bool P##_unary_ok(void (*array)(T *, const T *, size_t), T (*f)(T), const T *src) \
+{                                                                                   \
+    static T dst[MB_N];                                                             \
+    for (size_t off = 0; off < 4; off++) {                                          \
+        size_t n = MB_N - off;                                                      \
+        array(dst, src + off, n);                                                   \
+        for (size_t i = 0; i < n; i++) if (!SAME(dst[i], f(src[off + i]))) return false; \
+        memcpy(dst, src + off, n * sizeof(T));                                      \
+        array(dst, dst, n);                                                         \
+        for (size_t i = 0; i < n; i++) if (!SAME(dst[i], f(src[off + i]))) return false; \
+    }                                                                               \
+    return true;                                                                    \
+}                                                                                   \
+                                                                                    \
+static bool P##_pow_ok(void (*array)(T *, const T *, T, size_t), T (*f)(T, T), const T *src, T y) \
+{                                                                                   \
+    static T dst[MB_N];                                                             \
+    for (size_t off = 0; off < 4; off++) {                                          \
+        size_t n = MB_N - off;                                                      \
+        array(dst, src + off, y, n);                                                \
+        for (size_t i = 0; i < n; i++) if (!SAME(dst[i], f(src[off + i], y))) return false; \
+        memcpy(dst, src + off, n * sizeof(T));                                      \
+        array(dst, dst, y, n);                                                      \
+        for (size_t i = 0; i < n; i++) if (!SAME(dst[i], f(src[off + i], y))) return false; \
+    }                                                                               \
+    return true;                                                                    \
+}                                                                                   \
+                                                                                    \
+/* y is x read backwards, so specials meet finite values and each other      */     \
+static bool P##_hypot_ok(void (*array)(T *, const T *, const T *, size_t), T (*f)(T, T), const T *x) \
+{                                                                                   \
+    static T y[MB_N], dst[MB_N];                                                    \
+    for (size_t i = 0; i < MB_N; i++) y[i] = x[MB_N - 1 - i];                       \
+    for (size_t off = 0; off < 4; off++) {                                          \
+        size_t n = MB_N - off;                                                      \
+        array(dst, x + off, y, n);                                                  \
+        for (size_t i = 0; i < n; i++) if (!SAME(dst[i], f(x[off + i], y[i]))) return false; \
+        memcpy(dst, x + off, n * sizeof(T));                                        \
+        array(dst, dst, y, n);                                                      \
+        for (size_t i = 0; i < n; i++) if (!SAME(dst[i], f(x[off + i], y[i]))) return false; \
+    }                                                                               \
+    return true;                                                                    \
+}
+
+BATCH_CHECK(batch_f, float, same_result_f)
+BATCH_CHECK(batch_d, double, same_result_d)
+
+// fast_sincosf_poly_array out of place, with s aliasing x and with c aliasing x
+static bool batch_sincos_ok(const float *x)
+{
+    static float s[MB_N], c[MB_N];
+    for (int alias = 0; alias < 3; alias++) {
+        for (size_t off = 0; off < 4; off++) {
+            size_t n = MB_N - off;
+            const float *in = x + off;
+            if (alias == 1) in = memcpy(s, x + off, n * sizeof(float));
+            if (alias == 2) in = memcpy(c, x + off, n * sizeof(float));
+            fast_sincosf_poly_array(s, c, in, n);
+            for (size_t i = 0; i < n; i++) {
+                float ws, wc;
+                fast_sincosf_poly(x[off + i], &ws, &wc);
+                if (!same_result_f(s[i], ws) || !same_result_f(c[i], wc)) return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Every math_batch.h *_array function at `isa` against its scalar
+ *        function, element for element, on special values and a random
+ *        sweep, out of place and in place; pow over a few exponents of
+ *        each kind, sincos also with s or c aliasing x.
+ */
+static bool check_batch_bitexact(vec_isa_t isa)
+{
+    static float xf[MB_N];
+    static double xd[MB_N];
+    static const double ys[] = { 2.2, -0.5, 0.0, 3.0, -7.0, 0.5, 1e-3, NAN };
+    vec_isa_t saved = vec_isa_active();
+    if (!vec_isa_select(isa)) return false;
+    fill_batch_inputs(xf, xd, MB_N);
+
+    bool ok = batch_f_unary_ok(fast_inv_sqrt_array, fast_inv_sqrt, xf) &&
+              batch_f_unary_ok(fast_sqrt_array, fast_sqrt, xf) &&
+              batch_f_unary_ok(fast_log2f_array, fast_log2f, xf) &&
+              batch_f_unary_ok(fast_exp2f_array, fast_exp2f, xf) &&
+              batch_f_unary_ok(cbrt_f_array, cbrt_f, xf) &&
+              batch_f_unary_ok(fast_log2f_poly_array, fast_log2f_poly, xf) &&
+              batch_f_unary_ok(fast_exp2f_poly_array, fast_exp2f_poly, xf) &&
+              batch_f_unary_ok(sqrt_exact_f_array, sqrt_exact_f, xf) &&
+              batch_f_hypot_ok(hypot_f_array, hypot_f, xf) && batch_sincos_ok(xf) &&
+              batch_d_unary_ok(fast_inv_sqrtd_array, fast_inv_sqrtd, xd) &&
+              batch_d_unary_ok(fast_sqrtd_array, fast_sqrtd, xd) &&
+              batch_d_unary_ok(fast_log2d_array, fast_log2d, xd) &&
+              batch_d_unary_ok(fast_exp2d_array, fast_exp2d, xd) &&
+              batch_d_unary_ok(cbrt_d_array, cbrt_d, xd) &&
+              batch_d_unary_ok(sqrt_exact_d_array, sqrt_exact_d, xd) &&
+              batch_d_hypot_ok(hypot_d_array, hypot_d, xd);
+    for (size_t j = 0; j < sizeof ys / sizeof ys[0] && ok; j++) {
+        ok = batch_f_pow_ok(fast_powf_array, fast_powf, xf, (float)ys[j]) &&
+             batch_f_pow_ok(fast_powf_poly_array, fast_powf_poly, xf, (float)ys[j]) &&
+             batch_d_pow_ok(fast_powd_array, fast_powd, xd, ys[j]);
+    }
+
+    vec_isa_select(saved);
+    return ok;
+}
+
+/*
+ * One element of pow_f_array / pow_d_array as math_batch.h documents it:
+ * pow_fi / pow_di for an integral |y| <= POW_PLAN_MAX_INT, that chain for
+ * the integer part times sqrt(x + 0) (then the reciprocal) for a
+ * half-integral one, and the general tier otherwise.
+ */
+static float pow_array_ref_f(float x, float y)
+{
+    float a = fabsf(y);
+    if (!(a <= POW_PLAN_MAX_INT)) {
+        return FAST_MATH_TIER == FAST_MATH_PRECISE ? fast_powf_precise(x, y) : fast_powf_poly(x, y);
+    }
+    int k = (int)a;
+    if ((float)k == a) return pow_fi(x, (int)y);
+    if (a - (float)k != 0.5f) {
+        return FAST_MATH_TIER == FAST_MATH_PRECISE ? fast_powf_precise(x, y) : fast_powf_poly(x, y);
+    }
+    float r = pow_fi(x, k) * sqrt_exact_f(x + 0.0f);
+    return y < 0 ? 1 / r : r;
+}
+
+static double pow_array_ref_d(double x, double y)
+{
+    double a = fabs(y);
+    if (!(a <= POW_PLAN_MAX_INT)) return fast_powd_precise(x, y);
+    int k = (int)a;
+    if ((double)k == a) return pow_di(x, (int)y);
+    if (a - (double)k != 0.5) return fast_powd_precise(x, y);
+    double r = pow_di(x, k) * sqrt_exact_d(x + 0.0);
+    return y < 0 ? 1 / r : r;
+}
+
+/**
+ * @brief pow_f_array / pow_d_array at `isa` against pow_fi / pow_di for
+ *        every integer y in -64..64, and against the half-integer and
+ *        general tiers, out of place and in place; a negative x with a
+ *        half-integral y must be NaN, as on the general path.
+ */
+static bool check_pow_plan(vec_isa_t isa)
+{
+    static float xf[MB_N];
+    static double xd[MB_N];
+    static const double general[] = { 2.2, -0.3, 1e-3, 64.5, -64.5, 65.0, -100.0, INFINITY, NAN };
+    vec_isa_t saved = vec_isa_active();
+    if (!vec_isa_select(isa)) return false;
+    fill_batch_inputs(xf, xd, MB_N);
+    // every fourth sweep value near 1, where high powers stay finite
+    for (int i = 20; i < MB_N; i += 4) xd[i] = (double)i / MB_N * 3.0 - 1.5, xf[i] = (float)xd[i];
+
+    bool ok = true;
+    for (int y = -64; y <= 64 && ok; y++) {
+        ok = batch_f_pow_ok(pow_f_array, pow_array_ref_f, xf, (float)y) &&
+             batch_d_pow_ok(pow_d_array, pow_array_ref_d, xd, y) &&
+             (y == 64 || (batch_f_pow_ok(pow_f_array, pow_array_ref_f, xf, (float)y + 0.5f) &&
+                          batch_d_pow_ok(pow_d_array, pow_array_ref_d, xd, y + 0.5)));
+    }
+    for (size_t j = 0; j < sizeof general / sizeof general[0] && ok; j++) {
+        ok = batch_f_pow_ok(pow_f_array, pow_array_ref_f, xf, (float)general[j]) &&
+             batch_d_pow_ok(pow_d_array, pow_array_ref_d, xd, general[j]);
+    }
+    float nf[3] = { -4.0f, -1e-40f, -INFINITY };
+    double nd[3] = { -4.0, -1e-310, -INFINITY };
+    pow_f_array(nf, nf, 1.5f, 3);
+    pow_d_array(nd, nd, -2.5, 3);
+    for (int i = 0; i < 3 && ok; i++) ok = isnan(nf[i]) && isnan(nd[i]);
+
+    vec_isa_select(saved);
+    return ok;
+}
+
+/**
+ * @brief Map modes and error paths of vec_file.h on a scratch file: shared
+ *        writes synced and read back verified, private writes kept off the
+ *        file, then a corrupted payload, a bad alignment and a bad magic.
+ */
+static bool check_file_modes(const char *path)
+{
+    float data[5] = { 1, 2, 3, 4, 5 };
+    vector_t v = { .size = 5, .data = data };
+    vec_file_error_t err;
+    bool ok = vec_file_write(path, v, 0) == VEC_FILE_OK;
+
+    // shared: the write reaches the file and sync refreshes the checksum
+    vector_t m = vec_file_map(path, VEC_MAP_SHARED, &err);
+    ok = ok && m.data;
+    if (m.data) m.data[2] = 30.0f;
+    ok = ok && vec_file_sync(m) == VEC_FILE_OK;
+    vector_free(&m);
+    m = vec_file_map(path, VEC_MAP_READONLY | VEC_MAP_VERIFY, &err);
+    ok = ok && m.data && m.data[2] == 30.0f && vec_file_sync(m) == VEC_FILE_NOT_MAPPED;
+    vector_free(&m);
+
+    // private: copy-on-write, the file keeps 30
+    m = vec_file_map(path, VEC_MAP_PRIVATE, &err);
+    ok = ok && m.data;
+    if (m.data) m.data[2] = -1.0f;
+    vector_free(&m);
+    m = vec_file_map(path, VEC_MAP_READONLY | VEC_MAP_VERIFY, &err);
+    ok = ok && m.data && m.data[2] == 30.0f;
+    vector_free(&m);
+
+    vec_file_header_t h, bad;
+    ok = ok && vec_file_read_header(path, &h) == VEC_FILE_OK;
+    FILE *f = fopen(path, "r+b");
+    if (!f) return false;
+    unsigned char byte = 0x5a;
+    ok = ok && fseek(f, (long)h.data_offset + 5, SEEK_SET) == 0 && fwrite(&byte, 1, 1, f) == 1 && fflush(f) == 0;
+    m = vec_file_map(path, VEC_MAP_READONLY | VEC_MAP_VERIFY, &err);
+    ok = ok && !m.data && err == VEC_FILE_CHECKSUM;
+
+    bad = h;
+    bad.alignment = 48;
+    ok = ok && fseek(f, 0, SEEK_SET) == 0 && fwrite(&bad, sizeof bad, 1, f) == 1 && fflush(f) == 0;
+    m = vec_file_map(path, VEC_MAP_READONLY, &err);
+    ok = ok && !m.data && err == VEC_FILE_BAD_HEADER;
+
+    bad = h;
+    bad.magic[0] = 'X';
+    ok = ok && fseek(f, 0, SEEK_SET) == 0 && fwrite(&bad, sizeof bad, 1, f) == 1 && fflush(f) == 0;
+    m = vec_file_map(path, VEC_MAP_READONLY, &err);
+    ok = ok && !m.data && err == VEC_FILE_BAD_MAGIC && vec_file_read_header(path, &bad) == VEC_FILE_BAD_MAGIC;
+    fclose(f);
+    remove(path);
+    return ok;
+}
+
+/*
+ * Sparse dots the way vec_sparse.h defines them on dense arrays: the k-th
+ * product (over the i where a[i] != 0, and b[i] != 0 too when `both`)
+ * goes to lane k % SVEC_LANES, lanes added pairwise.
+ */
+static float sparse_ref_dot(const float *a, const float *b, size_t n, bool both)
+{
+    float lane[SVEC_LANES] = { 0 };
+    size_t k = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (a[i] != 0.0f && (!both || b[i] != 0.0f)) lane[k++ % SVEC_LANES] += a[i] * b[i];
+    }
+    for (int w = SVEC_LANES / 2; w > 0; w /= 2) {
+        for (int j = 0; j < w; j++) lane[j] += lane[j + w];
+    }
+    return lane[0];
+}
+
+static bool same_float(float a, float b) { return memcmp(&a, &b, sizeof a) == 0; }
+
+/**
+ * @brief Sparse vectors against dense arrays: from / to dense, svec_push,
+ *        svec_add, svec_dot_dense, and svec_dot both merging (similar nnz)
+ *        and galloping (nnz ratio >= SVEC_GALLOP, either side shorter).
+ */
+static bool check_sparse_reference(void)
+{
+    enum { N = 600 };
+    float d[3][N], sum[N];
+    for (int k = 0; k < 3; k++) fill_pattern(d[k], N, k, 0.37f, -17.0f);
+    for (int i = 0; i < N; i++) {
+        if (i % 3) d[0][i] = 0.0f;              // 200 entries
+        if (i % 2) d[1][i] = 0.0f;              // 300
+        if (i % 35) d[2][i] = 0.0f;             // 18, half of them off d[1]'s indices
+        sum[i] = d[0][i] + d[1][i];
+    }
+    svector_t s[3];
+    bool ok = true;
+    for (int k = 0; k < 3; k++) {
+        s[k] = svec_from_dense((vector_t){ .size = N, .data = d[k] });
+        vector_t back = svec_to_dense(s[k]);
+        ok = ok && back.data && memcmp(back.data, d[k], sizeof d[k]) == 0;
+        vector_free(&back);
+    }
+    ok = ok && s[1].nnz >= SVEC_GALLOP * s[2].nnz && s[1].nnz < SVEC_GALLOP * s[0].nnz;
+
+    svector_t pushed = svec_alloc(N, 0);
+    for (uint32_t i = 0; i < N; i++) {
+        if (d[0][i] != 0.0f) ok = ok && svec_push(&pushed, i, d[0][i]);
+    }
+    ok = ok && pushed.nnz == s[0].nnz && memcmp(pushed.index, s[0].index, s[0].nnz * sizeof(uint32_t)) == 0 &&
+         memcmp(pushed.value, s[0].value, s[0].nnz * sizeof(float)) == 0;
+    ok = ok && !svec_push(&pushed, 3, 1.0f) && !svec_push(&pushed, N, 1.0f);  // out of order, out of range
+    svec_free(&pushed);
+
+    svector_t added = svec_add(s[0], s[1]);
+    vector_t dense_sum = svec_to_dense(added);
+    ok = ok && added.nnz == (size_t)(N / 2 + N / 6) && dense_sum.data &&
+         memcmp(dense_sum.data, sum, sizeof sum) == 0;
+    vector_free(&dense_sum);
+    svec_free(&added);
+
+    ok = ok && same_float(svec_dot(s[0], s[1]), sparse_ref_dot(d[0], d[1], N, true));   // merge
+    ok = ok && same_float(svec_dot(s[1], s[2]), sparse_ref_dot(d[1], d[2], N, true));   // gallop through a
+    ok = ok && same_float(svec_dot(s[2], s[1]), sparse_ref_dot(d[2], d[1], N, true));   // gallop through b
+    ok = ok && same_float(svec_dot_dense(s[0], (vector_t){ .size = N, .data = d[1] }),
+                          sparse_ref_dot(d[0], d[1], N, false));
+    for (int k = 0; k < 3; k++) svec_free(&s[k]);
+    return ok;
+}
 
 int main(void)
 {
@@ -47,6 +991,10 @@ int main(void)
     print_vector("cross(v3,v2)", crossRes);
     vector_free(&crossRes);
 
+    // same cross product on stack values, no allocation
+    vec3f_t c3 = vec3f_cross(vec3f_from_vector(v3), vec3f_from_vector(v2));
+    printf("vec3f_cross(v3,v2) = [%f, %f, %f]\n", c3.x, c3.y, c3.z);
+
     float dotVal = vector_dot(v3, v2); // 1*2 + 2*2 + 3*2 = 2+4+6=12
     printf("dot(v3, v2) = %f\n", dotVal);
 
@@ -58,9 +1006,17 @@ int main(void)
     vector_t vpow = vector_pow(vcopy, 2.0f); // element-wise v3^2 => [1,4,9]
     print_vector("v3^2 =", vpow);
 
+    // non-integer exponents: half-integers go through sqrt, others exp2/log2
+    vector_t vhalf = vector_pow(vcopy, 1.5f);   // [1, 2.828427, 5.196152]
+    print_vector("v3^1.5 =", vhalf);
+    vector_t vreal = vector_pow(vcopy, -0.3f);  // ~[1, 0.812252, 0.719223], POLY-tier error
+    print_vector("v3^-0.3 =", vreal);
+
     // cleanup
     vector_free(&vcopy);
     vector_free(&vpow);
+    vector_free(&vhalf);
+    vector_free(&vreal);
 
     // integer exponent
     int base_i = 2, exp_i = 5;
@@ -84,10 +1040,253 @@ int main(void)
     float hVal = hypot_f(3.0f,4.0f);  // approximate sqrt(3^2+4^2)=5
     printf("hypot_f(3,4) = %f\n", hVal);
 
+    // arena-backed temporaries: no malloc inside the scope
+    vec_arena_t frame;
+    vec_arena_init(&frame, 4096);
+    VEC_ARENA_SCOPE(&frame) {
+        vector_t t = vector_add(vector_scalar_mul(v3, 2.0f), v2); // [4, 6, 8]
+        print_vector("arena: 2*v3 + v2 =", t);
+    }
+    printf("arena peak bytes = %zu\n", frame.peak);
+    vec_arena_reset(&frame);
+    vec_arena_destroy(&frame);
+
+    // pooled vectors are recycled through size-class free lists
+    vec_pool_t pool;
+    vec_pool_init(&pool, 0);
+    VEC_POOL_SCOPE(&pool) {
+        vector_t a = vector_copy(v3);
+        float *first = a.data;
+        vector_free(&a);
+        vector_t b = vector_copy(v3);
+        printf("pool reused block: %s\n", b.data == first ? "yes" : "no");
+        vector_free(&b);
+    }
+    vec_pool_destroy(&pool);
+
     vector_free(&v1);
     vector_free(&v2);
     vector_free(&v3);
 
+    // double vectors have the same operation set
+    dvector_t d1 = dvector(1.0, 2.0, 3.0);
+    dvector_t d2 = dvector(0.5, 0.25, 0.125);
+    dvector_t dsum = dvec_add(d1, d2);                  // [1.5, 2.25, 3.125]
+    print_dvector("d1 + d2 =", dsum);
+    printf("dot(d1, d2) = %f\n", dvec_dot(d1, d2));    // 0.5+0.5+0.375 = 1.375
+    printf("magnitude(d1) = %f\n", dvec_magnitude(d1)); // sqrt(14)
+    free_dvector(&d1);
+    free_dvector(&d2);
+    free_dvector(&dsum);
+
+    // half / bfloat16 storage: computed in fp32, rounded once on store
+    vector_t emb = vector_from_array(4, (const float[]){ 0.1f, -2.5f, 3.14159f, 1000.3f });
+    hvector_t he = hvec_from_vector(emb);
+    bvector_t be = bvec_from_vector(emb);
+    vector_t hw = hvec_to_vector(he), bw = bvec_to_vector(be);
+    print_vector("half(emb) =", hw);             // [0.099976, -2.5, 3.140625, 1000.5]
+    print_vector("bf16(emb) =", bw);             // [0.100098, -2.5, 3.140625, 1000]
+    printf("hvec_dot(emb, emb) = %f, bvec_dot_vector(emb, emb) = %f\n",
+           hvec_dot(he, he), bvec_dot_vector(be, emb));
+    hvec_free(&he);
+    bvec_free(&be);
+    vector_free(&hw);
+    vector_free(&bw);
+    vector_free(&emb);
+
+    // vectors saved to disk come back as zero-copy mappings
+    vector_t saved = vector_from_array(3, (const float[]){ 4.0f, 5.0f, 6.0f });
+    vec_file_error_t ferr = vec_file_write("cmath_demo.vec", saved, 0);
+    vector_t mapped = vec_file_map("cmath_demo.vec", VEC_MAP_READONLY | VEC_MAP_VERIFY, &ferr);
+    printf("mapped file: %s, equals saved: %s\n", vec_file_strerror(ferr),
+           vector_equals(mapped, saved) ? "yes" : "no");
+    vector_free(&mapped);                       // unmaps
+    vector_free(&saved);
+    remove("cmath_demo.vec");
+    printf("file map modes and errors: %s\n", check_file_modes("cmath_modes.vec") ? "ok" : "FAILED");
+
+    // the y column of packed xyz points, scaled in place through a strided view
+    float points[] = { 1, 2, 3,  4, 5, 6,  7, 8, 9 };
+    vec_view_t ys = vec_view_array(points, 1, 3, 3);
+    vec_view_scalar_mul_to(ys, ys, 10.0f);
+    vector_t ycol = vec_view_copy(ys);
+    print_vector("y column * 10 =", ycol);       // [20, 50, 80]
+    printf("sum of y = %f, points[4] = %f\n", vec_view_sum(ys), points[4]);
+    vector_free(&ycol);
+
+    // growable vectors: push doubles the capacity, the aligned allocator keeps 64-byte rows
+    vector_t grown = VEC_UNDEFINED;
+    VEC_ALLOCATOR_SCOPE(&VEC_ALIGNED_ALLOCATOR) {
+        for (int i = 0; i < 100; i++)
+            vector_push(&grown, (float)i);
+    }
+    printf("pushed %zu elements, capacity %zu, 64-byte aligned: %s\n", grown.size,
+           vector_capacity(grown), ((size_t)grown.data % VEC_ALIGN) == 0 ? "yes" : "no");
+    vector_shrink(&grown);
+    printf("after shrink: capacity %zu, sum = %f\n", vector_capacity(grown), vector_sum(grown));
+    vector_free(&grown);
+
+    // scoring two inputs against two weight rows: one GEMM instead of a dot per pair
+    matrix_t weights = matrix_from_array(2, 3, MAT_ROW_MAJOR, (const float[]){ 1, 2, 3,  4, 5, 6 });
+    matrix_t inputs = matrix_from_array(2, 3, MAT_ROW_MAJOR, (const float[]){ 1, 0, 1,  0, 1, 0 });
+    matrix_t scores = matrix_mul(inputs, matrix_transpose(weights));
+    print_matrix("inputs * weights^T =", scores);  // [[4, 10], [2, 5]]
+    vector_t first = vec_view_copy(matrix_row(inputs, 0));
+    vector_t single = matrix_mul_vector(weights, first);
+    print_vector("weights * inputs[0] =", single); // [4, 10]
+    vector_free(&single);
+    vector_free(&first);
+    matrix_free(&scores);
+    matrix_free(&inputs);
+    matrix_free(&weights);
+
+    // scale by 2 and move by (1, 0, -1): one call for the whole batch, no allocation
+    const float model[16] = { 2, 0, 0, 1,  0, 2, 0, 0,  0, 0, 2, -1,  0, 0, 0, 1 };
+    float corners[12] = { 0, 0, 0,  1, 0, 0,  0, 1, 0,  0, 0, 1 };
+    vec3_transform_points(model, corners, corners, 4);
+    printf("transformed corners:");
+    for (int i = 0; i < 4; i++) printf(" (%g, %g, %g)", corners[3 * i], corners[3 * i + 1], corners[3 * i + 2]);
+    printf("\n");                                  // (1, 0, -1) (3, 0, -1) (1, 2, -1) (1, 0, 1)
+
+    // prepared once: inverse and normal matrices are cached, every apply reuses them
+    xform_t placed = xform_make(model);
+    xform_apply(&placed, XFORM_INVERSE_POINTS, corners, corners, 4);
+    float normal[3] = { 0, 0, 1 };
+    xform_apply(&placed, XFORM_NORMALS, normal, normal, 1);
+    printf("back to model space: (%g, %g, %g) ... (%g, %g, %g), normal (%g, %g, %g)\n",
+           corners[0], corners[1], corners[2], corners[9], corners[10], corners[11],
+           normal[0], normal[1], normal[2]);  // (0, 0, 0) ... (0, 0, 1), normal (0, 0, 0.5)
+
+    // quarter turn about z, then halfway back along the arc to the identity
+    vector_t ex = vector_from_array(3, (const float[]){ 1, 0, 0 });
+    vector_t turned = vec_rotate_z(ex, 1.57079637f);
+    quat_t half = quat_slerp(quat_identity(), quat_from_axis_angle(0, 0, 1, 1.57079637f), 0.5f);
+    float diag[3] = { 1, 0, 0 };
+    quat_rotate_point(half, diag);
+    printf("rotated: (%.3f, %.3f, %.3f), halfway (%.3f, %.3f, %.3f)\n", turned.data[0], turned.data[1],
+           turned.data[2], diag[0], diag[1], diag[2]);  // (0, 1, 0), halfway (0.707, 0.707, 0)
+    vector_free(&turned);
+    vector_free(&ex);
+
+    // generated map vs the function-pointer fallback: same expression, same bits
+    vector_t from = vector_from_array(3, (const float[]){ 0, 10, -4 });
+    vector_t to = vector_from_array(3, (const float[]){ 1, 20, 4 });
+    vector_t amount = vector_from_array(3, (const float[]){ 0.5f, 0.25f, 1 });
+    vector_t mixed = vec_mix(from, to, amount);
+    vector_t called = vec_map3(from, to, amount, mix);
+    print_vector("vec_mix =", mixed);  // [0.5, 12.5, 4]
+    printf("matches vec_map3: %s\n", memcmp(mixed.data, called.data, 3 * sizeof(float)) == 0 ? "yes" : "NO");
+    vector_free(&called);
+    vector_free(&mixed);
+    vector_free(&amount);
+    vector_free(&to);
+    vector_free(&from);
+
+    // y = 2x + y in one pass, rounded once per element
+    vector_t xv = vector_from_array(3, (const float[]){ 1, 2, 3 });
+    vector_t yv = vector_from_array(3, (const float[]){ 10, 20, 30 });
+    vector_axpy(2.0f, xv, yv);
+    print_vector("axpy 2x + y =", yv);  // [12, 24, 36]
+    vector_clamp(yv, yv, 15.0f, 30.0f);
+    print_vector("clamped to [15, 30] =", yv);  // [15, 24, 30]
+    vector_free(&yv);
+    vector_free(&xv);
+
+    // three active features out of a million: the dots touch three weights
+    vector_t weights1m = vector_default(1u << 20, 0.5f);
+    weights1m.data[7] = 2.0f;
+    svector_t features = svec_from_arrays(1u << 20, (const uint32_t[]){ 7, 4096, 999999 },
+                                          (const float[]){ 1, 3, -1 }, 3);
+    svector_t other = svec_from_arrays(1u << 20, (const uint32_t[]){ 7, 500000 }, (const float[]){ 4, 9 }, 2);
+    printf("sparse score = %g, sparse . sparse = %g\n", svec_dot_dense(features, weights1m),
+           svec_dot(features, other));  // 3, 4
+    svec_free(&other);
+    svec_free(&features);
+    vector_free(&weights1m);
+    printf("sparse vectors match the dense reference: %s\n", check_sparse_reference() ? "yes" : "NO");
+
+    // the two stored points closest to (1, 1, 0), nearest first
+    vcoll_t stored = vcoll_alloc(3, 4);
+    vcoll_push(&stored, (const float[]){ 0, 0, 0 });
+    vcoll_push(&stored, (const float[]){ 1, 1, 1 });
+    vcoll_push(&stored, (const float[]){ 2, 2, 0 });
+    vcoll_push(&stored, (const float[]){ -1, 1, 0 });
+    vknn_hit_t nearest[2];
+    vcoll_search(&stored, VKNN_L2, (const float[]){ 1, 1, 0 }, 2, nearest);
+    printf("nearest = #%zu (%g), #%zu (%g)\n", nearest[0].index, nearest[0].distance,
+           nearest[1].index, nearest[1].distance);  // #1 (1), #0 (2)
+    vcoll_free(&stored);
+
+    // every available SIMD level must match the scalar kernels bit-for-bit
+    printf("active isa = %s\n", vec_isa_name(vec_isa_active()));
+    for (vec_isa_t isa = VEC_ISA_SSE2, top = vec_isa_detect(); isa <= top; isa = (vec_isa_t)(isa + 1)) {
+        printf("%s kernels bit-exact: %s\n", vec_isa_name(isa),
+               check_kernels_bitexact(isa) ? "yes" : "NO");
+        printf("%s double kernels bit-exact: %s\n", vec_isa_name(isa),
+               check_dkernels_bitexact(isa) ? "yes" : "NO");
+        printf("%s half conversions bit-exact: %s\n", vec_isa_name(isa),
+               check_half_bitexact(isa) ? "yes" : "NO");
+        printf("%s matrix kernels bit-exact: %s\n", vec_isa_name(isa),
+               check_mat_bitexact(isa) ? "yes" : "NO");
+        printf("%s matrix kernels match the reference: %s\n", vec_isa_name(isa),
+               check_mat_reference(isa) ? "yes" : "NO");
+        printf("%s transform kernels bit-exact: %s\n", vec_isa_name(isa),
+               check_xform_bitexact(isa) ? "yes" : "NO");
+        printf("%s rotation kernels bit-exact: %s\n", vec_isa_name(isa),
+               check_quat_bitexact(isa) ? "yes" : "NO");
+        printf("%s level-1 kernels bit-exact: %s\n", vec_isa_name(isa),
+               check_blas1_bitexact(isa) ? "yes" : "NO");
+        printf("%s sparse kernels bit-exact: %s\n", vec_isa_name(isa),
+               check_sparse_bitexact(isa) ? "yes" : "NO");
+        printf("%s nearest-neighbour kernels bit-exact: %s\n", vec_isa_name(isa),
+               check_knn_bitexact(isa) ? "yes" : "NO");
+        printf("%s deferred expressions bit-exact: %s\n", vec_isa_name(isa),
+               check_expr_bitexact(isa) ? "yes" : "NO");
+        printf("%s batch math bit-exact: %s\n", vec_isa_name(isa),
+               check_batch_bitexact(isa) ? "yes" : "NO");
+        printf("%s pow plans match pow_fi / pow_di: %s\n", vec_isa_name(isa),
+               check_pow_plan(isa) ? "yes" : "NO");
+    }
+
+    // reductions give the same bits with and without the thread pool
+    vector_t big = vector_default(1u << 20, 0.1f);
+    vector_t big2 = vector_scalar_mul(big, 3.0f);
+    float serial = vector_dot(big, big2);
+    vcoll_t corpus = vcoll_alloc(48, 1u << 14);
+    float row[48];
+    for (unsigned int i = 0; i < 1u << 14; i++) {
+        for (int d = 0; d < 48; d++) row[d] = (float)((i * 31u + (unsigned int)d * 17u) % 1009u) * 0.01f;
+        vcoll_push(&corpus, row);
+    }
+    vknn_hit_t top_serial[3 * 10], top_parallel[3 * 10];
+    vcoll_search_batch(&corpus, VKNN_COSINE, corpus.data, 3, 10, top_serial);
+    vec_parallel_init(4);
+    vec_parallel_set_threshold(1u << 16);
+    float parallel = vector_dot(big, big2);
+    printf("parallel dot on %u threads = %f, matches serial: %s\n",
+           vec_parallel_threads(), parallel, parallel == serial ? "yes" : "NO");
+    vcoll_search_batch(&corpus, VKNN_COSINE, corpus.data, 3, 10, top_parallel);
+    printf("parallel top-10 of %zu vectors matches serial: %s\n", corpus.count,
+           hits_equal(top_serial, top_parallel, 3 * 10) ? "yes" : "NO");
+    vcoll_free(&corpus);
+
+    // streamed chunk by chunk from disk, the reductions still give the same bits
+    vec_file_write("cmath_stream.vec", big, 0);
+    vec_stream_t *sa = vec_stream_open_file("cmath_stream.vec", 1u << 16);
+    vec_stream_t *sb = vec_stream_open_vector(big2, 1u << 16);
+    float streamed = vec_stream_dot(sa, sb);
+    printf("streamed dot in %zu-element chunks = %f, matches: %s\n",
+           vec_stream_chunk(sa), streamed, streamed == serial ? "yes" : "NO");
+    vec_stream_close(sa);
+    vec_stream_close(sb);
+    remove("cmath_stream.vec");
+    vec_parallel_shutdown();
+    vector_free(&big);
+    vector_free(&big2);
+
+    // where the calls and bytes went (configure with -DCMATH_STATS=ON to count)
+    vec_stats_dump(stdout, VEC_STATS_TABLE);
+
     // Done
     printf("=== All tests completed ===\n");
     return 0;
@@ -0,0 +1,796 @@
+#include <mat.h>
+#include <vec_simd.h>
+#include <vec_parallel.h>
+#include <vec_alloc.h>
+#include <math.h>
+#include <limits.h>
+#include <stdatomic.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    #define VEC_SIMD_X86 1
+    #include <immintrin.h>
+#endif
+
+#ifdef __GNUC__
+    #define UNROLL _Pragma("GCC unroll 32")
+#else
+    #define UNROLL
+#endif
+
+const matrix_t MAT_UNDEFINED = {0, 0, NULL, 0, MAT_ROW_MAJOR, NULL};
+const dmatrix_t DMAT_UNDEFINED = {0, 0, NULL, 0, MAT_ROW_MAJOR, NULL};
+
+/*
+ * Kernels for one element type at one level:
+ *
+ *   gemm - C[r][j] for an mr x nr tile (row-major, ldc apart) from a packed
+ *          sliver of A (k steps of mr elements) and of B (k steps of nr):
+ *          acc = fused sum over p in order, then C = fma(alpha, acc, beta*C),
+ *          or alpha*acc when beta == 0
+ *   dot4 - four row dot products with x, lane p % lanes fused in order,
+ *          lanes added pairwise
+ *   axpy - acc[i] = fma(a[i + j*lda], x[j], acc[i]) for j = 0 .. n-1, i < m
+ *
+ * Every level runs the same fused operations in the same order, so the
+ * results do not depend on the level.
+ */
+#define MAT_KERNELS_T(T)                                                            \
+    struct {                                                                        \
+        size_t mr, nr;                                                              \
+        void (*gemm)(size_t k, T alpha, const T *a, const T *b, T beta, T *c, size_t ldc); \
+        void (*dot4)(size_t k, const T *const *a, const T *x, T *out);              \
+        void (*axpy)(size_t m, size_t n, const T *a, size_t lda, const T *x, T *acc); \
+    }
+
+typedef MAT_KERNELS_T(float) mat_kernels_t;
+typedef MAT_KERNELS_T(double) dmat_kernels_t;
+
+#define T_f float
+#define T_d double
+#define FMA_f(a, b, c) fmaf(a, b, c)
+#define FMA_d(a, b, c) fma(a, b, c)
+#define GL_f MAT_GEMV_LANES
+#define GL_d (MAT_GEMV_LANES / 2)
+#define KT_f mat_kernels_t
+#define KT_d dmat_kernels_t
+
+#define MAT_TILE_MAX 512                // largest mr * nr of any level
+
+// pairwise, like the vec_simd.c reductions
+#define DEFINE_COMBINE(E)                                                           \
+static inline T_##E combine_lanes_##E(T_##E *lane)                                  \
+{                                                                                   \
+    for (int w = GL_##E / 2; w > 0; w /= 2) {                                       \
+        for (int j = 0; j < w; j++) lane[j] += lane[j + w];                         \
+    }                                                                               \
+    return lane[0];                                                                 \
+}
+
+DEFINE_COMBINE(f)
+DEFINE_COMBINE(d)
+
+/****************************************************SCALAR***************************************************/
+
+/*
+ * The reference kernels. SSE2 has no FMA, so it uses these too. The tails
+ * of the SIMD kernels are the same statements.
+ */
+#define DOT4_TAIL(E)                                                                \
+    for (; p < k; p++) {                                                            \
+        for (int r = 0; r < 4; r++) {                                               \
+            lane[r][p % GL_##E] = FMA_##E(a[r][p], x[p], lane[r][p % GL_##E]);      \
+        }                                                                           \
+    }                                                                               \
+    for (int r = 0; r < 4; r++) out[r] = combine_lanes_##E(lane[r]);
+
+#define AXPY_TAIL(E)                                                                \
+    for (; i < m; i++) {                                                            \
+        T_##E s = acc[i];                                                           \
+        for (size_t j = 0; j < n; j++) s = FMA_##E(a[i + j * lda], x[j], s);        \
+        acc[i] = s;                                                                 \
+    }
+
+#define MR_scalar 4
+#define NR_scalar 4
+
+#define SCALAR_KERNELS(E)                                                           \
+static void gemm_scalar_##E(size_t k, T_##E alpha, const T_##E *a, const T_##E *b,  \
+                            T_##E beta, T_##E *c, size_t ldc)                       \
+{                                                                                   \
+    T_##E acc[MR_scalar][NR_scalar] = { { 0 } };                                    \
+    for (size_t p = 0; p < k; p++, a += MR_scalar, b += NR_scalar) {                \
+        for (int r = 0; r < MR_scalar; r++) {                                       \
+            for (int j = 0; j < NR_scalar; j++) acc[r][j] = FMA_##E(a[r], b[j], acc[r][j]); \
+        }                                                                           \
+    }                                                                               \
+    for (int r = 0; r < MR_scalar; r++) {                                           \
+        for (int j = 0; j < NR_scalar; j++) {                                       \
+            T_##E *cp = c + r * ldc + j;                                            \
+            *cp = beta == 0 ? alpha * acc[r][j] : FMA_##E(alpha, acc[r][j], beta * *cp); \
+        }                                                                           \
+    }                                                                               \
+}                                                                                   \
+static void dot4_scalar_##E(size_t k, const T_##E *const *a, const T_##E *x, T_##E *out) \
+{                                                                                   \
+    T_##E lane[4][GL_##E] = { { 0 } };                                              \
+    size_t p = 0;                                                                   \
+    DOT4_TAIL(E)                                                                    \
+}                                                                                   \
+static void axpy_scalar_##E(size_t m, size_t n, const T_##E *a, size_t lda,         \
+                            const T_##E *x, T_##E *acc)                             \
+{                                                                                   \
+    size_t i = 0;                                                                   \
+    AXPY_TAIL(E)                                                                    \
+}                                                                                   \
+static const KT_##E mat_kernels_scalar_##E = {                                      \
+    MR_scalar, NR_scalar, gemm_scalar_##E, dot4_scalar_##E, axpy_scalar_##E         \
+};
+
+SCALAR_KERNELS(f)
+SCALAR_KERNELS(d)
+
+#ifdef VEC_SIMD_X86
+
+/*
+ * Register tiles: AVX2 has 16 registers, a 6 x 2-register tile leaves
+ * room for two B vectors and one broadcast; AVX-512 has 32, 8 x 2 leaves
+ * plenty to hide the FMA latency.
+ */
+#define TARGET_avx2   __attribute__((target("avx2,fma")))
+#define TARGET_avx512 __attribute__((target("avx512f")))
+#define TARGET_avx2_d   TARGET_avx2
+#define TARGET_avx512_d TARGET_avx512
+
+#define E_avx2     f
+#define E_avx512   f
+#define E_avx2_d   d
+#define E_avx512_d d
+
+#define VEC_avx2     __m256
+#define VEC_avx512   __m512
+#define VEC_avx2_d   __m256d
+#define VEC_avx512_d __m512d
+
+#define W_avx2     8
+#define W_avx512   16
+#define W_avx2_d   4
+#define W_avx512_d 8
+
+#define MR_avx2     6
+#define MR_avx512   8
+#define MR_avx2_d   6
+#define MR_avx512_d 8
+#define NV 2                            // B vectors per tile row
+#define NR_(key) (NV * W_##key)
+
+#define LOAD_avx2(p)      _mm256_load_ps(p)
+#define LOADU_avx2(p)     _mm256_loadu_ps(p)
+#define STOREU_avx2(p, v) _mm256_storeu_ps(p, v)
+#define SET1_avx2(s)      _mm256_set1_ps(s)
+#define MUL_avx2(a, b)    _mm256_mul_ps(a, b)
+#define FMA_avx2(a, b, c) _mm256_fmadd_ps(a, b, c)
+
+#define LOAD_avx512(p)      _mm512_load_ps(p)
+#define LOADU_avx512(p)     _mm512_loadu_ps(p)
+#define STOREU_avx512(p, v) _mm512_storeu_ps(p, v)
+#define SET1_avx512(s)      _mm512_set1_ps(s)
+#define MUL_avx512(a, b)    _mm512_mul_ps(a, b)
+#define FMA_avx512(a, b, c) _mm512_fmadd_ps(a, b, c)
+
+#define LOAD_avx2_d(p)      _mm256_load_pd(p)
+#define LOADU_avx2_d(p)     _mm256_loadu_pd(p)
+#define STOREU_avx2_d(p, v) _mm256_storeu_pd(p, v)
+#define SET1_avx2_d(s)      _mm256_set1_pd(s)
+#define MUL_avx2_d(a, b)    _mm256_mul_pd(a, b)
+#define FMA_avx2_d(a, b, c) _mm256_fmadd_pd(a, b, c)
+
+#define LOAD_avx512_d(p)      _mm512_load_pd(p)
+#define LOADU_avx512_d(p)     _mm512_loadu_pd(p)
+#define STOREU_avx512_d(p, v) _mm512_storeu_pd(p, v)
+#define SET1_avx512_d(s)      _mm512_set1_pd(s)
+#define MUL_avx512_d(a, b)    _mm512_mul_pd(a, b)
+#define FMA_avx512_d(a, b, c) _mm512_fmadd_pd(a, b, c)
+
+#define T_(key) CAT(T_, E_##key)
+#define CAT_(a, b) a##b
+#define CAT(a, b) CAT_(a, b)
+
+// dot4: GL / W registers of lanes per row; axpy: AU independent vectors of y
+#define AU 4
+#define RV_(key) (CAT(GL_, E_##key) / W_##key)
+
+/*
+ * The packed B sliver is 64-byte aligned with rows of nr elements, so its
+ * loads are aligned; C rows are not, so the epilogue uses unaligned ones.
+ */
+#define SIMD_KERNELS(key)                                                           \
+static TARGET_##key void gemm_##key(size_t k, T_(key) alpha, const T_(key) *a,      \
+                                    const T_(key) *b, T_(key) beta, T_(key) *c, size_t ldc) \
+{                                                                                   \
+    VEC_##key acc[MR_##key][NV];                                                    \
+    UNROLL for (int r = 0; r < MR_##key; r++) {                                     \
+        UNROLL for (int v = 0; v < NV; v++) acc[r][v] = SET1_##key(0);              \
+    }                                                                               \
+    for (size_t p = 0; p < k; p++, a += MR_##key, b += NR_(key)) {                  \
+        VEC_##key bv[NV];                                                           \
+        UNROLL for (int v = 0; v < NV; v++) bv[v] = LOAD_##key(b + v * W_##key);    \
+        UNROLL for (int r = 0; r < MR_##key; r++) {                                 \
+            VEC_##key ar = SET1_##key(a[r]);                                        \
+            UNROLL for (int v = 0; v < NV; v++) acc[r][v] = FMA_##key(ar, bv[v], acc[r][v]); \
+        }                                                                           \
+    }                                                                               \
+    VEC_##key va = SET1_##key(alpha), vb = SET1_##key(beta);                        \
+    UNROLL for (int r = 0; r < MR_##key; r++) {                                     \
+        UNROLL for (int v = 0; v < NV; v++) {                                       \
+            T_(key) *cp = c + r * ldc + v * W_##key;                                \
+            STOREU_##key(cp, beta == 0 ? MUL_##key(va, acc[r][v])                   \
+                                       : FMA_##key(va, acc[r][v], MUL_##key(vb, LOADU_##key(cp)))); \
+        }                                                                           \
+    }                                                                               \
+}                                                                                   \
+static TARGET_##key void dot4_##key(size_t k, const T_(key) *const *a,              \
+                                    const T_(key) *x, T_(key) *out)                 \
+{                                                                                   \
+    VEC_##key acc[4][RV_(key)];                                                     \
+    UNROLL for (int r = 0; r < 4; r++) {                                            \
+        UNROLL for (int v = 0; v < RV_(key); v++) acc[r][v] = SET1_##key(0);        \
+    }                                                                               \
+    size_t p = 0;                                                                   \
+    for (; p + CAT(GL_, E_##key) <= k; p += CAT(GL_, E_##key)) {                    \
+        UNROLL for (int v = 0; v < RV_(key); v++) {                                 \
+            VEC_##key xv = LOADU_##key(x + p + v * W_##key);                        \
+            UNROLL for (int r = 0; r < 4; r++) {                                    \
+                acc[r][v] = FMA_##key(LOADU_##key(a[r] + p + v * W_##key), xv, acc[r][v]); \
+            }                                                                       \
+        }                                                                           \
+    }                                                                               \
+    T_(key) lane[4][CAT(GL_, E_##key)];                                             \
+    for (int r = 0; r < 4; r++) {                                                   \
+        for (int v = 0; v < RV_(key); v++) STOREU_##key(lane[r] + v * W_##key, acc[r][v]); \
+    }                                                                               \
+    CAT(DOT4_TAIL_, E_##key)                                                        \
+}                                                                                   \
+static TARGET_##key void axpy_##key(size_t m, size_t n, const T_(key) *a, size_t lda, \
+                                    const T_(key) *x, T_(key) *acc)                 \
+{                                                                                   \
+    size_t i = 0;                                                                   \
+    for (; i + AU * W_##key <= m; i += AU * W_##key) {                              \
+        VEC_##key s[AU];                                                            \
+        UNROLL for (int u = 0; u < AU; u++) s[u] = LOADU_##key(acc + i + u * W_##key); \
+        const T_(key) *col = a + i;                                                 \
+        for (size_t j = 0; j < n; j++, col += lda) {                                \
+            VEC_##key xj = SET1_##key(x[j]);                                        \
+            UNROLL for (int u = 0; u < AU; u++) {                                   \
+                s[u] = FMA_##key(LOADU_##key(col + u * W_##key), xj, s[u]);         \
+            }                                                                       \
+        }                                                                           \
+        UNROLL for (int u = 0; u < AU; u++) STOREU_##key(acc + i + u * W_##key, s[u]); \
+    }                                                                               \
+    for (; i + W_##key <= m; i += W_##key) {                                        \
+        VEC_##key s = LOADU_##key(acc + i);                                         \
+        const T_(key) *col = a + i;                                                 \
+        for (size_t j = 0; j < n; j++, col += lda) {                                \
+            s = FMA_##key(LOADU_##key(col), SET1_##key(x[j]), s);                   \
+        }                                                                           \
+        STOREU_##key(acc + i, s);                                                   \
+    }                                                                               \
+    CAT(AXPY_TAIL_, E_##key)                                                        \
+}                                                                                   \
+static const CAT(KT_, E_##key) mat_kernels_##key = {                                \
+    MR_##key, NR_(key), gemm_##key, dot4_##key, axpy_##key                          \
+};
+
+#define DOT4_TAIL_f DOT4_TAIL(f)
+#define DOT4_TAIL_d DOT4_TAIL(d)
+#define AXPY_TAIL_f AXPY_TAIL(f)
+#define AXPY_TAIL_d AXPY_TAIL(d)
+
+SIMD_KERNELS(avx2)
+SIMD_KERNELS(avx2_d)
+SIMD_KERNELS(avx512)
+SIMD_KERNELS(avx512_d)
+
+#endif // VEC_SIMD_X86
+
+/****************************************************DISPATCH*************************************************/
+
+// AVX2 CPUs without FMA exist (rarely); they get the scalar kernels
+#ifdef VEC_SIMD_X86
+    #define MAT_DISPATCH_(sfx)                                                      \
+        vec_isa_t isa = vec_isa_active();                                           \
+        if (isa >= VEC_ISA_AVX512) return &mat_kernels_avx512##sfx;                 \
+        if (isa >= VEC_ISA_AVX2 && __builtin_cpu_supports("fma")) return &mat_kernels_avx2##sfx;
+#else
+    #define MAT_DISPATCH_(sfx)
+#endif
+
+static const mat_kernels_t *mat_kernels_f(void)
+{
+    MAT_DISPATCH_()
+    return &mat_kernels_scalar_f;
+}
+
+static const dmat_kernels_t *mat_kernels_d(void)
+{
+    MAT_DISPATCH_(_d)
+    return &mat_kernels_scalar_d;
+}
+
+/*****************************************************GEMM****************************************************/
+
+/*
+ * The driver works on a row-major C (a column-major C is computed as its
+ * row-major transpose, C^T = B^T A^T) and reads A and B through element
+ * strides, so it needs no copies for the other layouts or for transposed
+ * views. Loop nest, outside in:
+ *
+ *   jc: NC columns of B/C   -> B panel KC x NC packed (shared by all tasks)
+ *   pc: KC steps of k       -> C updated once per step, beta only on the first
+ *   ic: MC rows of A/C      -> A block MC x KC packed per task
+ *   jr, ir: nr / mr slivers -> one microkernel call per tile
+ *
+ * Tasks are (ic block, group of jr slivers); with the pool running the
+ * columns of a panel are split into enough groups to keep every thread
+ * busy. Each thread packs A into its own buffer (indexed by
+ * vec_parallel_worker, allocated on first use, freed at the end of the
+ * call). Edge tiles go through a full-size scratch tile.
+ */
+static inline size_t round_up(size_t n, size_t a)
+{
+    return (n + a - 1) / a * a;
+}
+
+#define GEMM_ENGINE(E)                                                              \
+typedef struct {                                                                    \
+    const KT_##E *k;                                                                \
+    size_t m, n, depth;                                                             \
+    const T_##E *a;                                                                 \
+    size_t ars, acs;                                                                \
+    const T_##E *b;                                                                 \
+    size_t brs, bcs;                                                                \
+    T_##E *c;                                                                       \
+    size_t ldc;                                                                     \
+    T_##E alpha, beta;                                                              \
+    size_t mc;              /* rows per A block, a multiple of mr */                \
+    size_t jc, nc, pc, kc;  /* current panel */                                     \
+    T_##E *bpack;                                                                   \
+    T_##E *apack[VEC_PARALLEL_MAX_THREADS];                                         \
+    size_t abytes;                                                                  \
+    size_t group;           /* columns per task, a multiple of nr */                \
+    size_t groups;                                                                  \
+    atomic_bool failed;                                                             \
+} gemm_job_##E;                                                                     \
+                                                                                    \
+/* B[pc.., jc..] into nr-wide slivers, k-major, zero padded */                      \
+static void pack_b_##E(void *ctx, size_t begin, size_t end)                         \
+{                                                                                   \
+    const gemm_job_##E *j = ctx;                                                    \
+    const size_t nr = j->k->nr, kc = j->kc;                                         \
+    if (j->bcs == 1) {                                                              \
+        /* row by row, so B is read in long contiguous runs */                      \
+        for (size_t p = 0; p < kc; p++) {                                           \
+            const T_##E *src = j->b + (j->pc + p) * j->brs + j->jc;                 \
+            for (size_t q = begin; q < end; q++) {                                  \
+                T_##E *dst = j->bpack + q * kc * nr + p * nr;                       \
+                size_t w = j->nc - q * nr < nr ? j->nc - q * nr : nr;               \
+                memcpy(dst, src + q * nr, w * sizeof(T_##E));                       \
+                if (w < nr) memset(dst + w, 0, (nr - w) * sizeof(T_##E));           \
+            }                                                                       \
+        }                                                                           \
+        return;                                                                     \
+    }                                                                               \
+    for (size_t q = begin; q < end; q++) {                                          \
+        T_##E *dst = j->bpack + q * kc * nr;                                        \
+        size_t w = j->nc - q * nr < nr ? j->nc - q * nr : nr;                       \
+        const T_##E *src = j->b + j->pc * j->brs + (j->jc + q * nr) * j->bcs;       \
+        for (size_t p = 0; p < kc; p++, src += j->brs, dst += nr) {                 \
+            for (size_t c = 0; c < w; c++) dst[c] = src[c * j->bcs];                \
+            for (size_t c = w; c < nr; c++) dst[c] = 0;                             \
+        }                                                                           \
+    }                                                                               \
+}                                                                                   \
+                                                                                    \
+/* A[ic.., pc..] into mr-tall slivers, k-major, zero padded */                      \
+static void pack_a_##E(const gemm_job_##E *j, T_##E *dst, size_t ic, size_t rows)   \
+{                                                                                   \
+    const size_t mr = j->k->mr, kc = j->kc;                                         \
+    for (size_t q = 0; q < rows; q += mr, dst += kc * mr) {                         \
+        size_t h = rows - q < mr ? rows - q : mr;                                   \
+        const T_##E *src = j->a + (ic + q) * j->ars + j->pc * j->acs;               \
+        for (size_t p = 0; p < kc; p++, src += j->acs) {                            \
+            for (size_t r = 0; r < h; r++) dst[p * mr + r] = src[r * j->ars];       \
+            for (size_t r = h; r < mr; r++) dst[p * mr + r] = 0;                    \
+        }                                                                           \
+    }                                                                               \
+}                                                                                   \
+                                                                                    \
+static void gemm_task_##E(void *ctx, size_t begin, size_t end)                      \
+{                                                                                   \
+    gemm_job_##E *j = ctx;                                                          \
+    const size_t mr = j->k->mr, nr = j->k->nr, kc = j->kc;                          \
+    const T_##E beta = j->pc == 0 ? j->beta : 1;                                    \
+    for (size_t t = begin; t < end; t++) {                                          \
+        size_t ic = t / j->groups * j->mc;                                          \
+        size_t rows = j->m - ic < j->mc ? j->m - ic : j->mc;                        \
+        T_##E **own = &j->apack[vec_parallel_worker()];                             \
+        if (!*own) *own = aligned_alloc(64, j->abytes);                             \
+        T_##E *apack = *own;                                                        \
+        if (!apack) {                                                               \
+            j->failed = true;                                                       \
+            return;                                                                 \
+        }                                                                           \
+        pack_a_##E(j, apack, ic, rows);                                             \
+        size_t j0 = t % j->groups * j->group;                                       \
+        size_t j1 = j0 + j->group < j->nc ? j0 + j->group : j->nc;                  \
+        for (size_t jr = j0; jr < j1; jr += nr) {                                   \
+            size_t w = j->nc - jr < nr ? j->nc - jr : nr;                           \
+            const T_##E *bp = j->bpack + jr / nr * kc * nr;                        \
+            for (size_t ir = 0; ir < rows; ir += mr) {                              \
+                size_t h = rows - ir < mr ? rows - ir : mr;                         \
+                const T_##E *ap = apack + ir / mr * kc * mr;                        \
+                T_##E *cp = j->c + (ic + ir) * j->ldc + j->jc + jr;                 \
+                if (h == mr && w == nr) {                                           \
+                    j->k->gemm(kc, j->alpha, ap, bp, beta, cp, j->ldc);             \
+                    continue;                                                       \
+                }                                                                   \
+                T_##E tile[MAT_TILE_MAX];                                           \
+                if (beta != 0) {                                                    \
+                    for (size_t r = 0; r < h; r++) {                                \
+                        for (size_t c = 0; c < w; c++) tile[r * nr + c] = cp[r * j->ldc + c]; \
+                    }                                                               \
+                }                                                                   \
+                j->k->gemm(kc, j->alpha, ap, bp, beta, tile, nr);                   \
+                for (size_t r = 0; r < h; r++) {                                    \
+                    for (size_t c = 0; c < w; c++) cp[r * j->ldc + c] = tile[r * nr + c]; \
+                }                                                                   \
+            }                                                                       \
+        }                                                                           \
+    }                                                                               \
+}                                                                                   \
+                                                                                    \
+/* C = beta * C (0 when beta == 0), for alpha == 0 or an empty k */                 \
+static void gemm_scale_##E(gemm_job_##E *j)                                         \
+{                                                                                   \
+    for (size_t i = 0; i < j->m; i++) {                                             \
+        T_##E *row = j->c + i * j->ldc;                                             \
+        for (size_t c = 0; c < j->n; c++) row[c] = j->beta == 0 ? 0 : j->beta * row[c]; \
+    }                                                                               \
+}                                                                                   \
+                                                                                    \
+static bool gemm_run_##E(gemm_job_##E *j)                                           \
+{                                                                                   \
+    if (j->m == 0 || j->n == 0) return true;                                        \
+    if (j->depth == 0 || j->alpha == 0) {                                           \
+        gemm_scale_##E(j);                                                          \
+        return true;                                                                \
+    }                                                                               \
+    const size_t mr = j->k->mr, nr = j->k->nr;                                      \
+    size_t ncmax = MAT_NC / nr * nr;                                                \
+    j->mc = MAT_MC / mr * mr;                                                       \
+    if (ncmax == 0) ncmax = nr;                                                     \
+    if (j->mc == 0) j->mc = mr;                                                     \
+    bool parallel = vec_parallel_threads() > 1 &&                                   \
+                    (double)j->m * (double)j->n * (double)j->depth >= MAT_PARALLEL_WORK; \
+    size_t kcmax = j->depth < MAT_KC ? j->depth : MAT_KC;                           \
+    size_t ncap = round_up(j->n < ncmax ? j->n : ncmax, nr);                        \
+    j->bpack = aligned_alloc(64, round_up(kcmax * ncap * sizeof(T_##E), 64));       \
+    if (!j->bpack) return false;                                                    \
+    j->abytes = round_up(round_up(j->m < j->mc ? j->m : j->mc, mr) * kcmax * sizeof(T_##E), 64); \
+    memset(j->apack, 0, sizeof j->apack);                                           \
+    j->failed = false;                                                              \
+    size_t blocks = (j->m + j->mc - 1) / j->mc;                                     \
+    for (j->jc = 0; j->jc < j->n && !j->failed; j->jc += ncmax) {                   \
+        j->nc = j->n - j->jc < ncmax ? j->n - j->jc : ncmax;                        \
+        size_t slivers = (j->nc + nr - 1) / nr;                                     \
+        j->groups = 1;                                                              \
+        if (parallel) {                                                             \
+            /* four tasks per thread, but no group narrower than 64 columns */      \
+            size_t want = (4 * (size_t)vec_parallel_threads() + blocks - 1) / blocks; \
+            size_t most = (j->nc + 63) / 64;                                        \
+            j->groups = want < most ? want : most;                                  \
+            if (j->groups == 0) j->groups = 1;                                      \
+        }                                                                           \
+        j->group = (slivers + j->groups - 1) / j->groups * nr;                      \
+        j->groups = (j->nc + j->group - 1) / j->group;                              \
+        for (j->pc = 0; j->pc < j->depth && !j->failed; j->pc += MAT_KC) {          \
+            j->kc = j->depth - j->pc < MAT_KC ? j->depth - j->pc : MAT_KC;          \
+            if (parallel) {                                                         \
+                vec_parallel_tasks(slivers, pack_b_##E, j);                         \
+                vec_parallel_tasks(blocks * j->groups, gemm_task_##E, j);           \
+            } else {                                                                \
+                pack_b_##E(j, 0, slivers);                                          \
+                gemm_task_##E(j, 0, blocks * j->groups);                            \
+            }                                                                       \
+        }                                                                           \
+    }                                                                               \
+    free(j->bpack);                                                                 \
+    for (size_t t = 0; t < VEC_PARALLEL_MAX_THREADS; t++) free(j->apack[t]);        \
+    return !j->failed;                                                              \
+}
+
+GEMM_ENGINE(f)
+GEMM_ENGINE(d)
+
+/*****************************************************GEMV****************************************************/
+
+/*
+ * Row-major A: four rows per dot4 call (a short last group repeats its
+ * first row and drops the extra results). Column-major A: MAT_GEMV_BLOCK
+ * rows of y at a time, accumulated in a stack buffer over MAT_GEMV_COLS
+ * columns per pass (fewer pages and prefetch streams live at once).
+ * Either way y[i] = fma(alpha, s, beta * y[i]) (alpha * s for beta == 0).
+ * Tasks are row blocks.
+ */
+#define MAT_GEMV_ROWS 64                // rows of a row-major A per task
+#define MAT_GEMV_BLOCK 1024             // rows of a column-major A per task
+#ifndef MAT_GEMV_COLS
+    #define MAT_GEMV_COLS 32            // columns per pass over a column-major block
+#endif
+
+#define GEMV_ENGINE(E)                                                              \
+typedef struct {                                                                    \
+    const KT_##E *k;                                                                \
+    size_t m, n;                                                                    \
+    const T_##E *a;                                                                 \
+    size_t lda;                                                                     \
+    bool rows;              /* A row-major */                                       \
+    const T_##E *x;                                                                 \
+    T_##E *y;                                                                       \
+    T_##E alpha, beta;                                                              \
+} gemv_job_##E;                                                                     \
+                                                                                    \
+static inline void gemv_store_##E(const gemv_job_##E *j, size_t i, T_##E s)         \
+{                                                                                   \
+    j->y[i] = j->beta == 0 ? j->alpha * s : FMA_##E(j->alpha, s, j->beta * j->y[i]); \
+}                                                                                   \
+                                                                                    \
+static void gemv_task_##E(void *ctx, size_t begin, size_t end)                      \
+{                                                                                   \
+    const gemv_job_##E *j = ctx;                                                    \
+    size_t per = j->rows ? MAT_GEMV_ROWS : MAT_GEMV_BLOCK;                          \
+    size_t i0 = begin * per, i1 = end * per < j->m ? end * per : j->m;              \
+    if (j->rows) {                                                                  \
+        for (size_t i = i0; i < i1; i += 4) {                                       \
+            size_t h = i1 - i < 4 ? i1 - i : 4;                                     \
+            const T_##E *row[4];                                                    \
+            T_##E s[4];                                                             \
+            for (size_t r = 0; r < 4; r++) row[r] = j->a + (i + (r < h ? r : 0)) * j->lda; \
+            j->k->dot4(j->n, row, j->x, s);                                         \
+            for (size_t r = 0; r < h; r++) gemv_store_##E(j, i + r, s[r]);          \
+        }                                                                           \
+    } else {                                                                        \
+        T_##E acc[MAT_GEMV_BLOCK];                                                  \
+        for (size_t i = i0; i < i1; i += MAT_GEMV_BLOCK) {                          \
+            size_t h = i1 - i < MAT_GEMV_BLOCK ? i1 - i : MAT_GEMV_BLOCK;           \
+            for (size_t r = 0; r < h; r++) acc[r] = 0;                              \
+            for (size_t c = 0; c < j->n; c += MAT_GEMV_COLS) {                      \
+                size_t w = j->n - c < MAT_GEMV_COLS ? j->n - c : MAT_GEMV_COLS;     \
+                j->k->axpy(h, w, j->a + i + c * j->lda, j->lda, j->x + c, acc);     \
+            }                                                                       \
+            for (size_t r = 0; r < h; r++) gemv_store_##E(j, i + r, acc[r]);        \
+        }                                                                           \
+    }                                                                               \
+}                                                                                   \
+                                                                                    \
+static void gemv_run_##E(gemv_job_##E *j)                                           \
+{                                                                                   \
+    size_t per = j->rows ? MAT_GEMV_ROWS : MAT_GEMV_BLOCK;                          \
+    size_t tasks = (j->m + per - 1) / per;                                          \
+    if ((double)j->m * (double)j->n >= MAT_PARALLEL_WORK) {                         \
+        vec_parallel_tasks(tasks, gemv_task_##E, j);                                \
+    } else {                                                                        \
+        gemv_task_##E(j, 0, tasks);                                                 \
+    }                                                                               \
+}
+
+GEMV_ENGINE(f)
+GEMV_ENGINE(d)
+
+/****************************************************MATRICES*************************************************/
+
+// Borrowed matrices carry this allocator: nothing to allocate, nothing to free
+static void *borrowed_alloc(void *ctx, size_t bytes)
+{
+    (void)ctx;
+    (void)bytes;
+    return NULL;
+}
+
+static void borrowed_free(void *ctx, void *ptr, size_t bytes)
+{
+    (void)ctx;
+    (void)ptr;
+    (void)bytes;
+}
+
+static const vec_allocator_t BORROWED_ALLOCATOR = { borrowed_alloc, borrowed_free, NULL };
+
+/*
+ * One implementation for both element types:
+ *   P  - function prefix (matrix / dmat)
+ *   MT - matrix type, T - element type, E - kernel key
+ *   VT, VA - vector type and its allocator
+ *   VW - view type of a row / column
+ *   UNDEF - undefined matrix, VUNDEF - undefined vector
+ */
+#define MAT_API(P, MT, T, E, VT, VA, VW, UNDEF, VUNDEF, VMAX)                       \
+static size_t P##_span(MT m)                                                        \
+{                                                                                   \
+    return m.layout == MAT_ROW_MAJOR ? m.rows : m.cols;                             \
+}                                                                                   \
+                                                                                    \
+MT P##_alloc(size_t rows, size_t cols, mat_layout_t layout)                         \
+{                                                                                   \
+    MT m = UNDEF;                                                                   \
+    if (cols != 0 && rows > (size_t)-1 / sizeof(T) / cols) return UNDEF;            \
+    m.allocator = vec_allocator_current();                                          \
+    m.data = (T *)m.allocator->alloc(m.allocator->ctx, rows * cols * sizeof(T));    \
+    if (!m.data && rows * cols != 0) return UNDEF;                                  \
+    m.rows = rows;                                                                  \
+    m.cols = cols;                                                                  \
+    m.layout = layout;                                                              \
+    m.ld = layout == MAT_ROW_MAJOR ? cols : rows;                                   \
+    return m;                                                                       \
+}                                                                                   \
+                                                                                    \
+MT P##_create(size_t rows, size_t cols, mat_layout_t layout)                        \
+{                                                                                   \
+    MT m = P##_alloc(rows, cols, layout);                                           \
+    if (m.data) memset(m.data, 0, rows * cols * sizeof(T));                         \
+    return m;                                                                       \
+}                                                                                   \
+                                                                                    \
+MT P##_from_array(size_t rows, size_t cols, mat_layout_t layout, const T *data)     \
+{                                                                                   \
+    MT m = P##_alloc(rows, cols, layout);                                           \
+    if (m.data) memcpy(m.data, data, rows * cols * sizeof(T));                      \
+    return m;                                                                       \
+}                                                                                   \
+                                                                                    \
+MT P##_identity(size_t n, mat_layout_t layout)                                      \
+{                                                                                   \
+    MT m = P##_create(n, n, layout);                                                \
+    if (m.data) {                                                                   \
+        for (size_t i = 0; i < n; i++) m.data[i * n + i] = 1;                       \
+    }                                                                               \
+    return m;                                                                       \
+}                                                                                   \
+                                                                                    \
+MT P##_wrap(T *data, size_t rows, size_t cols, size_t ld, mat_layout_t layout)      \
+{                                                                                   \
+    MT m = { rows, cols, data, ld, layout, &BORROWED_ALLOCATOR };                   \
+    return m;                                                                       \
+}                                                                                   \
+                                                                                    \
+void P##_free(MT *m)                                                                \
+{                                                                                   \
+    if (m->data && m->allocator) {                                                  \
+        m->allocator->free(m->allocator->ctx, m->data, P##_span(*m) * m->ld * sizeof(T)); \
+    }                                                                               \
+    m->data = NULL;                                                                 \
+}                                                                                   \
+                                                                                    \
+MT P##_copy(MT m)                                                                   \
+{                                                                                   \
+    MT r = P##_alloc(m.rows, m.cols, m.layout);                                     \
+    if (!r.data) return r;                                                          \
+    size_t lines = P##_span(m), len = m.layout == MAT_ROW_MAJOR ? m.cols : m.rows;  \
+    for (size_t i = 0; i < lines; i++) memcpy(r.data + i * r.ld, m.data + i * m.ld, len * sizeof(T)); \
+    return r;                                                                       \
+}                                                                                   \
+                                                                                    \
+MT P##_view(MT m, size_t row, size_t col, size_t rows, size_t cols)                 \
+{                                                                                   \
+    if (row > m.rows || rows > m.rows - row || col > m.cols || cols > m.cols - col) return UNDEF; \
+    MT v = { rows, cols, rows && cols ? P##_at(m, row, col) : m.data, m.ld, m.layout, &BORROWED_ALLOCATOR }; \
+    return v;                                                                       \
+}                                                                                   \
+                                                                                    \
+MT P##_transpose(MT m)                                                              \
+{                                                                                   \
+    MT t = { m.cols, m.rows, m.data, m.ld,                                          \
+             m.layout == MAT_ROW_MAJOR ? MAT_COL_MAJOR : MAT_ROW_MAJOR, &BORROWED_ALLOCATOR }; \
+    return t;                                                                       \
+}                                                                                   \
+                                                                                    \
+VW P##_row(MT m, size_t i)                                                          \
+{                                                                                   \
+    VW v = { m.cols, m.data + (m.layout == MAT_ROW_MAJOR ? i * m.ld : i),           \
+             m.layout == MAT_ROW_MAJOR ? 1 : (ptrdiff_t)m.ld };                     \
+    return v;                                                                       \
+}                                                                                   \
+                                                                                    \
+VW P##_col(MT m, size_t j)                                                          \
+{                                                                                   \
+    return P##_row(P##_transpose(m), j);                                            \
+}                                                                                   \
+                                                                                    \
+bool P##_equals(MT a, MT b)                                                         \
+{                                                                                   \
+    if (a.rows != b.rows || a.cols != b.cols) return false;                         \
+    for (size_t i = 0; i < a.rows; i++) {                                           \
+        for (size_t j = 0; j < a.cols; j++) {                                       \
+            if (*P##_at(a, i, j) != *P##_at(b, i, j)) return false;                 \
+        }                                                                           \
+    }                                                                               \
+    return true;                                                                    \
+}                                                                                   \
+                                                                                    \
+/* element strides of a matrix */                                                   \
+static void P##_strides(MT m, size_t *rs, size_t *cs)                               \
+{                                                                                   \
+    *rs = m.layout == MAT_ROW_MAJOR ? m.ld : 1;                                     \
+    *cs = m.layout == MAT_ROW_MAJOR ? 1 : m.ld;                                     \
+}                                                                                   \
+                                                                                    \
+bool P##_gemm(T alpha, MT a, MT b, T beta, MT c)                                    \
+{                                                                                   \
+    if (a.cols != b.rows || c.rows != a.rows || c.cols != b.cols) return false;     \
+    gemm_job_##E j = { .k = mat_kernels_##E(), .depth = a.cols, .c = c.data,        \
+                       .ldc = c.ld, .alpha = alpha, .beta = beta };                 \
+    if (c.layout == MAT_ROW_MAJOR) {                                                \
+        j.m = c.rows, j.n = c.cols, j.a = a.data, j.b = b.data;                     \
+        P##_strides(a, &j.ars, &j.acs);                                             \
+        P##_strides(b, &j.brs, &j.bcs);                                             \
+    } else {                                                                        \
+        j.m = c.cols, j.n = c.rows, j.a = b.data, j.b = a.data;                     \
+        P##_strides(b, &j.acs, &j.ars);                                             \
+        P##_strides(a, &j.bcs, &j.brs);                                             \
+    }                                                                               \
+    return gemm_run_##E(&j);                                                        \
+}                                                                                   \
+                                                                                    \
+MT P##_mul(MT a, MT b)                                                              \
+{                                                                                   \
+    if (a.cols != b.rows) return UNDEF;                                             \
+    MT c = P##_alloc(a.rows, b.cols, a.layout);                                     \
+    if (!c.data && a.rows * b.cols != 0) return UNDEF;                              \
+    if (!P##_gemm(1, a, b, 0, c)) {                                                 \
+        P##_free(&c);                                                               \
+        return UNDEF;                                                               \
+    }                                                                               \
+    return c;                                                                       \
+}                                                                                   \
+                                                                                    \
+bool P##_gemv(T alpha, MT a, VT x, T beta, VT y)                                    \
+{                                                                                   \
+    if (x.size != a.cols || y.size != a.rows) return false;                         \
+    gemv_job_##E j = { mat_kernels_##E(), a.rows, a.cols, a.data, a.ld,             \
+                       a.layout == MAT_ROW_MAJOR, x.data, y.data, alpha, beta };    \
+    gemv_run_##E(&j);                                                               \
+    return true;                                                                    \
+}                                                                                   \
+                                                                                    \
+VT P##_mul_vector(MT a, VT x)                                                       \
+{                                                                                   \
+    if (x.size != a.cols || a.rows > VMAX) return VUNDEF;                           \
+    VT y = VA((unsigned int)a.rows);                                                \
+    if (!y.data && a.rows != 0) return VUNDEF;                                      \
+    P##_gemv(1, a, x, 0, y);                                                        \
+    return y;                                                                       \
+}
+
+MAT_API(matrix, matrix_t, float, f, vector_t, vector_alloc, vec_view_t,
+        MAT_UNDEFINED, VEC_UNDEFINED, UINT_MAX)
+MAT_API(dmat, dmatrix_t, double, d, dvector_t, allocate_d, dvec_view_t,
+        DMAT_UNDEFINED, DVEC_UNDEFINED, UINT_MAX)
+
+void print_matrix(const char *label, matrix_t m)
+{
+    printf("%s\n", label);
+    for (size_t i = 0; i < m.rows; i++) {
+        printf("  [");
+        for (size_t j = 0; j < m.cols; j++) printf(j + 1 < m.cols ? "%f, " : "%f", *matrix_at(m, i, j));
+        printf("]\n");
+    }
+}
+
+void print_dmatrix(const char *label, dmatrix_t m)
+{
+    printf("%s\n", label);
+    for (size_t i = 0; i < m.rows; i++) {
+        printf("  [");
+        for (size_t j = 0; j < m.cols; j++) printf(j + 1 < m.cols ? "%f, " : "%f", *dmat_at(m, i, j));
+        printf("]\n");
+    }
+}
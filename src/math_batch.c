@@ -0,0 +1,523 @@
+#include <math_batch.h>
+#include <vec_simd.h>
+
+#ifndef POW_PLAN_BLOCK
+    #define POW_PLAN_BLOCK 1024     // elements per chain block (4 KiB per buffer, stays in L1)
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    #define VEC_SIMD_X86 1
+    #include <immintrin.h>
+#endif
+
+typedef void (*batch_f1_f)(float *dst, const float *src, size_t n);
+typedef void (*batch_fs_f)(float *dst, const float *src, float y, size_t n);
+typedef void (*batch_f2_f)(float *dst, const float *x, const float *y, size_t n);
+typedef void (*batch_d1_f)(double *dst, const double *src, size_t n);
+typedef void (*batch_ds_f)(double *dst, const double *src, double y, size_t n);
+typedef void (*batch_d2_f)(double *dst, const double *x, const double *y, size_t n);
+typedef void (*batch_sc_f)(float *s, float *c, const float *x, size_t n);
+
+typedef struct {
+    batch_f1_f inv_sqrt, sqrt, log2, exp2;
+    batch_fs_f pow;
+    batch_f1_f cbrt;
+    batch_f2_f hypot;
+    batch_d1_f inv_sqrtd, sqrtd, log2d, exp2d;
+    batch_ds_f powd;
+    batch_d1_f cbrtd;
+    batch_d2_f hypotd;
+    batch_f1_f log2_poly, exp2_poly;
+    batch_fs_f pow_poly;
+    batch_f1_f sqrt_exact;
+    batch_d1_f sqrt_exactd;
+    batch_sc_f sincos_poly;
+} math_batch_kernels_t;
+
+#ifdef VEC_SIMD_X86
+
+/****************************************************AVX2*****************************************************/
+
+#define MB_FN(name) name##_avx2
+#define MB_TARGET __attribute__((target("avx2")))
+
+#define VF __m256
+#define MF __m256
+#define WF 8
+#define F_LOADU(p)       _mm256_loadu_ps(p)
+#define F_STOREU(p, v)   _mm256_storeu_ps(p, v)
+#define F_SET1(s)        _mm256_set1_ps(s)
+#define F_ADD            _mm256_add_ps
+#define F_SUB            _mm256_sub_ps
+#define F_MUL            _mm256_mul_ps
+#define F_MAX            _mm256_max_ps
+#define F_MIN            _mm256_min_ps
+#define F_NEG(a)         _mm256_xor_ps(a, _mm256_set1_ps(-0.0f))
+#define F_CMPLT(a, b)    _mm256_cmp_ps(a, b, _CMP_LT_OQ)
+#define F_CMPLE(a, b)    _mm256_cmp_ps(a, b, _CMP_LE_OQ)
+#define F_CMPEQ(a, b)    _mm256_cmp_ps(a, b, _CMP_EQ_OQ)
+#define F_BLEND(m, a, b) _mm256_blendv_ps(a, b, m)
+#define F_TRUNC_BITS(t)  _mm256_castsi256_ps(_mm256_cvttps_epi32(t))
+#define F_INVSQRT_GUESS(x) _mm256_castsi256_ps(_mm256_sub_epi32(_mm256_set1_epi32(0x5f3759df), \
+                               _mm256_srai_epi32(_mm256_castps_si256(x), 1)))
+#define F_FROM_U32BITS(x) u32_to_ps_avx2(_mm256_castps_si256(x))
+#define F_SQRT           _mm256_sqrt_ps
+
+#define VI __m256i
+#define I_SET1(s)        _mm256_set1_epi32(s)
+#define I_ADD            _mm256_add_epi32
+#define I_SUB            _mm256_sub_epi32
+#define I_AND            _mm256_and_si256
+#define I_OR             _mm256_or_si256
+#define I_SRLI(v, n)     _mm256_srli_epi32(v, n)
+#define I_SLLI(v, n)     _mm256_slli_epi32(v, n)
+#define F_ASI(x)         _mm256_castps_si256(x)
+#define I_ASF(v)         _mm256_castsi256_ps(v)
+#define F_CVTI(v)        _mm256_cvtepi32_ps(v)
+#define I_CVTTF(x)       _mm256_cvttps_epi32(x)
+#define M_AND(a, b)      _mm256_and_ps(a, b)
+#define M_BITS(m)        ((unsigned int)_mm256_movemask_ps(m))
+
+#define VD __m256d
+#define MD __m256d
+#define WD 4
+#define D_LOADU(p)       _mm256_loadu_pd(p)
+#define D_STOREU(p, v)   _mm256_storeu_pd(p, v)
+#define D_SET1(s)        _mm256_set1_pd(s)
+#define D_ADD            _mm256_add_pd
+#define D_SUB            _mm256_sub_pd
+#define D_MUL            _mm256_mul_pd
+#define D_MAX            _mm256_max_pd
+#define D_MIN            _mm256_min_pd
+#define D_NEG(a)         _mm256_xor_pd(a, _mm256_set1_pd(-0.0))
+#define D_CMPLT(a, b)    _mm256_cmp_pd(a, b, _CMP_LT_OQ)
+#define D_CMPLE(a, b)    _mm256_cmp_pd(a, b, _CMP_LE_OQ)
+#define D_CMPEQ(a, b)    _mm256_cmp_pd(a, b, _CMP_EQ_OQ)
+#define D_BLEND(m, a, b) _mm256_blendv_pd(a, b, m)
+#define D_TRUNC_BITS(t)  _mm256_castsi256_pd(pd_to_u64_trunc_avx2(t))
+#define D_INVSQRT_GUESS(x) _mm256_castsi256_pd(_mm256_sub_epi64(_mm256_set1_epi64x(0x5fe6ec85e7de30daLL), \
+                               srai1_epi64_avx2(_mm256_castpd_si256(x))))
+#define D_FROM_U64BITS(x) u64_to_pd_avx2(_mm256_castpd_si256(x))
+#define D_SQRT           _mm256_sqrt_pd
+
+/**
+ * @brief Exact uint32 -> float (AVX2 only converts signed): both 16-bit
+ *        halves convert exactly, so the single rounding is in the final add.
+ */
+static inline MB_TARGET __m256 u32_to_ps_avx2(__m256i v)
+{
+    __m256 hi = _mm256_cvtepi32_ps(_mm256_srli_epi32(v, 16));
+    __m256 lo = _mm256_cvtepi32_ps(_mm256_and_si256(v, _mm256_set1_epi32(0xffff)));
+    return _mm256_add_ps(_mm256_mul_ps(hi, _mm256_set1_ps(65536.0f)), lo);
+}
+
+/**
+ * @brief Exact uint64 -> double using the 2^52 / 2^84 exponent trick: each
+ *        32-bit half is placed in a mantissa, the offsets cancel exactly and
+ *        only the final add rounds.
+ */
+static inline MB_TARGET __m256d u64_to_pd_avx2(__m256i v)
+{
+    const __m256i magic_lo = _mm256_set1_epi64x(0x4330000000000000LL);   // 2^52
+    const __m256i magic_hi = _mm256_set1_epi64x(0x4530000000000000LL);   // 2^84
+    __m256i lo = _mm256_blend_epi32(v, magic_lo, 0xAA);
+    __m256i hi = _mm256_or_si256(_mm256_srli_epi64(v, 32), magic_hi);
+    __m256d fhi = _mm256_sub_pd(_mm256_castsi256_pd(hi), _mm256_set1_pd(0x1.00000001p84)); // 2^84 + 2^52
+    return _mm256_add_pd(fhi, _mm256_castsi256_pd(lo));
+}
+
+/**
+ * @brief Truncating double -> uint64 for 0 <= y < 2^63 (AVX2 has no 64-bit
+ *        conversion): split into exact 32-bit integer halves and read them
+ *        back out of the mantissa after adding 2^52.
+ */
+static inline MB_TARGET __m256i pd_to_u64_trunc_avx2(__m256d y)
+{
+    const __m256d two52 = _mm256_set1_pd(4503599627370496.0);
+    __m256d hi = _mm256_floor_pd(_mm256_mul_pd(y, _mm256_set1_pd(2.3283064365386963e-10)));   // 2^-32
+    __m256d lo = _mm256_floor_pd(_mm256_sub_pd(y, _mm256_mul_pd(hi, _mm256_set1_pd(4294967296.0))));
+    __m256i hi_i = _mm256_slli_epi64(_mm256_castpd_si256(_mm256_add_pd(hi, two52)), 32);
+    __m256i lo_i = _mm256_and_si256(_mm256_castpd_si256(_mm256_add_pd(lo, two52)),
+                                    _mm256_set1_epi64x(0xffffffffLL));
+    return _mm256_or_si256(hi_i, lo_i);
+}
+
+// arithmetic >> 1 on 64-bit lanes (no _mm256_srai_epi64 before AVX-512)
+static inline MB_TARGET __m256i srai1_epi64_avx2(__m256i v)
+{
+    __m256i sign = _mm256_and_si256(v, _mm256_set1_epi64x((long long)0x8000000000000000ULL));
+    return _mm256_or_si256(_mm256_srli_epi64(v, 1), sign);
+}
+
+#include "math_batch_kernels.h"
+
+#undef MB_FN
+#undef MB_TARGET
+#undef VF
+#undef MF
+#undef WF
+#undef F_LOADU
+#undef F_STOREU
+#undef F_SET1
+#undef F_ADD
+#undef F_SUB
+#undef F_MUL
+#undef F_MAX
+#undef F_MIN
+#undef F_NEG
+#undef F_CMPLT
+#undef F_CMPLE
+#undef F_CMPEQ
+#undef F_BLEND
+#undef F_TRUNC_BITS
+#undef F_INVSQRT_GUESS
+#undef F_FROM_U32BITS
+#undef F_SQRT
+#undef VI
+#undef I_SET1
+#undef I_ADD
+#undef I_SUB
+#undef I_AND
+#undef I_OR
+#undef I_SRLI
+#undef I_SLLI
+#undef F_ASI
+#undef I_ASF
+#undef F_CVTI
+#undef I_CVTTF
+#undef M_AND
+#undef M_BITS
+#undef VD
+#undef MD
+#undef WD
+#undef D_LOADU
+#undef D_STOREU
+#undef D_SET1
+#undef D_ADD
+#undef D_SUB
+#undef D_MUL
+#undef D_MAX
+#undef D_MIN
+#undef D_NEG
+#undef D_CMPLT
+#undef D_CMPLE
+#undef D_CMPEQ
+#undef D_BLEND
+#undef D_TRUNC_BITS
+#undef D_INVSQRT_GUESS
+#undef D_FROM_U64BITS
+#undef D_SQRT
+
+/****************************************************AVX-512**************************************************/
+
+// DQ provides the unsigned 64-bit conversions used by the double kernels
+#define MB_FN(name) name##_avx512
+#define MB_TARGET __attribute__((target("avx512f,avx512dq")))
+
+#define VF __m512
+#define MF __mmask16
+#define WF 16
+#define F_LOADU(p)       _mm512_loadu_ps(p)
+#define F_STOREU(p, v)   _mm512_storeu_ps(p, v)
+#define F_SET1(s)        _mm512_set1_ps(s)
+#define F_ADD            _mm512_add_ps
+#define F_SUB            _mm512_sub_ps
+#define F_MUL            _mm512_mul_ps
+#define F_MAX            _mm512_max_ps
+#define F_MIN            _mm512_min_ps
+#define F_NEG(a)         _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(a), _mm512_set1_epi32((int)0x80000000u)))
+#define F_CMPLT(a, b)    _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ)
+#define F_CMPLE(a, b)    _mm512_cmp_ps_mask(a, b, _CMP_LE_OQ)
+#define F_CMPEQ(a, b)    _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ)
+#define F_BLEND(m, a, b) _mm512_mask_blend_ps(m, a, b)
+#define F_TRUNC_BITS(t)  _mm512_castsi512_ps(_mm512_cvttps_epi32(t))
+#define F_INVSQRT_GUESS(x) _mm512_castsi512_ps(_mm512_sub_epi32(_mm512_set1_epi32(0x5f3759df), \
+                               _mm512_srai_epi32(_mm512_castps_si512(x), 1)))
+#define F_FROM_U32BITS(x) _mm512_cvtepu32_ps(_mm512_castps_si512(x))
+#define F_SQRT           _mm512_sqrt_ps
+
+#define VI __m512i
+#define I_SET1(s)        _mm512_set1_epi32(s)
+#define I_ADD            _mm512_add_epi32
+#define I_SUB            _mm512_sub_epi32
+#define I_AND            _mm512_and_si512
+#define I_OR             _mm512_or_si512
+#define I_SRLI(v, n)     _mm512_srli_epi32(v, n)
+#define I_SLLI(v, n)     _mm512_slli_epi32(v, n)
+#define F_ASI(x)         _mm512_castps_si512(x)
+#define I_ASF(v)         _mm512_castsi512_ps(v)
+#define F_CVTI(v)        _mm512_cvtepi32_ps(v)
+#define I_CVTTF(x)       _mm512_cvttps_epi32(x)
+#define M_AND(a, b)      ((__mmask16)((a) & (b)))
+#define M_BITS(m)        ((unsigned int)(m))
+
+#define VD __m512d
+#define MD __mmask8
+#define WD 8
+#define D_LOADU(p)       _mm512_loadu_pd(p)
+#define D_STOREU(p, v)   _mm512_storeu_pd(p, v)
+#define D_SET1(s)        _mm512_set1_pd(s)
+#define D_ADD            _mm512_add_pd
+#define D_SUB            _mm512_sub_pd
+#define D_MUL            _mm512_mul_pd
+#define D_MAX            _mm512_max_pd
+#define D_MIN            _mm512_min_pd
+#define D_NEG(a)         _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(a), _mm512_set1_epi64((long long)0x8000000000000000ULL)))
+#define D_CMPLT(a, b)    _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ)
+#define D_CMPLE(a, b)    _mm512_cmp_pd_mask(a, b, _CMP_LE_OQ)
+#define D_CMPEQ(a, b)    _mm512_cmp_pd_mask(a, b, _CMP_EQ_OQ)
+#define D_BLEND(m, a, b) _mm512_mask_blend_pd(m, a, b)
+#define D_TRUNC_BITS(t)  _mm512_castsi512_pd(_mm512_cvttpd_epu64(t))
+#define D_INVSQRT_GUESS(x) _mm512_castsi512_pd(_mm512_sub_epi64(_mm512_set1_epi64(0x5fe6ec85e7de30daLL), \
+                               _mm512_srai_epi64(_mm512_castpd_si512(x), 1)))
+#define D_FROM_U64BITS(x) _mm512_cvtepu64_pd(_mm512_castpd_si512(x))
+#define D_SQRT           _mm512_sqrt_pd
+
+#include "math_batch_kernels.h"
+
+#endif // VEC_SIMD_X86
+
+/****************************************************SCALAR***************************************************/
+
+#define SCALAR_ARRAY1(name, T, fn)                                                  \
+static void name##_scalar(T *dst, const T *src, size_t n)                           \
+{                                                                                   \
+    for (size_t i = 0; i < n; i++) dst[i] = fn(src[i]);                             \
+}
+
+SCALAR_ARRAY1(inv_sqrt_array, float, fast_inv_sqrt)
+SCALAR_ARRAY1(sqrt_array, float, fast_sqrt)
+SCALAR_ARRAY1(log2f_array, float, fast_log2f)
+SCALAR_ARRAY1(exp2f_array, float, fast_exp2f)
+SCALAR_ARRAY1(cbrtf_array, float, cbrt_f)
+SCALAR_ARRAY1(inv_sqrtd_array, double, fast_inv_sqrtd)
+SCALAR_ARRAY1(sqrtd_array, double, fast_sqrtd)
+SCALAR_ARRAY1(log2d_array, double, fast_log2d)
+SCALAR_ARRAY1(exp2d_array, double, fast_exp2d)
+SCALAR_ARRAY1(cbrtd_array, double, cbrt_d)
+SCALAR_ARRAY1(log2f_poly_array, float, fast_log2f_poly)
+SCALAR_ARRAY1(exp2f_poly_array, float, fast_exp2f_poly)
+SCALAR_ARRAY1(sqrt_exact_array, float, sqrt_exact_f)
+SCALAR_ARRAY1(sqrt_exactd_array, double, sqrt_exact_d)
+
+static void powf_array_scalar(float *dst, const float *src, float y, size_t n)
+{
+    for (size_t i = 0; i < n; i++) dst[i] = fast_powf(src[i], y);
+}
+
+static void hypotf_array_scalar(float *dst, const float *x, const float *y, size_t n)
+{
+    for (size_t i = 0; i < n; i++) dst[i] = hypot_f(x[i], y[i]);
+}
+
+static void powd_array_scalar(double *dst, const double *src, double y, size_t n)
+{
+    for (size_t i = 0; i < n; i++) dst[i] = fast_powd(src[i], y);
+}
+
+static void powf_poly_array_scalar(float *dst, const float *src, float y, size_t n)
+{
+    for (size_t i = 0; i < n; i++) dst[i] = fast_powf_poly(src[i], y);
+}
+
+static void sincosf_poly_array_scalar(float *s, float *c, const float *x, size_t n)
+{
+    for (size_t i = 0; i < n; i++) fast_sincosf_poly(x[i], s + i, c + i);
+}
+
+static void hypotd_array_scalar(double *dst, const double *x, const double *y, size_t n)
+{
+    for (size_t i = 0; i < n; i++) dst[i] = hypot_d(x[i], y[i]);
+}
+
+static const math_batch_kernels_t batch_kernels_scalar = {
+    inv_sqrt_array_scalar, sqrt_array_scalar, log2f_array_scalar, exp2f_array_scalar,
+    powf_array_scalar, cbrtf_array_scalar, hypotf_array_scalar,
+    inv_sqrtd_array_scalar, sqrtd_array_scalar, log2d_array_scalar, exp2d_array_scalar,
+    powd_array_scalar, cbrtd_array_scalar, hypotd_array_scalar,
+    log2f_poly_array_scalar, exp2f_poly_array_scalar, powf_poly_array_scalar,
+    sqrt_exact_array_scalar, sqrt_exactd_array_scalar, sincosf_poly_array_scalar
+};
+
+/****************************************************DISPATCH*************************************************/
+
+/**
+ * @brief Kernels for the active ISA level. AVX-512 additionally needs DQ;
+ *        without it the AVX2 kernels are used.
+ */
+static const math_batch_kernels_t *batch_kernels(void)
+{
+#ifdef VEC_SIMD_X86
+    vec_isa_t isa = vec_isa_active();
+    if (isa >= VEC_ISA_AVX512 && __builtin_cpu_supports("avx512dq")) return &batch_kernels_avx512;
+    if (isa >= VEC_ISA_AVX2) return &batch_kernels_avx2;
+#endif
+    return &batch_kernels_scalar;
+}
+
+void fast_inv_sqrt_array(float *dst, const float *src, size_t n) { batch_kernels()->inv_sqrt(dst, src, n); }
+void fast_sqrt_array(float *dst, const float *src, size_t n) { batch_kernels()->sqrt(dst, src, n); }
+void fast_log2f_array(float *dst, const float *src, size_t n) { batch_kernels()->log2(dst, src, n); }
+void fast_exp2f_array(float *dst, const float *src, size_t n) { batch_kernels()->exp2(dst, src, n); }
+void fast_powf_array(float *dst, const float *src, float y, size_t n) { batch_kernels()->pow(dst, src, y, n); }
+void cbrt_f_array(float *dst, const float *src, size_t n) { batch_kernels()->cbrt(dst, src, n); }
+void hypot_f_array(float *dst, const float *x, const float *y, size_t n) { batch_kernels()->hypot(dst, x, y, n); }
+
+void fast_inv_sqrtd_array(double *dst, const double *src, size_t n) { batch_kernels()->inv_sqrtd(dst, src, n); }
+void fast_sqrtd_array(double *dst, const double *src, size_t n) { batch_kernels()->sqrtd(dst, src, n); }
+void fast_log2d_array(double *dst, const double *src, size_t n) { batch_kernels()->log2d(dst, src, n); }
+void fast_exp2d_array(double *dst, const double *src, size_t n) { batch_kernels()->exp2d(dst, src, n); }
+void fast_powd_array(double *dst, const double *src, double y, size_t n) { batch_kernels()->powd(dst, src, y, n); }
+void cbrt_d_array(double *dst, const double *src, size_t n) { batch_kernels()->cbrtd(dst, src, n); }
+void hypot_d_array(double *dst, const double *x, const double *y, size_t n) { batch_kernels()->hypotd(dst, x, y, n); }
+
+void fast_log2f_poly_array(float *dst, const float *src, size_t n) { batch_kernels()->log2_poly(dst, src, n); }
+void fast_exp2f_poly_array(float *dst, const float *src, size_t n) { batch_kernels()->exp2_poly(dst, src, n); }
+void fast_powf_poly_array(float *dst, const float *src, float y, size_t n) { batch_kernels()->pow_poly(dst, src, y, n); }
+void sqrt_exact_f_array(float *dst, const float *src, size_t n) { batch_kernels()->sqrt_exact(dst, src, n); }
+void sqrt_exact_d_array(double *dst, const double *src, size_t n) { batch_kernels()->sqrt_exactd(dst, src, n); }
+void fast_sincosf_poly_array(float *s, float *c, const float *x, size_t n) { batch_kernels()->sincos_poly(s, c, x, n); }
+
+/****************************************************POW PLAN*************************************************/
+
+pow_plan_t pow_plan_d(double y)
+{
+    pow_plan_t p = { POW_PLAN_GENERAL, 0, false, y };
+    double a = y < 0.0 ? -y : y;
+    if (y == 0.0) {
+        p.kind = POW_PLAN_ONE;
+        return p;
+    }
+    if (!(a <= (double)POW_PLAN_MAX_INT)) return p;   // NaN too
+
+    double k = (double)(int)a;
+    if (k == a) {
+        p.kind = POW_PLAN_INT;
+    } else if (a - k == 0.5) {
+        p.kind = POW_PLAN_HALF_INT;
+    } else {
+        return p;
+    }
+    p.k = (unsigned int)k;
+    p.reciprocal = y < 0.0;
+    return p;
+}
+
+pow_plan_t pow_plan_f(float y) { return pow_plan_d(y); }
+
+/*
+ * The chain kernels are generated for float (f) and double (d): r = x^k
+ * with pow_fi/pow_di's multiply order, i.e. the running product picks up
+ * x^(2^j) for each set bit j of k, squares computed on the fly. r may be
+ * x; x is only read before r is first written.
+ */
+#define POW_PLAN_DEFINE(E, T, KT, kernels, sqrt_array, general)                    \
+static void pow_chain_block_##E(const KT *vk, T *r, const T *x, unsigned int k,     \
+                                T *sq, size_t m)                                    \
+{                                                                                   \
+    switch (k) {                                                                    \
+        case 1:                                                                     \
+            if (r != x) memmove(r, x, m * sizeof(T));                               \
+            return;                                                                 \
+        case 2:                                                                     \
+            vk->mul(r, x, x, m);                                                    \
+            return;                                                                 \
+        case 3:                                                                     \
+            vk->mul(sq, x, x, m);                                                   \
+            vk->mul(r, x, sq, m);                                                   \
+            return;                                                                 \
+        case 4:                                                                     \
+            vk->mul(sq, x, x, m);                                                   \
+            vk->mul(r, sq, sq, m);                                                  \
+            return;                                                                 \
+        default:                                                                    \
+            break;                                                                  \
+    }                                                                               \
+                                                                                    \
+    const T *cur = x;                                                               \
+    bool started = false;                                                           \
+    while (k > 0) {                                                                 \
+        if (k & 1) {                                                                \
+            if (!started) {                                                         \
+                if (r != cur) memmove(r, cur, m * sizeof(T));   /* 1 * cur == cur */ \
+                started = true;                                                     \
+            } else {                                                                \
+                vk->mul(r, r, cur, m);                                              \
+            }                                                                       \
+        }                                                                           \
+        k >>= 1;                                                                    \
+        if (k) {                                                                    \
+            vk->mul(sq, cur, cur, m);                                               \
+            cur = sq;                                                               \
+        }                                                                           \
+    }                                                                               \
+}                                                                                   \
+                                                                                    \
+void pow_plan_apply_##E(const pow_plan_t *plan, T *dst, const T *src, size_t n)     \
+{                                                                                   \
+    if (plan->kind == POW_PLAN_ONE) {                                               \
+        for (size_t i = 0; i < n; i++) dst[i] = 1;                                  \
+        return;                                                                     \
+    }                                                                               \
+    if (plan->kind == POW_PLAN_GENERAL) {                                           \
+        general(dst, src, (T)plan->y, n);                                           \
+        return;                                                                     \
+    }                                                                               \
+                                                                                    \
+    const KT *vk = kernels();                                                       \
+    T sq[POW_PLAN_BLOCK];                                                           \
+    T rt[POW_PLAN_BLOCK];                                                           \
+    for (size_t i = 0; i < n; i += POW_PLAN_BLOCK) {                                \
+        size_t m = MIN((size_t)POW_PLAN_BLOCK, n - i);                              \
+        T *r = dst + i;                                                             \
+        const T *x = src + i;                                                       \
+                                                                                    \
+        if (plan->kind == POW_PLAN_HALF_INT) {                                      \
+            /* + 0 turns -0 into +0, as pow(-0, 0.5) is +0 */                       \
+            for (size_t j = 0; j < m; j++) rt[j] = x[j] + (T)0;                     \
+            sqrt_array(rt, rt, m);                                                  \
+            if (plan->k == 0) {                                                     \
+                memcpy(r, rt, m * sizeof(T));                                       \
+            } else {                                                                \
+                pow_chain_block_##E(vk, r, x, plan->k, sq, m);                      \
+                vk->mul(r, r, rt, m);                                               \
+            }                                                                       \
+        } else {                                                                    \
+            pow_chain_block_##E(vk, r, x, plan->k, sq, m);                          \
+        }                                                                           \
+        if (plan->reciprocal) {                                                     \
+            for (size_t j = 0; j < m; j++) r[j] = 1 / r[j];                         \
+        }                                                                           \
+    }                                                                               \
+}
+
+// general float exponents: POLY tier unless PRECISE is asked for
+static void pow_general_f(float *dst, const float *src, float y, size_t n)
+{
+    if (FAST_MATH_TIER == FAST_MATH_PRECISE) {
+        for (size_t i = 0; i < n; i++) dst[i] = fast_powf_precise(src[i], y);
+    } else {
+        fast_powf_poly_array(dst, src, y, n);
+    }
+}
+
+// general double exponents: there is no double POLY tier, use PRECISE
+static void pow_general_d(double *dst, const double *src, double y, size_t n)
+{
+    for (size_t i = 0; i < n; i++) dst[i] = fast_powd_precise(src[i], y);
+}
+
+POW_PLAN_DEFINE(f, float, vec_kernels_t, vec_kernels, sqrt_exact_f_array, pow_general_f)
+POW_PLAN_DEFINE(d, double, vec_dkernels_t, vec_dkernels, sqrt_exact_d_array, pow_general_d)
+
+void pow_f_array(float *dst, const float *src, float y, size_t n)
+{
+    pow_plan_t plan = pow_plan_f(y);
+    pow_plan_apply_f(&plan, dst, src, n);
+}
+
+void pow_d_array(double *dst, const double *src, double y, size_t n)
+{
+    pow_plan_t plan = pow_plan_d(y);
+    pow_plan_apply_d(&plan, dst, src, n);
+}
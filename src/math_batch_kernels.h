@@ -0,0 +1,343 @@
+/*
+ * Instruction-set independent bodies of the math_batch.h kernels.
+ *
+ * This file is included once per SIMD level by math_batch.c, after the level
+ * has defined its register types and primitive operations:
+ *
+ *   MB_FN(name), MB_TARGET                         naming / target attribute
+ *   VF, MF, WF / VD, MD, WD                        register, mask, lane count
+ *   F_LOADU F_STOREU F_SET1 F_ADD F_SUB F_MUL      float primitives
+ *   F_MAX F_MIN F_NEG F_CMPLT F_CMPLE F_CMPEQ      (MAX/MIN return the second
+ *   F_BLEND(m, a, b)  -> m ? b : a                  operand when one is NaN)
+ *   F_FROM_U32BITS(x) -> (float)(uint32 bits of x)
+ *   F_TRUNC_BITS(t)   -> float with bits (uint32)t
+ *   F_INVSQRT_GUESS(x)-> float with bits 0x5f3759df - (bits(x) >> 1)
+ *   F_SQRT            -> correctly rounded sqrt
+ *   D_* / D_FROM_U64BITS / D_TRUNC_BITS / D_INVSQRT_GUESS: double versions
+ *   VI, I_SET1 I_ADD I_SUB I_AND I_OR              int32 register / primitives
+ *   I_SRLI(v, n) I_SLLI(v, n)                      logical shifts
+ *   F_ASI(x) / I_ASF(v)                            bit casts float <-> int32
+ *   F_CVTI(v) -> (float)v,  I_CVTTF(x) -> (int32)x (truncating)
+ *   M_AND(a, b), M_BITS(m) -> lane i of m in bit i
+ *
+ * Every function mirrors the operation order of its scalar counterpart in
+ * math_core.h so the results are bit-identical; keep them in sync.
+ */
+
+/****************************************************FLOAT****************************************************/
+
+static inline MB_TARGET VF MB_FN(v_inv_sqrtf)(VF x)
+{
+    VF xhalf = F_MUL(F_SET1(0.5f), x);
+    VF y = F_INVSQRT_GUESS(x);
+    y = F_MUL(y, F_SUB(F_SET1(1.5f), F_MUL(F_MUL(xhalf, y), y)));
+    return F_BLEND(F_CMPLE(x, F_SET1(0.0f)), y, F_SET1(NAN));
+}
+
+static inline MB_TARGET VF MB_FN(v_sqrtf)(VF x)
+{
+    VF r = F_MUL(x, MB_FN(v_inv_sqrtf)(x));
+    return F_BLEND(F_CMPLT(x, F_SET1(0.0f)), r, F_SET1(NAN));
+}
+
+static inline MB_TARGET VF MB_FN(v_log2f)(VF x)
+{
+    VF y = F_MUL(F_FROM_U32BITS(x), F_SET1(1.1920928955078125e-7f));
+    y = F_SUB(y, F_SET1(126.94269504f));
+    return F_BLEND(F_CMPLE(x, F_SET1(0.0f)), y, F_SET1(-INFINITY));
+}
+
+static inline MB_TARGET VF MB_FN(v_exp2f)(VF p)
+{
+    VF t = F_ADD(p, F_SET1(126.94269504f));
+    t = F_MAX(t, F_SET1(0.0f));         // NaN and negatives -> 0
+    t = F_MIN(t, F_SET1(255.0f));
+    return F_TRUNC_BITS(F_MUL(t, F_SET1(8388608.0f)));
+}
+
+static inline MB_TARGET VF MB_FN(v_powf)(VF x, float y)
+{
+    VF r = MB_FN(v_exp2f)(F_MUL(F_SET1(y), MB_FN(v_log2f)(x)));
+    float at_zero = y > 0.0f ? 0.0f : (y == 0.0f ? 1.0f : INFINITY);
+    r = F_BLEND(F_CMPEQ(x, F_SET1(0.0f)), r, F_SET1(at_zero));
+    return F_BLEND(F_CMPLT(x, F_SET1(0.0f)), r, F_SET1(NAN));
+}
+
+static inline MB_TARGET VF MB_FN(v_cbrtf)(VF x)
+{
+    MF neg = F_CMPLT(x, F_SET1(0.0f));
+    VF r = MB_FN(v_powf)(F_BLEND(neg, x, F_NEG(x)), 1.0f / 3.0f);
+    return F_BLEND(neg, r, F_NEG(r));
+}
+
+static inline MB_TARGET VF MB_FN(v_hypotf)(VF x, VF y)
+{
+    return MB_FN(v_sqrtf)(F_ADD(F_MUL(x, x), F_MUL(y, y)));
+}
+
+#define MB_ARRAY_F1(name, vfn, sfn)                                                 \
+static MB_TARGET void MB_FN(name)(float *dst, const float *src, size_t n)           \
+{                                                                                   \
+    size_t i = 0;                                                                   \
+    for (; i + WF <= n; i += WF) F_STOREU(dst + i, vfn(F_LOADU(src + i)));          \
+    for (; i < n; i++) dst[i] = sfn(src[i]);                                        \
+}
+
+MB_ARRAY_F1(inv_sqrt_array, MB_FN(v_inv_sqrtf), fast_inv_sqrt)
+MB_ARRAY_F1(sqrt_array, MB_FN(v_sqrtf), fast_sqrt)
+MB_ARRAY_F1(log2f_array, MB_FN(v_log2f), fast_log2f)
+MB_ARRAY_F1(exp2f_array, MB_FN(v_exp2f), fast_exp2f)
+MB_ARRAY_F1(cbrtf_array, MB_FN(v_cbrtf), cbrt_f)
+MB_ARRAY_F1(sqrt_exact_array, F_SQRT, sqrt_exact_f)
+
+static MB_TARGET void MB_FN(powf_array)(float *dst, const float *src, float y, size_t n)
+{
+    size_t i = 0;
+    for (; i + WF <= n; i += WF) F_STOREU(dst + i, MB_FN(v_powf)(F_LOADU(src + i), y));
+    for (; i < n; i++) dst[i] = fast_powf(src[i], y);
+}
+
+static MB_TARGET void MB_FN(hypotf_array)(float *dst, const float *x, const float *y, size_t n)
+{
+    size_t i = 0;
+    for (; i + WF <= n; i += WF) F_STOREU(dst + i, MB_FN(v_hypotf)(F_LOADU(x + i), F_LOADU(y + i)));
+    for (; i < n; i++) dst[i] = hypot_f(x[i], y[i]);
+}
+
+/*
+ * POLY tier. Only the common path (normal inputs, results in the normal
+ * range) is vectorized; each function reports in `ok` the lanes that took
+ * it, and the array loops recompute the others with the scalar function.
+ */
+
+static inline MB_TARGET VF MB_FN(v_log2f_poly)(VF x, MF *ok)
+{
+    *ok = M_AND(F_CMPLE(F_SET1(1.17549435e-38f), x), F_CMPLE(x, F_SET1(3.40282347e+38f)));
+    VI bits = F_ASI(x);
+    VF e = F_CVTI(I_SUB(I_SRLI(bits, 23), I_SET1(127)));
+    VF m = I_ASF(I_OR(I_AND(bits, I_SET1(0x007fffff)), I_SET1(0x3f800000)));
+    MF big = F_CMPLT(F_SET1(1.41421356f), m);
+    m = F_BLEND(big, m, F_MUL(m, F_SET1(0.5f)));
+    e = F_BLEND(big, e, F_ADD(e, F_SET1(1.0f)));    // (float)(e + 1), exact
+    VF f = F_SUB(m, F_SET1(1.0f));
+    VF p = F_SET1(-0.206858124f);
+    p = F_ADD(F_MUL(p, f), F_SET1(0.318407118f));
+    p = F_SUB(F_MUL(p, f), F_SET1(0.366413259f));
+    p = F_ADD(F_MUL(p, f), F_SET1(0.479793884f));
+    p = F_SUB(F_MUL(p, f), F_SET1(0.721208468f));
+    p = F_ADD(F_MUL(p, f), F_SET1(1.4427018f));
+    return F_ADD(e, F_MUL(f, p));
+}
+
+static inline MB_TARGET VF MB_FN(v_exp2f_poly)(VF p, MF *ok)
+{
+    *ok = M_AND(F_CMPLT(F_SET1(-125.0f), p), F_CMPLT(p, F_SET1(127.0f)));  // -126 < i <= 127
+    MF pos = F_CMPLE(F_SET1(0.0f), p);
+    VI i = I_CVTTF(F_BLEND(pos, F_SUB(p, F_SET1(0.5f)), F_ADD(p, F_SET1(0.5f))));
+    VF f = F_SUB(p, F_CVTI(i));
+    VF r = F_SET1(0.00956051021f);
+    r = F_ADD(F_MUL(r, f), F_SET1(0.0559170392f));
+    r = F_ADD(F_MUL(r, f), F_SET1(0.240249811f));
+    r = F_ADD(F_MUL(r, f), F_SET1(0.693121968f));
+    r = F_ADD(F_MUL(r, f), F_SET1(0.999999191f));
+    return F_MUL(r, I_ASF(I_SLLI(I_ADD(i, I_SET1(127)), 23)));
+}
+
+static inline MB_TARGET VF MB_FN(v_powf_poly)(VF x, float y, MF *ok)
+{
+    MF ok_log, ok_exp;
+    VF r = MB_FN(v_exp2f_poly)(F_MUL(F_SET1(y), MB_FN(v_log2f_poly)(x, &ok_log)), &ok_exp);
+    *ok = M_AND(ok_log, ok_exp);
+    return r;
+}
+
+// stores r, then redoes the lanes outside `ok` from the saved inputs (dst may be src)
+#define MB_FIXUP_F(dst, x, r, ok, sfn_of)                                           \
+    do {                                                                            \
+        unsigned int bad_ = ~M_BITS(ok) & ((1u << WF) - 1);                         \
+        if (bad_) {                                                                 \
+            float xs_[WF];                                                          \
+            F_STOREU(xs_, x);                                                       \
+            F_STOREU(dst, r);                                                       \
+            for (; bad_; bad_ &= bad_ - 1) {                                        \
+                int j_ = __builtin_ctz(bad_);                                       \
+                (dst)[j_] = sfn_of(xs_[j_]);                                        \
+            }                                                                       \
+        } else {                                                                    \
+            F_STOREU(dst, r);                                                       \
+        }                                                                           \
+    } while (0)
+
+#define MB_ARRAY_F1_POLY(name, vfn, sfn)                                            \
+static MB_TARGET void MB_FN(name)(float *dst, const float *src, size_t n)           \
+{                                                                                   \
+    size_t i = 0;                                                                   \
+    for (; i + WF <= n; i += WF) {                                                  \
+        MF ok;                                                                      \
+        VF x = F_LOADU(src + i);                                                    \
+        VF r = vfn(x, &ok);                                                         \
+        MB_FIXUP_F(dst + i, x, r, ok, sfn);                                         \
+    }                                                                               \
+    for (; i < n; i++) dst[i] = sfn(src[i]);                                        \
+}
+
+MB_ARRAY_F1_POLY(log2f_poly_array, MB_FN(v_log2f_poly), fast_log2f_poly)
+MB_ARRAY_F1_POLY(exp2f_poly_array, MB_FN(v_exp2f_poly), fast_exp2f_poly)
+
+static MB_TARGET void MB_FN(powf_poly_array)(float *dst, const float *src, float y, size_t n)
+{
+    size_t i = 0;
+#define MB_POWF_POLY_(x) fast_powf_poly(x, y)
+    for (; i + WF <= n; i += WF) {
+        MF ok;
+        VF x = F_LOADU(src + i);
+        VF r = MB_FN(v_powf_poly)(x, y, &ok);
+        MB_FIXUP_F(dst + i, x, r, ok, MB_POWF_POLY_);
+    }
+#undef MB_POWF_POLY_
+    for (; i < n; i++) dst[i] = fast_powf_poly(src[i], y);
+}
+
+/*
+ * sin and cos together, mirroring fast_sincosf_poly. Lanes outside
+ * [-FAST_SINCOS_MAX, FAST_SINCOS_MAX] (and NaN) are not `ok`.
+ */
+static inline MB_TARGET void MB_FN(v_sincosf_poly)(VF x, VF *s, VF *c, MF *ok)
+{
+    *ok = M_AND(F_CMPLE(F_SET1(-FAST_SINCOS_MAX), x), F_CMPLE(x, F_SET1(FAST_SINCOS_MAX)));
+    VF k = F_SUB(F_ADD(F_MUL(x, F_SET1(0.636619772f)), F_SET1(12582912.0f)), F_SET1(12582912.0f));
+    VF r = F_SUB(x, F_MUL(k, F_SET1(1.5703125f)));
+    r = F_SUB(r, F_MUL(k, F_SET1(4.837512969970703125e-4f)));
+    r = F_SUB(r, F_MUL(k, F_SET1(7.54978995489188216e-8f)));
+    VF z = F_MUL(r, r);
+    VF sp = F_ADD(F_MUL(F_SET1(-1.9515295891e-4f), z), F_SET1(8.3321608736e-3f));
+    sp = F_SUB(F_MUL(sp, z), F_SET1(1.6666654611e-1f));
+    sp = F_ADD(F_MUL(F_MUL(sp, z), r), r);
+    VF cp = F_SUB(F_MUL(F_SET1(2.443315711809948e-5f), z), F_SET1(1.388731625493765e-3f));
+    cp = F_ADD(F_MUL(cp, z), F_SET1(4.166664568298827e-2f));
+    cp = F_ADD(F_SUB(F_MUL(F_MUL(cp, z), z), F_MUL(F_SET1(0.5f), z)), F_SET1(1.0f));
+    // quadrant bits as masks: (float)(q & b) > 0
+    VI q = I_CVTTF(k);
+    VF zero = F_SET1(0.0f);
+    MF odd = F_CMPLT(zero, F_CVTI(I_AND(q, I_SET1(1))));
+    MF sneg = F_CMPLT(zero, F_CVTI(I_AND(q, I_SET1(2))));
+    MF cneg = F_CMPLT(zero, F_CVTI(I_AND(I_ADD(q, I_SET1(1)), I_SET1(2))));
+    VF sv = F_BLEND(odd, sp, cp);
+    VF cv = F_BLEND(odd, cp, sp);
+    *s = F_BLEND(sneg, sv, F_NEG(sv));
+    *c = F_BLEND(cneg, cv, F_NEG(cv));
+}
+
+static MB_TARGET void MB_FN(sincosf_poly_array)(float *s, float *c, const float *x, size_t n)
+{
+    size_t i = 0;
+    for (; i + WF <= n; i += WF) {
+        MF ok;
+        VF vs, vc, xv = F_LOADU(x + i);
+        MB_FN(v_sincosf_poly)(xv, &vs, &vc, &ok);
+        unsigned int bad = ~M_BITS(ok) & ((1u << WF) - 1);
+        float xs[WF];
+        if (bad) F_STOREU(xs, xv);                  // s or c may be x
+        F_STOREU(s + i, vs);
+        F_STOREU(c + i, vc);
+        for (; bad; bad &= bad - 1) {
+            int j = __builtin_ctz(bad);
+            fast_sincosf_poly(xs[j], s + i + j, c + i + j);
+        }
+    }
+    for (; i < n; i++) fast_sincosf_poly(x[i], s + i, c + i);
+}
+
+/****************************************************DOUBLE***************************************************/
+
+static inline MB_TARGET VD MB_FN(v_inv_sqrtd)(VD x)
+{
+    VD xhalf = D_MUL(D_SET1(0.5), x);
+    VD y = D_INVSQRT_GUESS(x);
+    y = D_MUL(y, D_SUB(D_SET1(1.5), D_MUL(D_MUL(xhalf, y), y)));
+    return D_BLEND(D_CMPLE(x, D_SET1(0.0)), y, D_SET1(NAN));
+}
+
+static inline MB_TARGET VD MB_FN(v_sqrtd)(VD x)
+{
+    VD r = D_MUL(x, MB_FN(v_inv_sqrtd)(x));
+    return D_BLEND(D_CMPLT(x, D_SET1(0.0)), r, D_SET1(NAN));
+}
+
+static inline MB_TARGET VD MB_FN(v_log2d)(VD x)
+{
+    VD y = D_MUL(D_FROM_U64BITS(x), D_SET1(2.220446049250313e-16));
+    y = D_SUB(y, D_SET1(1022.94269504));
+    return D_BLEND(D_CMPLE(x, D_SET1(0.0)), y, D_SET1(-INFINITY));
+}
+
+static inline MB_TARGET VD MB_FN(v_exp2d)(VD p)
+{
+    VD t = D_ADD(p, D_SET1(1022.94269504));
+    t = D_MAX(t, D_SET1(0.0));
+    t = D_MIN(t, D_SET1(2047.0));
+    return D_TRUNC_BITS(D_MUL(t, D_SET1(4503599627370496.0)));
+}
+
+static inline MB_TARGET VD MB_FN(v_powd)(VD x, double y)
+{
+    VD r = MB_FN(v_exp2d)(D_MUL(D_SET1(y), MB_FN(v_log2d)(x)));
+    double at_zero = y > 0.0 ? 0.0 : (y == 0.0 ? 1.0 : INFINITY);
+    r = D_BLEND(D_CMPEQ(x, D_SET1(0.0)), r, D_SET1(at_zero));
+    return D_BLEND(D_CMPLT(x, D_SET1(0.0)), r, D_SET1(NAN));
+}
+
+static inline MB_TARGET VD MB_FN(v_cbrtd)(VD x)
+{
+    MD neg = D_CMPLT(x, D_SET1(0.0));
+    VD r = MB_FN(v_powd)(D_BLEND(neg, x, D_NEG(x)), 1.0 / 3.0);
+    return D_BLEND(neg, r, D_NEG(r));
+}
+
+static inline MB_TARGET VD MB_FN(v_hypotd)(VD x, VD y)
+{
+    return MB_FN(v_sqrtd)(D_ADD(D_MUL(x, x), D_MUL(y, y)));
+}
+
+#define MB_ARRAY_D1(name, vfn, sfn)                                                 \
+static MB_TARGET void MB_FN(name)(double *dst, const double *src, size_t n)         \
+{                                                                                   \
+    size_t i = 0;                                                                   \
+    for (; i + WD <= n; i += WD) D_STOREU(dst + i, vfn(D_LOADU(src + i)));          \
+    for (; i < n; i++) dst[i] = sfn(src[i]);                                        \
+}
+
+MB_ARRAY_D1(inv_sqrtd_array, MB_FN(v_inv_sqrtd), fast_inv_sqrtd)
+MB_ARRAY_D1(sqrtd_array, MB_FN(v_sqrtd), fast_sqrtd)
+MB_ARRAY_D1(log2d_array, MB_FN(v_log2d), fast_log2d)
+MB_ARRAY_D1(exp2d_array, MB_FN(v_exp2d), fast_exp2d)
+MB_ARRAY_D1(cbrtd_array, MB_FN(v_cbrtd), cbrt_d)
+MB_ARRAY_D1(sqrt_exactd_array, D_SQRT, sqrt_exact_d)
+
+static MB_TARGET void MB_FN(powd_array)(double *dst, const double *src, double y, size_t n)
+{
+    size_t i = 0;
+    for (; i + WD <= n; i += WD) D_STOREU(dst + i, MB_FN(v_powd)(D_LOADU(src + i), y));
+    for (; i < n; i++) dst[i] = fast_powd(src[i], y);
+}
+
+static MB_TARGET void MB_FN(hypotd_array)(double *dst, const double *x, const double *y, size_t n)
+{
+    size_t i = 0;
+    for (; i + WD <= n; i += WD) D_STOREU(dst + i, MB_FN(v_hypotd)(D_LOADU(x + i), D_LOADU(y + i)));
+    for (; i < n; i++) dst[i] = hypot_d(x[i], y[i]);
+}
+
+static const math_batch_kernels_t MB_FN(batch_kernels) = {
+    MB_FN(inv_sqrt_array), MB_FN(sqrt_array), MB_FN(log2f_array), MB_FN(exp2f_array),
+    MB_FN(powf_array), MB_FN(cbrtf_array), MB_FN(hypotf_array),
+    MB_FN(inv_sqrtd_array), MB_FN(sqrtd_array), MB_FN(log2d_array), MB_FN(exp2d_array),
+    MB_FN(powd_array), MB_FN(cbrtd_array), MB_FN(hypotd_array),
+    MB_FN(log2f_poly_array), MB_FN(exp2f_poly_array), MB_FN(powf_poly_array),
+    MB_FN(sqrt_exact_array), MB_FN(sqrt_exactd_array), MB_FN(sincosf_poly_array)
+};
+
+#undef MB_ARRAY_F1
+#undef MB_ARRAY_F1_POLY
+#undef MB_FIXUP_F
+#undef MB_ARRAY_D1
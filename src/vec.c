@@ -1,28 +1,50 @@
 #include <vec.h> 
 #include <math_core.h>
+#include <vec_simd.h>
+#include <vec_parallel.h>
+#include <vec_view.h>
+#include <vec_stats.h>
+#include <math_batch.h>
+#include <stdatomic.h>
+#include <limits.h>
 
-const vector_t VEC_UNDEFINED = {0, NULL};
-const dvector_t DVEC_UNDEFINED = {0, NULL};
+const vector_t VEC_UNDEFINED = {0, NULL, NULL, 0};
+const dvector_t DVEC_UNDEFINED = {0, NULL, NULL, 0};
 
 /**
  * @brief Allocate a vector of given size (uninitialized data).
+ *        Storage comes from the calling thread's active allocator
+ *        (see VEC_ALLOCATOR_SCOPE), malloc by default.
  */
 vector_t vector_alloc(unsigned int size)
 {
+    VEC_STATS_SCOPE(vector_alloc, size);
     vector_t v;
+    v.allocator = vec_allocator_current();
     v.size = size;
-    v.data = (float*)malloc(size * sizeof(float));
+    v.capacity = size;
+    v.data = (float*)v.allocator->alloc(v.allocator->ctx, size * sizeof(float));
+    VEC_STATS_ALLOCATED(size * sizeof(float));
     return v;
 }
 
 /**
  * @brief Free the vector memory, setting v->data = NULL.
+ *        The buffer goes back to the allocator that produced it, so a vector
+ *        may be freed outside the scope it was allocated in.
  */
 void vector_free(vector_t *v)
 {
+    VEC_STATS_SCOPE(vector_free, v->size);
     if (v->data) {
-        free(v->data);
+        VEC_STATS_FREED(vector_capacity(*v) * sizeof(float));
+        if (v->allocator) {
+            v->allocator->free(v->allocator->ctx, v->data, vector_capacity(*v) * sizeof(float));
+        } else {
+            free(v->data);
+        }
         v->data = NULL;
+        v->capacity = 0;
     }
     // v->size is left as-is or set to 0 if you prefer
 }
@@ -32,6 +54,7 @@ void vector_free(vector_t *v)
  */
 vector_t vector_create(unsigned int size)
 {
+    VEC_STATS_SCOPE(vector_create, size);
     vector_t v = vector_alloc(size);
     for (unsigned int i = 0; i < size; i++) {
         v.data[i] = 0.0f;
@@ -44,6 +67,7 @@ vector_t vector_create(unsigned int size)
  */
 vector_t vector_from_array(unsigned int size, const float *src)
 {
+    VEC_STATS_SCOPE(vector_from_array, size);
     vector_t v = vector_alloc(size);
     memcpy(v.data, src, size * sizeof(float));
     return v;
@@ -54,6 +78,7 @@ vector_t vector_from_array(unsigned int size, const float *src)
  */
 vector_t vector_copy(const vector_t v)
 {
+    VEC_STATS_SCOPE(vector_copy, v.size);
     vector_t c = vector_alloc(v.size);
     memcpy(c.data, v.data, v.size * sizeof(float));
     return c;
@@ -64,6 +89,7 @@ vector_t vector_copy(const vector_t v)
  */
 vector_t vector_default(unsigned int size, float value)
 {
+    VEC_STATS_SCOPE(vector_default, size);
     vector_t v = vector_alloc(size);
     for (unsigned int i = 0; i < size; i++) {
         v.data[i] = value;
@@ -71,19 +97,34 @@ vector_t vector_default(unsigned int size, float value)
     return v;
 }
 
+typedef struct {
+    const float *a, *b;
+    atomic_bool differs;
+} equals_ctx_t;
+
+static void equals_chunk(void *ctx, size_t begin, size_t end)
+{
+    equals_ctx_t *c = ctx;
+    if (atomic_load_explicit(&c->differs, memory_order_relaxed)) return;
+    for (size_t i = begin; i < end; i++) {
+        if (c->a[i] != c->b[i]) {
+            atomic_store_explicit(&c->differs, true, memory_order_relaxed);
+            return;
+        }
+    }
+}
+
 /**
  * @brief Check if two vectors are equal (element-wise ==).
  *        Returns false if sizes differ or any element differs.
  */
 bool vector_equals(const vector_t v1, const vector_t v2)
 {
+    VEC_STATS_SCOPE(vector_equals, v1.size);
     if (v1.size != v2.size) return false;
-    for (unsigned int i = 0; i < v1.size; i++) {
-        if (v1.data[i] != v2.data[i]) {
-            return false;
-        }
-    }
-    return true;
+    equals_ctx_t c = { v1.data, v2.data, false };
+    vec_parallel_for(v1.size, equals_chunk, &c);
+    return !atomic_load(&c.differs);
 }
 
 /**
@@ -91,13 +132,9 @@ bool vector_equals(const vector_t v1, const vector_t v2)
  */
 vector_t vector_scalar_add(const vector_t v, float scalar)
 {
+    VEC_STATS_SCOPE(vector_scalar_add, v.size);
     vector_t r = vector_alloc(v.size);
-    const float * __restrict src = v.data;
-          float * __restrict dst = r.data;
-
-    for (unsigned int i = 0; i < v.size; i++) {
-        dst[i] = src[i] + scalar;
-    }
+    vec_parallel_scalar(vec_kernels()->scalar_add, r.data, v.data, scalar, v.size);
     return r;
 }
 
@@ -106,10 +143,8 @@ vector_t vector_scalar_add(const vector_t v, float scalar)
  */
 void vector_scalar_add_inplace(vector_t *v, float scalar)
 {
-    float * __restrict dst = v->data;
-    for (unsigned int i = 0; i < v->size; i++) {
-        dst[i] += scalar;
-    }
+    VEC_STATS_SCOPE(vector_scalar_add_inplace, v->size);
+    vec_parallel_scalar(vec_kernels()->scalar_add, v->data, v->data, scalar, v->size);
 }
 
 /**
@@ -117,12 +152,9 @@ void vector_scalar_add_inplace(vector_t *v, float scalar)
  */
 vector_t vector_scalar_sub(const vector_t v, float scalar)
 {
+    VEC_STATS_SCOPE(vector_scalar_sub, v.size);
     vector_t r = vector_alloc(v.size);
-    const float * __restrict src = v.data;
-          float * __restrict dst = r.data;
-    for (unsigned int i = 0; i < v.size; i++) {
-        dst[i] = src[i] - scalar;
-    }
+    vec_parallel_scalar(vec_kernels()->scalar_sub, r.data, v.data, scalar, v.size);
     return r;
 }
 
@@ -131,10 +163,8 @@ vector_t vector_scalar_sub(const vector_t v, float scalar)
  */
 void vector_scalar_sub_inplace(vector_t *v, float scalar)
 {
-    float * __restrict dst = v->data;
-    for (unsigned int i = 0; i < v->size; i++) {
-        dst[i] -= scalar;
-    }
+    VEC_STATS_SCOPE(vector_scalar_sub_inplace, v->size);
+    vec_parallel_scalar(vec_kernels()->scalar_sub, v->data, v->data, scalar, v->size);
 }
 
 /**
@@ -142,12 +172,9 @@ void vector_scalar_sub_inplace(vector_t *v, float scalar)
  */
 vector_t vector_scalar_mul(const vector_t v, float scalar)
 {
+    VEC_STATS_SCOPE(vector_scalar_mul, v.size);
     vector_t r = vector_alloc(v.size);
-    const float * __restrict src = v.data;
-          float * __restrict dst = r.data;
-    for (unsigned int i = 0; i < v.size; i++) {
-        dst[i] = src[i] * scalar;
-    }
+    vec_parallel_scalar(vec_kernels()->scalar_mul, r.data, v.data, scalar, v.size);
     return r;
 }
 
@@ -156,10 +183,8 @@ vector_t vector_scalar_mul(const vector_t v, float scalar)
  */
 void vector_scalar_mul_inplace(vector_t *v, float scalar)
 {
-    float * __restrict dst = v->data;
-    for (unsigned int i = 0; i < v->size; i++) {
-        dst[i] *= scalar;
-    }
+    VEC_STATS_SCOPE(vector_scalar_mul_inplace, v->size);
+    vec_parallel_scalar(vec_kernels()->scalar_mul, v->data, v->data, scalar, v->size);
 }
 
 /**
@@ -167,15 +192,12 @@ void vector_scalar_mul_inplace(vector_t *v, float scalar)
  */
 vector_t vector_scalar_div(const vector_t v, float scalar)
 {
+    VEC_STATS_SCOPE(vector_scalar_div, v.size);
     if (scalar == 0.0f) {
         return vector_default(v.size, INFINITY);
     }
     vector_t r = vector_alloc(v.size);
-    const float * __restrict src = v.data;
-          float * __restrict dst = r.data;
-    for (unsigned int i = 0; i < v.size; i++) {
-        dst[i] = src[i] / scalar;
-    }
+    vec_parallel_scalar(vec_kernels()->scalar_div, r.data, v.data, scalar, v.size);
     return r;
 }
 
@@ -184,26 +206,36 @@ vector_t vector_scalar_div(const vector_t v, float scalar)
  */
 void vector_scalar_div_inplace(vector_t *v, float scalar)
 {
+    VEC_STATS_SCOPE(vector_scalar_div_inplace, v->size);
     if (scalar == 0.0f) {
         return;
     }
-    float * __restrict dst = v->data;
-    for (unsigned int i = 0; i < v->size; i++) {
-        dst[i] /= scalar;
-    }
+    vec_parallel_scalar(vec_kernels()->scalar_div, v->data, v->data, scalar, v->size);
+}
+
+typedef struct {
+    float *dst;
+    const float *src;
+    pow_plan_t plan;
+} pow_ctx_t;
+
+static void pow_chunk(void *ctx, size_t begin, size_t end)
+{
+    const pow_ctx_t *c = ctx;
+    pow_plan_apply_f(&c->plan, c->dst + begin, c->src + begin, end - begin);
 }
 
 /**
- * @brief Raise each element to a power, returns a new vector.
+ * @brief Raise each element to a power, returns a new vector. The exponent
+ *        is classified once (see pow_plan_t): integers and half-integers use
+ *        exact multiply chains, other exponents the POLY exp2/log2 path.
  */
 vector_t vector_pow(const vector_t v, float power)
 {
+    VEC_STATS_SCOPE(vector_pow, v.size);
     vector_t r = vector_alloc(v.size);
-    const float * __restrict src = v.data;
-          float * __restrict dst = r.data;
-    for (unsigned int i = 0; i < v.size; i++) {
-        dst[i] = pow_fi(src[i], power);
-    }
+    pow_ctx_t c = { r.data, v.data, pow_plan_f(power) };
+    vec_parallel_for(v.size, pow_chunk, &c);
     return r;
 }
 
@@ -212,10 +244,9 @@ vector_t vector_pow(const vector_t v, float power)
  */
 void vector_pow_inplace(vector_t *v, float power)
 {
-    float * __restrict dst = v->data;
-    for (unsigned int i = 0; i < v->size; i++) {
-        dst[i] = pow_fi(dst[i], power);
-    }
+    VEC_STATS_SCOPE(vector_pow_inplace, v->size);
+    pow_ctx_t c = { v->data, v->data, pow_plan_f(power) };
+    vec_parallel_for(v->size, pow_chunk, &c);
 }
 
 /**
@@ -223,15 +254,10 @@ void vector_pow_inplace(vector_t *v, float power)
  */
 vector_t vector_add(const vector_t v1, const vector_t v2)
 {
+    VEC_STATS_SCOPE(vector_add, v1.size);
     // For real production code, you might check size mismatch
     vector_t r = vector_alloc(v1.size);
-    const float * __restrict src1 = v1.data;
-    const float * __restrict src2 = v2.data;
-          float * __restrict dst  = r.data;
-
-    for (unsigned int i = 0; i < v1.size; i++) {
-        dst[i] = src1[i] + src2[i];
-    }
+    vec_parallel_binary(vec_kernels()->add, r.data, v1.data, v2.data, v1.size);
     return r;
 }
 
@@ -240,12 +266,9 @@ vector_t vector_add(const vector_t v1, const vector_t v2)
  */
 void vector_add_inplace(vector_t *v1, const vector_t v2)
 {
-    float * __restrict dst  = v1->data;
-    const float * __restrict src2 = v2.data;
+    VEC_STATS_SCOPE(vector_add_inplace, v1->size);
     // assume same size
-    for (unsigned int i = 0; i < v1->size; i++) {
-        dst[i] += src2[i];
-    }
+    vec_parallel_binary(vec_kernels()->add, v1->data, v1->data, v2.data, v1->size);
 }
 
 /**
@@ -253,14 +276,9 @@ void vector_add_inplace(vector_t *v1, const vector_t v2)
  */
 vector_t vector_sub(const vector_t v1, const vector_t v2)
 {
+    VEC_STATS_SCOPE(vector_sub, v1.size);
     vector_t r = vector_alloc(v1.size);
-    const float * __restrict src1 = v1.data;
-    const float * __restrict src2 = v2.data;
-          float * __restrict dst  = r.data;
-
-    for (unsigned int i = 0; i < v1.size; i++) {
-        dst[i] = src1[i] - src2[i];
-    }
+    vec_parallel_binary(vec_kernels()->sub, r.data, v1.data, v2.data, v1.size);
     return r;
 }
 
@@ -269,11 +287,8 @@ vector_t vector_sub(const vector_t v1, const vector_t v2)
  */
 void vector_sub_inplace(vector_t *v1, const vector_t v2)
 {
-    float * __restrict dst  = v1->data;
-    const float * __restrict src2 = v2.data;
-    for (unsigned int i = 0; i < v1->size; i++) {
-        dst[i] -= src2[i];
-    }
+    VEC_STATS_SCOPE(vector_sub_inplace, v1->size);
+    vec_parallel_binary(vec_kernels()->sub, v1->data, v1->data, v2.data, v1->size);
 }
 
 /**
@@ -281,14 +296,9 @@ void vector_sub_inplace(vector_t *v1, const vector_t v2)
  */
 vector_t vector_mul(const vector_t v1, const vector_t v2)
 {
+    VEC_STATS_SCOPE(vector_mul, v1.size);
     vector_t r = vector_alloc(v1.size);
-    const float * __restrict src1 = v1.data;
-    const float * __restrict src2 = v2.data;
-          float * __restrict dst  = r.data;
-
-    for (unsigned int i = 0; i < v1.size; i++) {
-        dst[i] = src1[i] * src2[i];
-    }
+    vec_parallel_binary(vec_kernels()->mul, r.data, v1.data, v2.data, v1.size);
     return r;
 }
 
@@ -297,11 +307,8 @@ vector_t vector_mul(const vector_t v1, const vector_t v2)
  */
 void vector_mul_inplace(vector_t *v1, const vector_t v2)
 {
-    float * __restrict dst  = v1->data;
-    const float * __restrict src2 = v2.data;
-    for (unsigned int i = 0; i < v1->size; i++) {
-        dst[i] *= src2[i];
-    }
+    VEC_STATS_SCOPE(vector_mul_inplace, v1->size);
+    vec_parallel_binary(vec_kernels()->mul, v1->data, v1->data, v2.data, v1->size);
 }
 
 /**
@@ -309,13 +316,9 @@ void vector_mul_inplace(vector_t *v1, const vector_t v2)
  */
 vector_t vector_div(const vector_t v1, const vector_t v2)
 {
+    VEC_STATS_SCOPE(vector_div, v1.size);
     vector_t r = vector_alloc(v1.size);
-    const float * __restrict src1 = v1.data;
-    const float * __restrict src2 = v2.data;
-          float * __restrict dst  = r.data;
-    for (unsigned int i = 0; i < v1.size; i++) {
-        dst[i] = src1[i] / src2[i];
-    }
+    vec_parallel_binary(vec_kernels()->div, r.data, v1.data, v2.data, v1.size);
     return r;
 }
 
@@ -324,33 +327,186 @@ vector_t vector_div(const vector_t v1, const vector_t v2)
  */
 void vector_div_inplace(vector_t *v1, const vector_t v2)
 {
-    float * __restrict dst  = v1->data;
-    const float * __restrict src2 = v2.data;
-    for (unsigned int i = 0; i < v1->size; i++) {
-        dst[i] /= src2[i];
+    VEC_STATS_SCOPE(vector_div_inplace, v1->size);
+    vec_parallel_binary(vec_kernels()->div, v1->data, v1->data, v2.data, v1->size);
+}
+
+typedef struct {
+    const float *a, *b;
+    vec_reduce_mode_t mode;
+} dot_ctx_t;
+
+/* power-of-two scale bringing m into [0.5, 1), clamped to normal floats */
+static float reduce_scale(float m)
+{
+    union {
+        float f;
+        uint32_t i;
+    } v = { m };
+    int e = (int)((v.i >> 23) & 0xff) - 126;
+    int se = -e < -126 ? -126 : (-e > 127 ? 127 : -e);
+    v.i = (uint32_t)(se + 127) << 23;
+    return v.f;
+}
+
+static double dot_chunk(void *ctx, size_t begin, size_t end)
+{
+    const dot_ctx_t *c = ctx;
+    const vec_kernels_t *k = vec_kernels();
+    const float *a = c->a + begin, *b = c->b + begin;
+    size_t n = end - begin;
+
+    switch (c->mode) {
+        case VEC_REDUCE_COMPENSATED:
+            return k->dot_compensated(a, b, n);
+        case VEC_REDUCE_SCALED: {
+            float ma = k->maxabs(a, n);
+            float mb = a == b ? ma : k->maxabs(b, n);
+            // zero, inf or NaN: the unscaled sum already gives the right answer
+            if (!(ma > 0.0f && mb > 0.0f && ma <= FLT_MAX && mb <= FLT_MAX)) return k->dot(a, b, n);
+            float sa = reduce_scale(ma), sb = reduce_scale(mb);
+            return (double)k->dot_scaled(a, b, sa, sb, n) / ((double)sa * (double)sb);
+        }
+        default:
+            return k->dot(a, b, n);
+    }
+}
+
+/*
+ * Strided views are reduced in the same chunks as contiguous ones; each
+ * strided operand's chunk is gathered into scratch first, so the kernels
+ * see exactly the elements a vec_view_copy would hold. The scratch is one
+ * buffer per pool thread (indexed by vec_parallel_worker, as mat.c's A
+ * panels), allocated on its first chunk and freed when the call returns.
+ * Running out of memory marks the call failed and the chunk adds 0.
+ */
+typedef struct {
+    void *buf[VEC_PARALLEL_MAX_THREADS];
+    size_t elements;            // per operand: one chunk, or the whole view if shorter
+    size_t bytes;
+    atomic_bool failed;
+} view_scratch_t;
+
+// room for `operands` gathered chunks of `size`-byte elements of an n-element view
+static void view_scratch_init(view_scratch_t *s, size_t n, size_t size, int operands)
+{
+    memset(s->buf, 0, sizeof s->buf);
+    s->elements = n < VEC_PARALLEL_CHUNK ? n : VEC_PARALLEL_CHUNK;
+    s->bytes = (size_t)operands * s->elements * size;
+    atomic_init(&s->failed, false);
+}
+
+// the calling thread's buffer; NULL (and the call marked failed) if out of memory
+static void *view_scratch_get(view_scratch_t *s)
+{
+    void **own = &s->buf[vec_parallel_worker()];
+    if (!*own) *own = malloc(s->bytes);
+    if (!*own) atomic_store_explicit(&s->failed, true, memory_order_relaxed);
+    return *own;
+}
+
+// frees every buffer; false if any chunk could not get one
+static bool view_scratch_release(view_scratch_t *s)
+{
+    for (size_t t = 0; t < VEC_PARALLEL_MAX_THREADS; t++) free(s->buf[t]);
+    return !atomic_load_explicit(&s->failed, memory_order_relaxed);
+}
+
+typedef struct {
+    vec_view_t a, b;
+    vec_reduce_mode_t mode;
+    view_scratch_t scratch;
+} view_dot_ctx_t;
+
+// elements [begin, begin + n) of v, contiguous: in place or gathered into buf
+static const float *view_chunk(vec_view_t v, size_t begin, size_t n, float *buf)
+{
+    const float *p = v.data + (ptrdiff_t)begin * v.stride;
+    if (v.stride == 1) return p;
+    vec_kernels()->gather(buf, p, v.stride, n);
+    return buf;
+}
+
+static double view_dot_chunk(void *ctx, size_t begin, size_t end)
+{
+    view_dot_ctx_t *c = ctx;
+    size_t n = end - begin;
+    float *buf = (float *)view_scratch_get(&c->scratch);
+    if (!buf) return 0.0;
+    dot_ctx_t d = { view_chunk(c->a, begin, n, buf), NULL, c->mode };
+    bool same = c->a.data == c->b.data && c->a.stride == c->b.stride;
+    d.b = same ? d.a : view_chunk(c->b, begin, n, buf + c->scratch.elements);
+    return dot_chunk(&d, 0, n);
+}
+
+// unrounded dot product of two equally sized views; *ok false if the gather scratch ran out
+static double view_dot(vec_view_t a, vec_view_t b, vec_reduce_mode_t mode, bool *ok)
+{
+    if (vec_view_is_contiguous(a) && vec_view_is_contiguous(b)) {
+        dot_ctx_t c = { a.data, b.data, mode };
+        return vec_parallel_reduce(a.size, dot_chunk, &c);
+    }
+    view_dot_ctx_t c = { .a = a, .b = b, .mode = mode };
+    bool same = a.data == b.data && a.stride == b.stride;
+    view_scratch_init(&c.scratch, a.size, sizeof(float), same ? 1 : 2);
+    double r = vec_parallel_reduce(a.size, view_dot_chunk, &c);
+    if (!view_scratch_release(&c.scratch)) {
+        if (ok) *ok = false;
+        return NAN;
     }
+    return r;
+}
+
+/**
+ * @brief Dot product of two views with the given accuracy mode. Long
+ *        vectors are reduced per VEC_PARALLEL_CHUNK chunk and the chunks
+ *        combined pairwise in double, with or without the thread pool (see
+ *        vec_parallel.h). Returns 0 for mismatched sizes. Strided views are
+ *        gathered into scratch; if that cannot be allocated the result is
+ *        NaN and *ok (when ok is not NULL) is set to false, otherwise *ok is
+ *        set to true.
+ */
+float vec_view_dot_ex(vec_view_t a, vec_view_t b, vec_reduce_mode_t mode, bool *ok)
+{
+    VEC_STATS_SCOPE(vec_view_dot_ex, a.size);
+    if (ok) *ok = true;
+    if (a.size != b.size) return 0.0f;
+    return (float)view_dot(a, b, mode, ok);
+}
+
+float vec_view_dot(vec_view_t a, vec_view_t b)
+{
+    return vec_view_dot_ex(a, b, VEC_REDUCE_FAST, NULL);
+}
+
+/**
+ * @brief Dot product of two vectors with the given accuracy mode (see
+ *        vec_view_dot_ex).
+ */
+float vector_dot_ex(const vector_t v1, const vector_t v2, vec_reduce_mode_t mode)
+{
+    VEC_STATS_SCOPE(vector_dot_ex, v1.size);
+    return vec_view_dot_ex(vec_view_of(v1), vec_view_of(v2), mode, NULL);
 }
 
 /**
- * @brief Dot product of two vectors.
+ * @brief Dot product of two vectors (VEC_REDUCE_FAST).
  */
 float vector_dot(const vector_t v1, const vector_t v2)
 {
-    float sum = 0.0f;
-    const float * __restrict src1 = v1.data;
-    const float * __restrict src2 = v2.data;
-    for (unsigned int i = 0; i < v1.size; i++) {
-        sum += src1[i] * src2[i];
-    }
-    return sum;
+    VEC_STATS_SCOPE(vector_dot, v1.size);
+    return vector_dot_ex(v1, v2, VEC_REDUCE_FAST);
 }
 
 /**
- * @brief Cross product in 3D. Expects v1.size == 3 and v2.size == 3.
+ * @brief Cross product in 3D. Returns VEC_UNDEFINED unless
+ *        v1.size == 3 and v2.size == 3. For hot paths prefer vec3f_cross
+ *        (vec_fixed.h), which does not allocate.
  */
 vector_t vector_cross(const vector_t v1, const vector_t v2)
 {
-    // If size !=3 => out-of-bounds errors.
+    VEC_STATS_SCOPE(vector_cross, v1.size);
+    if (v1.size != 3 || v2.size != 3) return VEC_UNDEFINED;
     vector_t r = vector_alloc(3);
     const float * __restrict a = v1.data;
     const float * __restrict b = v2.data;
@@ -371,16 +527,90 @@ vector_t vector_cross_R7(const vector_t v1, const vector_t v2)
 
 
 /**
- * @brief Magnitude (Euclidean norm) of a vector.
+ * @brief Magnitude (Euclidean norm) of a vector: VEC_REDUCE_FAST sum of
+ *        squares and the fast sqrt_f approximation.
  */
+float vec_view_magnitude(vec_view_t v)
+{
+    VEC_STATS_SCOPE(vec_view_magnitude, v.size);
+    return sqrt_f((float)view_dot(v, v, VEC_REDUCE_FAST, NULL));
+}
+
 float vector_magnitude(const vector_t v)
 {
-    float sum = 0.0f;
-    const float * __restrict src = v.data;
-    for (unsigned int i = 0; i < v.size; i++) {
-        sum += src[i] * src[i];
+    VEC_STATS_SCOPE(vector_magnitude, v.size);
+    return vec_view_magnitude(vec_view_of(v));
+}
+
+/**
+ * @brief Magnitude with the given accuracy mode and a correctly rounded
+ *        sqrt. VEC_REDUCE_SCALED returns a finite result whenever the true
+ *        magnitude fits in a float. `ok` as for vec_view_dot_ex.
+ */
+float vec_view_magnitude_ex(vec_view_t v, vec_reduce_mode_t mode, bool *ok)
+{
+    VEC_STATS_SCOPE(vec_view_magnitude_ex, v.size);
+    if (ok) *ok = true;
+    return (float)sqrt_exact_d(view_dot(v, v, mode, ok));
+}
+
+float vector_magnitude_ex(const vector_t v, vec_reduce_mode_t mode)
+{
+    VEC_STATS_SCOPE(vector_magnitude_ex, v.size);
+    return vec_view_magnitude_ex(vec_view_of(v), mode, NULL);
+}
+
+static double sum_chunk(void *ctx, size_t begin, size_t end)
+{
+    const float *a = ctx;
+    return vec_kernels()->sum(a + begin, end - begin);
+}
+
+typedef struct {
+    vec_view_t v;
+    view_scratch_t scratch;
+} view_sum_ctx_t;
+
+static double view_sum_chunk(void *ctx, size_t begin, size_t end)
+{
+    view_sum_ctx_t *c = ctx;
+    size_t n = end - begin;
+    float *buf = (float *)view_scratch_get(&c->scratch);
+    if (!buf) return 0.0;
+    return vec_kernels()->sum(view_chunk(c->v, begin, n, buf), n);
+}
+
+/**
+ * @brief Sum of the elements. Each chunk is summed in float lanes like
+ *        vector_dot; the chunk partials are added pairwise in double and
+ *        returned without rounding back to float. `ok` as for
+ *        vec_view_dot_ex.
+ */
+double vec_view_sum_ex(vec_view_t v, bool *ok)
+{
+    VEC_STATS_SCOPE(vec_view_sum_ex, v.size);
+    if (ok) *ok = true;
+    if (vec_view_is_contiguous(v)) return vec_parallel_reduce(v.size, sum_chunk, v.data);
+    view_sum_ctx_t c = { .v = v };
+    view_scratch_init(&c.scratch, v.size, sizeof(float), 1);
+    double r = vec_parallel_reduce(v.size, view_sum_chunk, &c);
+    if (!view_scratch_release(&c.scratch)) {
+        if (ok) *ok = false;
+        return NAN;
     }
-    return sqrt_f(sum);
+    return r;
+}
+
+double vec_view_sum(vec_view_t v)
+{
+    VEC_STATS_SCOPE(vec_view_sum, v.size);
+    return vec_view_sum_ex(v, NULL);
+}
+
+double vector_sum(const vector_t v)
+{
+    VEC_STATS_SCOPE(vector_sum, v.size);
+    return vec_view_sum(vec_view_of(v));
 }
 
 /**
@@ -400,18 +630,29 @@ void print_vector(const char* label, vector_t v)
 /****************************************************DVEC*****************************************************/
 
 dvector_t allocate_d(unsigned int size) {
-    dvector_t v = {size, (double *)malloc(size * sizeof(double))};
+    VEC_STATS_SCOPE(allocate_d, size);
+    const vec_allocator_t *a = vec_allocator_current();
+    dvector_t v = {size, (double *)a->alloc(a->ctx, size * sizeof(double)), a, size};
+    VEC_STATS_ALLOCATED(size * sizeof(double));
     return v;
 }
 
 void free_dvector(dvector_t *v) {
+    VEC_STATS_SCOPE(free_dvector, v->size);
     if (v->data != NULL) {
-        free(v->data);
+        VEC_STATS_FREED(dvec_capacity(*v) * sizeof(double));
+        if (v->allocator) {
+            v->allocator->free(v->allocator->ctx, v->data, dvec_capacity(*v) * sizeof(double));
+        } else {
+            free(v->data);
+        }
         v->data = NULL;
+        v->capacity = 0;
     }
 }
 
 dvector_t dvec_create(unsigned int size) {
+    VEC_STATS_SCOPE(dvec_create, size);
     dvector_t v = allocate_d(size);
     for (unsigned int i = 0; i < size; i++) {
         v.data[i] = 0.0;
@@ -419,26 +660,509 @@ dvector_t dvec_create(unsigned int size) {
     return v;
 }
 
-dvector_t dvec_create_from_array(unsigned int size, double *data) {
+dvector_t dvec_create_from_array(unsigned int size, const double *data) {
+    VEC_STATS_SCOPE(dvec_create_from_array, size);
     dvector_t v = allocate_d(size);
-    for (unsigned int i = 0; i < size; i++) {
-        v.data[i] = data[i];
-    }
+    memcpy(v.data, data, size * sizeof(double));
     return v;
 }
 
 dvector_t dvec_copy(dvector_t v) {
+    VEC_STATS_SCOPE(dvec_copy, v.size);
     dvector_t copy = allocate_d(v.size);
-    for (unsigned int i = 0; i < v.size; i++) {
-        copy.data[i] = v.data[i];
-    }
+    memcpy(copy.data, v.data, v.size * sizeof(double));
     return copy;
 }
 
 dvector_t dvec_default(unsigned int size, double value) {
+    VEC_STATS_SCOPE(dvec_default, size);
     dvector_t v = allocate_d(size);
     for (unsigned int i = 0; i < size; i++) {
         v.data[i] = value;
     }
     return v;
 }
+
+typedef struct {
+    const double *a, *b;
+    atomic_bool differs;
+} dequals_ctx_t;
+
+static void dequals_chunk(void *ctx, size_t begin, size_t end)
+{
+    dequals_ctx_t *c = ctx;
+    if (atomic_load_explicit(&c->differs, memory_order_relaxed)) return;
+    for (size_t i = begin; i < end; i++) {
+        if (c->a[i] != c->b[i]) {
+            atomic_store_explicit(&c->differs, true, memory_order_relaxed);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Check if two double vectors are equal (element-wise ==).
+ */
+bool dvec_equals(dvector_t v1, dvector_t v2)
+{
+    VEC_STATS_SCOPE(dvec_equals, v1.size);
+    if (v1.size != v2.size) return false;
+    dequals_ctx_t c = { v1.data, v2.data, false };
+    vec_parallel_for(v1.size, dequals_chunk, &c);
+    return !atomic_load(&c.differs);
+}
+
+/*
+ * The element-wise double operations mirror the float ones above, on the
+ * vec_dkernels() table. Mismatched sizes give DVEC_UNDEFINED (or leave the
+ * in-place operand untouched) instead of reading past the shorter vector.
+ */
+#define DVEC_SCALAR_OP(name, kernel)                                                \
+dvector_t dvec_scalar_##name(dvector_t v, double scalar)                            \
+{                                                                                   \
+    VEC_STATS_SCOPE(dvec_scalar_##name, v.size);                                    \
+    dvector_t r = allocate_d(v.size);                                               \
+    vec_parallel_dscalar(vec_dkernels()->kernel, r.data, v.data, scalar, v.size);   \
+    return r;                                                                       \
+}                                                                                   \
+void dvec_scalar_##name##_inplace(dvector_t *v, double scalar)                      \
+{                                                                                   \
+    VEC_STATS_SCOPE(dvec_scalar_##name##_inplace, v->size);                         \
+    vec_parallel_dscalar(vec_dkernels()->kernel, v->data, v->data, scalar, v->size); \
+}
+
+#define DVEC_BINARY_OP(name, kernel)                                                \
+dvector_t dvec_##name(dvector_t v1, dvector_t v2)                                   \
+{                                                                                   \
+    VEC_STATS_SCOPE(dvec_##name, v1.size);                                          \
+    if (v1.size != v2.size) return DVEC_UNDEFINED;                                  \
+    dvector_t r = allocate_d(v1.size);                                              \
+    vec_parallel_dbinary(vec_dkernels()->kernel, r.data, v1.data, v2.data, v1.size); \
+    return r;                                                                       \
+}                                                                                   \
+void dvec_##name##_inplace(dvector_t *v1, dvector_t v2)                             \
+{                                                                                   \
+    VEC_STATS_SCOPE(dvec_##name##_inplace, v1->size);                               \
+    if (v1->size != v2.size) return;                                                \
+    vec_parallel_dbinary(vec_dkernels()->kernel, v1->data, v1->data, v2.data, v1->size); \
+}
+
+DVEC_SCALAR_OP(add, scalar_add)
+DVEC_SCALAR_OP(sub, scalar_sub)
+DVEC_SCALAR_OP(mul, scalar_mul)
+DVEC_BINARY_OP(add, add)
+DVEC_BINARY_OP(sub, sub)
+DVEC_BINARY_OP(mul, mul)
+DVEC_BINARY_OP(div, div)
+
+/**
+ * @brief Divide each element by scalar; like vector_scalar_div, dividing by
+ *        zero gives a vector of INFINITY.
+ */
+dvector_t dvec_scalar_div(dvector_t v, double scalar)
+{
+    VEC_STATS_SCOPE(dvec_scalar_div, v.size);
+    if (scalar == 0.0) {
+        return dvec_default(v.size, INFINITY);
+    }
+    dvector_t r = allocate_d(v.size);
+    vec_parallel_dscalar(vec_dkernels()->scalar_div, r.data, v.data, scalar, v.size);
+    return r;
+}
+
+/**
+ * @brief Divide each element by scalar in place (no-op for zero).
+ */
+void dvec_scalar_div_inplace(dvector_t *v, double scalar)
+{
+    VEC_STATS_SCOPE(dvec_scalar_div_inplace, v->size);
+    if (scalar == 0.0) {
+        return;
+    }
+    vec_parallel_dscalar(vec_dkernels()->scalar_div, v->data, v->data, scalar, v->size);
+}
+
+typedef struct {
+    double *dst;
+    const double *src;
+    pow_plan_t plan;
+} dpow_ctx_t;
+
+static void dpow_chunk(void *ctx, size_t begin, size_t end)
+{
+    const dpow_ctx_t *c = ctx;
+    pow_plan_apply_d(&c->plan, c->dst + begin, c->src + begin, end - begin);
+}
+
+/**
+ * @brief Raise each element to a power (see pow_plan_t; non-integer,
+ *        non-half-integer exponents use fast_powd_precise).
+ */
+dvector_t dvec_pow(dvector_t v, double power)
+{
+    VEC_STATS_SCOPE(dvec_pow, v.size);
+    dvector_t r = allocate_d(v.size);
+    dpow_ctx_t c = { r.data, v.data, pow_plan_d(power) };
+    vec_parallel_for(v.size, dpow_chunk, &c);
+    return r;
+}
+
+void dvec_pow_inplace(dvector_t *v, double power)
+{
+    VEC_STATS_SCOPE(dvec_pow_inplace, v->size);
+    dpow_ctx_t c = { v->data, v->data, pow_plan_d(power) };
+    vec_parallel_for(v->size, dpow_chunk, &c);
+}
+
+typedef struct {
+    const double *a, *b;
+    vec_reduce_mode_t mode;
+    double scale;           // fixed scale of dvec_magnitude_ex's scaled mode, else 0
+} ddot_ctx_t;
+
+/* power-of-two scale bringing m into [0.5, 1), clamped to normal doubles */
+static double reduce_scale_d(double m)
+{
+    union {
+        double f;
+        uint64_t i;
+    } v = { m };
+    int e = (int)((v.i >> 52) & 0x7ff) - 1022;
+    int se = -e < -1022 ? -1022 : (-e > 1023 ? 1023 : -e);
+    v.i = (uint64_t)(se + 1023) << 52;
+    return v.f;
+}
+
+static double ddot_chunk(void *ctx, size_t begin, size_t end)
+{
+    const ddot_ctx_t *c = ctx;
+    const vec_dkernels_t *k = vec_dkernels();
+    const double *a = c->a + begin, *b = c->b + begin;
+    size_t n = end - begin;
+
+    switch (c->mode) {
+        case VEC_REDUCE_COMPENSATED:
+            return k->dot_compensated(a, b, n);
+        case VEC_REDUCE_SCALED: {
+            if (c->scale > 0.0) return k->dot_scaled(a, b, c->scale, c->scale, n);
+            double ma = k->maxabs(a, n);
+            double mb = a == b ? ma : k->maxabs(b, n);
+            // zero, inf or NaN: the unscaled sum already gives the right answer
+            if (!(ma > 0.0 && mb > 0.0 && ma <= DBL_MAX && mb <= DBL_MAX)) return k->dot(a, b, n);
+            double sa = reduce_scale_d(ma), sb = reduce_scale_d(mb);
+            return k->dot_scaled(a, b, sa, sb, n) / sa / sb;
+        }
+        default:
+            return k->dot(a, b, n);
+    }
+}
+
+typedef struct {
+    dvec_view_t a, b;
+    vec_reduce_mode_t mode;
+    double scale;
+    view_scratch_t scratch;
+} view_ddot_ctx_t;
+
+static const double *dview_chunk(dvec_view_t v, size_t begin, size_t n, double *buf)
+{
+    const double *p = v.data + (ptrdiff_t)begin * v.stride;
+    if (v.stride == 1) return p;
+    vec_dkernels()->gather(buf, p, v.stride, n);
+    return buf;
+}
+
+static double view_ddot_chunk(void *ctx, size_t begin, size_t end)
+{
+    view_ddot_ctx_t *c = ctx;
+    size_t n = end - begin;
+    double *buf = (double *)view_scratch_get(&c->scratch);
+    if (!buf) return 0.0;
+    ddot_ctx_t d = { dview_chunk(c->a, begin, n, buf), NULL, c->mode, c->scale };
+    bool same = c->a.data == c->b.data && c->a.stride == c->b.stride;
+    d.b = same ? d.a : dview_chunk(c->b, begin, n, buf + c->scratch.elements);
+    return ddot_chunk(&d, 0, n);
+}
+
+static double dview_dot(dvec_view_t a, dvec_view_t b, vec_reduce_mode_t mode, double scale, bool *ok)
+{
+    if (dvec_view_is_contiguous(a) && dvec_view_is_contiguous(b)) {
+        ddot_ctx_t c = { a.data, b.data, mode, scale };
+        return vec_parallel_reduce(a.size, ddot_chunk, &c);
+    }
+    view_ddot_ctx_t c = { .a = a, .b = b, .mode = mode, .scale = scale };
+    bool same = a.data == b.data && a.stride == b.stride;
+    view_scratch_init(&c.scratch, a.size, sizeof(double), same ? 1 : 2);
+    double r = vec_parallel_reduce(a.size, view_ddot_chunk, &c);
+    if (!view_scratch_release(&c.scratch)) {
+        if (ok) *ok = false;
+        return NAN;
+    }
+    return r;
+}
+
+/**
+ * @brief Dot product of two double views with the given accuracy mode,
+ *        reduced like vec_view_dot_ex, `ok` included. Returns 0 for
+ *        mismatched sizes.
+ */
+double dvec_view_dot_ex(dvec_view_t a, dvec_view_t b, vec_reduce_mode_t mode, bool *ok)
+{
+    VEC_STATS_SCOPE(dvec_view_dot_ex, a.size);
+    if (ok) *ok = true;
+    if (a.size != b.size) return 0.0;
+    return dview_dot(a, b, mode, 0.0, ok);
+}
+
+double dvec_view_dot(dvec_view_t a, dvec_view_t b)
+{
+    return dvec_view_dot_ex(a, b, VEC_REDUCE_FAST, NULL);
+}
+
+double dvec_dot_ex(dvector_t v1, dvector_t v2, vec_reduce_mode_t mode)
+{
+    VEC_STATS_SCOPE(dvec_dot_ex, v1.size);
+    return dvec_view_dot_ex(dvec_view_of(v1), dvec_view_of(v2), mode, NULL);
+}
+
+/**
+ * @brief Dot product of two double vectors (VEC_REDUCE_FAST).
+ */
+double dvec_dot(dvector_t v1, dvector_t v2)
+{
+    VEC_STATS_SCOPE(dvec_dot, v1.size);
+    return dvec_dot_ex(v1, v2, VEC_REDUCE_FAST);
+}
+
+/**
+ * @brief Cross product in 3D; DVEC_UNDEFINED unless both sizes are 3.
+ */
+dvector_t dvec_cross(dvector_t v1, dvector_t v2)
+{
+    VEC_STATS_SCOPE(dvec_cross, v1.size);
+    if (v1.size != 3 || v2.size != 3) return DVEC_UNDEFINED;
+    dvector_t r = allocate_d(3);
+    const double * __restrict a = v1.data;
+    const double * __restrict b = v2.data;
+
+    r.data[0] = a[1] * b[2] - a[2] * b[1];
+    r.data[1] = a[2] * b[0] - a[0] * b[2];
+    r.data[2] = a[0] * b[1] - a[1] * b[0];
+    return r;
+}
+
+/**
+ * @brief Magnitude with the given accuracy mode and a correctly rounded
+ *        sqrt. The scaled mode uses one scale for the whole vector, taken
+ *        from its largest element, so the result is finite whenever the
+ *        true magnitude fits in a double. `ok` as for vec_view_dot_ex.
+ */
+double dvec_view_magnitude_ex(dvec_view_t v, vec_reduce_mode_t mode, bool *ok)
+{
+    VEC_STATS_SCOPE(dvec_view_magnitude_ex, v.size);
+    if (ok) *ok = true;
+    if (mode == VEC_REDUCE_SCALED) {
+        const vec_dkernels_t *k = vec_dkernels();
+        double m = 0.0, buf[256];
+        if (dvec_view_is_contiguous(v)) {
+            m = k->maxabs(v.data, v.size);
+        } else {
+            for (size_t i = 0; i < v.size; i += 256) {
+                size_t n = v.size - i < 256 ? v.size - i : 256;
+                double mb = k->maxabs(dview_chunk(v, i, n, buf), n);
+                m = mb > m ? mb : m;
+            }
+        }
+        if (!(m > 0.0 && m <= DBL_MAX)) {
+            mode = VEC_REDUCE_FAST;
+        } else {
+            double scale = reduce_scale_d(m);
+            return sqrt_exact_d(dview_dot(v, v, mode, scale, ok)) / scale;
+        }
+    }
+    return sqrt_exact_d(dview_dot(v, v, mode, 0.0, ok));
+}
+
+double dvec_magnitude_ex(dvector_t v, vec_reduce_mode_t mode)
+{
+    VEC_STATS_SCOPE(dvec_magnitude_ex, v.size);
+    return dvec_view_magnitude_ex(dvec_view_of(v), mode, NULL);
+}
+
+/**
+ * @brief Magnitude (Euclidean norm): VEC_REDUCE_FAST sum of squares. Unlike
+ *        vector_magnitude the sqrt is the correctly rounded one; at double
+ *        precision the fast approximations would dominate the error.
+ */
+double dvec_view_magnitude(dvec_view_t v)
+{
+    VEC_STATS_SCOPE(dvec_view_magnitude, v.size);
+    return dvec_view_magnitude_ex(v, VEC_REDUCE_FAST, NULL);
+}
+
+double dvec_magnitude(dvector_t v)
+{
+    VEC_STATS_SCOPE(dvec_magnitude, v.size);
+    return dvec_view_magnitude(dvec_view_of(v));
+}
+
+static double dsum_chunk(void *ctx, size_t begin, size_t end)
+{
+    const double *a = ctx;
+    return vec_dkernels()->sum(a + begin, end - begin);
+}
+
+typedef struct {
+    dvec_view_t v;
+    view_scratch_t scratch;
+} view_dsum_ctx_t;
+
+static double view_dsum_chunk(void *ctx, size_t begin, size_t end)
+{
+    view_dsum_ctx_t *c = ctx;
+    size_t n = end - begin;
+    double *buf = (double *)view_scratch_get(&c->scratch);
+    if (!buf) return 0.0;
+    return vec_dkernels()->sum(dview_chunk(c->v, begin, n, buf), n);
+}
+
+/**
+ * @brief Sum of the elements of a double view or vector. `ok` as for
+ *        vec_view_dot_ex.
+ */
+double dvec_view_sum_ex(dvec_view_t v, bool *ok)
+{
+    VEC_STATS_SCOPE(dvec_view_sum_ex, v.size);
+    if (ok) *ok = true;
+    if (dvec_view_is_contiguous(v)) return vec_parallel_reduce(v.size, dsum_chunk, v.data);
+    view_dsum_ctx_t c = { .v = v };
+    view_scratch_init(&c.scratch, v.size, sizeof(double), 1);
+    double r = vec_parallel_reduce(v.size, view_dsum_chunk, &c);
+    if (!view_scratch_release(&c.scratch)) {
+        if (ok) *ok = false;
+        return NAN;
+    }
+    return r;
+}
+
+double dvec_view_sum(dvec_view_t v)
+{
+    VEC_STATS_SCOPE(dvec_view_sum, v.size);
+    return dvec_view_sum_ex(v, NULL);
+}
+
+double dvec_sum(dvector_t v)
+{
+    VEC_STATS_SCOPE(dvec_sum, v.size);
+    return dvec_view_sum(dvec_view_of(v));
+}
+
+/**
+ * @brief Print a double vector to stdout.
+ */
+void print_dvector(const char *label, dvector_t v)
+{
+    printf("%s [", label);
+    for (unsigned int i = 0; i < v.size; i++) {
+        printf("%f", v.data[i]);
+        if (i + 1 < v.size) printf(", ");
+    }
+    printf("]\n");
+}
+
+/****************************************************GROWTH***************************************************/
+
+/*
+ * Capacity management for vector_t (V = vector) and dvector_t (V = dvec):
+ * VT is the vector type, T its element type, N the type of its size and
+ * capacity fields and MAX the largest count N can hold.
+ */
+#define VEC_GROWTH_API(V, VT, T, N, MAX)                                            \
+size_t V##_capacity(VT v)                                                           \
+{                                                                                   \
+    return v.capacity > v.size ? v.capacity : v.size;                               \
+}                                                                                   \
+                                                                                    \
+/* move the first `size` elements into a buffer of exactly `capacity` */            \
+static bool V##_move(VT *v, size_t size, size_t capacity)                           \
+{                                                                                   \
+    VEC_STATS_SCOPE(V##_move, size);                                                \
+    const vec_allocator_t *old = v->allocator;                                      \
+    const vec_allocator_t *a = !v->data ? vec_allocator_current()                   \
+                             : old ? old : &VEC_SYSTEM_ALLOCATOR;                   \
+    T *data = NULL;                                                                 \
+    if (capacity > 0) {                                                             \
+        data = (T *)a->alloc(a->ctx, capacity * sizeof(T));                         \
+        if (!data && a != vec_allocator_current()) {                                \
+            /* allocators that cannot serve more (a file mapping) */                \
+            a = vec_allocator_current();                                            \
+            data = (T *)a->alloc(a->ctx, capacity * sizeof(T));                     \
+        }                                                                           \
+        if (!data) return false;                                                    \
+        VEC_STATS_ALLOCATED(capacity * sizeof(T));                                  \
+        if (size > 0) memcpy(data, v->data, size * sizeof(T));                      \
+    }                                                                               \
+    if (v->data) {                                                                  \
+        size_t bytes = V##_capacity(*v) * sizeof(T);                                \
+        VEC_STATS_FREED(bytes);                                                     \
+        if (old) old->free(old->ctx, v->data, bytes);                               \
+        else free(v->data);                                                         \
+    }                                                                               \
+    v->data = data;                                                                 \
+    v->size = (N)size;                                                              \
+    v->capacity = (N)capacity;                                                      \
+    v->allocator = a;                                                               \
+    return true;                                                                    \
+}                                                                                   \
+                                                                                    \
+bool V##_reserve(VT *v, size_t capacity)                                            \
+{                                                                                   \
+    VEC_STATS_SCOPE(V##_reserve, capacity);                                         \
+    if (v->data && capacity <= V##_capacity(*v)) return true;                       \
+    if (capacity > (size_t)(MAX) || capacity > (size_t)-1 / sizeof(T)) return false; \
+    return V##_move(v, v->data ? v->size : 0, capacity);                            \
+}                                                                                   \
+                                                                                    \
+/* room for `extra` more elements, doubling the capacity when it runs out */        \
+static bool V##_grow(VT *v, size_t extra)                                           \
+{                                                                                   \
+    size_t size = v->data ? v->size : 0;                                            \
+    size_t cap = v->data ? V##_capacity(*v) : 0;                                    \
+    if (extra > (size_t)(MAX) - size) return false;                                 \
+    if (v->data && size + extra <= cap) return true;                                \
+    size_t grown = cap > (size_t)(MAX) / 2 ? (size_t)(MAX) : cap * 2;               \
+    if (grown < VEC_GROW_MIN) grown = VEC_GROW_MIN;                                 \
+    if (grown < size + extra) grown = size + extra;                                 \
+    return V##_reserve(v, grown);                                                   \
+}                                                                                   \
+                                                                                    \
+bool V##_push(VT *v, T value)                                                       \
+{                                                                                   \
+    VEC_STATS_SCOPE(V##_push, 1);                                                   \
+    if (!V##_grow(v, 1)) return false;                                              \
+    v->data[v->size++] = value;                                                     \
+    return true;                                                                    \
+}                                                                                   \
+                                                                                    \
+bool V##_append(VT *v, const T *src, size_t n)                                      \
+{                                                                                   \
+    VEC_STATS_SCOPE(V##_append, n);                                                 \
+    /* src may live in the buffer that growing is about to replace */               \
+    bool inside = v->data && src >= v->data && src < v->data + V##_capacity(*v);    \
+    size_t offset = inside ? (size_t)(src - v->data) : 0;                           \
+    if (!V##_grow(v, n)) return false;                                              \
+    if (inside) src = v->data + offset;                                             \
+    if (n > 0) memmove(v->data + v->size, src, n * sizeof(T));                      \
+    v->size += (N)n;                                                                \
+    return true;                                                                    \
+}                                                                                   \
+                                                                                    \
+bool V##_shrink(VT *v)                                                              \
+{                                                                                   \
+    VEC_STATS_SCOPE(V##_shrink, v->data ? v->size : 0);                             \
+    if (!v->data || V##_capacity(*v) == v->size) return true;                       \
+    return V##_move(v, v->size, v->size);                                           \
+}
+
+VEC_GROWTH_API(vector, vector_t, float, size_t, (size_t)-1 / sizeof(float))
+VEC_GROWTH_API(dvec, dvector_t, double, unsigned int, UINT_MAX)
@@ -0,0 +1,289 @@
+#include <vec_alloc.h>
+#include <math_core.h>
+
+/****************************************************SYSTEM***************************************************/
+
+static void *system_alloc(void *ctx, size_t bytes)
+{
+    (void)ctx;
+    return malloc(bytes);
+}
+
+static void system_free(void *ctx, void *ptr, size_t bytes)
+{
+    (void)ctx;
+    (void)bytes;
+    free(ptr);
+}
+
+const vec_allocator_t VEC_SYSTEM_ALLOCATOR = { system_alloc, system_free, NULL };
+
+static _Thread_local const vec_allocator_t *allocator_stack[VEC_ALLOCATOR_STACK_DEPTH];
+static _Thread_local int allocator_depth = 0;
+
+/**
+ * @brief Allocator currently serving vector_alloc on this thread.
+ */
+const vec_allocator_t *vec_allocator_current(void)
+{
+    return allocator_depth > 0 ? allocator_stack[allocator_depth - 1] : &VEC_SYSTEM_ALLOCATOR;
+}
+
+/**
+ * @brief Make `a` the active allocator for this thread.
+ *        Returns false (and changes nothing) when the stack is full.
+ */
+bool vec_allocator_push(const vec_allocator_t *a)
+{
+    if (allocator_depth >= VEC_ALLOCATOR_STACK_DEPTH) return false;
+    allocator_stack[allocator_depth++] = a ? a : &VEC_SYSTEM_ALLOCATOR;
+    return true;
+}
+
+/**
+ * @brief Undo the matching vec_allocator_push.
+ */
+void vec_allocator_pop(void)
+{
+    if (allocator_depth > 0) allocator_depth--;
+}
+
+static inline size_t align_up(size_t n, size_t a)
+{
+    return (n + a - 1) & ~(a - 1);
+}
+
+/***************************************************ALIGNED***************************************************/
+
+static void *aligned_system_alloc(void *ctx, size_t bytes)
+{
+    (void)ctx;
+    // aligned_alloc wants a multiple of the alignment
+    if (bytes > (size_t)-1 - VEC_ALIGN) return NULL;
+    return aligned_alloc(VEC_ALIGN, align_up(bytes ? bytes : 1, VEC_ALIGN));
+}
+
+const vec_allocator_t VEC_ALIGNED_ALLOCATOR = { aligned_system_alloc, system_free, NULL };
+
+/****************************************************ARENA****************************************************/
+
+struct vec_arena_block {
+    vec_arena_block_t *next;
+    size_t size;
+    size_t used;
+};
+
+// first usable byte of a block, kept VEC_ALLOC_ALIGN aligned
+#define ARENA_HEADER align_up(sizeof(vec_arena_block_t), VEC_ALLOC_ALIGN)
+#define ARENA_DATA(b) ((unsigned char *)(b) + ARENA_HEADER)
+
+static vec_arena_block_t *arena_block_new(size_t size, vec_arena_block_t *next)
+{
+    vec_arena_block_t *b = (vec_arena_block_t *)malloc(ARENA_HEADER + size);
+    if (!b) return NULL;
+    b->next = next;
+    b->size = size;
+    b->used = 0;
+    return b;
+}
+
+static void *arena_alloc(void *ctx, size_t bytes)
+{
+    vec_arena_t *arena = (vec_arena_t *)ctx;
+    vec_arena_block_t *b = arena->head;
+    size_t offset = b ? align_up(b->used, VEC_ALLOC_ALIGN) : 0;
+
+    if (!b || offset + bytes > b->size) {
+        // chain a new block; never smaller than the request itself
+        size_t size = MAX(arena->block_size, align_up(bytes, VEC_ALLOC_ALIGN));
+        b = arena_block_new(size, arena->head);
+        if (!b) return NULL;
+        arena->head = b;
+        offset = 0;
+    }
+    b->used = offset + bytes;
+    arena->used += bytes;
+    if (arena->used > arena->peak) arena->peak = arena->used;
+    return ARENA_DATA(b) + offset;
+}
+
+static void arena_free(void *ctx, void *ptr, size_t bytes)
+{
+    // Individual frees are no-ops, except that the most recent allocation is
+    // rolled back so short-lived temporaries freed in LIFO order get reused.
+    vec_arena_t *arena = (vec_arena_t *)ctx;
+    vec_arena_block_t *b = arena->head;
+    if (b && (unsigned char *)ptr + bytes == ARENA_DATA(b) + b->used) {
+        b->used = (size_t)((unsigned char *)ptr - ARENA_DATA(b));
+        arena->used -= bytes;
+    }
+}
+
+/**
+ * @brief Initialize an arena with one block of `capacity` bytes.
+ *        Later blocks are chained on demand; the arena must not move while
+ *        vectors allocated from it are alive.
+ */
+bool vec_arena_init(vec_arena_t *arena, size_t capacity)
+{
+    if (capacity == 0) capacity = 64 * 1024;
+    arena->block_size = align_up(capacity, VEC_ALLOC_ALIGN);
+    arena->used = 0;
+    arena->peak = 0;
+    arena->head = arena_block_new(arena->block_size, NULL);
+    arena->allocator.alloc = arena_alloc;
+    arena->allocator.free = arena_free;
+    arena->allocator.ctx = arena;
+    return arena->head != NULL;
+}
+
+/**
+ * @brief Invalidate every vector allocated from the arena.
+ *        If the arena had to chain extra blocks since the last reset they are
+ *        merged into a single block large enough for the whole batch, so a
+ *        steady-state frame loop settles on one malloc-free block.
+ */
+void vec_arena_reset(vec_arena_t *arena)
+{
+    vec_arena_block_t *b = arena->head;
+    if (b && b->next) {
+        size_t total = 0;
+        while (b) {
+            vec_arena_block_t *next = b->next;
+            total += b->size;
+            free(b);
+            b = next;
+        }
+        arena->block_size = MAX(arena->block_size, total);
+        arena->head = arena_block_new(arena->block_size, NULL);
+    } else if (b) {
+        b->used = 0;
+    }
+    arena->used = 0;
+}
+
+/**
+ * @brief Release all blocks. Vectors from the arena become dangling.
+ */
+void vec_arena_destroy(vec_arena_t *arena)
+{
+    vec_arena_block_t *b = arena->head;
+    while (b) {
+        vec_arena_block_t *next = b->next;
+        free(b);
+        b = next;
+    }
+    arena->head = NULL;
+    arena->used = 0;
+}
+
+const vec_allocator_t *vec_arena_allocator(vec_arena_t *arena)
+{
+    return &arena->allocator;
+}
+
+/****************************************************POOL*****************************************************/
+
+struct vec_pool_slab {
+    vec_pool_slab_t *next;
+};
+
+#define POOL_MAX_BYTES ((size_t)1 << (VEC_POOL_MIN_SHIFT + VEC_POOL_CLASSES - 1))
+#define POOL_HEADER align_up(sizeof(vec_pool_slab_t), VEC_ALLOC_ALIGN)
+
+/**
+ * @brief Smallest size class that fits `bytes`, or -1 if it is too large.
+ */
+static int pool_class(size_t bytes)
+{
+    if (bytes > POOL_MAX_BYTES) return -1;
+    int c = 0;
+    size_t cap = (size_t)1 << VEC_POOL_MIN_SHIFT;
+    while (cap < bytes) {
+        cap <<= 1;
+        c++;
+    }
+    return c;
+}
+
+static bool pool_refill(vec_pool_t *pool, int c)
+{
+    size_t obj = (size_t)1 << (VEC_POOL_MIN_SHIFT + c);
+    size_t count = MAX(pool->slab_size / obj, 1);
+    vec_pool_slab_t *slab = (vec_pool_slab_t *)malloc(POOL_HEADER + count * obj);
+    if (!slab) return false;
+    slab->next = pool->slabs;
+    pool->slabs = slab;
+
+    // thread the new objects onto the class free list
+    unsigned char *p = (unsigned char *)slab + POOL_HEADER;
+    for (size_t i = 0; i < count; i++, p += obj) {
+        *(void **)p = pool->free_lists[c];
+        pool->free_lists[c] = p;
+    }
+    return true;
+}
+
+static void *pool_alloc(void *ctx, size_t bytes)
+{
+    vec_pool_t *pool = (vec_pool_t *)ctx;
+    int c = pool_class(bytes);
+    if (c < 0) return malloc(bytes);
+    if (!pool->free_lists[c] && !pool_refill(pool, c)) return NULL;
+
+    void *p = pool->free_lists[c];
+    pool->free_lists[c] = *(void **)p;
+    return p;
+}
+
+static void pool_free(void *ctx, void *ptr, size_t bytes)
+{
+    vec_pool_t *pool = (vec_pool_t *)ctx;
+    int c = pool_class(bytes);
+    if (c < 0) {
+        free(ptr);
+        return;
+    }
+    *(void **)ptr = pool->free_lists[c];
+    pool->free_lists[c] = ptr;
+}
+
+/**
+ * @brief Initialize an empty pool. Each class is refilled `slab_size` bytes
+ *        at a time (at least one object); the pool must not move while
+ *        vectors allocated from it are alive.
+ */
+bool vec_pool_init(vec_pool_t *pool, size_t slab_size)
+{
+    for (int c = 0; c < VEC_POOL_CLASSES; c++) {
+        pool->free_lists[c] = NULL;
+    }
+    pool->slabs = NULL;
+    pool->slab_size = slab_size ? slab_size : 256 * 1024;
+    pool->allocator.alloc = pool_alloc;
+    pool->allocator.free = pool_free;
+    pool->allocator.ctx = pool;
+    return true;
+}
+
+/**
+ * @brief Release every slab. Vectors from the pool become dangling.
+ */
+void vec_pool_destroy(vec_pool_t *pool)
+{
+    vec_pool_slab_t *s = pool->slabs;
+    while (s) {
+        vec_pool_slab_t *next = s->next;
+        free(s);
+        s = next;
+    }
+    pool->slabs = NULL;
+    for (int c = 0; c < VEC_POOL_CLASSES; c++) {
+        pool->free_lists[c] = NULL;
+    }
+}
+
+const vec_allocator_t *vec_pool_allocator(vec_pool_t *pool)
+{
+    return &pool->allocator;
+}
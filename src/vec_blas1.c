@@ -0,0 +1,373 @@
+#include <vec_blas1.h>
+#include <vec_simd.h>
+#include <vec_parallel.h>
+#include <math_core.h>
+#include <math.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    #define VEC_SIMD_X86 1
+    #include <immintrin.h>
+#endif
+
+/*
+ * One kernel signature for every operation, so one job type and one chunk
+ * function serve them all: dst[i] from x[i], y[i], z[i] (the ones the
+ * operation uses; the others may be NULL) and the scalars a, b.
+ *
+ *   axpy  - fma(a, x, y)          lerp  - fma(a, y - x, x)   (a = t)
+ *   axpby - fma(a, x, b * y)      clamp - CLAMP(x, a, b)     (a = lo, b = hi)
+ *   fma   - fma(x, y, z)
+ */
+#define BLAS1_KERNELS_T(T)                                                          \
+    struct {                                                                        \
+        void (*axpy)(T *dst, const T *x, const T *y, const T *z, T a, T b, size_t n); \
+        void (*axpby)(T *dst, const T *x, const T *y, const T *z, T a, T b, size_t n); \
+        void (*fma)(T *dst, const T *x, const T *y, const T *z, T a, T b, size_t n); \
+        void (*lerp)(T *dst, const T *x, const T *y, const T *z, T a, T b, size_t n); \
+        void (*clamp)(T *dst, const T *x, const T *y, const T *z, T a, T b, size_t n); \
+    }
+
+typedef BLAS1_KERNELS_T(float) blas1_kernels_t;
+typedef BLAS1_KERNELS_T(double) dblas1_kernels_t;
+
+typedef void (*blas1_kernel_f)(float *, const float *, const float *, const float *, float, float, size_t);
+typedef void (*dblas1_kernel_f)(double *, const double *, const double *, const double *, double, double, size_t);
+
+// element i of the operands (loads of x are repeated in lerp; the compiler merges them)
+#define LD_(key, p) LOADU_##key((p) + i)
+#define OP_axpy(key)  FMA_##key(va, LD_(key, x), LD_(key, y))
+#define OP_axpby(key) FMA_##key(va, LD_(key, x), MUL_##key(vb, LD_(key, y)))
+#define OP_fma(key)   FMA_##key(LD_(key, x), LD_(key, y), LD_(key, z))
+#define OP_lerp(key)  FMA_##key(va, SUB_##key(LD_(key, y), LD_(key, x)), LD_(key, x))
+#define OP_clamp(key) MAX_##key(va, MIN_##key(LD_(key, x), vb))
+
+// operand pointer advanced to element i, NULL kept NULL
+#define OFF_(p, i) ((p) ? (p) + (i) : NULL)
+
+/*
+ * One kernel of one level: W elements per step, the remainder through the
+ * scalar kernel of the element type (TAIL_ is empty at the scalar level,
+ * where W is 1).
+ */
+#define BLAS1_KERNEL(key, op)                                                       \
+TARGET_##key static void op##_##key(T_##key *dst, const T_##key *x, const T_##key *y, \
+                                    const T_##key *z, T_##key a, T_##key b, size_t n) \
+{                                                                                   \
+    V_##key va = SET1_##key(a), vb = SET1_##key(b);                                 \
+    (void)va, (void)vb, (void)y, (void)z;                                           \
+    size_t i = 0;                                                                   \
+    for (; i + W_##key <= n; i += W_##key) STOREU_##key(dst + i, OP_##op(key));     \
+    TAIL_##key(op, dst + i, OFF_(x, i), OFF_(y, i), OFF_(z, i), a, b, n - i);       \
+}
+
+#define BLAS1_LEVEL(key)                                                            \
+BLAS1_KERNEL(key, axpy)                                                             \
+BLAS1_KERNEL(key, axpby)                                                            \
+BLAS1_KERNEL(key, fma)                                                              \
+BLAS1_KERNEL(key, lerp)                                                             \
+BLAS1_KERNEL(key, clamp)                                                            \
+static const KT_##key blas1_kernels_##key = {                                       \
+    axpy_##key, axpby_##key, fma_##key, lerp_##key, clamp_##key                     \
+};
+
+/****************************************************SCALAR***************************************************/
+
+// the reference on CPUs with FMA hardware (at the scalar and SSE2 levels)
+#define TARGET_scalar_f
+#define TARGET_scalar_d
+#define T_scalar_f float
+#define T_scalar_d double
+#define W_scalar_f 1
+#define W_scalar_d 1
+#define KT_scalar_f blas1_kernels_t
+#define KT_scalar_d dblas1_kernels_t
+#define V_scalar_f float
+#define V_scalar_d double
+#define TAIL_scalar_f(...)
+#define TAIL_scalar_d(...)
+
+#define LOADU_scalar_f(p)       (*(p))
+#define STOREU_scalar_f(p, v)   (*(p) = (v))
+#define SET1_scalar_f(s)        (s)
+#define FMA_scalar_f(a, b, c)   fmaf(a, b, c)
+#define MUL_scalar_f(a, b)      ((a) * (b))
+#define SUB_scalar_f(a, b)      ((a) - (b))
+#define MIN_scalar_f(a, b)      MIN(a, b)
+#define MAX_scalar_f(a, b)      MAX(a, b)
+
+#define LOADU_scalar_d(p)       (*(p))
+#define STOREU_scalar_d(p, v)   (*(p) = (v))
+#define SET1_scalar_d(s)        (s)
+#define FMA_scalar_d(a, b, c)   fma(a, b, c)
+#define MUL_scalar_d(a, b)      ((a) * (b))
+#define SUB_scalar_d(a, b)      ((a) - (b))
+#define MIN_scalar_d(a, b)      MIN(a, b)
+#define MAX_scalar_d(a, b)      MAX(a, b)
+
+BLAS1_LEVEL(scalar_f)
+BLAS1_LEVEL(scalar_d)
+
+/*
+ * Without FMA hardware fmaf / fma are emulated in software, many times the
+ * cost of the mul + add they replace, so such CPUs run these instead at
+ * every level: the same operations unfused, rounding the product first.
+ */
+#define TARGET_plain_f
+#define TARGET_plain_d
+#define T_plain_f float
+#define T_plain_d double
+#define W_plain_f 1
+#define W_plain_d 1
+#define KT_plain_f blas1_kernels_t
+#define KT_plain_d dblas1_kernels_t
+#define V_plain_f float
+#define V_plain_d double
+#define TAIL_plain_f(...)
+#define TAIL_plain_d(...)
+
+#define LOADU_plain_f(p)        (*(p))
+#define STOREU_plain_f(p, v)    (*(p) = (v))
+#define SET1_plain_f(s)         (s)
+#define FMA_plain_f(a, b, c)    ((a) * (b) + (c))
+#define MUL_plain_f(a, b)       ((a) * (b))
+#define SUB_plain_f(a, b)       ((a) - (b))
+#define MIN_plain_f(a, b)       MIN(a, b)
+#define MAX_plain_f(a, b)       MAX(a, b)
+
+#define LOADU_plain_d(p)        (*(p))
+#define STOREU_plain_d(p, v)    (*(p) = (v))
+#define SET1_plain_d(s)         (s)
+#define FMA_plain_d(a, b, c)    ((a) * (b) + (c))
+#define MUL_plain_d(a, b)       ((a) * (b))
+#define SUB_plain_d(a, b)       ((a) - (b))
+#define MIN_plain_d(a, b)       MIN(a, b)
+#define MAX_plain_d(a, b)       MAX(a, b)
+
+BLAS1_LEVEL(plain_f)
+BLAS1_LEVEL(plain_d)
+
+#ifdef VEC_SIMD_X86
+
+/*
+ * _mm*_min(x, hi) is x < hi ? x : hi and _mm*_max(lo, m) is lo > m ? lo : m,
+ * NaNs included, which is exactly MIN / MAX of math_core.h.
+ */
+#define TARGET_sse2     __attribute__((target("sse2")))
+#define TARGET_avx2     __attribute__((target("avx2,fma")))
+#define TARGET_avx512   __attribute__((target("avx512f")))
+#define TARGET_avx2_d   TARGET_avx2
+#define TARGET_avx512_d TARGET_avx512
+#define TARGET_sse2_d   TARGET_sse2
+
+#define T_sse2     float
+#define T_avx2     float
+#define T_avx512   float
+#define T_avx2_d   double
+#define T_avx512_d double
+#define T_sse2_d   double
+
+#define V_sse2     __m128
+#define V_avx2     __m256
+#define V_avx512   __m512
+#define V_avx2_d   __m256d
+#define V_avx512_d __m512d
+#define V_sse2_d   __m128d
+
+#define W_sse2     4
+#define W_avx2     8
+#define W_avx512   16
+#define W_avx2_d   4
+#define W_avx512_d 8
+#define W_sse2_d   2
+
+#define KT_sse2     blas1_kernels_t
+#define KT_avx2     blas1_kernels_t
+#define KT_avx512   blas1_kernels_t
+#define KT_avx2_d   dblas1_kernels_t
+#define KT_avx512_d dblas1_kernels_t
+#define KT_sse2_d   dblas1_kernels_t
+
+#define TAIL_sse2(op, ...)     op##_plain_f(__VA_ARGS__)
+#define TAIL_avx2(op, ...)     op##_scalar_f(__VA_ARGS__)
+#define TAIL_avx512(op, ...)   op##_scalar_f(__VA_ARGS__)
+#define TAIL_avx2_d(op, ...)   op##_scalar_d(__VA_ARGS__)
+#define TAIL_avx512_d(op, ...) op##_scalar_d(__VA_ARGS__)
+#define TAIL_sse2_d(op, ...)   op##_plain_d(__VA_ARGS__)
+
+// SSE2 has no FMA: its kernels are the vector form of the unfused ones
+#define LOADU_sse2(p)       _mm_loadu_ps(p)
+#define STOREU_sse2(p, v)   _mm_storeu_ps(p, v)
+#define SET1_sse2(s)        _mm_set1_ps(s)
+#define FMA_sse2(a, b, c)   _mm_add_ps(_mm_mul_ps(a, b), c)
+#define MUL_sse2(a, b)      _mm_mul_ps(a, b)
+#define SUB_sse2(a, b)      _mm_sub_ps(a, b)
+#define MIN_sse2(a, b)      _mm_min_ps(a, b)
+#define MAX_sse2(a, b)      _mm_max_ps(a, b)
+
+#define LOADU_sse2_d(p)       _mm_loadu_pd(p)
+#define STOREU_sse2_d(p, v)   _mm_storeu_pd(p, v)
+#define SET1_sse2_d(s)        _mm_set1_pd(s)
+#define FMA_sse2_d(a, b, c)   _mm_add_pd(_mm_mul_pd(a, b), c)
+#define MUL_sse2_d(a, b)      _mm_mul_pd(a, b)
+#define SUB_sse2_d(a, b)      _mm_sub_pd(a, b)
+#define MIN_sse2_d(a, b)      _mm_min_pd(a, b)
+#define MAX_sse2_d(a, b)      _mm_max_pd(a, b)
+
+#define LOADU_avx2(p)       _mm256_loadu_ps(p)
+#define STOREU_avx2(p, v)   _mm256_storeu_ps(p, v)
+#define SET1_avx2(s)        _mm256_set1_ps(s)
+#define FMA_avx2(a, b, c)   _mm256_fmadd_ps(a, b, c)
+#define MUL_avx2(a, b)      _mm256_mul_ps(a, b)
+#define SUB_avx2(a, b)      _mm256_sub_ps(a, b)
+#define MIN_avx2(a, b)      _mm256_min_ps(a, b)
+#define MAX_avx2(a, b)      _mm256_max_ps(a, b)
+
+#define LOADU_avx512(p)     _mm512_loadu_ps(p)
+#define STOREU_avx512(p, v) _mm512_storeu_ps(p, v)
+#define SET1_avx512(s)      _mm512_set1_ps(s)
+#define FMA_avx512(a, b, c) _mm512_fmadd_ps(a, b, c)
+#define MUL_avx512(a, b)    _mm512_mul_ps(a, b)
+#define SUB_avx512(a, b)    _mm512_sub_ps(a, b)
+#define MIN_avx512(a, b)    _mm512_min_ps(a, b)
+#define MAX_avx512(a, b)    _mm512_max_ps(a, b)
+
+#define LOADU_avx2_d(p)       _mm256_loadu_pd(p)
+#define STOREU_avx2_d(p, v)   _mm256_storeu_pd(p, v)
+#define SET1_avx2_d(s)        _mm256_set1_pd(s)
+#define FMA_avx2_d(a, b, c)   _mm256_fmadd_pd(a, b, c)
+#define MUL_avx2_d(a, b)      _mm256_mul_pd(a, b)
+#define SUB_avx2_d(a, b)      _mm256_sub_pd(a, b)
+#define MIN_avx2_d(a, b)      _mm256_min_pd(a, b)
+#define MAX_avx2_d(a, b)      _mm256_max_pd(a, b)
+
+#define LOADU_avx512_d(p)     _mm512_loadu_pd(p)
+#define STOREU_avx512_d(p, v) _mm512_storeu_pd(p, v)
+#define SET1_avx512_d(s)      _mm512_set1_pd(s)
+#define FMA_avx512_d(a, b, c) _mm512_fmadd_pd(a, b, c)
+#define MUL_avx512_d(a, b)    _mm512_mul_pd(a, b)
+#define SUB_avx512_d(a, b)    _mm512_sub_pd(a, b)
+#define MIN_avx512_d(a, b)    _mm512_min_pd(a, b)
+#define MAX_avx512_d(a, b)    _mm512_max_pd(a, b)
+
+BLAS1_LEVEL(sse2)
+BLAS1_LEVEL(avx2)
+BLAS1_LEVEL(avx512)
+BLAS1_LEVEL(sse2_d)
+BLAS1_LEVEL(avx2_d)
+BLAS1_LEVEL(avx512_d)
+
+#endif // VEC_SIMD_X86
+
+/****************************************************DISPATCH*************************************************/
+
+/*
+ * Whether the element-wise fma is fused depends on the CPU, not on the
+ * selected level, so every level of one machine gives the same bits: with
+ * FMA hardware the reference kernels call fmaf / fma (one instruction) and
+ * AVX2+FMA / AVX-512 use FMA instructions; without it every level runs the
+ * unfused kernels, vectorized from SSE2 up. Other targets fuse when the C
+ * library says fma is fast.
+ */
+static bool blas1_fused(void)
+{
+#if defined(VEC_SIMD_X86)
+    return __builtin_cpu_supports("fma");
+#elif defined(FP_FAST_FMAF) && defined(FP_FAST_FMA)
+    return true;
+#else
+    return false;
+#endif
+}
+
+#ifdef VEC_SIMD_X86
+    #define BLAS1_DISPATCH_(sfx)                                                    \
+        vec_isa_t isa = vec_isa_active();                                           \
+        if (!blas1_fused()) {                                                       \
+            if (isa >= VEC_ISA_SSE2) return &blas1_kernels_sse2##sfx;               \
+        } else {                                                                    \
+            if (isa >= VEC_ISA_AVX512) return &blas1_kernels_avx512##sfx;           \
+            if (isa >= VEC_ISA_AVX2) return &blas1_kernels_avx2##sfx;               \
+        }
+#else
+    #define BLAS1_DISPATCH_(sfx)
+#endif
+
+static const blas1_kernels_t *blas1_kernels(void)
+{
+    BLAS1_DISPATCH_()
+    return blas1_fused() ? &blas1_kernels_scalar_f : &blas1_kernels_plain_f;
+}
+
+static const dblas1_kernels_t *dblas1_kernels(void)
+{
+    BLAS1_DISPATCH_(_d)
+    return blas1_fused() ? &blas1_kernels_scalar_d : &blas1_kernels_plain_d;
+}
+
+/*****************************************************API*****************************************************/
+
+/*
+ * Front ends for vector_t (V = vector) and dvector_t (V = dvec): size
+ * checks, then the kernel over the pool. KF is the kernel pointer type and
+ * K() the table of the active level.
+ */
+#define BLAS1_API(V, VT, T, KF, K)                                                  \
+typedef struct {                                                                    \
+    KF k;                                                                           \
+    T *dst;                                                                         \
+    const T *x, *y, *z;                                                             \
+    T a, b;                                                                         \
+} V##_blas1_job_t;                                                                  \
+                                                                                    \
+static void V##_blas1_chunk(void *ctx, size_t begin, size_t end)                    \
+{                                                                                   \
+    const V##_blas1_job_t *j = ctx;                                                 \
+    j->k(j->dst + begin, OFF_(j->x, begin), OFF_(j->y, begin), OFF_(j->z, begin),   \
+         j->a, j->b, end - begin);                                                  \
+}                                                                                   \
+                                                                                    \
+static bool V##_blas1_run(KF k, VT dst, const T *x, const T *y, const T *z, T a, T b) \
+{                                                                                   \
+    V##_blas1_job_t j = { k, dst.data, x, y, z, a, b };                             \
+    vec_parallel_for(dst.size, V##_blas1_chunk, &j);                                \
+    return true;                                                                    \
+}                                                                                   \
+                                                                                    \
+bool V##_axpy(T a, VT x, VT y)                                                      \
+{                                                                                   \
+    if (x.size != y.size) return false;                                             \
+    return V##_blas1_run(K()->axpy, y, x.data, y.data, NULL, a, 0);                 \
+}                                                                                   \
+                                                                                    \
+bool V##_axpby(T a, VT x, T b, VT y)                                                \
+{                                                                                   \
+    if (x.size != y.size) return false;                                             \
+    return V##_blas1_run(K()->axpby, y, x.data, y.data, NULL, a, b);                \
+}                                                                                   \
+                                                                                    \
+bool V##_waxpby(VT w, T a, VT x, T b, VT y)                                         \
+{                                                                                   \
+    if (x.size != w.size || y.size != w.size) return false;                         \
+    return V##_blas1_run(K()->axpby, w, x.data, y.data, NULL, a, b);                \
+}                                                                                   \
+                                                                                    \
+bool V##_fma(VT dst, VT x, VT y, VT z)                                              \
+{                                                                                   \
+    if (x.size != dst.size || y.size != dst.size || z.size != dst.size) return false; \
+    return V##_blas1_run(K()->fma, dst, x.data, y.data, z.data, 0, 0);              \
+}                                                                                   \
+                                                                                    \
+bool V##_lerp(VT dst, VT a, VT b, T t)                                              \
+{                                                                                   \
+    if (a.size != dst.size || b.size != dst.size) return false;                     \
+    return V##_blas1_run(K()->lerp, dst, a.data, b.data, NULL, t, 0);               \
+}                                                                                   \
+                                                                                    \
+bool V##_clamp(VT dst, VT x, T lo, T hi)                                            \
+{                                                                                   \
+    if (x.size != dst.size) return false;                                           \
+    return V##_blas1_run(K()->clamp, dst, x.data, NULL, NULL, lo, hi);              \
+}
+
+BLAS1_API(vector, vector_t, float, blas1_kernel_f, blas1_kernels)
+BLAS1_API(dvec, dvector_t, double, dblas1_kernel_f, dblas1_kernels)
@@ -0,0 +1,241 @@
+#include <vec_expr.h>
+#include <vec_simd.h>
+#include <math_batch.h>
+
+/**
+ * @brief One step of a compiled expression: dst = a OP b (or a OP scalar).
+ *        An operand is either a scratch slot or a leaf pointer (slot == -1).
+ */
+typedef struct {
+    vec_expr_op_t op;
+    int dst;
+    int a_slot;
+    int b_slot;
+    const float *a_leaf;
+    const float *b_leaf;
+    float scalar;
+    pow_plan_t pow;         // VEC_EXPR_POW: exponent classified once at compile time
+} expr_instr_t;
+
+typedef struct {
+    expr_instr_t code[VEC_EXPR_MAX_NODES];
+    int count;
+} expr_program_t;
+
+typedef struct {
+    int slot;
+    const float *leaf;
+} expr_operand_t;
+
+/****************************************************BUILD****************************************************/
+
+void vec_expr_init(vec_expr_graph_t *g)
+{
+    g->count = 0;
+    g->size = 0;
+    g->error = false;
+}
+
+static vec_expr_t expr_push(vec_expr_graph_t *g, vec_expr_op_t op, vec_expr_t lhs, vec_expr_t rhs,
+                            float scalar, const float *data)
+{
+    if (g->count >= VEC_EXPR_MAX_NODES) {
+        g->error = true;
+        return -1;
+    }
+    vec_expr_node_t *n = &g->nodes[g->count];
+    n->op = op;
+    n->lhs = lhs;
+    n->rhs = rhs;
+    n->scalar = scalar;
+    n->data = data;
+    return g->count++;
+}
+
+static bool expr_valid(const vec_expr_graph_t *g, vec_expr_t e)
+{
+    return e >= 0 && e < g->count;
+}
+
+/**
+ * @brief Record a reference to `v`. The first leaf fixes the graph size.
+ */
+vec_expr_t vec_expr_leaf(vec_expr_graph_t *g, vector_t v)
+{
+    bool first = true;
+    for (int i = 0; i < g->count && first; i++) {
+        first = g->nodes[i].op != VEC_EXPR_LEAF;
+    }
+    if (first) {
+        g->size = v.size;
+    } else if (v.size != g->size) {
+        g->error = true;
+        return -1;
+    }
+    return expr_push(g, VEC_EXPR_LEAF, -1, -1, 0.0f, v.data);
+}
+
+static vec_expr_t expr_binary(vec_expr_graph_t *g, vec_expr_op_t op, vec_expr_t a, vec_expr_t b)
+{
+    if (!expr_valid(g, a) || !expr_valid(g, b)) return -1;
+    return expr_push(g, op, a, b, 0.0f, NULL);
+}
+
+static vec_expr_t expr_unary(vec_expr_graph_t *g, vec_expr_op_t op, vec_expr_t a, float scalar)
+{
+    if (!expr_valid(g, a)) return -1;
+    return expr_push(g, op, a, -1, scalar, NULL);
+}
+
+vec_expr_t vec_expr_add(vec_expr_graph_t *g, vec_expr_t a, vec_expr_t b) { return expr_binary(g, VEC_EXPR_ADD, a, b); }
+vec_expr_t vec_expr_sub(vec_expr_graph_t *g, vec_expr_t a, vec_expr_t b) { return expr_binary(g, VEC_EXPR_SUB, a, b); }
+vec_expr_t vec_expr_mul(vec_expr_graph_t *g, vec_expr_t a, vec_expr_t b) { return expr_binary(g, VEC_EXPR_MUL, a, b); }
+vec_expr_t vec_expr_div(vec_expr_graph_t *g, vec_expr_t a, vec_expr_t b) { return expr_binary(g, VEC_EXPR_DIV, a, b); }
+
+vec_expr_t vec_expr_scalar_add(vec_expr_graph_t *g, vec_expr_t a, float s) { return expr_unary(g, VEC_EXPR_SCALAR_ADD, a, s); }
+vec_expr_t vec_expr_scalar_sub(vec_expr_graph_t *g, vec_expr_t a, float s) { return expr_unary(g, VEC_EXPR_SCALAR_SUB, a, s); }
+vec_expr_t vec_expr_scalar_mul(vec_expr_graph_t *g, vec_expr_t a, float s) { return expr_unary(g, VEC_EXPR_SCALAR_MUL, a, s); }
+vec_expr_t vec_expr_scalar_div(vec_expr_graph_t *g, vec_expr_t a, float s) { return expr_unary(g, VEC_EXPR_SCALAR_DIV, a, s); }
+vec_expr_t vec_expr_pow(vec_expr_graph_t *g, vec_expr_t a, float power) { return expr_unary(g, VEC_EXPR_POW, a, power); }
+
+/****************************************************COMPILE**************************************************/
+
+/**
+ * @brief Scratch slots needed to evaluate `e` (Sethi-Ullman number).
+ *        Leaves are read in place and need none.
+ */
+static int expr_need(const vec_expr_graph_t *g, vec_expr_t e)
+{
+    const vec_expr_node_t *n = &g->nodes[e];
+    if (n->op == VEC_EXPR_LEAF) return 0;
+    if (n->rhs < 0) return MAX(expr_need(g, n->lhs), 1);
+
+    int l = expr_need(g, n->lhs);
+    int r = expr_need(g, n->rhs);
+    return MAX(l == r ? l + 1 : MAX(l, r), 1);
+}
+
+/**
+ * @brief Emit code for `e` using slots from `base` upwards. The heavier
+ *        subtree is evaluated first so the lighter one fits in what is left.
+ */
+static bool expr_gen(const vec_expr_graph_t *g, vec_expr_t e, int base,
+                     expr_program_t *p, expr_operand_t *out)
+{
+    const vec_expr_node_t *n = &g->nodes[e];
+    if (n->op == VEC_EXPR_LEAF) {
+        out->slot = -1;
+        out->leaf = n->data;
+        return true;
+    }
+    if (base >= VEC_EXPR_MAX_SLOTS) return false;
+
+    expr_operand_t a = { -1, NULL }, b = { -1, NULL };
+    if (n->rhs < 0) {
+        if (!expr_gen(g, n->lhs, base, p, &a)) return false;
+    } else if (expr_need(g, n->lhs) >= expr_need(g, n->rhs)) {
+        if (!expr_gen(g, n->lhs, base, p, &a)) return false;
+        if (!expr_gen(g, n->rhs, base + (a.slot >= 0), p, &b)) return false;
+    } else {
+        if (!expr_gen(g, n->rhs, base, p, &b)) return false;
+        if (!expr_gen(g, n->lhs, base + (b.slot >= 0), p, &a)) return false;
+    }
+
+    // shared subtrees are re-emitted, so the program can outgrow the graph
+    if (p->count >= VEC_EXPR_MAX_NODES) return false;
+    expr_instr_t *ins = &p->code[p->count++];
+    ins->op = n->op;
+    ins->dst = base;
+    ins->a_slot = a.slot;
+    ins->a_leaf = a.leaf;
+    ins->b_slot = b.slot;
+    ins->b_leaf = b.leaf;
+    ins->scalar = n->scalar;
+    if (n->op == VEC_EXPR_POW) ins->pow = pow_plan_f(n->scalar);
+
+    out->slot = base;
+    out->leaf = NULL;
+    return true;
+}
+
+/****************************************************EVALUATE*************************************************/
+
+static void expr_run(const expr_instr_t *ins, const vec_kernels_t *k, float *d,
+                     const float *a, const float *b, size_t m)
+{
+    switch (ins->op) {
+        case VEC_EXPR_ADD: k->add(d, a, b, m); break;
+        case VEC_EXPR_SUB: k->sub(d, a, b, m); break;
+        case VEC_EXPR_MUL: k->mul(d, a, b, m); break;
+        case VEC_EXPR_DIV: k->div(d, a, b, m); break;
+        case VEC_EXPR_SCALAR_ADD: k->scalar_add(d, a, ins->scalar, m); break;
+        case VEC_EXPR_SCALAR_SUB: k->scalar_sub(d, a, ins->scalar, m); break;
+        case VEC_EXPR_SCALAR_MUL: k->scalar_mul(d, a, ins->scalar, m); break;
+        case VEC_EXPR_SCALAR_DIV:
+            // same contract as vector_scalar_div: dividing by zero yields INFINITY
+            if (ins->scalar == 0.0f) {
+                for (size_t j = 0; j < m; j++) d[j] = INFINITY;
+            } else {
+                k->scalar_div(d, a, ins->scalar, m);
+            }
+            break;
+        case VEC_EXPR_POW:
+            pow_plan_apply_f(&ins->pow, d, a, m);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Evaluate `root` into dst->data, which must hold g->size elements.
+ *        dst may be one of the leaves: each block is fully read before the
+ *        matching block of dst is written.
+ */
+bool vec_expr_eval_to(const vec_expr_graph_t *g, vec_expr_t root, vector_t *dst)
+{
+    if (g->error || !expr_valid(g, root) || dst->size != g->size) return false;
+
+    const vec_expr_node_t *r = &g->nodes[root];
+    if (r->op == VEC_EXPR_LEAF) {
+        if (dst->data != r->data) memmove(dst->data, r->data, g->size * sizeof(float));
+        return true;
+    }
+
+    expr_program_t prog;
+    expr_operand_t out;
+    prog.count = 0;
+    if (!expr_gen(g, root, 0, &prog, &out)) return false;
+
+    float scratch[VEC_EXPR_MAX_SLOTS][VEC_EXPR_BLOCK];
+    const vec_kernels_t *k = vec_kernels();
+    const expr_instr_t *last = &prog.code[prog.count - 1];
+
+    for (size_t i = 0; i < g->size; i += VEC_EXPR_BLOCK) {
+        size_t m = MIN((size_t)VEC_EXPR_BLOCK, g->size - i);
+        for (const expr_instr_t *ins = prog.code; ins <= last; ins++) {
+            // the root writes straight into the destination
+            float *d = ins == last ? dst->data + i : scratch[ins->dst];
+            const float *a = ins->a_slot >= 0 ? scratch[ins->a_slot] : ins->a_leaf + i;
+            const float *b = ins->b_slot >= 0 ? scratch[ins->b_slot]
+                           : ins->b_leaf ? ins->b_leaf + i : NULL;
+            expr_run(ins, k, d, a, b, m);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Evaluate `root` into a freshly allocated vector (one allocation for
+ *        the whole expression). Returns VEC_UNDEFINED if the graph is invalid.
+ */
+vector_t vec_expr_eval(const vec_expr_graph_t *g, vec_expr_t root)
+{
+    if (g->error || !expr_valid(g, root)) return VEC_UNDEFINED;
+    vector_t r = vector_alloc(g->size);
+    if (!vec_expr_eval_to(g, root, &r)) {
+        vector_free(&r);
+        return VEC_UNDEFINED;
+    }
+    return r;
+}
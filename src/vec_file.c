@@ -0,0 +1,330 @@
+#include <vec_file.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define VEC_FILE_MMAP 1
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+#include <errno.h>
+#include <limits.h>
+
+// the format is little-endian and a mapping hands out the file bytes in place
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+    #error "vec_file.c: the vector file format is little-endian; big-endian hosts are not supported"
+#endif
+
+#define HEADER_BYTES sizeof(vec_file_header_t)
+#define U64_MAX (~(uint64_t)0)
+#define BYTES_MAX ((uint64_t)(size_t)-1)           // largest mappable size
+
+typedef char vec_file_header_is_64_bytes[sizeof(vec_file_header_t) == 64 ? 1 : -1];
+
+static size_t dtype_size(uint32_t dtype)
+{
+    switch (dtype) {
+        case VEC_DTYPE_F32: return sizeof(float);
+        case VEC_DTYPE_F64: return sizeof(double);
+        case VEC_DTYPE_F16: return sizeof(half_t);
+        case VEC_DTYPE_BF16: return sizeof(bf16_t);
+        default: return 0;
+    }
+}
+
+/**
+ * @brief Fletcher-64: two running sums modulo 2^32 - 1 over 32-bit words.
+ *        The modulo is deferred over blocks short enough that the second
+ *        sum cannot overflow 64 bits.
+ */
+uint64_t vec_file_checksum(const void *data, size_t bytes)
+{
+    const unsigned char *p = (const unsigned char *)data;
+    const uint64_t mod = 0xffffffffu;
+    uint64_t s1 = 0, s2 = 0;
+    size_t words = bytes / 4;
+
+    while (words > 0) {
+        size_t block = words < 65536 ? words : 65536;
+        words -= block;
+        for (size_t i = 0; i < block; i++, p += 4) {
+            uint32_t w;
+            memcpy(&w, p, 4);
+            s1 += w;
+            s2 += s1;
+        }
+        s1 %= mod;
+        s2 %= mod;
+    }
+    if (bytes % 4) {
+        uint32_t w = 0;
+        memcpy(&w, p, bytes % 4);
+        s1 = (s1 + w) % mod;
+        s2 = (s2 + s1) % mod;
+    }
+    return (s2 << 32) | s1;
+}
+
+const char *vec_file_strerror(vec_file_error_t err)
+{
+    switch (err) {
+        case VEC_FILE_OK: return "ok";
+        case VEC_FILE_IO: return "i/o error";
+        case VEC_FILE_BAD_MAGIC: return "not a vector file";
+        case VEC_FILE_BAD_VERSION: return "unsupported format version";
+        case VEC_FILE_BAD_DTYPE: return "element type mismatch";
+        case VEC_FILE_TRUNCATED: return "file truncated";
+        case VEC_FILE_CHECKSUM: return "checksum mismatch";
+        case VEC_FILE_TOO_LARGE: return "too many elements for the vector type";
+        case VEC_FILE_NOT_MAPPED: return "not a shared file mapping";
+        case VEC_FILE_UNSUPPORTED: return "memory mapping not supported";
+        case VEC_FILE_BAD_HEADER: return "bad data alignment or offset";
+    }
+    return "unknown error";
+}
+
+/**
+ * @brief Header sanity checks shared by vec_file_read_header and the map
+ *        calls. `file_bytes` is the size of the file on disk.
+ */
+static vec_file_error_t check_header(const vec_file_header_t *h, uint64_t file_bytes)
+{
+    if (memcmp(h->magic, VEC_FILE_MAGIC, sizeof h->magic) != 0) return VEC_FILE_BAD_MAGIC;
+    if (h->version == 0 || h->version > VEC_FILE_VERSION) return VEC_FILE_BAD_VERSION;
+    size_t elem = dtype_size(h->dtype);
+    if (elem == 0) return VEC_FILE_BAD_DTYPE;
+    if (h->alignment == 0 || (h->alignment & (h->alignment - 1)) != 0 ||
+        h->data_offset < HEADER_BYTES || h->data_offset % h->alignment != 0) return VEC_FILE_BAD_HEADER;
+    if (h->length > (U64_MAX - h->data_offset) / elem ||
+        h->data_offset + h->length * elem > file_bytes) return VEC_FILE_TRUNCATED;
+    return VEC_FILE_OK;
+}
+
+vec_file_error_t vec_file_read_header(const char *path, vec_file_header_t *header)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) return VEC_FILE_IO;
+    vec_file_error_t err = VEC_FILE_OK;
+    if (fread(header, HEADER_BYTES, 1, f) != 1) {
+        err = ferror(f) ? VEC_FILE_IO : VEC_FILE_BAD_MAGIC;
+    } else if (fseek(f, 0, SEEK_END) != 0) {
+        err = VEC_FILE_IO;
+    } else {
+        long end = ftell(f);
+        err = end < 0 ? VEC_FILE_IO : check_header(header, (uint64_t)end);
+    }
+    fclose(f);
+    return err;
+}
+
+/****************************************************WRITE****************************************************/
+
+static vec_file_error_t file_write(const char *path, const void *data, size_t length,
+                                   uint32_t dtype, size_t alignment)
+{
+    if (alignment == 0) alignment = VEC_FILE_ALIGN;
+    if ((alignment & (alignment - 1)) != 0 || alignment > 0xffffffffu) {
+        errno = EINVAL;
+        return VEC_FILE_IO;
+    }
+    size_t bytes = length * dtype_size(dtype);
+
+    vec_file_header_t h;
+    memset(&h, 0, sizeof h);
+    memcpy(h.magic, VEC_FILE_MAGIC, sizeof h.magic);
+    h.version = VEC_FILE_VERSION;
+    h.dtype = dtype;
+    h.length = length;
+    h.alignment = (uint32_t)alignment;
+    h.data_offset = (HEADER_BYTES + alignment - 1) & ~(uint64_t)(alignment - 1);
+    h.checksum = vec_file_checksum(data, bytes);
+
+    FILE *f = fopen(path, "wb");
+    if (!f) return VEC_FILE_IO;
+    bool ok = fwrite(&h, HEADER_BYTES, 1, f) == 1;
+    static const unsigned char zeros[256];
+    for (uint64_t pad = h.data_offset - HEADER_BYTES; ok && pad > 0; ) {
+        size_t chunk = pad < sizeof zeros ? (size_t)pad : sizeof zeros;
+        ok = fwrite(zeros, 1, chunk, f) == chunk;
+        pad -= chunk;
+    }
+    if (ok && bytes > 0) ok = fwrite(data, 1, bytes, f) == bytes;
+    if (fclose(f) != 0) ok = false;
+    return ok ? VEC_FILE_OK : VEC_FILE_IO;
+}
+
+vec_file_error_t vec_file_write(const char *path, vector_t v, size_t alignment)
+{
+    return file_write(path, v.data, v.size, VEC_DTYPE_F32, alignment);
+}
+
+vec_file_error_t dvec_file_write(const char *path, dvector_t v, size_t alignment)
+{
+    return file_write(path, v.data, v.size, VEC_DTYPE_F64, alignment);
+}
+
+vec_file_error_t hvec_file_write(const char *path, hvector_t v, size_t alignment)
+{
+    return file_write(path, v.data, v.size, VEC_DTYPE_F16, alignment);
+}
+
+vec_file_error_t bvec_file_write(const char *path, bvector_t v, size_t alignment)
+{
+    return file_write(path, v.data, v.size, VEC_DTYPE_BF16, alignment);
+}
+
+/*****************************************************MAP*****************************************************/
+
+/*
+ * A mapped vector's allocator is embedded in a small malloc'd record that
+ * also remembers the whole mapping (header included), so vector_free & co.
+ * unmap it and vec_file_sync can find the header again.
+ */
+typedef struct {
+    vec_allocator_t allocator;
+    unsigned char *base;
+    size_t bytes;
+    bool shared;
+} vec_mapping_t;
+
+#ifdef VEC_FILE_MMAP
+
+static void *mapping_alloc(void *ctx, size_t bytes)
+{
+    // a mapping only ever owns the vector it was created for
+    (void)ctx;
+    (void)bytes;
+    return NULL;
+}
+
+static void mapping_free(void *ctx, void *ptr, size_t bytes)
+{
+    vec_mapping_t *m = (vec_mapping_t *)ctx;
+    (void)ptr;
+    (void)bytes;
+    munmap(m->base, m->bytes);
+    free(m);
+}
+
+/**
+ * @brief Map `path`, check it holds `dtype` elements and at most
+ *        `max_length` of them. Returns the element data (NULL on error) and
+ *        the element count / owning allocator through the out parameters.
+ */
+static void *file_map(const char *path, int mode, uint32_t dtype, uint64_t max_length,
+                      size_t *length, const vec_allocator_t **owner, vec_file_error_t *err)
+{
+    int kind = mode & ~VEC_MAP_VERIFY;
+    int fd = open(path, kind == VEC_MAP_SHARED ? O_RDWR : O_RDONLY);
+    if (fd < 0) { *err = VEC_FILE_IO; return NULL; }
+
+    struct stat st;
+    vec_file_header_t h;
+    ssize_t got = fstat(fd, &st) == 0 ? pread(fd, &h, HEADER_BYTES, 0) : -1;
+    if (got != (ssize_t)HEADER_BYTES) {
+        *err = got < 0 ? VEC_FILE_IO : VEC_FILE_BAD_MAGIC;
+        close(fd);
+        return NULL;
+    }
+    *err = check_header(&h, (uint64_t)st.st_size);
+    if (*err == VEC_FILE_OK && h.dtype != dtype) *err = VEC_FILE_BAD_DTYPE;
+    if (*err == VEC_FILE_OK && (h.length > max_length || h.data_offset + h.length * dtype_size(dtype) > BYTES_MAX))
+        *err = VEC_FILE_TOO_LARGE;
+    if (*err != VEC_FILE_OK) {
+        close(fd);
+        return NULL;
+    }
+
+    size_t data_bytes = (size_t)h.length * dtype_size(dtype);
+    size_t bytes = (size_t)h.data_offset + data_bytes;
+    int prot = kind == VEC_MAP_READONLY ? PROT_READ : PROT_READ | PROT_WRITE;
+    int flags = kind == VEC_MAP_SHARED ? MAP_SHARED : MAP_PRIVATE;
+    void *base = mmap(NULL, bytes, prot, flags, fd, 0);
+    close(fd);                                  // the mapping keeps the file open
+    if (base == MAP_FAILED) { *err = VEC_FILE_IO; return NULL; }
+
+    unsigned char *data = (unsigned char *)base + h.data_offset;
+    if ((mode & VEC_MAP_VERIFY) && vec_file_checksum(data, data_bytes) != h.checksum) {
+        munmap(base, bytes);
+        *err = VEC_FILE_CHECKSUM;
+        return NULL;
+    }
+
+    vec_mapping_t *m = (vec_mapping_t *)malloc(sizeof *m);
+    if (!m) {
+        munmap(base, bytes);
+        *err = VEC_FILE_IO;
+        return NULL;
+    }
+    m->allocator = (vec_allocator_t){ mapping_alloc, mapping_free, m };
+    m->base = (unsigned char *)base;
+    m->bytes = bytes;
+    m->shared = kind == VEC_MAP_SHARED;
+    *length = (size_t)h.length;
+    *owner = &m->allocator;
+    return data;
+}
+
+/**
+ * @brief Refresh the header checksum from the current contents and flush
+ *        header and data to the file.
+ */
+static vec_file_error_t file_sync(const vec_allocator_t *owner)
+{
+    if (!owner || owner->free != mapping_free) return VEC_FILE_NOT_MAPPED;
+    vec_mapping_t *m = (vec_mapping_t *)owner->ctx;
+    if (!m->shared) return VEC_FILE_NOT_MAPPED;
+
+    vec_file_header_t h;
+    memcpy(&h, m->base, HEADER_BYTES);
+    h.checksum = vec_file_checksum(m->base + h.data_offset, m->bytes - (size_t)h.data_offset);
+    memcpy(m->base, &h, HEADER_BYTES);
+    return msync(m->base, m->bytes, MS_SYNC) == 0 ? VEC_FILE_OK : VEC_FILE_IO;
+}
+
+#else // !VEC_FILE_MMAP
+
+static void *file_map(const char *path, int mode, uint32_t dtype, uint64_t max_length,
+                      size_t *length, const vec_allocator_t **owner, vec_file_error_t *err)
+{
+    (void)path; (void)mode; (void)dtype; (void)max_length; (void)length; (void)owner;
+    *err = VEC_FILE_UNSUPPORTED;
+    return NULL;
+}
+
+static vec_file_error_t file_sync(const vec_allocator_t *owner)
+{
+    (void)owner;
+    return VEC_FILE_UNSUPPORTED;
+}
+
+#endif // VEC_FILE_MMAP
+
+/*
+ * Typed front ends: V is the function prefix, VT the vector type, ET its
+ * element type, DT the file dtype, MAX the largest size VT can hold.
+ */
+#define VEC_FILE_MAP_API(V, VT, ET, DT, MAX, UNDEF)                                 \
+VT V##_file_map(const char *path, int mode, vec_file_error_t *err)                  \
+{                                                                                   \
+    vec_file_error_t e;                                                             \
+    size_t length = 0;                                                              \
+    const vec_allocator_t *owner = NULL;                                            \
+    void *data = file_map(path, mode, DT, MAX, &length, &owner, &e);                \
+    if (err) *err = e;                                                              \
+    if (!data) return UNDEF;                                                        \
+    VT v = UNDEF;                                                                   \
+    v.size = length;                                                                \
+    v.data = (ET *)data;                                                            \
+    v.allocator = owner;                                                            \
+    return v;                                                                       \
+}                                                                                   \
+vec_file_error_t V##_file_sync(VT v)                                                \
+{                                                                                   \
+    return file_sync(v.allocator);                                                  \
+}
+
+VEC_FILE_MAP_API(vec, vector_t, float, VEC_DTYPE_F32, (uint64_t)UINT_MAX, VEC_UNDEFINED)
+VEC_FILE_MAP_API(dvec, dvector_t, double, VEC_DTYPE_F64, (uint64_t)UINT_MAX, DVEC_UNDEFINED)
+VEC_FILE_MAP_API(hvec, hvector_t, half_t, VEC_DTYPE_F16, BYTES_MAX, HVEC_UNDEFINED)
+VEC_FILE_MAP_API(bvec, bvector_t, bf16_t, VEC_DTYPE_BF16, BYTES_MAX, BVEC_UNDEFINED)
@@ -0,0 +1,271 @@
+#include <vec_fixed.h>
+#include <vec_simd.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    #define VEC_SIMD_X86 1
+    #include <immintrin.h>
+#endif
+
+#define SOA_ALIGN 64
+
+static inline size_t soa_stride(size_t count, size_t elem)
+{
+    return (count * elem + SOA_ALIGN - 1) & ~(size_t)(SOA_ALIGN - 1);
+}
+
+/**
+ * @brief One allocation holding three 64-byte aligned component arrays.
+ *        Returns the aligned base and stores the raw block in *block.
+ */
+static unsigned char *soa_alloc_block(size_t stride, const vec_allocator_t **allocator, void **block)
+{
+    const vec_allocator_t *a = vec_allocator_current();
+    *allocator = a;
+    *block = a->alloc(a->ctx, 3 * stride + SOA_ALIGN);
+    if (!*block) return NULL;
+    size_t base = ((size_t)*block + SOA_ALIGN - 1) & ~(size_t)(SOA_ALIGN - 1);
+    return (unsigned char *)base;
+}
+
+/****************************************************VEC3F****************************************************/
+
+vec3f_soa_t vec3f_soa_alloc(size_t count)
+{
+    vec3f_soa_t v;
+    size_t stride = soa_stride(count, sizeof(float));
+    unsigned char *base = soa_alloc_block(stride, &v.allocator, &v.block);
+    v.count = base ? count : 0;
+    v.x = base ? (float *)base : NULL;
+    v.y = base ? (float *)(base + stride) : NULL;
+    v.z = base ? (float *)(base + 2 * stride) : NULL;
+    return v;
+}
+
+void vec3f_soa_free(vec3f_soa_t *v)
+{
+    if (v->block) {
+        size_t bytes = 3 * soa_stride(v->count, sizeof(float)) + SOA_ALIGN;
+        v->allocator->free(v->allocator->ctx, v->block, bytes);
+        v->block = NULL;
+        v->x = v->y = v->z = NULL;
+    }
+}
+
+vec3f_t vec3f_soa_get(const vec3f_soa_t *v, size_t i)
+{
+    return vec3f_make(v->x[i], v->y[i], v->z[i]);
+}
+
+void vec3f_soa_set(vec3f_soa_t *v, size_t i, vec3f_t a)
+{
+    v->x[i] = a.x;
+    v->y[i] = a.y;
+    v->z[i] = a.z;
+}
+
+/*
+ * Batch kernels. Each SIMD level processes W vectors per iteration with the
+ * same operation order as the vec3f_* inline functions (no FMA), so every
+ * level matches the scalar path bit-for-bit; the n % W tail uses the inline
+ * functions directly.
+ */
+static void soa_cross_tail(vec3f_soa_t *d, const vec3f_soa_t *a, const vec3f_soa_t *b, size_t i)
+{
+    for (; i < d->count; i++) {
+        vec3f_soa_set(d, i, vec3f_cross(vec3f_soa_get(a, i), vec3f_soa_get(b, i)));
+    }
+}
+
+static void soa_dot_tail(float *d, const vec3f_soa_t *a, const vec3f_soa_t *b, size_t i)
+{
+    for (; i < a->count; i++) {
+        d[i] = vec3f_dot(vec3f_soa_get(a, i), vec3f_soa_get(b, i));
+    }
+}
+
+static void soa_magnitude_tail(float *d, const vec3f_soa_t *a, size_t i)
+{
+    for (; i < a->count; i++) {
+        d[i] = vec3f_length(vec3f_soa_get(a, i));
+    }
+}
+
+static void soa_normalize_tail(vec3f_soa_t *v, size_t i)
+{
+    for (; i < v->count; i++) {
+        vec3f_soa_set(v, i, vec3f_normalize(vec3f_soa_get(v, i)));
+    }
+}
+
+#ifdef VEC_SIMD_X86
+
+#define SOA_LEVEL(isa, TARGET, VEC, W, LOAD, STORE, ADD, SUB, MUL, DIV, SQRT, SET1) \
+static TARGET void soa_cross_##isa(vec3f_soa_t *d, const vec3f_soa_t *a, const vec3f_soa_t *b) \
+{                                                                                   \
+    size_t i = 0;                                                                   \
+    for (; i + W <= d->count; i += W) {                                             \
+        VEC ax = LOAD(a->x + i), ay = LOAD(a->y + i), az = LOAD(a->z + i);          \
+        VEC bx = LOAD(b->x + i), by = LOAD(b->y + i), bz = LOAD(b->z + i);          \
+        STORE(d->x + i, SUB(MUL(ay, bz), MUL(az, by)));                             \
+        STORE(d->y + i, SUB(MUL(az, bx), MUL(ax, bz)));                             \
+        STORE(d->z + i, SUB(MUL(ax, by), MUL(ay, bx)));                             \
+    }                                                                               \
+    soa_cross_tail(d, a, b, i);                                                     \
+}                                                                                   \
+static TARGET void soa_dot_##isa(float *d, const vec3f_soa_t *a, const vec3f_soa_t *b) \
+{                                                                                   \
+    size_t i = 0;                                                                   \
+    for (; i + W <= a->count; i += W) {                                             \
+        VEC s = ADD(ADD(MUL(LOAD(a->x + i), LOAD(b->x + i)),                        \
+                        MUL(LOAD(a->y + i), LOAD(b->y + i))),                       \
+                    MUL(LOAD(a->z + i), LOAD(b->z + i)));                           \
+        STORE(d + i, s);                                                            \
+    }                                                                               \
+    soa_dot_tail(d, a, b, i);                                                       \
+}                                                                                   \
+static TARGET void soa_magnitude_##isa(float *d, const vec3f_soa_t *a)              \
+{                                                                                   \
+    size_t i = 0;                                                                   \
+    for (; i + W <= a->count; i += W) {                                             \
+        VEC x = LOAD(a->x + i), y = LOAD(a->y + i), z = LOAD(a->z + i);             \
+        STORE(d + i, SQRT(ADD(ADD(MUL(x, x), MUL(y, y)), MUL(z, z))));              \
+    }                                                                               \
+    soa_magnitude_tail(d, a, i);                                                    \
+}                                                                                   \
+static TARGET void soa_normalize_##isa(vec3f_soa_t *v)                              \
+{                                                                                   \
+    size_t i = 0;                                                                   \
+    const VEC one = SET1(1.0f), zero = SET1(0.0f);                                  \
+    for (; i + W <= v->count; i += W) {                                             \
+        VEC x = LOAD(v->x + i), y = LOAD(v->y + i), z = LOAD(v->z + i);             \
+        VEC len = SQRT(ADD(ADD(MUL(x, x), MUL(y, y)), MUL(z, z)));                  \
+        VEC inv = DIV(one, len);                                                    \
+        SOA_KEEP_##isa(len, zero, x, MUL(x, inv), v->x + i);                        \
+        SOA_KEEP_##isa(len, zero, y, MUL(y, inv), v->y + i);                        \
+        SOA_KEEP_##isa(len, zero, z, MUL(z, inv), v->z + i);                        \
+    }                                                                               \
+    soa_normalize_tail(v, i);                                                       \
+}
+
+// store `scaled` where len > 0, keep `orig` elsewhere (zero or NaN length)
+#define SOA_KEEP_avx2(len, zero, orig, scaled, p) \
+    _mm256_storeu_ps(p, _mm256_blendv_ps(orig, scaled, _mm256_cmp_ps(len, zero, _CMP_GT_OQ)))
+#define SOA_KEEP_avx512(len, zero, orig, scaled, p) \
+    _mm512_storeu_ps(p, _mm512_mask_blend_ps(_mm512_cmp_ps_mask(len, zero, _CMP_GT_OQ), orig, scaled))
+
+SOA_LEVEL(avx2, __attribute__((target("avx2"))), __m256, 8,
+          _mm256_loadu_ps, _mm256_storeu_ps, _mm256_add_ps, _mm256_sub_ps,
+          _mm256_mul_ps, _mm256_div_ps, _mm256_sqrt_ps, _mm256_set1_ps)
+
+SOA_LEVEL(avx512, __attribute__((target("avx512f"))), __m512, 16,
+          _mm512_loadu_ps, _mm512_storeu_ps, _mm512_add_ps, _mm512_sub_ps,
+          _mm512_mul_ps, _mm512_div_ps, _mm512_sqrt_ps, _mm512_set1_ps)
+
+#endif // VEC_SIMD_X86
+
+void vec3f_soa_cross(vec3f_soa_t *dst, const vec3f_soa_t *a, const vec3f_soa_t *b)
+{
+#ifdef VEC_SIMD_X86
+    vec_isa_t isa = vec_isa_active();
+    if (isa >= VEC_ISA_AVX512) { soa_cross_avx512(dst, a, b); return; }
+    if (isa >= VEC_ISA_AVX2)   { soa_cross_avx2(dst, a, b); return; }
+#endif
+    soa_cross_tail(dst, a, b, 0);
+}
+
+void vec3f_soa_dot(float *dst, const vec3f_soa_t *a, const vec3f_soa_t *b)
+{
+#ifdef VEC_SIMD_X86
+    vec_isa_t isa = vec_isa_active();
+    if (isa >= VEC_ISA_AVX512) { soa_dot_avx512(dst, a, b); return; }
+    if (isa >= VEC_ISA_AVX2)   { soa_dot_avx2(dst, a, b); return; }
+#endif
+    soa_dot_tail(dst, a, b, 0);
+}
+
+void vec3f_soa_magnitude(float *dst, const vec3f_soa_t *a)
+{
+#ifdef VEC_SIMD_X86
+    vec_isa_t isa = vec_isa_active();
+    if (isa >= VEC_ISA_AVX512) { soa_magnitude_avx512(dst, a); return; }
+    if (isa >= VEC_ISA_AVX2)   { soa_magnitude_avx2(dst, a); return; }
+#endif
+    soa_magnitude_tail(dst, a, 0);
+}
+
+void vec3f_soa_normalize(vec3f_soa_t *v)
+{
+#ifdef VEC_SIMD_X86
+    vec_isa_t isa = vec_isa_active();
+    if (isa >= VEC_ISA_AVX512) { soa_normalize_avx512(v); return; }
+    if (isa >= VEC_ISA_AVX2)   { soa_normalize_avx2(v); return; }
+#endif
+    soa_normalize_tail(v, 0);
+}
+
+/****************************************************VEC3D****************************************************/
+
+/*
+ * The double batches use plain loops, written so the compiler can vectorize
+ * them, but carry no hand-written kernels. Each element is read in full
+ * before its result is stored, so dst may be one of the inputs, as in the
+ * float batches; no pointer is restrict-qualified for that reason.
+ */
+
+vec3d_soa_t vec3d_soa_alloc(size_t count)
+{
+    vec3d_soa_t v;
+    size_t stride = soa_stride(count, sizeof(double));
+    unsigned char *base = soa_alloc_block(stride, &v.allocator, &v.block);
+    v.count = base ? count : 0;
+    v.x = base ? (double *)base : NULL;
+    v.y = base ? (double *)(base + stride) : NULL;
+    v.z = base ? (double *)(base + 2 * stride) : NULL;
+    return v;
+}
+
+void vec3d_soa_free(vec3d_soa_t *v)
+{
+    if (v->block) {
+        size_t bytes = 3 * soa_stride(v->count, sizeof(double)) + SOA_ALIGN;
+        v->allocator->free(v->allocator->ctx, v->block, bytes);
+        v->block = NULL;
+        v->x = v->y = v->z = NULL;
+    }
+}
+
+void vec3d_soa_cross(vec3d_soa_t *dst, const vec3d_soa_t *a, const vec3d_soa_t *b)
+{
+    for (size_t i = 0; i < dst->count; i++) {
+        double ax = a->x[i], ay = a->y[i], az = a->z[i];
+        double bx = b->x[i], by = b->y[i], bz = b->z[i];
+        dst->x[i] = ay * bz - az * by;
+        dst->y[i] = az * bx - ax * bz;
+        dst->z[i] = ax * by - ay * bx;
+    }
+}
+
+void vec3d_soa_dot(double *dst, const vec3d_soa_t *a, const vec3d_soa_t *b)
+{
+    for (size_t i = 0; i < a->count; i++) {
+        dst[i] = a->x[i] * b->x[i] + a->y[i] * b->y[i] + a->z[i] * b->z[i];
+    }
+}
+
+void vec3d_soa_magnitude(double *dst, const vec3d_soa_t *a)
+{
+    for (size_t i = 0; i < a->count; i++) {
+        double x = a->x[i], y = a->y[i], z = a->z[i];
+        dst[i] = sqrt_exact_d(x * x + y * y + z * z);
+    }
+}
+
+void vec3d_soa_normalize(vec3d_soa_t *v)
+{
+    for (size_t i = 0; i < v->count; i++) {
+        vec3d_t n = vec3d_normalize(vec3d_make(v->x[i], v->y[i], v->z[i]));
+        v->x[i] = n.x;
+        v->y[i] = n.y;
+        v->z[i] = n.z;
+    }
+}
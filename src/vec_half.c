@@ -0,0 +1,417 @@
+#include <vec_half.h>
+#include <vec_simd.h>
+#include <vec_parallel.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    #define VEC_SIMD_X86 1
+    #include <immintrin.h>
+#endif
+
+const hvector_t HVEC_UNDEFINED = {0, NULL, NULL};
+const bvector_t BVEC_UNDEFINED = {0, NULL, NULL};
+
+/*
+ * Kernels for one storage format at one level. Formats are keyed h (half)
+ * and b (bfloat16); both store uint16_t, so one table type serves both.
+ */
+typedef struct {
+    void (*from_f32)(uint16_t *dst, const float *src, size_t n);
+    void (*to_f32)(float *dst, const uint16_t *src, size_t n);
+    void (*add)(uint16_t *dst, const uint16_t *a, const uint16_t *b, size_t n);
+    void (*scale)(uint16_t *dst, const uint16_t *a, float s, size_t n);
+    float (*dot)(const uint16_t *a, const uint16_t *b, size_t n);
+    float (*dot_f32)(const uint16_t *a, const float *b, size_t n);
+} half_kernels_t;
+
+#define TO_F32_h   half_to_float
+#define FROM_F32_h half_from_float
+#define TO_F32_b   bf16_to_float
+#define FROM_F32_b bf16_from_float
+
+#define LANES VEC_REDUCE_LANES
+
+// same pairwise order as the vec_simd.c reductions
+static inline float combine_lanes(float *lane)
+{
+    for (int w = LANES / 2; w > 0; w /= 2) {
+        for (int j = 0; j < w; j++) lane[j] += lane[j + w];
+    }
+    return lane[0];
+}
+
+/****************************************************SCALAR***************************************************/
+
+/*
+ * The scalar kernels double as the tails of the SIMD ones: `i` is where
+ * the caller stopped. Reductions take the lanes the caller accumulated.
+ */
+#define HALF_TAILS(F)                                                               \
+static void from_f32_tail_##F(uint16_t *dst, const float *src, size_t i, size_t n)  \
+{                                                                                   \
+    for (; i < n; i++) dst[i] = FROM_F32_##F(src[i]);                               \
+}                                                                                   \
+static void to_f32_tail_##F(float *dst, const uint16_t *src, size_t i, size_t n)    \
+{                                                                                   \
+    for (; i < n; i++) dst[i] = TO_F32_##F(src[i]);                                 \
+}                                                                                   \
+static void add_tail_##F(uint16_t *dst, const uint16_t *a, const uint16_t *b, size_t i, size_t n) \
+{                                                                                   \
+    for (; i < n; i++) dst[i] = FROM_F32_##F(TO_F32_##F(a[i]) + TO_F32_##F(b[i]));  \
+}                                                                                   \
+static void scale_tail_##F(uint16_t *dst, const uint16_t *a, float s, size_t i, size_t n) \
+{                                                                                   \
+    for (; i < n; i++) dst[i] = FROM_F32_##F(TO_F32_##F(a[i]) * s);                 \
+}                                                                                   \
+static float dot_tail_##F(float *lane, const uint16_t *a, const uint16_t *b, size_t i, size_t n) \
+{                                                                                   \
+    for (; i < n; i++) lane[i % LANES] += TO_F32_##F(a[i]) * TO_F32_##F(b[i]);      \
+    return combine_lanes(lane);                                                     \
+}                                                                                   \
+static float dot_f32_tail_##F(float *lane, const uint16_t *a, const float *b, size_t i, size_t n) \
+{                                                                                   \
+    for (; i < n; i++) lane[i % LANES] += TO_F32_##F(a[i]) * b[i];                  \
+    return combine_lanes(lane);                                                     \
+}                                                                                   \
+static void from_f32_scalar_##F(uint16_t *dst, const float *src, size_t n) { from_f32_tail_##F(dst, src, 0, n); } \
+static void to_f32_scalar_##F(float *dst, const uint16_t *src, size_t n) { to_f32_tail_##F(dst, src, 0, n); }     \
+static void add_scalar_##F(uint16_t *dst, const uint16_t *a, const uint16_t *b, size_t n) { add_tail_##F(dst, a, b, 0, n); } \
+static void scale_scalar_##F(uint16_t *dst, const uint16_t *a, float s, size_t n) { scale_tail_##F(dst, a, s, 0, n); } \
+static float dot_scalar_##F(const uint16_t *a, const uint16_t *b, size_t n)         \
+{                                                                                   \
+    float lane[LANES] = { 0 };                                                      \
+    return dot_tail_##F(lane, a, b, 0, n);                                          \
+}                                                                                   \
+static float dot_f32_scalar_##F(const uint16_t *a, const float *b, size_t n)        \
+{                                                                                   \
+    float lane[LANES] = { 0 };                                                      \
+    return dot_f32_tail_##F(lane, a, b, 0, n);                                      \
+}                                                                                   \
+static const half_kernels_t half_kernels_scalar_##F = {                             \
+    from_f32_scalar_##F, to_f32_scalar_##F, add_scalar_##F, scale_scalar_##F,       \
+    dot_scalar_##F, dot_f32_scalar_##F                                              \
+};
+
+HALF_TAILS(h)
+HALF_TAILS(b)
+
+#ifdef VEC_SIMD_X86
+
+/*
+ * Per-level widening load (LOADH) and narrowing store (STOREH) of W
+ * elements. half uses the hardware conversions (F16C on AVX2, native on
+ * AVX-512F); bfloat16 widens with a 16-bit shift and narrows with integer
+ * round-to-nearest-even, since VCVTNEPS2BF16 flushes subnormals.
+ */
+#define TARGET_avx2   __attribute__((target("avx2,f16c")))
+#define TARGET_avx512 __attribute__((target("avx512f")))
+
+#define VEC_avx2   __m256
+#define VEC_avx512 __m512
+#define W_avx2     8
+#define W_avx512   16
+
+#define LOADU_avx2(p)      _mm256_loadu_ps(p)
+#define STOREU_avx2(p, v)  _mm256_storeu_ps(p, v)
+#define SET1_avx2(s)       _mm256_set1_ps(s)
+#define ADD_avx2(a, b)     _mm256_add_ps(a, b)
+#define MUL_avx2(a, b)     _mm256_mul_ps(a, b)
+
+#define LOADU_avx512(p)     _mm512_loadu_ps(p)
+#define STOREU_avx512(p, v) _mm512_storeu_ps(p, v)
+#define SET1_avx512(s)      _mm512_set1_ps(s)
+#define ADD_avx512(a, b)    _mm512_add_ps(a, b)
+#define MUL_avx512(a, b)    _mm512_mul_ps(a, b)
+
+#define HALF_ROUND (_MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)
+
+#define LOADH_avx2_h(p)     _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)(p)))
+#define STOREH_avx2_h(p, v) _mm_storeu_si128((__m128i *)(p), _mm256_cvtps_ph(v, HALF_ROUND))
+#define LOADH_avx512_h(p)     _mm512_cvtph_ps(_mm256_loadu_si256((const __m256i *)(p)))
+#define STOREH_avx512_h(p, v) _mm256_storeu_si256((__m256i *)(p), _mm512_cvtps_ph(v, HALF_ROUND))
+
+#define LOADH_avx2_b(p) \
+    _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(p))), 16))
+#define STOREH_avx2_b(p, v) _mm_storeu_si128((__m128i *)(p), bf16_round_avx2(v))
+#define LOADH_avx512_b(p) \
+    _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i *)(p))), 16))
+#define STOREH_avx512_b(p, v) _mm256_storeu_si256((__m256i *)(p), bf16_round_avx512(v))
+
+// the integer form of bf16_from_float, eight / sixteen lanes at a time
+static TARGET_avx2 inline __m128i bf16_round_avx2(__m256 v)
+{
+    __m256i x = _mm256_castps_si256(v);
+    __m256i odd = _mm256_and_si256(_mm256_srli_epi32(x, 16), _mm256_set1_epi32(1));
+    __m256i r = _mm256_add_epi32(x, _mm256_add_epi32(odd, _mm256_set1_epi32(0x7fff)));
+    __m256i nan = _mm256_cmpgt_epi32(_mm256_and_si256(x, _mm256_set1_epi32(0x7fffffff)),
+                                     _mm256_set1_epi32(0x7f800000));
+    r = _mm256_blendv_epi8(r, _mm256_or_si256(x, _mm256_set1_epi32(0x400000)), nan);
+    r = _mm256_srli_epi32(r, 16);
+    // packus works per 128-bit half; gather both halves into the low one
+    r = _mm256_permute4x64_epi64(_mm256_packus_epi32(r, r), 0x08);
+    return _mm256_castsi256_si128(r);
+}
+
+static TARGET_avx512 inline __m256i bf16_round_avx512(__m512 v)
+{
+    __m512i x = _mm512_castps_si512(v);
+    __m512i odd = _mm512_and_si512(_mm512_srli_epi32(x, 16), _mm512_set1_epi32(1));
+    __m512i r = _mm512_add_epi32(x, _mm512_add_epi32(odd, _mm512_set1_epi32(0x7fff)));
+    __mmask16 nan = _mm512_cmpgt_epi32_mask(_mm512_and_si512(x, _mm512_set1_epi32(0x7fffffff)),
+                                            _mm512_set1_epi32(0x7f800000));
+    r = _mm512_mask_or_epi32(r, nan, x, _mm512_set1_epi32(0x400000));
+    return _mm512_cvtepi32_epi16(_mm512_srli_epi32(r, 16));
+}
+
+/*
+ * One level for one format. The reductions keep LANES / W accumulator
+ * registers, register r holding lanes r*W .. r*W+W-1, exactly like the
+ * vec_simd.c dot kernels; the tail and the lane combine are shared with
+ * the scalar kernels.
+ */
+#define R_(isa) (LANES / W_##isa)
+
+#define HALF_LEVEL(isa, F)                                                          \
+static TARGET_##isa void from_f32_##isa##_##F(uint16_t *dst, const float *src, size_t n) \
+{                                                                                   \
+    size_t i = 0;                                                                   \
+    for (; i + W_##isa <= n; i += W_##isa) STOREH_##isa##_##F(dst + i, LOADU_##isa(src + i)); \
+    from_f32_tail_##F(dst, src, i, n);                                              \
+}                                                                                   \
+static TARGET_##isa void to_f32_##isa##_##F(float *dst, const uint16_t *src, size_t n) \
+{                                                                                   \
+    size_t i = 0;                                                                   \
+    for (; i + W_##isa <= n; i += W_##isa) STOREU_##isa(dst + i, LOADH_##isa##_##F(src + i)); \
+    to_f32_tail_##F(dst, src, i, n);                                                \
+}                                                                                   \
+static TARGET_##isa void add_##isa##_##F(uint16_t *dst, const uint16_t *a, const uint16_t *b, size_t n) \
+{                                                                                   \
+    size_t i = 0;                                                                   \
+    for (; i + W_##isa <= n; i += W_##isa) {                                        \
+        STOREH_##isa##_##F(dst + i, ADD_##isa(LOADH_##isa##_##F(a + i), LOADH_##isa##_##F(b + i))); \
+    }                                                                               \
+    add_tail_##F(dst, a, b, i, n);                                                  \
+}                                                                                   \
+static TARGET_##isa void scale_##isa##_##F(uint16_t *dst, const uint16_t *a, float s, size_t n) \
+{                                                                                   \
+    VEC_##isa vs = SET1_##isa(s);                                                   \
+    size_t i = 0;                                                                   \
+    for (; i + W_##isa <= n; i += W_##isa) {                                        \
+        STOREH_##isa##_##F(dst + i, MUL_##isa(LOADH_##isa##_##F(a + i), vs));       \
+    }                                                                               \
+    scale_tail_##F(dst, a, s, i, n);                                                \
+}                                                                                   \
+static TARGET_##isa float dot_##isa##_##F(const uint16_t *a, const uint16_t *b, size_t n) \
+{                                                                                   \
+    VEC_##isa acc[R_(isa)];                                                         \
+    for (int r = 0; r < R_(isa); r++) acc[r] = SET1_##isa(0.0f);                    \
+    size_t i = 0;                                                                   \
+    for (; i + LANES <= n; i += LANES) {                                            \
+        for (int r = 0; r < R_(isa); r++) {                                         \
+            acc[r] = ADD_##isa(acc[r], MUL_##isa(LOADH_##isa##_##F(a + i + r * W_##isa), \
+                                                 LOADH_##isa##_##F(b + i + r * W_##isa))); \
+        }                                                                           \
+    }                                                                               \
+    float lane[LANES];                                                              \
+    for (int r = 0; r < R_(isa); r++) STOREU_##isa(lane + r * W_##isa, acc[r]);     \
+    return dot_tail_##F(lane, a, b, i, n);                                          \
+}                                                                                   \
+static TARGET_##isa float dot_f32_##isa##_##F(const uint16_t *a, const float *b, size_t n) \
+{                                                                                   \
+    VEC_##isa acc[R_(isa)];                                                         \
+    for (int r = 0; r < R_(isa); r++) acc[r] = SET1_##isa(0.0f);                    \
+    size_t i = 0;                                                                   \
+    for (; i + LANES <= n; i += LANES) {                                            \
+        for (int r = 0; r < R_(isa); r++) {                                         \
+            acc[r] = ADD_##isa(acc[r], MUL_##isa(LOADH_##isa##_##F(a + i + r * W_##isa), \
+                                                 LOADU_##isa(b + i + r * W_##isa))); \
+        }                                                                           \
+    }                                                                               \
+    float lane[LANES];                                                              \
+    for (int r = 0; r < R_(isa); r++) STOREU_##isa(lane + r * W_##isa, acc[r]);     \
+    return dot_f32_tail_##F(lane, a, b, i, n);                                      \
+}                                                                                   \
+static const half_kernels_t half_kernels_##isa##_##F = {                            \
+    from_f32_##isa##_##F, to_f32_##isa##_##F, add_##isa##_##F, scale_##isa##_##F,   \
+    dot_##isa##_##F, dot_f32_##isa##_##F                                            \
+};
+
+HALF_LEVEL(avx2, h)
+HALF_LEVEL(avx2, b)
+HALF_LEVEL(avx512, h)
+HALF_LEVEL(avx512, b)
+
+// bfloat16 needs nothing beyond AVX2; half also needs F16C there
+#define LEVEL_OK_avx2_h __builtin_cpu_supports("f16c")
+#define LEVEL_OK_avx2_b 1
+
+#endif // VEC_SIMD_X86
+
+/****************************************************DISPATCH*************************************************/
+
+#ifdef VEC_SIMD_X86
+    #define HALF_DISPATCH_(F)                                                       \
+        vec_isa_t isa = vec_isa_active();                                           \
+        if (isa >= VEC_ISA_AVX512) return &half_kernels_avx512_##F;                 \
+        if (isa >= VEC_ISA_AVX2 && LEVEL_OK_avx2_##F) return &half_kernels_avx2_##F;
+#else
+    #define HALF_DISPATCH_(F)
+#endif
+
+static const half_kernels_t *half_kernels_h(void)
+{
+    HALF_DISPATCH_(h)
+    return &half_kernels_scalar_h;
+}
+
+static const half_kernels_t *half_kernels_b(void)
+{
+    HALF_DISPATCH_(b)
+    return &half_kernels_scalar_b;
+}
+
+void half_from_float_array(half_t *dst, const float *src, size_t n) { half_kernels_h()->from_f32(dst, src, n); }
+void half_to_float_array(float *dst, const half_t *src, size_t n) { half_kernels_h()->to_f32(dst, src, n); }
+void bf16_from_float_array(bf16_t *dst, const float *src, size_t n) { half_kernels_b()->from_f32(dst, src, n); }
+void bf16_to_float_array(float *dst, const bf16_t *src, size_t n) { half_kernels_b()->to_f32(dst, src, n); }
+
+/****************************************************VECTORS**************************************************/
+
+/*
+ * Chunk bodies for vec_parallel_for / vec_parallel_reduce. The reductions
+ * use the same chunking as vector_dot, so the results match it on the
+ * widened vectors with and without the pool.
+ */
+typedef struct {
+    const half_kernels_t *k;
+    uint16_t *dst;
+    float *fdst;
+    const uint16_t *a;
+    const uint16_t *b;
+    const float *fsrc;
+    float s;
+} half_job_t;
+
+static void from_f32_chunk(void *ctx, size_t begin, size_t end)
+{
+    const half_job_t *j = ctx;
+    j->k->from_f32(j->dst + begin, j->fsrc + begin, end - begin);
+}
+
+static void to_f32_chunk(void *ctx, size_t begin, size_t end)
+{
+    const half_job_t *j = ctx;
+    j->k->to_f32(j->fdst + begin, j->a + begin, end - begin);
+}
+
+static void add_chunk(void *ctx, size_t begin, size_t end)
+{
+    const half_job_t *j = ctx;
+    j->k->add(j->dst + begin, j->a + begin, j->b + begin, end - begin);
+}
+
+static void scale_chunk(void *ctx, size_t begin, size_t end)
+{
+    const half_job_t *j = ctx;
+    j->k->scale(j->dst + begin, j->a + begin, j->s, end - begin);
+}
+
+static double dot_chunk(void *ctx, size_t begin, size_t end)
+{
+    const half_job_t *j = ctx;
+    return j->k->dot(j->a + begin, j->b + begin, end - begin);
+}
+
+static double dot_f32_chunk(void *ctx, size_t begin, size_t end)
+{
+    const half_job_t *j = ctx;
+    return j->k->dot_f32(j->a + begin, j->fsrc + begin, end - begin);
+}
+
+/*
+ * The public API for one format: F is the kernel key, V the function
+ * prefix, VT the vector type and UNDEF its undefined value.
+ */
+#define HALF_VECTOR_API(F, V, VT, UNDEF)                                            \
+VT V##_alloc(size_t size)                                                           \
+{                                                                                   \
+    VT v;                                                                           \
+    v.allocator = vec_allocator_current();                                          \
+    v.size = size;                                                                  \
+    v.data = (uint16_t *)v.allocator->alloc(v.allocator->ctx, size * sizeof(uint16_t)); \
+    return v;                                                                       \
+}                                                                                   \
+void V##_free(VT *v)                                                                \
+{                                                                                   \
+    if (v->data) {                                                                  \
+        if (v->allocator) {                                                         \
+            v->allocator->free(v->allocator->ctx, v->data, v->size * sizeof(uint16_t)); \
+        } else {                                                                    \
+            free(v->data);                                                          \
+        }                                                                           \
+        v->data = NULL;                                                             \
+    }                                                                               \
+}                                                                                   \
+VT V##_from_vector(vector_t v)                                                      \
+{                                                                                   \
+    VT r = V##_alloc(v.size);                                                       \
+    if (!r.data) return r;                                                          \
+    half_job_t j = { half_kernels_##F(), r.data, NULL, NULL, NULL, v.data, 0.0f };  \
+    vec_parallel_for(v.size, from_f32_chunk, &j);                                   \
+    return r;                                                                       \
+}                                                                                   \
+vector_t V##_to_vector(VT v)                                                        \
+{                                                                                   \
+    vector_t r = vector_alloc((unsigned int)v.size);                                \
+    if (!r.data) return r;                                                          \
+    half_job_t j = { half_kernels_##F(), NULL, r.data, v.data, NULL, NULL, 0.0f };  \
+    vec_parallel_for(v.size, to_f32_chunk, &j);                                     \
+    return r;                                                                       \
+}                                                                                   \
+VT V##_add(VT a, VT b)                                                              \
+{                                                                                   \
+    if (a.size != b.size) return UNDEF;                                             \
+    VT r = V##_alloc(a.size);                                                       \
+    if (!r.data) return r;                                                          \
+    half_job_t j = { half_kernels_##F(), r.data, NULL, a.data, b.data, NULL, 0.0f }; \
+    vec_parallel_for(a.size, add_chunk, &j);                                        \
+    return r;                                                                       \
+}                                                                                   \
+void V##_add_inplace(VT *a, VT b)                                                   \
+{                                                                                   \
+    if (a->size != b.size) return;                                                 \
+    half_job_t j = { half_kernels_##F(), a->data, NULL, a->data, b.data, NULL, 0.0f }; \
+    vec_parallel_for(a->size, add_chunk, &j);                                       \
+}                                                                                   \
+VT V##_scale(VT a, float s)                                                         \
+{                                                                                   \
+    VT r = V##_alloc(a.size);                                                       \
+    if (!r.data) return r;                                                          \
+    half_job_t j = { half_kernels_##F(), r.data, NULL, a.data, NULL, NULL, s };     \
+    vec_parallel_for(a.size, scale_chunk, &j);                                      \
+    return r;                                                                       \
+}                                                                                   \
+void V##_scale_inplace(VT *a, float s)                                              \
+{                                                                                   \
+    half_job_t j = { half_kernels_##F(), a->data, NULL, a->data, NULL, NULL, s };   \
+    vec_parallel_for(a->size, scale_chunk, &j);                                     \
+}                                                                                   \
+float V##_dot(VT a, VT b)                                                           \
+{                                                                                   \
+    if (a.size != b.size) return 0.0f;                                              \
+    half_job_t j = { half_kernels_##F(), NULL, NULL, a.data, b.data, NULL, 0.0f };  \
+    return (float)vec_parallel_reduce(a.size, dot_chunk, &j);                       \
+}                                                                                   \
+float V##_dot_vector(VT a, vector_t b)                                              \
+{                                                                                   \
+    if (a.size != b.size) return 0.0f;                                              \
+    half_job_t j = { half_kernels_##F(), NULL, NULL, a.data, NULL, b.data, 0.0f };  \
+    return (float)vec_parallel_reduce(a.size, dot_f32_chunk, &j);                   \
+}                                                                                   \
+float V##_magnitude(VT a)                                                           \
+{                                                                                   \
+    half_job_t j = { half_kernels_##F(), NULL, NULL, a.data, a.data, NULL, 0.0f };  \
+    return sqrt_exact_f((float)vec_parallel_reduce(a.size, dot_chunk, &j));       \
+}
+
+HALF_VECTOR_API(h, hvec, hvector_t, HVEC_UNDEFINED)
+HALF_VECTOR_API(b, bvec, bvector_t, BVEC_UNDEFINED)
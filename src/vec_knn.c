@@ -0,0 +1,454 @@
+#include <vec_knn.h>
+#include <vec_simd.h>
+#include <vec_parallel.h>
+#include <vec_alloc.h>
+#include <math_core.h>
+#include <math.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    #define VEC_SIMD_X86 1
+    #include <immintrin.h>
+#endif
+
+#if VKNN_LANES % 16 != 0
+    #error "VKNN_LANES must be a multiple of 16 (whole AVX-512 registers)"
+#endif
+
+const vcoll_t VCOLL_UNDEFINED = {0, 0, 0, 0, NULL, NULL, NULL};
+
+/*
+ * Dot products of nrows rows, stride floats apart, with the queries q[0..QT):
+ * out[r * QT + j] = rows[r] . q[j] over the whole (zero padded) stride.
+ * Element d of a pair is multiplied and added in lane d % VKNN_LANES; one row
+ * register feeds the QT query accumulators before the next is loaded.
+ */
+typedef void (*knn_tile_f)(const float *rows, size_t stride, size_t nrows, const float *const *q, float *out);
+
+typedef struct {
+    knn_tile_f tile1;   // one query
+    knn_tile_f tile;    // VKNN_QUERY_TILE queries
+} knn_kernels_t;
+
+// pairwise, like the vec_simd.c reductions
+static inline float combine_lanes(float *lane)
+{
+    for (int w = VKNN_LANES / 2; w > 0; w /= 2) {
+        for (int j = 0; j < w; j++) lane[j] += lane[j + w];
+    }
+    return lane[0];
+}
+
+/*
+ * Per-level building blocks: V_ register type of W_ floats, R_ registers per
+ * VKNN_LANES lanes. The scalar level holds its lanes in plain floats.
+ */
+#define TARGET_scalar
+#define V_scalar float
+#define W_scalar 1
+#define ZERO_scalar 0.0f
+#define LOAD_scalar(p) (*(p))
+#define STORE_scalar(p, v) (*(p) = (v))
+#define ADD_scalar(a, b) ((a) + (b))
+#define MUL_scalar(a, b) ((a) * (b))
+
+#define TARGET_avx2 __attribute__((target("avx2")))
+#define V_avx2 __m256
+#define W_avx2 8
+#define ZERO_avx2 _mm256_setzero_ps()
+#define LOAD_avx2(p) _mm256_loadu_ps(p)
+#define STORE_avx2(p, v) _mm256_storeu_ps(p, v)
+#define ADD_avx2(a, b) _mm256_add_ps(a, b)
+#define MUL_avx2(a, b) _mm256_mul_ps(a, b)
+
+#define TARGET_avx512 __attribute__((target("avx512f")))
+#define V_avx512 __m512
+#define W_avx512 16
+#define ZERO_avx512 _mm512_setzero_ps()
+#define LOAD_avx512(p) _mm512_loadu_ps(p)
+#define STORE_avx512(p, v) _mm512_storeu_ps(p, v)
+#define ADD_avx512(a, b) _mm512_add_ps(a, b)
+#define MUL_avx512(a, b) _mm512_mul_ps(a, b)
+
+#define KNN_TILE(key, name, QT)                                                                         \
+TARGET_##key static void name##_##key(const float *rows, size_t stride, size_t nrows,                   \
+                                      const float *const *q, float *out)                                \
+{                                                                                                       \
+    enum { R = VKNN_LANES / W_##key };                                                                  \
+    for (size_t r = 0; r < nrows; r++) {                                                                \
+        const float *x = rows + r * stride;                                                             \
+        V_##key acc[QT][R];                                                                             \
+        for (int j = 0; j < QT; j++) {                                                                  \
+            for (int u = 0; u < R; u++) acc[j][u] = ZERO_##key;                                         \
+        }                                                                                               \
+        for (size_t d = 0; d < stride; d += VKNN_LANES) {                                               \
+            for (int u = 0; u < R; u++) {                                                               \
+                V_##key xv = LOAD_##key(x + d + u * W_##key);                                           \
+                for (int j = 0; j < QT; j++) {                                                          \
+                    acc[j][u] = ADD_##key(acc[j][u], MUL_##key(xv, LOAD_##key(q[j] + d + u * W_##key)));\
+                }                                                                                       \
+            }                                                                                           \
+        }                                                                                               \
+        for (int j = 0; j < QT; j++) {                                                                  \
+            float lane[VKNN_LANES];                                                                     \
+            for (int u = 0; u < R; u++) STORE_##key(lane + u * W_##key, acc[j][u]);                     \
+            out[r * QT + j] = combine_lanes(lane);                                                      \
+        }                                                                                               \
+    }                                                                                                   \
+}
+
+#define KNN_LEVEL(key)                                                                                  \
+KNN_TILE(key, dot_tile1, 1)                                                                             \
+KNN_TILE(key, dot_tile, VKNN_QUERY_TILE)                                                                \
+static const knn_kernels_t knn_kernels_##key = { dot_tile1_##key, dot_tile_##key };
+
+KNN_LEVEL(scalar)
+#ifdef VEC_SIMD_X86
+KNN_LEVEL(avx2)
+KNN_LEVEL(avx512)
+#endif
+
+static const knn_kernels_t *knn_kernels(void)
+{
+#ifdef VEC_SIMD_X86
+    vec_isa_t isa = vec_isa_active();
+    if (isa >= VEC_ISA_AVX512) return &knn_kernels_avx512;
+    if (isa >= VEC_ISA_AVX2) return &knn_kernels_avx2;
+#endif
+    return &knn_kernels_scalar;
+}
+
+/*************************************************COLLECTION**************************************************/
+
+// rows and their norms: capacity * stride floats, then capacity floats
+static bool vcoll_move(vcoll_t *c, size_t capacity)
+{
+    const vec_allocator_t *a = c->allocator;
+    float *data = NULL;
+    if (capacity > 0) {
+        if (capacity > (size_t)-1 / sizeof(float) / (c->stride + 1)) return false;
+        data = (float *)a->alloc(a->ctx, capacity * (c->stride + 1) * sizeof(float));
+        if (!data) return false;
+        if (c->count > 0) {
+            memcpy(data, c->data, c->count * c->stride * sizeof(float));
+            memcpy(data + capacity * c->stride, c->norm2, c->count * sizeof(float));
+        }
+    }
+    if (c->data) a->free(a->ctx, c->data, c->capacity * (c->stride + 1) * sizeof(float));
+    c->data = data;
+    c->norm2 = data ? data + capacity * c->stride : NULL;
+    c->capacity = capacity;
+    return true;
+}
+
+/**
+ * @brief Storage always comes from VEC_ALIGNED_ALLOCATOR, whatever the
+ *        thread's allocator stack holds: the rows are the hot data of every
+ *        search and each one should start a cache line.
+ */
+vcoll_t vcoll_alloc(size_t dim, size_t capacity)
+{
+    if (dim == 0 || dim > (size_t)-1 / 2) return VCOLL_UNDEFINED;
+    size_t stride = (dim + VKNN_LANES - 1) / VKNN_LANES * VKNN_LANES;
+    vcoll_t c = { dim, stride, 0, 0, NULL, NULL, &VEC_ALIGNED_ALLOCATOR };
+    if (!vcoll_move(&c, capacity)) return VCOLL_UNDEFINED;
+    return c;
+}
+
+void vcoll_free(vcoll_t *c)
+{
+    if (c->data) c->allocator->free(c->allocator->ctx, c->data, c->capacity * (c->stride + 1) * sizeof(float));
+    c->data = NULL;
+    c->norm2 = NULL;
+    c->count = 0;
+    c->capacity = 0;
+}
+
+bool vcoll_push(vcoll_t *c, const float *v)
+{
+    if (!c->allocator) return false;
+    if (c->count == c->capacity) {
+        size_t grown = c->capacity < 8 ? 16 : c->capacity * 2;
+        if (!vcoll_move(c, grown)) return false;
+    }
+    float *row = c->data + c->count * c->stride;
+    memcpy(row, v, c->dim * sizeof(float));
+    memset(row + c->dim, 0, (c->stride - c->dim) * sizeof(float));
+    // the same kernel the searches use, so |x|^2 matches a query's own
+    const float *self = row;
+    knn_kernels()->tile1(row, c->stride, 1, &self, &c->norm2[c->count]);
+    c->count++;
+    return true;
+}
+
+bool vcoll_push_vector(vcoll_t *c, vector_t v)
+{
+    if (v.size != c->dim || !v.data) return false;
+    return vcoll_push(c, v.data);
+}
+
+const float *vcoll_row(const vcoll_t *c, size_t i)
+{
+    return i < c->count ? c->data + i * c->stride : NULL;
+}
+
+/***************************************************SEARCH****************************************************/
+
+static inline float knn_distance(vknn_metric_t metric, float dot, float qn, float xn)
+{
+    float d;
+    if (metric == VKNN_L2) {
+        d = qn + xn - 2.0f * dot;
+        if (d < 0.0f) d = 0.0f;                 // cancellation on near-duplicates
+    } else if (metric == VKNN_IP) {
+        d = -dot;
+    } else {
+        d = qn > 0.0f && xn > 0.0f ? 1.0f - dot / (sqrt_exact_f(qn) * sqrt_exact_f(xn)) : 1.0f;
+    }
+    return d == d ? d : INFINITY;
+}
+
+// ties go to the lower index, so any split of the rows keeps the same hits
+static inline bool hit_worse(vknn_hit_t a, vknn_hit_t b)
+{
+    return a.distance > b.distance || (a.distance == b.distance && a.index > b.index);
+}
+
+// bounded max-heap: h[0] is the worst of the *n <= k hits kept
+static void heap_offer(vknn_hit_t *h, size_t *n, size_t k, vknn_hit_t hit)
+{
+    size_t i;
+    if (*n < k) {
+        i = (*n)++;
+        while (i > 0 && hit_worse(hit, h[(i - 1) / 2])) {
+            h[i] = h[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+    } else {
+        if (k == 0 || !hit_worse(h[0], hit)) return;
+        i = 0;
+        for (;;) {
+            size_t child = 2 * i + 1;
+            if (child >= *n) break;
+            if (child + 1 < *n && hit_worse(h[child + 1], h[child])) child++;
+            if (!hit_worse(h[child], hit)) break;
+            h[i] = h[child];
+            i = child;
+        }
+    }
+    h[i] = hit;
+}
+
+static int hit_compare(const void *a, const void *b)
+{
+    vknn_hit_t x = *(const vknn_hit_t *)a, y = *(const vknn_hit_t *)b;
+    return hit_worse(x, y) - hit_worse(y, x);
+}
+
+/*
+ * Task t runs the queries of group t / segments against the rows of segment
+ * t % segments. Either every distance goes to dist (one query, no heaps) or
+ * into the heap of (query, segment) at heaps + (q * segments + s) * hstride.
+ */
+typedef struct {
+    const vcoll_t *c;
+    vknn_metric_t metric;
+    const float *q;         // nq padded queries, c->stride apart
+    const float *qn;        // their squared norms
+    size_t nq;
+    size_t group;           // queries per group, a multiple of VKNN_QUERY_TILE
+    size_t segments;        // row ranges per group
+    size_t k;               // heap bound
+    size_t hstride;
+    vknn_hit_t *heaps;
+    size_t *fill;           // hits in each heap
+    float *dist;
+    vknn_hit_t *out;        // final k hits per query, out_k apart
+    size_t out_k;
+} knn_job_t;
+
+static size_t segment_start(size_t n, size_t parts, size_t s)
+{
+    return n / parts * s + (s < n % parts ? s : n % parts);
+}
+
+static void knn_task(void *ctx, size_t begin, size_t end)
+{
+    const knn_job_t *j = ctx;
+    const vcoll_t *c = j->c;
+    const knn_kernels_t *kern = knn_kernels();
+    float dots[VKNN_ROW_BLOCK * VKNN_QUERY_TILE];
+    for (size_t t = begin; t < end; t++) {
+        size_t s = t % j->segments, q0 = t / j->segments * j->group;
+        size_t q1 = q0 + j->group < j->nq ? q0 + j->group : j->nq;
+        size_t r0 = segment_start(c->count, j->segments, s), r1 = segment_start(c->count, j->segments, s + 1);
+        for (size_t rb = r0; rb < r1; rb += VKNN_ROW_BLOCK) {
+            size_t nr = r1 - rb < VKNN_ROW_BLOCK ? r1 - rb : VKNN_ROW_BLOCK;
+            const float *rows = c->data + rb * c->stride;
+            for (size_t qt = q0; qt < q1; qt += VKNN_QUERY_TILE) {
+                size_t m = q1 - qt < VKNN_QUERY_TILE ? q1 - qt : VKNN_QUERY_TILE, w = 1;
+                const float *qp[VKNN_QUERY_TILE];
+                for (size_t u = 0; u < VKNN_QUERY_TILE; u++) qp[u] = j->q + (qt + (u < m ? u : m - 1)) * c->stride;
+                if (m == 1) {
+                    kern->tile1(rows, c->stride, nr, qp, dots);
+                } else {
+                    kern->tile(rows, c->stride, nr, qp, dots);     // a short tile repeats its last query
+                    w = VKNN_QUERY_TILE;
+                }
+                for (size_t u = 0; u < m; u++) {
+                    size_t q = qt + u;
+                    if (j->dist) {
+                        for (size_t r = 0; r < nr; r++) {
+                            j->dist[rb + r] = knn_distance(j->metric, dots[r * w + u], j->qn[q], c->norm2[rb + r]);
+                        }
+                        continue;
+                    }
+                    vknn_hit_t *h = j->heaps + (q * j->segments + s) * j->hstride;
+                    size_t *n = &j->fill[q * j->segments + s];
+                    for (size_t r = 0; r < nr; r++) {
+                        vknn_hit_t hit = { rb + r, knn_distance(j->metric, dots[r * w + u], j->qn[q], c->norm2[rb + r]) };
+                        heap_offer(h, n, j->k, hit);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// merge the segments' heaps into out, sort, pad with sentinels
+static void knn_finish(void *ctx, size_t begin, size_t end)
+{
+    const knn_job_t *j = ctx;
+    for (size_t q = begin; q < end; q++) {
+        vknn_hit_t *h = j->out + q * j->out_k;
+        size_t n = j->fill[q * j->segments];
+        if (j->segments > 1) {
+            n = 0;
+            for (size_t s = 0; s < j->segments; s++) {
+                const vknn_hit_t *part = j->heaps + (q * j->segments + s) * j->hstride;
+                for (size_t e = 0; e < j->fill[q * j->segments + s]; e++) heap_offer(h, &n, j->k, part[e]);
+            }
+        }
+        qsort(h, n, sizeof(vknn_hit_t), hit_compare);
+        for (; n < j->out_k; n++) h[n] = (vknn_hit_t){ (size_t)-1, INFINITY };
+    }
+}
+
+/*
+ * Pads the queries to the row stride, takes their norms and splits the
+ * work: serial below vec_parallel_threshold() multiply-adds, else query
+ * groups of whole tiles over the threads and, if that leaves threads idle,
+ * row segments of at least VKNN_ROW_BLOCK rows within each group.
+ */
+static bool knn_run(knn_job_t *j, const float *queries)
+{
+    const vcoll_t *c = j->c;
+    size_t nq = j->nq, stride = c->stride;
+    if (nq > (size_t)-1 / sizeof(float) / (stride + 1)) return false;
+    float *q = aligned_alloc(VEC_ALIGN, (nq * (stride + 1) * sizeof(float) + VEC_ALIGN - 1) / VEC_ALIGN * VEC_ALIGN);
+    if (!q) return false;
+    float *qn = q + nq * stride;
+    for (size_t i = 0; i < nq; i++) {
+        float *row = q + i * stride;
+        memcpy(row, queries + i * c->dim, c->dim * sizeof(float));
+        memset(row + c->dim, 0, (stride - c->dim) * sizeof(float));
+        const float *self = row;
+        knn_kernels()->tile1(row, stride, 1, &self, &qn[i]);
+    }
+    j->q = q;
+    j->qn = qn;
+
+    size_t threads = vec_parallel_threads(), tiles = (nq + VKNN_QUERY_TILE - 1) / VKNN_QUERY_TILE;
+    size_t work = c->count * stride;
+    bool parallel = threads > 1 && work >= vec_parallel_threshold() / nq;
+    j->group = tiles * VKNN_QUERY_TILE;
+    j->segments = 1;
+    if (parallel) {
+        size_t groups = tiles < threads ? tiles : threads;
+        j->group = (tiles + groups - 1) / groups * VKNN_QUERY_TILE;
+        groups = (nq + j->group - 1) / j->group;
+        size_t segments = threads / groups, most = c->count / VKNN_ROW_BLOCK;
+        j->segments = segments < most ? segments : (most ? most : 1);
+    }
+    size_t tasks = j->group ? (nq + j->group - 1) / j->group * j->segments : 0;
+
+    bool ok = true;
+    vknn_hit_t *scratch = NULL;
+    if (!j->dist) {
+        // one segment builds its heaps in place in out
+        j->hstride = j->out_k;
+        j->heaps = j->out;
+        if (j->segments > 1) {
+            j->hstride = j->k;
+            scratch = malloc(nq * j->segments * j->k * sizeof(vknn_hit_t));
+            j->heaps = scratch;
+        }
+        j->fill = calloc(nq * j->segments, sizeof(size_t));
+        ok = j->fill && (j->segments == 1 || scratch);
+    }
+    if (ok) {
+        if (parallel) vec_parallel_tasks(tasks, knn_task, j);
+        else knn_task(j, 0, tasks);
+        if (!j->dist) vec_parallel_for(nq, knn_finish, j);
+    }
+    free(j->fill);
+    free(scratch);
+    free(q);
+    return ok;
+}
+
+bool vcoll_distances(const vcoll_t *c, vknn_metric_t metric, const float *query, float *out)
+{
+    if (!c->allocator) return false;
+    knn_job_t j = { c, metric, NULL, NULL, 1, 0, 1, 0, 0, NULL, NULL, out, NULL, 0 };
+    return knn_run(&j, query);
+}
+
+size_t vcoll_search(const vcoll_t *c, vknn_metric_t metric, const float *query, size_t k, vknn_hit_t *out)
+{
+    if (!vcoll_search_batch(c, metric, query, 1, k, out)) return 0;
+    return k < c->count ? k : c->count;
+}
+
+bool vcoll_search_batch(const vcoll_t *c, vknn_metric_t metric, const float *queries, size_t nq, size_t k, vknn_hit_t *out)
+{
+    if (!c->allocator) return false;
+    if (k == 0 || nq == 0) return true;
+    knn_job_t j = { c, metric, NULL, NULL, nq, 0, 1, k < c->count ? k : c->count, 0, NULL, NULL, NULL, out, k };
+    return knn_run(&j, queries);
+}
+
+/****************************************************PAIRS****************************************************/
+
+/**
+ * @brief Euclidean distance between two vectors of the same size, squares
+ *        summed in VKNN_LANES lanes as the collection kernels do. NAN when
+ *        the sizes differ.
+ */
+float vec_distance(vector_t v1, vector_t v2)
+{
+    if (v1.size != v2.size) return NAN;
+    float lane[VKNN_LANES] = { 0 };
+    for (size_t i = 0; i < v1.size; i++) {
+        float d = v1.data[i] - v2.data[i];
+        lane[i % VKNN_LANES] += d * d;
+    }
+    return sqrt_exact_f(combine_lanes(lane));
+}
+
+/**
+ * @brief Angle between two vectors in radians, in [0, pi]. NAN when the
+ *        sizes differ or either vector is zero.
+ */
+float vec_angle(vector_t v1, vector_t v2)
+{
+    if (v1.size != v2.size) return NAN;
+    float dot[VKNN_LANES] = { 0 }, n1[VKNN_LANES] = { 0 }, n2[VKNN_LANES] = { 0 };
+    for (size_t i = 0; i < v1.size; i++) {
+        dot[i % VKNN_LANES] += v1.data[i] * v2.data[i];
+        n1[i % VKNN_LANES] += v1.data[i] * v1.data[i];
+        n2[i % VKNN_LANES] += v2.data[i] * v2.data[i];
+    }
+    float d = combine_lanes(dot), a = combine_lanes(n1), b = combine_lanes(n2);
+    if (!(a > 0.0f) || !(b > 0.0f)) return NAN;
+    return acosf(CLAMP(d / (sqrt_exact_f(a) * sqrt_exact_f(b)), -1.0f, 1.0f));
+}
@@ -0,0 +1,83 @@
+#include <vec_map.h>
+
+/*
+ * The function-pointer maps declared in vec.h: the generic fallback for a
+ * function only known at run time. They share the vector front ends and
+ * the pool split with the VEC_MAPn_DEFINE maps but call through the
+ * pointer for every element; define a map with the macros when the
+ * expression is known at compile time.
+ */
+
+typedef float (*map1_f)(float);
+typedef float (*map2_f)(float, float);
+typedef float (*map3_f)(float, float, float);
+typedef float (*map4_f)(float, float, float, float);
+typedef float (*map5_f)(float, float, float, float, float);
+
+static void vec_map_chunk(void *ctx, size_t begin, size_t end)
+{
+    const vec_map_ctx_t *c = ctx;
+    map1_f f = (map1_f)c->fn;
+    for (size_t i = begin; i < end; i++) c->dst[i] = f(c->in[0][i]);
+}
+
+static void vec_map_scalar_chunk(void *ctx, size_t begin, size_t end)
+{
+    const vec_map_ctx_t *c = ctx;
+    map2_f f = (map2_f)c->fn;
+    for (size_t i = begin; i < end; i++) c->dst[i] = f(c->in[0][i], c->s);
+}
+
+static void vec_map2_chunk(void *ctx, size_t begin, size_t end)
+{
+    const vec_map_ctx_t *c = ctx;
+    map2_f f = (map2_f)c->fn;
+    for (size_t i = begin; i < end; i++) c->dst[i] = f(c->in[0][i], c->in[1][i]);
+}
+
+static void vec_map3_chunk(void *ctx, size_t begin, size_t end)
+{
+    const vec_map_ctx_t *c = ctx;
+    map3_f f = (map3_f)c->fn;
+    for (size_t i = begin; i < end; i++) c->dst[i] = f(c->in[0][i], c->in[1][i], c->in[2][i]);
+}
+
+static void vec_map4_chunk(void *ctx, size_t begin, size_t end)
+{
+    const vec_map_ctx_t *c = ctx;
+    map4_f f = (map4_f)c->fn;
+    for (size_t i = begin; i < end; i++) {
+        c->dst[i] = f(c->in[0][i], c->in[1][i], c->in[2][i], c->in[3][i]);
+    }
+}
+
+static void vec_map5_chunk(void *ctx, size_t begin, size_t end)
+{
+    const vec_map_ctx_t *c = ctx;
+    map5_f f = (map5_f)c->fn;
+    for (size_t i = begin; i < end; i++) {
+        c->dst[i] = f(c->in[0][i], c->in[1][i], c->in[2][i], c->in[3][i], c->in[4][i]);
+    }
+}
+
+VEC_MAP_FRONT_(, vec_map, (, map1_f func), true, c.fn = (void (*)(void))func)
+
+VEC_MAP_FRONT_(, vec_map_scalar, (, float scalar, map2_f func), true,
+               (c.s = scalar, c.fn = (void (*)(void))func))
+
+VEC_MAP_FRONT_(, vec_map2, (, vector_t v2, map2_f func), v2.size == v.size,
+               (c.in[1] = v2.data, c.fn = (void (*)(void))func))
+
+VEC_MAP_FRONT_(, vec_map3, (, vector_t v2, vector_t v3, map3_f func),
+               v2.size == v.size && v3.size == v.size,
+               (c.in[1] = v2.data, c.in[2] = v3.data, c.fn = (void (*)(void))func))
+
+VEC_MAP_FRONT_(, vec_map4, (, vector_t v2, vector_t v3, vector_t v4, map4_f func),
+               v2.size == v.size && v3.size == v.size && v4.size == v.size,
+               (c.in[1] = v2.data, c.in[2] = v3.data, c.in[3] = v4.data,
+                c.fn = (void (*)(void))func))
+
+VEC_MAP_FRONT_(, vec_map5, (, vector_t v2, vector_t v3, vector_t v4, vector_t v5, map5_f func),
+               v2.size == v.size && v3.size == v.size && v4.size == v.size && v5.size == v.size,
+               (c.in[1] = v2.data, c.in[2] = v3.data, c.in[3] = v4.data, c.in[4] = v5.data,
+                c.fn = (void (*)(void))func))
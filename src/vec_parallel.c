@@ -0,0 +1,470 @@
+#include <vec_parallel.h>
+#include <stdatomic.h>
+
+#if defined(VEC_PARALLEL_PTHREADS)
+    #include <pthread.h>
+    #include <sched.h>
+    #include <unistd.h>
+#endif
+
+/****************************************************COMBINE**************************************************/
+
+/*
+ * Serial and parallel reductions both feed their chunk partials through the
+ * cascade (see vec_cascade_t), so the result only depends on n.
+ */
+void vec_cascade_push(vec_cascade_t *c, double v)
+{
+    c->sum[c->top] = v;
+    c->level[c->top] = 0;
+    c->top++;
+    while (c->top >= 2 && c->level[c->top - 1] == c->level[c->top - 2]) {
+        c->sum[c->top - 2] += c->sum[c->top - 1];
+        c->level[c->top - 2]++;
+        c->top--;
+    }
+}
+
+double vec_cascade_finish(const vec_cascade_t *c)
+{
+    if (c->top == 0) return 0.0;
+    double acc = c->sum[c->top - 1];
+    for (int i = c->top - 2; i >= 0; i--) acc = c->sum[i] + acc;
+    return acc;
+}
+
+static size_t chunk_count(size_t n)
+{
+    return (n + VEC_PARALLEL_CHUNK - 1) / VEC_PARALLEL_CHUNK;
+}
+
+static atomic_size_t threshold = VEC_PARALLEL_THRESHOLD;
+
+void vec_parallel_set_threshold(size_t elements)
+{
+    atomic_store(&threshold, elements);
+}
+
+size_t vec_parallel_threshold(void)
+{
+    return atomic_load(&threshold);
+}
+
+/*****************************************************POOL****************************************************/
+
+/* one call of the job: chunk `index` covering [begin, end) */
+typedef void (*job_fn)(void *ctx, size_t index, size_t begin, size_t end);
+
+#if defined(VEC_PARALLEL_PTHREADS)
+
+/* chunk range [begin, end) owned by one thread, packed so that the owner
+ * popping from the front and thieves splitting off the back both go
+ * through a single CAS; padded to its own cache line */
+typedef struct {
+    _Atomic unsigned long long range;
+    char pad[64 - sizeof(unsigned long long)];
+} slot_t;
+
+#define RANGE_PACK(b, e) (((unsigned long long)(b) << 32) | (unsigned long long)(e))
+#define RANGE_BEGIN(r) ((size_t)((r) >> 32))
+#define RANGE_END(r) ((size_t)((r) & 0xffffffffULL))
+
+static struct {
+    unsigned int count;         // threads per job, caller included; 0 = not started
+    pthread_t *threads;         // count - 1 workers
+    slot_t *slots;              // count slots, slot 0 belongs to the caller
+
+    pthread_mutex_t lock;       // guards everything below up to `active`
+    pthread_cond_t wake;
+    unsigned long generation;   // bumped for every job
+    bool open;                  // a job is accepting workers
+    bool stop;
+
+    job_fn fn;
+    void *ctx;
+    size_t n;
+    atomic_size_t done;         // chunks finished in the current job
+    atomic_uint active;         // workers inside the current job
+
+    pthread_mutex_t submit;     // one job at a time
+} pool = { 0, NULL, NULL, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER,
+           0, false, false, NULL, NULL, 0, 0, 0, PTHREAD_MUTEX_INITIALIZER };
+
+static _Thread_local bool in_job = false;
+static _Thread_local unsigned int worker_index = 0;
+
+static bool take_own(slot_t *s, size_t *index)
+{
+    unsigned long long r = atomic_load(&s->range);
+    while (RANGE_BEGIN(r) < RANGE_END(r)) {
+        if (atomic_compare_exchange_weak(&s->range, &r, RANGE_PACK(RANGE_BEGIN(r) + 1, RANGE_END(r)))) {
+            *index = RANGE_BEGIN(r);
+            return true;
+        }
+    }
+    return false;
+}
+
+/* move the back half (at least one chunk) of a victim's range into `self` */
+static bool steal(slot_t *victim, slot_t *self)
+{
+    unsigned long long r = atomic_load(&victim->range);
+    while (RANGE_BEGIN(r) < RANGE_END(r)) {
+        size_t b = RANGE_BEGIN(r), e = RANGE_END(r);
+        size_t mid = e - (e - b + 1) / 2;
+        if (atomic_compare_exchange_weak(&victim->range, &r, RANGE_PACK(b, mid))) {
+            atomic_store(&self->range, RANGE_PACK(mid, e));
+            return true;
+        }
+    }
+    return false;
+}
+
+static void run_job(unsigned int self, job_fn fn, void *ctx, size_t n)
+{
+    slot_t *own = &pool.slots[self];
+    for (;;) {
+        size_t index;
+        while (take_own(own, &index)) {
+            size_t begin = index * VEC_PARALLEL_CHUNK;
+            size_t end = begin + VEC_PARALLEL_CHUNK < n ? begin + VEC_PARALLEL_CHUNK : n;
+            fn(ctx, index, begin, end);
+            atomic_fetch_add(&pool.done, 1);
+        }
+        bool stolen = false;
+        for (unsigned int k = 1; k < pool.count && !stolen; k++) {
+            stolen = steal(&pool.slots[(self + k) % pool.count], own);
+        }
+        if (!stolen) return;
+    }
+}
+
+static void *worker_main(void *arg)
+{
+    unsigned int self = (unsigned int)(size_t)arg;
+    unsigned long seen = 0;
+    in_job = true;              // nested parallel calls from a chunk run serially
+    worker_index = self;
+
+    pthread_mutex_lock(&pool.lock);
+    for (;;) {
+        while (pool.generation == seen && !pool.stop) pthread_cond_wait(&pool.wake, &pool.lock);
+        if (pool.stop) break;
+        seen = pool.generation;
+        if (!pool.open) continue;       // woke up after the job was already finished
+
+        job_fn fn = pool.fn;
+        void *ctx = pool.ctx;
+        size_t n = pool.n;
+        atomic_fetch_add(&pool.active, 1);
+        pthread_mutex_unlock(&pool.lock);
+
+        run_job(self, fn, ctx, n);
+
+        atomic_fetch_sub(&pool.active, 1);
+        pthread_mutex_lock(&pool.lock);
+    }
+    pthread_mutex_unlock(&pool.lock);
+    return NULL;
+}
+
+/* Run fn over every chunk of [0, n) on the pool. Returns false (and runs
+ * nothing) if the pool is off, busy, or this is a nested call. */
+static bool pool_run(size_t n, job_fn fn, void *ctx)
+{
+    if (in_job || pool.count < 2) return false;
+    if (pthread_mutex_trylock(&pool.submit) != 0) return false;
+    if (pool.count < 2) {
+        pthread_mutex_unlock(&pool.submit);
+        return false;
+    }
+
+    size_t chunks = chunk_count(n);
+    for (unsigned int t = 0; t < pool.count; t++) {
+        size_t b = chunks * t / pool.count, e = chunks * (t + 1) / pool.count;
+        atomic_store(&pool.slots[t].range, RANGE_PACK(b, e));
+    }
+    atomic_store(&pool.done, 0);
+
+    pthread_mutex_lock(&pool.lock);
+    pool.fn = fn;
+    pool.ctx = ctx;
+    pool.n = n;
+    pool.open = true;
+    pool.generation++;
+    pthread_cond_broadcast(&pool.wake);
+    pthread_mutex_unlock(&pool.lock);
+
+    in_job = true;
+    run_job(0, fn, ctx, n);
+    in_job = false;
+
+    while (atomic_load(&pool.done) < chunks) sched_yield();
+    pthread_mutex_lock(&pool.lock);
+    pool.open = false;
+    pthread_mutex_unlock(&pool.lock);
+    while (atomic_load(&pool.active) != 0) sched_yield();
+
+    pthread_mutex_unlock(&pool.submit);
+    return true;
+}
+
+static void pool_stop_locked(void)
+{
+    if (pool.count == 0) return;
+    pthread_mutex_lock(&pool.lock);
+    pool.stop = true;
+    pthread_cond_broadcast(&pool.wake);
+    pthread_mutex_unlock(&pool.lock);
+    for (unsigned int t = 0; t + 1 < pool.count; t++) pthread_join(pool.threads[t], NULL);
+    free(pool.threads);
+    free(pool.slots);
+    pool.threads = NULL;
+    pool.slots = NULL;
+    pool.count = 0;
+    pool.stop = false;
+}
+
+/**
+ * @brief Start (or restart with a new size) the worker pool. `threads`
+ *        counts the calling thread; 0 takes $CMATH_THREADS, else the
+ *        number of online CPUs. Returns false if threads could not be
+ *        created, leaving the pool off.
+ */
+bool vec_parallel_init(unsigned int threads)
+{
+    if (threads == 0) {
+        const char *env = getenv("CMATH_THREADS");
+        long v = env ? strtol(env, NULL, 10) : 0;
+        if (v <= 0) v = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = v > 0 ? (unsigned int)v : 1;
+    }
+    if (threads > VEC_PARALLEL_MAX_THREADS) threads = VEC_PARALLEL_MAX_THREADS;
+
+    pthread_mutex_lock(&pool.submit);
+    pool_stop_locked();
+
+    bool ok = true;
+    if (threads > 1) {
+        pool.threads = malloc((threads - 1) * sizeof(pthread_t));
+        pool.slots = aligned_alloc(64, threads * sizeof(slot_t));
+        ok = pool.threads && pool.slots;
+        unsigned int started = 0;
+        while (ok && started + 1 < threads) {
+            ok = pthread_create(&pool.threads[started], NULL, worker_main, (void *)(size_t)(started + 1)) == 0;
+            if (ok) started++;
+        }
+        pool.count = started + 1;
+        if (!ok) pool_stop_locked();
+        else pool.count = threads;
+    }
+
+    pthread_mutex_unlock(&pool.submit);
+    return ok;
+}
+
+/**
+ * @brief Stop and join all workers. Safe to call when the pool is off.
+ */
+void vec_parallel_shutdown(void)
+{
+    pthread_mutex_lock(&pool.submit);
+    pool_stop_locked();
+    pthread_mutex_unlock(&pool.submit);
+}
+
+unsigned int vec_parallel_threads(void)
+{
+    return pool.count > 1 ? pool.count : 1;
+}
+
+/**
+ * @brief Index of the calling thread in the pool: 1 .. count-1 on a worker,
+ *        0 on any other thread. No two threads of one parallel call share
+ *        an index, so chunks can use it to pick per-thread scratch.
+ */
+unsigned int vec_parallel_worker(void)
+{
+    return worker_index;
+}
+
+#else // !VEC_PARALLEL_PTHREADS: no thread support in this build, always serial
+
+static bool pool_run(size_t n, job_fn fn, void *ctx)
+{
+    (void)n;
+    (void)fn;
+    (void)ctx;
+    return false;
+}
+
+bool vec_parallel_init(unsigned int threads)
+{
+    return threads <= 1;
+}
+
+void vec_parallel_shutdown(void)
+{
+}
+
+unsigned int vec_parallel_threads(void)
+{
+    return 1;
+}
+
+unsigned int vec_parallel_worker(void)
+{
+    return 0;
+}
+
+#endif // VEC_PARALLEL_PTHREADS
+
+/**************************************************FRONT ENDS*************************************************/
+
+typedef struct {
+    vec_parallel_fn fn;
+    void *ctx;
+} for_job_t;
+
+static void for_chunk(void *ctx, size_t index, size_t begin, size_t end)
+{
+    const for_job_t *j = ctx;
+    (void)index;
+    j->fn(j->ctx, begin, end);
+}
+
+/**
+ * @brief Call fn on chunks covering [0, n), spread over the pool when it is
+ *        running and n >= vec_parallel_threshold(); otherwise fn(ctx, 0, n).
+ *        Chunks must be independent of each other.
+ */
+void vec_parallel_for(size_t n, vec_parallel_fn fn, void *ctx)
+{
+    if (n >= vec_parallel_threshold() && n > VEC_PARALLEL_CHUNK) {
+        for_job_t j = { fn, ctx };
+        if (pool_run(n, for_chunk, &j)) return;
+    }
+    fn(ctx, 0, n);
+}
+
+static void task_chunk(void *ctx, size_t index, size_t begin, size_t end)
+{
+    const for_job_t *j = ctx;
+    (void)begin;
+    (void)end;
+    j->fn(j->ctx, index, index + 1);
+}
+
+/**
+ * @brief Call fn(ctx, t, t + 1) for every task t < tasks, spread over the
+ *        pool when it is running; otherwise fn(ctx, 0, tasks). Unlike
+ *        vec_parallel_for there is no size threshold: each task is assumed
+ *        to be worth a thread, the caller decides when to go parallel.
+ */
+void vec_parallel_tasks(size_t tasks, vec_parallel_fn fn, void *ctx)
+{
+    if (tasks > 1 && tasks <= 0xffffffffu && tasks <= (size_t)-1 / VEC_PARALLEL_CHUNK) {
+        for_job_t j = { fn, ctx };
+        if (pool_run(tasks * VEC_PARALLEL_CHUNK, task_chunk, &j)) return;
+    }
+    fn(ctx, 0, tasks);
+}
+
+typedef struct {
+    vec_parallel_reduce_fn fn;
+    void *ctx;
+    double *partials;
+} reduce_job_t;
+
+static void reduce_chunk(void *ctx, size_t index, size_t begin, size_t end)
+{
+    const reduce_job_t *j = ctx;
+    j->partials[index] = j->fn(j->ctx, begin, end);
+}
+
+/**
+ * @brief Sum of fn(ctx, begin, end) over the VEC_PARALLEL_CHUNK chunks of
+ *        [0, n), combined pairwise in chunk order. The chunking does not
+ *        depend on the pool, so serial and parallel runs return the same
+ *        bits. A single chunk returns fn(ctx, 0, n) as is.
+ */
+double vec_parallel_reduce(size_t n, vec_parallel_reduce_fn fn, void *ctx)
+{
+    size_t chunks = chunk_count(n);
+    if (chunks <= 1) return fn(ctx, 0, n);
+
+    vec_cascade_t c = { .top = 0 };
+    if (n >= vec_parallel_threshold()) {
+        reduce_job_t j = { fn, ctx, malloc(chunks * sizeof(double)) };
+        if (j.partials && pool_run(n, reduce_chunk, &j)) {
+            for (size_t i = 0; i < chunks; i++) vec_cascade_push(&c, j.partials[i]);
+            free(j.partials);
+            return vec_cascade_finish(&c);
+        }
+        free(j.partials);
+    }
+
+    for (size_t begin = 0; begin < n; begin += VEC_PARALLEL_CHUNK) {
+        size_t end = begin + VEC_PARALLEL_CHUNK < n ? begin + VEC_PARALLEL_CHUNK : n;
+        vec_cascade_push(&c, fn(ctx, begin, end));
+    }
+    return vec_cascade_finish(&c);
+}
+
+typedef struct {
+    vec_binary_kernel_f binary;
+    vec_scalar_kernel_f scalar;
+    float *dst;
+    const float *a, *b;
+    float s;
+} kernel_job_t;
+
+static void kernel_chunk(void *ctx, size_t begin, size_t end)
+{
+    const kernel_job_t *j = ctx;
+    if (j->binary) j->binary(j->dst + begin, j->a + begin, j->b + begin, end - begin);
+    else j->scalar(j->dst + begin, j->a + begin, j->s, end - begin);
+}
+
+/**
+ * @brief Element-wise kernel over [0, n), split over the pool when enabled.
+ *        Same aliasing rules as the kernel itself.
+ */
+void vec_parallel_binary(vec_binary_kernel_f k, float *dst, const float *a, const float *b, size_t n)
+{
+    kernel_job_t j = { k, NULL, dst, a, b, 0.0f };
+    vec_parallel_for(n, kernel_chunk, &j);
+}
+
+void vec_parallel_scalar(vec_scalar_kernel_f k, float *dst, const float *a, float s, size_t n)
+{
+    kernel_job_t j = { NULL, k, dst, a, NULL, s };
+    vec_parallel_for(n, kernel_chunk, &j);
+}
+
+typedef struct {
+    vec_dbinary_kernel_f binary;
+    vec_dscalar_kernel_f scalar;
+    double *dst;
+    const double *a, *b;
+    double s;
+} dkernel_job_t;
+
+static void dkernel_chunk(void *ctx, size_t begin, size_t end)
+{
+    const dkernel_job_t *j = ctx;
+    if (j->binary) j->binary(j->dst + begin, j->a + begin, j->b + begin, end - begin);
+    else j->scalar(j->dst + begin, j->a + begin, j->s, end - begin);
+}
+
+void vec_parallel_dbinary(vec_dbinary_kernel_f k, double *dst, const double *a, const double *b, size_t n)
+{
+    dkernel_job_t j = { k, NULL, dst, a, b, 0.0 };
+    vec_parallel_for(n, dkernel_chunk, &j);
+}
+
+void vec_parallel_dscalar(vec_dscalar_kernel_f k, double *dst, const double *a, double s, size_t n)
+{
+    dkernel_job_t j = { NULL, k, dst, a, NULL, s };
+    vec_parallel_for(n, dkernel_chunk, &j);
+}
@@ -0,0 +1,379 @@
+#include <vec_quat.h>
+#include <math_core.h>
+#include <math_batch.h>
+#include <vec_parallel.h>
+
+/*
+ * The single-quaternion functions and the _soa kernels share the inline
+ * helpers below, and the kernels take their sines from
+ * fast_sincosf_poly_array, which matches fast_sincosf_poly bit-for-bit; so
+ * element i of a batch is exactly what the scalar call returns.
+ */
+
+static inline quat_t quat_scale(quat_t q, float s)
+{
+    quat_t r = { q.x * s, q.y * s, q.z * s, q.w * s };
+    return r;
+}
+
+static inline quat_t quat_load(quat_soa_t q, size_t i)
+{
+    quat_t r = { q.x[i], q.y[i], q.z[i], q.w[i] };
+    return r;
+}
+
+static inline void quat_store(quat_soa_t q, size_t i, quat_t v)
+{
+    q.x[i] = v.x, q.y[i] = v.y, q.z[i] = v.z, q.w[i] = v.w;
+}
+
+// rotation by the angle whose half has sine s and cosine c, about (x, y, z)
+static inline quat_t axis_angle_finish(float x, float y, float z, float s, float c)
+{
+    float len2 = x * x + y * y + z * z;
+    if (len2 == 0.0f) return quat_identity();
+    float k = s / sqrt_exact_f(len2);
+    quat_t q = { x * k, y * k, z * k, c };
+    return q;
+}
+
+/*
+ * acos on [0, 1], cephes style: the asin polynomial on d, or on the half
+ * angle sqrt((1 - d) / 2) above 0.5, where acos(d) = 2 asin of it.
+ */
+static inline float asin_poly(float z)
+{
+    return (((4.2163199048e-2f * z + 2.4181311049e-2f) * z + 4.5470025998e-2f) * z
+            + 7.4953002686e-2f) * z + 1.6666752422e-1f;
+}
+
+static inline float acos_unit(float d)
+{
+    if (d > 0.5f) {
+        float z = 0.5f * (1.0f - d);
+        float s = sqrt_exact_f(z);
+        return 2.0f * (s + s * z * asin_poly(z));
+    }
+    return 1.57079637f - (d + d * (d * d) * asin_poly(d * d));
+}
+
+/*
+ * Slerp in two halves around the sines: the first picks the shorter arc
+ * (sign) and the three angles (1 - t) theta, t theta, theta, all zero when
+ * the quaternions are too close for the sine ratio to be accurate; the
+ * second combines. theta == 0 means nlerp.
+ */
+static inline void slerp_angles(quat_t a, quat_t b, float t, float *sign, float *a0, float *a1, float *th)
+{
+    float d = quat_dot(a, b);
+    *sign = d < 0.0f ? -1.0f : 1.0f;
+    d = d < 0.0f ? -d : d;
+    if (d > QUAT_SLERP_LINEAR) {
+        *a0 = *a1 = *th = 0.0f;
+        return;
+    }
+    *th = acos_unit(d);
+    *a0 = (1.0f - t) * *th;
+    *a1 = t * *th;
+}
+
+static inline quat_t nlerp_signed(quat_t a, quat_t b, float t, float sign)
+{
+    float wa = 1.0f - t, wb = sign * t;
+    quat_t r = { wa * a.x + wb * b.x, wa * a.y + wb * b.y, wa * a.z + wb * b.z, wa * a.w + wb * b.w };
+    return quat_normalize(r);
+}
+
+static inline quat_t slerp_finish(quat_t a, quat_t b, float t, float sign, float th,
+                                  float s0, float s1, float sth)
+{
+    if (th == 0.0f) return nlerp_signed(a, b, t, sign);
+    float wa = s0 / sth, wb = (sign * s1) / sth;
+    quat_t r = { wa * a.x + wb * b.x, wa * a.y + wb * b.y, wa * a.z + wb * b.z, wa * a.w + wb * b.w };
+    return r;
+}
+
+/****************************************************SCALAR***************************************************/
+
+quat_t quat_identity(void)
+{
+    quat_t q = { 0.0f, 0.0f, 0.0f, 1.0f };
+    return q;
+}
+
+quat_t quat_from_axis_angle(float x, float y, float z, float angle)
+{
+    float s, c;
+    fast_sincosf_poly(0.5f * angle, &s, &c);
+    return axis_angle_finish(x, y, z, s, c);
+}
+
+quat_t quat_from_euler(float pitch, float yaw, float roll)
+{
+    quat_t qx = quat_from_axis_angle(1.0f, 0.0f, 0.0f, pitch);
+    quat_t qy = quat_from_axis_angle(0.0f, 1.0f, 0.0f, yaw);
+    quat_t qz = quat_from_axis_angle(0.0f, 0.0f, 1.0f, roll);
+    return quat_mul(qy, quat_mul(qx, qz));
+}
+
+/*
+ * Shepperd's method: take the square root of the largest of w^2, x^2, y^2,
+ * z^2 (four times each, from the trace and diagonal) so the divisor is
+ * never small.
+ */
+quat_t quat_from_rot3(const rot3_t *r)
+{
+    const float *m = r->m;
+    float tr = m[0] + m[4] + m[8];
+    quat_t q;
+    if (tr > 0.0f) {
+        float s = 2.0f * sqrt_exact_f(tr + 1.0f);
+        q.w = 0.25f * s, q.x = (m[7] - m[5]) / s, q.y = (m[2] - m[6]) / s, q.z = (m[3] - m[1]) / s;
+    } else if (m[0] > m[4] && m[0] > m[8]) {
+        float s = 2.0f * sqrt_exact_f(1.0f + m[0] - m[4] - m[8]);
+        q.w = (m[7] - m[5]) / s, q.x = 0.25f * s, q.y = (m[1] + m[3]) / s, q.z = (m[2] + m[6]) / s;
+    } else if (m[4] > m[8]) {
+        float s = 2.0f * sqrt_exact_f(1.0f + m[4] - m[0] - m[8]);
+        q.w = (m[2] - m[6]) / s, q.x = (m[1] + m[3]) / s, q.y = 0.25f * s, q.z = (m[5] + m[7]) / s;
+    } else {
+        float s = 2.0f * sqrt_exact_f(1.0f + m[8] - m[0] - m[4]);
+        q.w = (m[3] - m[1]) / s, q.x = (m[2] + m[6]) / s, q.y = (m[5] + m[7]) / s, q.z = 0.25f * s;
+    }
+    return quat_normalize(q);
+}
+
+quat_t quat_mul(quat_t a, quat_t b)
+{
+    quat_t r = {
+        a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+        a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+        a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+        a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z
+    };
+    return r;
+}
+
+quat_t quat_conjugate(quat_t q)
+{
+    quat_t r = { -q.x, -q.y, -q.z, q.w };
+    return r;
+}
+
+quat_t quat_normalize(quat_t q)
+{
+    float len2 = quat_dot(q, q);
+    if (len2 == 0.0f) return quat_identity();
+    return quat_scale(q, 1.0f / sqrt_exact_f(len2));
+}
+
+float quat_dot(quat_t a, quat_t b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
+
+quat_t quat_nlerp(quat_t a, quat_t b, float t)
+{
+    return nlerp_signed(a, b, t, quat_dot(a, b) < 0.0f ? -1.0f : 1.0f);
+}
+
+quat_t quat_slerp(quat_t a, quat_t b, float t)
+{
+    float sign, a0, a1, th, s0, s1, sth, c;
+    slerp_angles(a, b, t, &sign, &a0, &a1, &th);
+    fast_sincosf_poly(a0, &s0, &c);
+    fast_sincosf_poly(a1, &s1, &c);
+    fast_sincosf_poly(th, &sth, &c);
+    return slerp_finish(a, b, t, sign, th, s0, s1, sth);
+}
+
+rot3_t rot3_from_quat(quat_t q)
+{
+    float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+    rot3_t r = { {
+        1.0f - 2.0f * (yy + zz), 2.0f * (xy - wz), 2.0f * (xz + wy),
+        2.0f * (xy + wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz - wx),
+        2.0f * (xz - wy), 2.0f * (yz + wx), 1.0f - 2.0f * (xx + yy)
+    } };
+    return r;
+}
+
+// the 3x4 form the vec_xform.h direction kernels take
+static inline void rot3_to_3x4(const rot3_t *r, float *m)
+{
+    for (int i = 0; i < 3; i++) {
+        m[4 * i] = r->m[3 * i], m[4 * i + 1] = r->m[3 * i + 1], m[4 * i + 2] = r->m[3 * i + 2];
+        m[4 * i + 3] = 0.0f;
+    }
+}
+
+// one vector, in the XF_LINEAR order of vec_xform.c
+static inline void rot3_apply(const float *m, float *x, float *y, float *z)
+{
+    float vx = *x, vy = *y, vz = *z;
+    *x = m[0] * vx + m[1] * vy + m[2] * vz;
+    *y = m[3] * vx + m[4] * vy + m[5] * vz;
+    *z = m[6] * vx + m[7] * vy + m[8] * vz;
+}
+
+void quat_rotate_point(quat_t q, float *v)
+{
+    rot3_t r = rot3_from_quat(q);
+    rot3_apply(r.m, v, v + 1, v + 2);
+}
+
+/****************************************************BATCHES**************************************************/
+
+void quat_rotate_aos(quat_t q, float *v, size_t n)
+{
+    rot3_t r = rot3_from_quat(q);
+    float m[12];
+    rot3_to_3x4(&r, m);
+    vec3_transform_directions(m, v, v, n);
+}
+
+void quat_rotate_soa(quat_t q, vec3_soa_t v, size_t n)
+{
+    rot3_t r = rot3_from_quat(q);
+    rot3_rotate_soa(&r, v, n);
+}
+
+void rot3_rotate_soa(const rot3_t *r, vec3_soa_t v, size_t n)
+{
+    float m[12];
+    rot3_to_3x4(r, m);
+    vec3_transform_directions_soa(m, v, v, n);
+}
+
+typedef struct {
+    quat_soa_t dst, a, b;
+    vec3_soa_t v;
+    const float *angle;
+    float t;
+} quat_job_t;
+
+static void rotate_each_chunk(void *ctx, size_t begin, size_t end)
+{
+    const quat_job_t *j = ctx;
+    for (size_t i = begin; i < end; i++) {
+        rot3_t r = rot3_from_quat(quat_load(j->a, i));
+        rot3_apply(r.m, j->v.x + i, j->v.y + i, j->v.z + i);
+    }
+}
+
+static void axis_angle_chunk(void *ctx, size_t begin, size_t end)
+{
+    const quat_job_t *j = ctx;
+    float half[QUAT_BLOCK], s[QUAT_BLOCK], c[QUAT_BLOCK];
+    for (size_t i0 = begin; i0 < end; i0 += QUAT_BLOCK) {
+        size_t m = end - i0 < QUAT_BLOCK ? end - i0 : QUAT_BLOCK;
+        for (size_t k = 0; k < m; k++) half[k] = 0.5f * j->angle[i0 + k];
+        fast_sincosf_poly_array(s, c, half, m);
+        for (size_t k = 0; k < m; k++) {
+            size_t i = i0 + k;
+            quat_store(j->dst, i, axis_angle_finish(j->v.x[i], j->v.y[i], j->v.z[i], s[k], c[k]));
+        }
+    }
+}
+
+static void nlerp_chunk(void *ctx, size_t begin, size_t end)
+{
+    const quat_job_t *j = ctx;
+    for (size_t i = begin; i < end; i++) {
+        quat_store(j->dst, i, quat_nlerp(quat_load(j->a, i), quat_load(j->b, i), j->t));
+    }
+}
+
+// angles of a block in rows of m: (1 - t) theta, t theta, theta
+static void slerp_chunk(void *ctx, size_t begin, size_t end)
+{
+    const quat_job_t *j = ctx;
+    float ang[3 * QUAT_BLOCK], sn[3 * QUAT_BLOCK], cs[3 * QUAT_BLOCK], sign[QUAT_BLOCK];
+    for (size_t i0 = begin; i0 < end; i0 += QUAT_BLOCK) {
+        size_t m = end - i0 < QUAT_BLOCK ? end - i0 : QUAT_BLOCK;
+        for (size_t k = 0; k < m; k++) {
+            slerp_angles(quat_load(j->a, i0 + k), quat_load(j->b, i0 + k), j->t,
+                         &sign[k], &ang[k], &ang[m + k], &ang[2 * m + k]);
+        }
+        fast_sincosf_poly_array(sn, cs, ang, 3 * m);
+        for (size_t k = 0; k < m; k++) {
+            size_t i = i0 + k;
+            quat_store(j->dst, i, slerp_finish(quat_load(j->a, i), quat_load(j->b, i), j->t, sign[k],
+                                               ang[2 * m + k], sn[k], sn[m + k], sn[2 * m + k]));
+        }
+    }
+}
+
+void quat_rotate_each_soa(quat_soa_t q, vec3_soa_t v, size_t n)
+{
+    quat_job_t j = { .a = q, .v = v };
+    vec_parallel_for(n, rotate_each_chunk, &j);
+}
+
+void quat_from_axis_angle_soa(quat_soa_t dst, vec3_soa_t axis, const float *angle, size_t n)
+{
+    quat_job_t j = { .dst = dst, .v = axis, .angle = angle };
+    vec_parallel_for(n, axis_angle_chunk, &j);
+}
+
+void quat_nlerp_soa(quat_soa_t dst, quat_soa_t a, quat_soa_t b, float t, size_t n)
+{
+    quat_job_t j = { .dst = dst, .a = a, .b = b, .t = t };
+    vec_parallel_for(n, nlerp_chunk, &j);
+}
+
+void quat_slerp_soa(quat_soa_t dst, quat_soa_t a, quat_soa_t b, float t, size_t n)
+{
+    quat_job_t j = { .dst = dst, .a = a, .b = b, .t = t };
+    vec_parallel_for(n, slerp_chunk, &j);
+}
+
+/**************************************************VEC.H FORMS**********************************************/
+
+/*
+ * The vec_rotate_* functions declared in vec.h rotate a 3-element vector
+ * into a new one (VEC_UNDEFINED for any other size). vec_rotate_matrix
+ * takes a row-major 3x3 matrix, vec_rotate_quaternion normalizes (x, y, z, w).
+ */
+static vector_t rotate_copy(vector_t v, quat_t q)
+{
+    if (v.size != 3 || !v.data) return VEC_UNDEFINED;
+    vector_t r = vector_from_array(3, v.data);
+    if (r.data) quat_rotate_point(q, r.data);
+    return r;
+}
+
+vector_t vec_rotate(vector_t v, float angle, vector_t axis)
+{
+    if (axis.size != 3 || !axis.data) return VEC_UNDEFINED;
+    return rotate_copy(v, quat_from_axis_angle(axis.data[0], axis.data[1], axis.data[2], angle));
+}
+
+vector_t vec_rotate_x(vector_t v, float angle) { return rotate_copy(v, quat_from_axis_angle(1.0f, 0.0f, 0.0f, angle)); }
+vector_t vec_rotate_y(vector_t v, float angle) { return rotate_copy(v, quat_from_axis_angle(0.0f, 1.0f, 0.0f, angle)); }
+vector_t vec_rotate_z(vector_t v, float angle) { return rotate_copy(v, quat_from_axis_angle(0.0f, 0.0f, 1.0f, angle)); }
+
+vector_t vec_rotate_axis(vector_t v, float angle, float x, float y, float z)
+{
+    return rotate_copy(v, quat_from_axis_angle(x, y, z, angle));
+}
+
+vector_t vec_rotate_euler(vector_t v, float pitch, float yaw, float roll)
+{
+    return rotate_copy(v, quat_from_euler(pitch, yaw, roll));
+}
+
+vector_t vec_rotate_quaternion(vector_t v, float x, float y, float z, float w)
+{
+    quat_t q = { x, y, z, w };
+    return rotate_copy(v, quat_normalize(q));
+}
+
+vector_t vec_rotate_matrix(vector_t v, float *matrix)
+{
+    if (v.size != 3 || !v.data) return VEC_UNDEFINED;
+    vector_t r = vector_from_array(3, v.data);
+    if (r.data) rot3_apply(matrix, r.data, r.data + 1, r.data + 2);
+    return r;
+}
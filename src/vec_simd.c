@@ -0,0 +1,680 @@
+#include <vec_simd.h>
+#include <limits.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    #define VEC_SIMD_X86 1
+    #include <immintrin.h>
+#endif
+
+// true if p is aligned to `bytes` (a power of two)
+#define IS_ALIGNED(p, bytes) ((((size_t)(p)) & ((bytes) - 1)) == 0)
+
+/*
+ * Every kernel is generated once per (level, element type) from the same
+ * macros below. A "key" names the combination: scalar, sse2, avx2, avx512
+ * for float and the same with _d for double. Each key supplies T_<key>
+ * (element type), E_<key> (f or d, picks the shared helpers) and KT_<key>
+ * (its kernel table type); the SIMD keys add the intrinsics listed further
+ * down.
+ */
+#define CAT_(a, b) a##b
+#define CAT(a, b) CAT_(a, b)
+
+#define T_f float
+#define T_d double
+
+#define T_scalar   float
+#define E_scalar   f
+#define KT_scalar  vec_kernels_t
+#define T_scalar_d double
+#define E_scalar_d d
+#define KT_scalar_d vec_dkernels_t
+
+/****************************************************SCALAR***************************************************/
+
+#define SCALAR_BINARY(key, name, OP)                                                \
+static void name##_##key(T_##key *dst, const T_##key *a, const T_##key *b, size_t n) \
+{                                                                                   \
+    for (size_t i = 0; i < n; i++) {                                                \
+        dst[i] = a[i] OP b[i];                                                      \
+    }                                                                               \
+}
+
+#define SCALAR_SCALAR(key, name, OP)                                                \
+static void scalar_##name##_##key(T_##key *dst, const T_##key *a, T_##key s, size_t n) \
+{                                                                                   \
+    for (size_t i = 0; i < n; i++) {                                                \
+        dst[i] = a[i] OP s;                                                         \
+    }                                                                               \
+}
+
+/*
+ * Reduction lanes: lane j holds the sum of every element i with
+ * i % VEC_REDUCE_LANES == j. The SIMD kernels keep the lanes in registers
+ * for whole blocks and finish the n % VEC_REDUCE_LANES tail with the same
+ * scalar statements, so every level produces the same lane values.
+ */
+#define LANES VEC_REDUCE_LANES
+#define ABS_(x) ((x) < 0 ? -(x) : (x))
+
+// TwoSum: s + c absorbs p exactly (barring overflow)
+#define TWO_SUM_STEP(T, s, c, p) do {                                               \
+    T t_ = (s) + (p), z_ = t_ - (s);                                                \
+    (c) += ((s) - (t_ - z_)) + ((p) - z_);                                          \
+    (s) = t_;                                                                       \
+} while (0)
+
+/*
+ * Helpers shared by all levels of one element type. The compensated
+ * combine TwoSums the lanes in double and adds their error terms to the
+ * running error. Once a sum overflows its error terms turn NaN (inf - inf),
+ * so only finite error terms are used.
+ */
+#define DEFINE_HELPERS(E)                                                           \
+static inline T_##E combine_lanes_##E(T_##E *lane)                                  \
+{                                                                                   \
+    for (int w = LANES / 2; w > 0; w /= 2) {                                        \
+        for (int j = 0; j < w; j++) lane[j] += lane[j + w];                         \
+    }                                                                               \
+    return lane[0];                                                                 \
+}                                                                                   \
+static inline double combine_lanes_compensated_##E(const T_##E *s, const T_##E *c)  \
+{                                                                                   \
+    double sum = 0.0, err = 0.0;                                                    \
+    for (int j = 0; j < LANES; j++) {                                               \
+        TWO_SUM_STEP(double, sum, err, (double)s[j]);                               \
+        if (c[j] - c[j] == 0) err += c[j];                                          \
+    }                                                                               \
+    return err - err == 0.0 ? sum + err : sum;                                      \
+}                                                                                   \
+static T_##E maxabs_##E(const T_##E *a, size_t n)                                   \
+{                                                                                   \
+    T_##E m = 0;                                                                    \
+    for (size_t i = 0; i < n; i++) {                                                \
+        T_##E x = ABS_(a[i]);                                                       \
+        m = x > m ? x : m;                                                          \
+    }                                                                               \
+    return m;                                                                       \
+}                                                                                   \
+static void gather_##E(T_##E *dst, const T_##E *src, ptrdiff_t stride, size_t n)    \
+{                                                                                   \
+    for (size_t i = 0; i < n; i++) dst[i] = src[(ptrdiff_t)i * stride];             \
+}                                                                                   \
+static void scatter_##E(T_##E *dst, ptrdiff_t stride, const T_##E *src, size_t n)   \
+{                                                                                   \
+    for (size_t i = 0; i < n; i++) dst[(ptrdiff_t)i * stride] = src[i];             \
+}
+
+DEFINE_HELPERS(f)
+DEFINE_HELPERS(d)
+
+#define SUM_TAIL         for (; i < n; i++) lane[i % LANES] += a[i];
+#define DOT_TAIL         for (; i < n; i++) lane[i % LANES] += a[i] * b[i];
+#define DOT_COMP_TAIL(T) for (; i < n; i++) TWO_SUM_STEP(T, s[i % LANES], c[i % LANES], a[i] * b[i]);
+#define DOT_SCALED_TAIL                                                             \
+    for (; i < n; i++) lane[i % LANES] += (a[i] * sa) * (b[i] * sb);
+
+#define SCALAR_REDUCTIONS(key)                                                      \
+static T_##key sum_##key(const T_##key *a, size_t n)                                \
+{                                                                                   \
+    T_##key lane[LANES] = { 0 };                                                    \
+    size_t i = 0;                                                                   \
+    for (; i + LANES <= n; i += LANES) {                                            \
+        for (int j = 0; j < LANES; j++) lane[j] += a[i + j];                        \
+    }                                                                               \
+    SUM_TAIL                                                                        \
+    return CAT(combine_lanes_, E_##key)(lane);                                      \
+}                                                                                   \
+static T_##key dot_##key(const T_##key *a, const T_##key *b, size_t n)              \
+{                                                                                   \
+    T_##key lane[LANES] = { 0 };                                                    \
+    size_t i = 0;                                                                   \
+    for (; i + LANES <= n; i += LANES) {                                            \
+        for (int j = 0; j < LANES; j++) lane[j] += a[i + j] * b[i + j];             \
+    }                                                                               \
+    DOT_TAIL                                                                        \
+    return CAT(combine_lanes_, E_##key)(lane);                                      \
+}                                                                                   \
+static double dot_compensated_##key(const T_##key *a, const T_##key *b, size_t n)   \
+{                                                                                   \
+    T_##key s[LANES] = { 0 }, c[LANES] = { 0 };                                     \
+    size_t i = 0;                                                                   \
+    for (; i + LANES <= n; i += LANES) {                                            \
+        for (int j = 0; j < LANES; j++) TWO_SUM_STEP(T_##key, s[j], c[j], a[i + j] * b[i + j]); \
+    }                                                                               \
+    DOT_COMP_TAIL(T_##key)                                                          \
+    return CAT(combine_lanes_compensated_, E_##key)(s, c);                          \
+}                                                                                   \
+static T_##key dot_scaled_##key(const T_##key *a, const T_##key *b,                 \
+                                T_##key sa, T_##key sb, size_t n)                   \
+{                                                                                   \
+    T_##key lane[LANES] = { 0 };                                                    \
+    size_t i = 0;                                                                   \
+    for (; i + LANES <= n; i += LANES) {                                            \
+        for (int j = 0; j < LANES; j++) lane[j] += (a[i + j] * sa) * (b[i + j] * sb); \
+    }                                                                               \
+    DOT_SCALED_TAIL                                                                 \
+    return CAT(combine_lanes_, E_##key)(lane);                                      \
+}
+
+#define DEFINE_SCALAR(key, ISA)                                                      \
+    SCALAR_BINARY(key, add, +)                                                      \
+    SCALAR_BINARY(key, sub, -)                                                      \
+    SCALAR_BINARY(key, mul, *)                                                      \
+    SCALAR_BINARY(key, div, /)                                                      \
+    SCALAR_SCALAR(key, add, +)                                                      \
+    SCALAR_SCALAR(key, sub, -)                                                      \
+    SCALAR_SCALAR(key, mul, *)                                                      \
+    SCALAR_SCALAR(key, div, /)                                                      \
+    SCALAR_REDUCTIONS(key)                                                          \
+    static const KT_##key kernels_##key = {                                         \
+        ISA,                                                                        \
+        add_##key, sub_##key, mul_##key, div_##key,                                 \
+        scalar_add_##key, scalar_sub_##key, scalar_mul_##key, scalar_div_##key,     \
+        dot_##key, dot_compensated_##key, dot_scaled_##key, CAT(maxabs_, E_##key),  \
+        sum_##key, CAT(gather_, E_##key), CAT(scatter_, E_##key)                    \
+    };
+
+DEFINE_SCALAR(scalar, VEC_ISA_SCALAR)
+DEFINE_SCALAR(scalar_d, VEC_ISA_SCALAR)
+
+#ifdef VEC_SIMD_X86
+
+/*
+ * Each x86 key is described by a handful of macros: the target attribute,
+ * register type, lane count, load/store intrinsics, the packed operation for
+ * add/sub/mul/div and how the last n % W elements are finished.
+ */
+#define TARGET_sse2   __attribute__((target("sse2")))
+#define TARGET_avx2   __attribute__((target("avx2")))
+#define TARGET_avx512 __attribute__((target("avx512f")))
+#define TARGET_sse2_d   TARGET_sse2
+#define TARGET_avx2_d   TARGET_avx2
+#define TARGET_avx512_d TARGET_avx512
+
+#define T_sse2     float
+#define T_avx2     float
+#define T_avx512   float
+#define T_sse2_d   double
+#define T_avx2_d   double
+#define T_avx512_d double
+
+#define E_sse2     f
+#define E_avx2     f
+#define E_avx512   f
+#define E_sse2_d   d
+#define E_avx2_d   d
+#define E_avx512_d d
+
+#define KT_sse2     vec_kernels_t
+#define KT_avx2     vec_kernels_t
+#define KT_avx512   vec_kernels_t
+#define KT_sse2_d   vec_dkernels_t
+#define KT_avx2_d   vec_dkernels_t
+#define KT_avx512_d vec_dkernels_t
+
+#define VEC_sse2     __m128
+#define VEC_avx2     __m256
+#define VEC_avx512   __m512
+#define VEC_sse2_d   __m128d
+#define VEC_avx2_d   __m256d
+#define VEC_avx512_d __m512d
+
+#define W_sse2     4
+#define W_avx2     8
+#define W_avx512   16
+#define W_sse2_d   2
+#define W_avx2_d   4
+#define W_avx512_d 8
+
+#define LOAD_sse2(p)      _mm_load_ps(p)
+#define LOADU_sse2(p)     _mm_loadu_ps(p)
+#define STORE_sse2(p, v)  _mm_store_ps(p, v)
+#define STOREU_sse2(p, v) _mm_storeu_ps(p, v)
+#define SET1_sse2(s)      _mm_set1_ps(s)
+#define VOP_sse2(name)    _mm_##name##_ps
+#define ABS_sse2(v)       _mm_and_ps(v, _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff)))
+
+#define LOAD_avx2(p)      _mm256_load_ps(p)
+#define LOADU_avx2(p)     _mm256_loadu_ps(p)
+#define STORE_avx2(p, v)  _mm256_store_ps(p, v)
+#define STOREU_avx2(p, v) _mm256_storeu_ps(p, v)
+#define SET1_avx2(s)      _mm256_set1_ps(s)
+#define VOP_avx2(name)    _mm256_##name##_ps
+#define ABS_avx2(v)       _mm256_and_ps(v, _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff)))
+
+#define LOAD_avx512(p)      _mm512_load_ps(p)
+#define LOADU_avx512(p)     _mm512_loadu_ps(p)
+#define STORE_avx512(p, v)  _mm512_store_ps(p, v)
+#define STOREU_avx512(p, v) _mm512_storeu_ps(p, v)
+#define SET1_avx512(s)      _mm512_set1_ps(s)
+#define VOP_avx512(name)    _mm512_##name##_ps
+#define ABS_avx512(v)       _mm512_abs_ps(v)
+
+#define LOAD_sse2_d(p)      _mm_load_pd(p)
+#define LOADU_sse2_d(p)     _mm_loadu_pd(p)
+#define STORE_sse2_d(p, v)  _mm_store_pd(p, v)
+#define STOREU_sse2_d(p, v) _mm_storeu_pd(p, v)
+#define SET1_sse2_d(s)      _mm_set1_pd(s)
+#define VOP_sse2_d(name)    _mm_##name##_pd
+#define ABS_sse2_d(v)       _mm_and_pd(v, _mm_castsi128_pd(_mm_set1_epi64x(0x7fffffffffffffffLL)))
+
+#define LOAD_avx2_d(p)      _mm256_load_pd(p)
+#define LOADU_avx2_d(p)     _mm256_loadu_pd(p)
+#define STORE_avx2_d(p, v)  _mm256_store_pd(p, v)
+#define STOREU_avx2_d(p, v) _mm256_storeu_pd(p, v)
+#define SET1_avx2_d(s)      _mm256_set1_pd(s)
+#define VOP_avx2_d(name)    _mm256_##name##_pd
+#define ABS_avx2_d(v)       _mm256_and_pd(v, _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffLL)))
+
+#define LOAD_avx512_d(p)      _mm512_load_pd(p)
+#define LOADU_avx512_d(p)     _mm512_loadu_pd(p)
+#define STORE_avx512_d(p, v)  _mm512_store_pd(p, v)
+#define STOREU_avx512_d(p, v) _mm512_storeu_pd(p, v)
+#define SET1_avx512_d(s)      _mm512_set1_pd(s)
+#define VOP_avx512_d(name)    _mm512_##name##_pd
+#define ABS_avx512_d(v)       _mm512_abs_pd(v)
+
+// SSE2/AVX2 finish with scalar ops
+#define TAIL_BINARY_sse2(name, OP) for (; i < n; i++) dst[i] = a[i] OP b[i];
+#define TAIL_SCALAR_sse2(name, OP) for (; i < n; i++) dst[i] = a[i] OP s;
+#define TAIL_BINARY_avx2 TAIL_BINARY_sse2
+#define TAIL_SCALAR_avx2 TAIL_SCALAR_sse2
+#define TAIL_BINARY_sse2_d TAIL_BINARY_sse2
+#define TAIL_SCALAR_sse2_d TAIL_SCALAR_sse2
+#define TAIL_BINARY_avx2_d TAIL_BINARY_sse2
+#define TAIL_SCALAR_avx2_d TAIL_SCALAR_sse2
+
+// AVX-512 finishes with one masked operation; masked-off lanes do not fault
+#define TAIL_AVX512_(M, sfx, name, bvec)                                            \
+    if (i < n) {                                                                    \
+        M k = (M)((1u << (n - i)) - 1u);                                            \
+        _mm512_mask_storeu_##sfx(dst + i, k, _mm512_maskz_##name##_##sfx(k,         \
+            _mm512_maskz_loadu_##sfx(k, a + i), bvec));                             \
+    }
+#define TAIL_BINARY_avx512(name, OP) TAIL_AVX512_(__mmask16, ps, name, _mm512_maskz_loadu_ps(k, b + i))
+#define TAIL_SCALAR_avx512(name, OP) TAIL_AVX512_(__mmask16, ps, name, vs)
+#define TAIL_BINARY_avx512_d(name, OP) TAIL_AVX512_(__mmask8, pd, name, _mm512_maskz_loadu_pd(k, b + i))
+#define TAIL_SCALAR_avx512_d(name, OP) TAIL_AVX512_(__mmask8, pd, name, vs)
+
+/*
+ * The head is peeled with scalar ops until dst is register-aligned. If the
+ * sources are then aligned as well the main loop uses aligned loads,
+ * otherwise unaligned ones; stores are always aligned.
+ */
+#define SIMD_BINARY(isa, name, OP)                                                  \
+static TARGET_##isa void name##_##isa(T_##isa *dst, const T_##isa *a, const T_##isa *b, size_t n) \
+{                                                                                   \
+    const size_t bytes = W_##isa * sizeof(T_##isa);                                 \
+    size_t i = 0;                                                                   \
+    for (; i < n && !IS_ALIGNED(dst + i, bytes); i++) {                             \
+        dst[i] = a[i] OP b[i];                                                      \
+    }                                                                               \
+    if (IS_ALIGNED(a + i, bytes) && IS_ALIGNED(b + i, bytes)) {                     \
+        for (; i + W_##isa <= n; i += W_##isa) {                                    \
+            STORE_##isa(dst + i, VOP_##isa(name)(LOAD_##isa(a + i), LOAD_##isa(b + i))); \
+        }                                                                           \
+    } else {                                                                        \
+        for (; i + W_##isa <= n; i += W_##isa) {                                    \
+            STORE_##isa(dst + i, VOP_##isa(name)(LOADU_##isa(a + i), LOADU_##isa(b + i))); \
+        }                                                                           \
+    }                                                                               \
+    TAIL_BINARY_##isa(name, OP)                                                     \
+}
+
+#define SIMD_SCALAR(isa, name, OP)                                                  \
+static TARGET_##isa void scalar_##name##_##isa(T_##isa *dst, const T_##isa *a, T_##isa s, size_t n) \
+{                                                                                   \
+    const size_t bytes = W_##isa * sizeof(T_##isa);                                 \
+    size_t i = 0;                                                                   \
+    for (; i < n && !IS_ALIGNED(dst + i, bytes); i++) {                             \
+        dst[i] = a[i] OP s;                                                         \
+    }                                                                               \
+    VEC_##isa vs = SET1_##isa(s);                                                   \
+    if (IS_ALIGNED(a + i, bytes)) {                                                 \
+        for (; i + W_##isa <= n; i += W_##isa) {                                    \
+            STORE_##isa(dst + i, VOP_##isa(name)(LOAD_##isa(a + i), vs));           \
+        }                                                                           \
+    } else {                                                                        \
+        for (; i + W_##isa <= n; i += W_##isa) {                                    \
+            STORE_##isa(dst + i, VOP_##isa(name)(LOADU_##isa(a + i), vs));          \
+        }                                                                           \
+    }                                                                               \
+    TAIL_SCALAR_##isa(name, OP)                                                     \
+}
+
+/*
+ * Reductions: VEC_REDUCE_LANES / W registers of accumulators, register r
+ * holding lanes r*W .. r*W+W-1. Unaligned loads throughout; the lane of an
+ * element depends only on its index.
+ */
+#define R_(isa) (LANES / W_##isa)
+
+#define SIMD_SUM(isa)                                                               \
+static TARGET_##isa T_##isa sum_##isa(const T_##isa *a, size_t n)                   \
+{                                                                                   \
+    VEC_##isa acc[R_(isa)];                                                         \
+    for (int r = 0; r < R_(isa); r++) acc[r] = SET1_##isa(0);                       \
+    size_t i = 0;                                                                   \
+    for (; i + LANES <= n; i += LANES) {                                            \
+        for (int r = 0; r < R_(isa); r++) {                                         \
+            acc[r] = VOP_##isa(add)(acc[r], LOADU_##isa(a + i + r * W_##isa));      \
+        }                                                                           \
+    }                                                                               \
+    T_##isa lane[LANES];                                                            \
+    for (int r = 0; r < R_(isa); r++) STOREU_##isa(lane + r * W_##isa, acc[r]);     \
+    SUM_TAIL                                                                        \
+    return CAT(combine_lanes_, E_##isa)(lane);                                      \
+}
+
+#define SIMD_DOT(isa)                                                               \
+static TARGET_##isa T_##isa dot_##isa(const T_##isa *a, const T_##isa *b, size_t n) \
+{                                                                                   \
+    VEC_##isa acc[R_(isa)];                                                         \
+    for (int r = 0; r < R_(isa); r++) acc[r] = SET1_##isa(0);                       \
+    size_t i = 0;                                                                   \
+    for (; i + LANES <= n; i += LANES) {                                            \
+        for (int r = 0; r < R_(isa); r++) {                                         \
+            acc[r] = VOP_##isa(add)(acc[r], VOP_##isa(mul)(LOADU_##isa(a + i + r * W_##isa), \
+                                                           LOADU_##isa(b + i + r * W_##isa))); \
+        }                                                                           \
+    }                                                                               \
+    T_##isa lane[LANES];                                                            \
+    for (int r = 0; r < R_(isa); r++) STOREU_##isa(lane + r * W_##isa, acc[r]);     \
+    DOT_TAIL                                                                        \
+    return CAT(combine_lanes_, E_##isa)(lane);                                      \
+}
+
+#define SIMD_DOT_COMPENSATED(isa)                                                   \
+static TARGET_##isa double dot_compensated_##isa(const T_##isa *a, const T_##isa *b, size_t n) \
+{                                                                                   \
+    VEC_##isa vs[R_(isa)], vc[R_(isa)];                                             \
+    for (int r = 0; r < R_(isa); r++) vs[r] = vc[r] = SET1_##isa(0);                \
+    size_t i = 0;                                                                   \
+    for (; i + LANES <= n; i += LANES) {                                            \
+        for (int r = 0; r < R_(isa); r++) {                                         \
+            VEC_##isa p = VOP_##isa(mul)(LOADU_##isa(a + i + r * W_##isa),          \
+                                         LOADU_##isa(b + i + r * W_##isa));         \
+            VEC_##isa t = VOP_##isa(add)(vs[r], p);                                 \
+            VEC_##isa z = VOP_##isa(sub)(t, vs[r]);                                 \
+            VEC_##isa e = VOP_##isa(add)(VOP_##isa(sub)(vs[r], VOP_##isa(sub)(t, z)), \
+                                         VOP_##isa(sub)(p, z));                     \
+            vc[r] = VOP_##isa(add)(vc[r], e);                                       \
+            vs[r] = t;                                                              \
+        }                                                                           \
+    }                                                                               \
+    T_##isa s[LANES], c[LANES];                                                     \
+    for (int r = 0; r < R_(isa); r++) {                                             \
+        STOREU_##isa(s + r * W_##isa, vs[r]);                                       \
+        STOREU_##isa(c + r * W_##isa, vc[r]);                                       \
+    }                                                                               \
+    DOT_COMP_TAIL(T_##isa)                                                          \
+    return CAT(combine_lanes_compensated_, E_##isa)(s, c);                          \
+}
+
+#define SIMD_DOT_SCALED(isa)                                                        \
+static TARGET_##isa T_##isa dot_scaled_##isa(const T_##isa *a, const T_##isa *b,    \
+                                             T_##isa sa, T_##isa sb, size_t n)      \
+{                                                                                   \
+    VEC_##isa acc[R_(isa)];                                                         \
+    VEC_##isa va = SET1_##isa(sa), vb = SET1_##isa(sb);                             \
+    for (int r = 0; r < R_(isa); r++) acc[r] = SET1_##isa(0);                       \
+    size_t i = 0;                                                                   \
+    for (; i + LANES <= n; i += LANES) {                                            \
+        for (int r = 0; r < R_(isa); r++) {                                         \
+            VEC_##isa x = VOP_##isa(mul)(LOADU_##isa(a + i + r * W_##isa), va);     \
+            VEC_##isa y = VOP_##isa(mul)(LOADU_##isa(b + i + r * W_##isa), vb);     \
+            acc[r] = VOP_##isa(add)(acc[r], VOP_##isa(mul)(x, y));                  \
+        }                                                                           \
+    }                                                                               \
+    T_##isa lane[LANES];                                                            \
+    for (int r = 0; r < R_(isa); r++) STOREU_##isa(lane + r * W_##isa, acc[r]);     \
+    DOT_SCALED_TAIL                                                                 \
+    return CAT(combine_lanes_, E_##isa)(lane);                                      \
+}
+
+#define SIMD_MAXABS(isa)                                                            \
+static TARGET_##isa T_##isa maxabs_##isa(const T_##isa *a, size_t n)                \
+{                                                                                   \
+    VEC_##isa m = SET1_##isa(0);                                                    \
+    size_t i = 0;                                                                   \
+    for (; i + W_##isa <= n; i += W_##isa) {                                        \
+        m = VOP_##isa(max)(m, ABS_##isa(LOADU_##isa(a + i)));                        \
+    }                                                                               \
+    T_##isa lane[W_##isa];                                                          \
+    STOREU_##isa(lane, m);                                                          \
+    T_##isa r = CAT(maxabs_, E_##isa)(a + i, n - i);                                \
+    for (int j = 0; j < W_##isa; j++) r = lane[j] > r ? lane[j] : r;                \
+    return r;                                                                       \
+}
+
+/*
+ * Gathers and scatters use 32-bit element offsets from a base that moves
+ * W * stride elements per step; strides too large for that fall back to
+ * the scalar loops. SSE2 has neither, AVX2 has no scatter: those table
+ * entries are the scalar loops.
+ */
+#define SIMD_GATHER(isa)                                                            \
+static TARGET_##isa void gather_##isa(T_##isa *dst, const T_##isa *src,             \
+                                      ptrdiff_t stride, size_t n)                   \
+{                                                                                   \
+    size_t i = 0;                                                                   \
+    if (stride <= INT_MAX / W_##isa && stride >= -(INT_MAX / W_##isa)) {            \
+        IDX_T_##isa idx = IDX_##isa((int)stride);                                   \
+        for (; i + W_##isa <= n; i += W_##isa) {                                    \
+            STOREU_##isa(dst + i, GATHER_##isa(src + (ptrdiff_t)i * stride, idx));   \
+        }                                                                           \
+    }                                                                               \
+    if (i < n) CAT(gather_, E_##isa)(dst + i, src + (ptrdiff_t)i * stride, stride, n - i); \
+}
+
+#define SIMD_SCATTER(isa)                                                           \
+static TARGET_##isa void scatter_##isa(T_##isa *dst, ptrdiff_t stride,              \
+                                       const T_##isa *src, size_t n)                \
+{                                                                                   \
+    size_t i = 0;                                                                   \
+    if (stride <= INT_MAX / W_##isa && stride >= -(INT_MAX / W_##isa)) {            \
+        IDX_T_##isa idx = IDX_##isa((int)stride);                                   \
+        for (; i + W_##isa <= n; i += W_##isa) {                                    \
+            SCATTER_##isa(dst + (ptrdiff_t)i * stride, idx, LOADU_##isa(src + i));  \
+        }                                                                           \
+    }                                                                               \
+    if (i < n) CAT(scatter_, E_##isa)(dst + (ptrdiff_t)i * stride, stride, src + i, n - i); \
+}
+
+#define IDX_T_avx2      __m256i
+#define IDX_avx2(s)     _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(s))
+#define GATHER_avx2(p, idx) _mm256_i32gather_ps(p, idx, 4)
+
+#define IDX_T_avx2_d    __m128i
+#define IDX_avx2_d(s)   _mm_setr_epi32(0, (s), 2 * (s), 3 * (s))
+#define GATHER_avx2_d(p, idx) _mm256_i32gather_pd(p, idx, 8)
+
+#define IDX_T_avx512    __m512i
+#define IDX_avx512(s)   _mm512_mullo_epi32(_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, \
+                                                             12, 13, 14, 15), _mm512_set1_epi32(s))
+#define GATHER_avx512(p, idx)     _mm512_i32gather_ps(idx, p, 4)
+#define SCATTER_avx512(p, idx, v) _mm512_i32scatter_ps(p, idx, v, 4)
+
+#define IDX_T_avx512_d  __m256i
+#define IDX_avx512_d(s) _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(s))
+#define GATHER_avx512_d(p, idx)     _mm512_i32gather_pd(idx, p, 8)
+#define SCATTER_avx512_d(p, idx, v) _mm512_i32scatter_pd(p, idx, v, 8)
+
+SIMD_GATHER(avx2)
+SIMD_GATHER(avx2_d)
+SIMD_GATHER(avx512)
+SIMD_GATHER(avx512_d)
+SIMD_SCATTER(avx512)
+SIMD_SCATTER(avx512_d)
+
+#define GATHER_FN_sse2      gather_f
+#define GATHER_FN_avx2      gather_avx2
+#define GATHER_FN_avx512    gather_avx512
+#define GATHER_FN_sse2_d    gather_d
+#define GATHER_FN_avx2_d    gather_avx2_d
+#define GATHER_FN_avx512_d  gather_avx512_d
+#define SCATTER_FN_sse2     scatter_f
+#define SCATTER_FN_avx2     scatter_f
+#define SCATTER_FN_avx512   scatter_avx512
+#define SCATTER_FN_sse2_d   scatter_d
+#define SCATTER_FN_avx2_d   scatter_d
+#define SCATTER_FN_avx512_d scatter_avx512_d
+
+#define DEFINE_LEVEL(isa, ISA)                                                       \
+    SIMD_BINARY(isa, add, +)                                                        \
+    SIMD_BINARY(isa, sub, -)                                                        \
+    SIMD_BINARY(isa, mul, *)                                                        \
+    SIMD_BINARY(isa, div, /)                                                        \
+    SIMD_SCALAR(isa, add, +)                                                        \
+    SIMD_SCALAR(isa, sub, -)                                                        \
+    SIMD_SCALAR(isa, mul, *)                                                        \
+    SIMD_SCALAR(isa, div, /)                                                        \
+    SIMD_DOT(isa)                                                                   \
+    SIMD_DOT_COMPENSATED(isa)                                                       \
+    SIMD_DOT_SCALED(isa)                                                            \
+    SIMD_MAXABS(isa)                                                                \
+    SIMD_SUM(isa)                                                                   \
+    static const KT_##isa kernels_##isa = {                                         \
+        ISA,                                                                        \
+        add_##isa, sub_##isa, mul_##isa, div_##isa,                                 \
+        scalar_add_##isa, scalar_sub_##isa, scalar_mul_##isa, scalar_div_##isa,     \
+        dot_##isa, dot_compensated_##isa, dot_scaled_##isa, maxabs_##isa,           \
+        sum_##isa, GATHER_FN_##isa, SCATTER_FN_##isa                                \
+    };
+
+DEFINE_LEVEL(sse2, VEC_ISA_SSE2)
+DEFINE_LEVEL(avx2, VEC_ISA_AVX2)
+DEFINE_LEVEL(avx512, VEC_ISA_AVX512)
+DEFINE_LEVEL(sse2_d, VEC_ISA_SSE2)
+DEFINE_LEVEL(avx2_d, VEC_ISA_AVX2)
+DEFINE_LEVEL(avx512_d, VEC_ISA_AVX512)
+
+#endif // VEC_SIMD_X86
+
+/****************************************************DISPATCH*************************************************/
+
+static const vec_kernels_t *kernel_table(vec_isa_t isa)
+{
+    switch (isa) {
+        case VEC_ISA_SCALAR: return &kernels_scalar;
+#ifdef VEC_SIMD_X86
+        case VEC_ISA_SSE2:   return &kernels_sse2;
+        case VEC_ISA_AVX2:   return &kernels_avx2;
+        case VEC_ISA_AVX512: return &kernels_avx512;
+#endif
+        default:             return NULL;
+    }
+}
+
+static const vec_dkernels_t *dkernel_table(vec_isa_t isa)
+{
+    switch (isa) {
+        case VEC_ISA_SCALAR: return &kernels_scalar_d;
+#ifdef VEC_SIMD_X86
+        case VEC_ISA_SSE2:   return &kernels_sse2_d;
+        case VEC_ISA_AVX2:   return &kernels_avx2_d;
+        case VEC_ISA_AVX512: return &kernels_avx512_d;
+#endif
+        default:             return NULL;
+    }
+}
+
+static vec_isa_t active_isa = VEC_ISA_SCALAR;
+static const vec_kernels_t *active_kernels = NULL;
+static const vec_dkernels_t *active_dkernels = NULL;
+
+/**
+ * @brief Highest level both compiled in and supported by the running CPU
+ *        (including OS support for the wider register state).
+ */
+vec_isa_t vec_isa_detect(void)
+{
+#ifdef VEC_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return VEC_ISA_AVX512;
+    if (__builtin_cpu_supports("avx2")) return VEC_ISA_AVX2;
+    if (__builtin_cpu_supports("sse2")) return VEC_ISA_SSE2;
+#endif
+    return VEC_ISA_SCALAR;
+}
+
+const char *vec_isa_name(vec_isa_t isa)
+{
+    static const char *names[VEC_ISA_COUNT] = { "scalar", "sse2", "avx2", "avx512" };
+    return (unsigned)isa < VEC_ISA_COUNT ? names[isa] : "unknown";
+}
+
+/**
+ * @brief Kernels for `isa`, or NULL if this CPU or build cannot run them.
+ */
+const vec_kernels_t *vec_kernels_for(vec_isa_t isa)
+{
+    if ((unsigned)isa >= VEC_ISA_COUNT || isa > vec_isa_detect()) return NULL;
+    return kernel_table(isa);
+}
+
+/**
+ * @brief Double kernels for `isa`, or NULL if this CPU or build cannot run them.
+ */
+const vec_dkernels_t *vec_dkernels_for(vec_isa_t isa)
+{
+    if ((unsigned)isa >= VEC_ISA_COUNT || isa > vec_isa_detect()) return NULL;
+    return dkernel_table(isa);
+}
+
+/**
+ * @brief Force the level used by vec.c (float and double kernels alike).
+ *        Not thread-safe; call it before vector code runs on other threads.
+ */
+bool vec_isa_select(vec_isa_t isa)
+{
+    const vec_kernels_t *k = vec_kernels_for(isa);
+    if (!k) return false;
+    active_isa = isa;
+    active_dkernels = dkernel_table(isa);
+    active_kernels = k;
+    return true;
+}
+
+vec_isa_t vec_isa_active(void)
+{
+    vec_kernels();
+    return active_isa;
+}
+
+/**
+ * @brief Resolve the kernel level once at startup: the best detected level,
+ *        capped by the CMATH_ISA environment variable if set (e.g.
+ *        CMATH_ISA=sse2 to compare levels without rebuilding).
+ */
+#ifdef __GNUC__
+__attribute__((constructor))
+#endif
+static void vec_simd_init(void)
+{
+    vec_isa_t isa = vec_isa_detect();
+    const char *cap = getenv("CMATH_ISA");
+    if (cap) {
+        for (int i = 0; i < VEC_ISA_COUNT; i++) {
+            if (strcmp(cap, vec_isa_name((vec_isa_t)i)) == 0 && (vec_isa_t)i < isa) {
+                isa = (vec_isa_t)i;
+            }
+        }
+    }
+    active_isa = isa;
+    active_dkernels = dkernel_table(isa);
+    active_kernels = kernel_table(isa);
+}
+
+const vec_kernels_t *vec_kernels(void)
+{
+    if (!active_kernels) vec_simd_init();
+    return active_kernels;
+}
+
+const vec_dkernels_t *vec_dkernels(void)
+{
+    if (!active_kernels) vec_simd_init();
+    return active_dkernels;
+}
@@ -0,0 +1,318 @@
+#include <vec_sparse.h>
+#include <vec_simd.h>
+#include <vec_parallel.h>
+#include <vec_alloc.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    #define VEC_SIMD_X86 1
+    #include <immintrin.h>
+#endif
+
+const svector_t SVEC_UNDEFINED = {0, 0, NULL, NULL, 0, NULL};
+
+/*
+ * Kernels over entries [0, n) of a slice of a sparse vector:
+ *
+ *   dot_dense   - sum of val[k] * v[idx[k]], product k in lane k % SVEC_LANES
+ *   scatter_add - dst[idx[k]] = dst[idx[k]] + alpha * val[k]
+ *
+ * Slices start at multiples of SVEC_LANES (the vec_parallel chunks do), so
+ * the lane of an entry does not depend on where its chunk starts.
+ */
+typedef struct {
+    float (*dot_dense)(const uint32_t *idx, const float *val, const float *v, size_t n);
+    void (*scatter_add)(float *dst, const uint32_t *idx, const float *val, float alpha, size_t n);
+} svec_kernels_t;
+
+// pairwise, like the vec_simd.c reductions
+static inline float combine_lanes(float *lane)
+{
+    for (int w = SVEC_LANES / 2; w > 0; w /= 2) {
+        for (int j = 0; j < w; j++) lane[j] += lane[j + w];
+    }
+    return lane[0];
+}
+
+/****************************************************SCALAR***************************************************/
+
+static float dot_dense_scalar(const uint32_t *idx, const float *val, const float *v, size_t n)
+{
+    float lane[SVEC_LANES] = { 0 };
+    for (size_t k = 0; k < n; k++) lane[k % SVEC_LANES] += val[k] * v[idx[k]];
+    return combine_lanes(lane);
+}
+
+static void scatter_add_scalar(float *dst, const uint32_t *idx, const float *val, float alpha, size_t n)
+{
+    for (size_t k = 0; k < n; k++) dst[idx[k]] = dst[idx[k]] + alpha * val[k];
+}
+
+static const svec_kernels_t svec_kernels_scalar = { dot_dense_scalar, scatter_add_scalar };
+
+#ifdef VEC_SIMD_X86
+
+/*
+ * The SIMD kernels keep lanes 0..15 in registers for the whole blocks of
+ * SVEC_LANES entries and finish the tail in the same lanes in memory.
+ */
+#define TARGET_avx2   __attribute__((target("avx2")))
+#define TARGET_avx512 __attribute__((target("avx512f")))
+
+TARGET_avx2 static float dot_dense_avx2(const uint32_t *idx, const float *val, const float *v, size_t n)
+{
+    __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+    size_t k = 0;
+    for (; k + 16 <= n; k += 16) {
+        __m256i i0 = _mm256_loadu_si256((const __m256i *)(idx + k));
+        __m256i i1 = _mm256_loadu_si256((const __m256i *)(idx + k + 8));
+        acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_loadu_ps(val + k), _mm256_i32gather_ps(v, i0, 4)));
+        acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(_mm256_loadu_ps(val + k + 8), _mm256_i32gather_ps(v, i1, 4)));
+    }
+    float lane[SVEC_LANES];
+    _mm256_storeu_ps(lane, acc0);
+    _mm256_storeu_ps(lane + 8, acc1);
+    for (; k < n; k++) lane[k % SVEC_LANES] += val[k] * v[idx[k]];
+    return combine_lanes(lane);
+}
+
+TARGET_avx512 static float dot_dense_avx512(const uint32_t *idx, const float *val, const float *v, size_t n)
+{
+    __m512 acc = _mm512_setzero_ps();
+    size_t k = 0;
+    for (; k + 16 <= n; k += 16) {
+        __m512i i = _mm512_loadu_si512((const void *)(idx + k));
+        acc = _mm512_add_ps(acc, _mm512_mul_ps(_mm512_loadu_ps(val + k), _mm512_i32gather_ps(i, v, 4)));
+    }
+    float lane[SVEC_LANES];
+    _mm512_storeu_ps(lane, acc);
+    for (; k < n; k++) lane[k % SVEC_LANES] += val[k] * v[idx[k]];
+    return combine_lanes(lane);
+}
+
+// the indices of one vector are distinct, so a scatter never collides
+TARGET_avx512 static void scatter_add_avx512(float *dst, const uint32_t *idx, const float *val, float alpha, size_t n)
+{
+    __m512 va = _mm512_set1_ps(alpha);
+    size_t k = 0;
+    for (; k + 16 <= n; k += 16) {
+        __m512i i = _mm512_loadu_si512((const void *)(idx + k));
+        __m512 d = _mm512_add_ps(_mm512_i32gather_ps(i, dst, 4), _mm512_mul_ps(va, _mm512_loadu_ps(val + k)));
+        _mm512_i32scatter_ps(dst, i, d, 4);
+    }
+    scatter_add_scalar(dst, idx + k, val + k, alpha, n - k);
+}
+
+// AVX2 has no scatter
+static const svec_kernels_t svec_kernels_avx2 = { dot_dense_avx2, scatter_add_scalar };
+static const svec_kernels_t svec_kernels_avx512 = { dot_dense_avx512, scatter_add_avx512 };
+
+#endif // VEC_SIMD_X86
+
+static const svec_kernels_t *svec_kernels(void)
+{
+#ifdef VEC_SIMD_X86
+    vec_isa_t isa = vec_isa_active();
+    if (isa >= VEC_ISA_AVX512) return &svec_kernels_avx512;
+    if (isa >= VEC_ISA_AVX2) return &svec_kernels_avx2;
+#endif
+    return &svec_kernels_scalar;
+}
+
+/***************************************************STORAGE***************************************************/
+
+#define SVEC_ENTRY_BYTES (sizeof(uint32_t) + sizeof(float))
+
+// one block: capacity indices, then capacity values
+static bool svec_move(svector_t *s, size_t capacity)
+{
+    const vec_allocator_t *a = s->allocator ? s->allocator : vec_allocator_current();
+    uint32_t *index = NULL;
+    float *value = NULL;
+    if (capacity > 0) {
+        if (capacity > (size_t)-1 / SVEC_ENTRY_BYTES) return false;
+        index = (uint32_t *)a->alloc(a->ctx, capacity * SVEC_ENTRY_BYTES);
+        if (!index) return false;
+        value = (float *)(index + capacity);
+        if (s->nnz > 0) {
+            memcpy(index, s->index, s->nnz * sizeof(uint32_t));
+            memcpy(value, s->value, s->nnz * sizeof(float));
+        }
+    }
+    if (s->index) a->free(a->ctx, s->index, s->capacity * SVEC_ENTRY_BYTES);
+    s->index = index;
+    s->value = value;
+    s->capacity = capacity;
+    s->allocator = a;
+    return true;
+}
+
+svector_t svec_alloc(size_t size, size_t capacity)
+{
+    if (size > SVEC_MAX_SIZE) return SVEC_UNDEFINED;
+    svector_t s = { size, 0, NULL, NULL, 0, vec_allocator_current() };
+    if (!svec_move(&s, capacity)) return SVEC_UNDEFINED;
+    return s;
+}
+
+void svec_free(svector_t *s)
+{
+    if (s->index) s->allocator->free(s->allocator->ctx, s->index, s->capacity * SVEC_ENTRY_BYTES);
+    s->index = NULL;
+    s->value = NULL;
+    s->nnz = 0;
+    s->capacity = 0;
+}
+
+bool svec_push(svector_t *s, uint32_t index, float value)
+{
+    if (index >= s->size || (s->nnz > 0 && index <= s->index[s->nnz - 1])) return false;
+    if (s->nnz == s->capacity) {
+        size_t grown = s->capacity < 8 ? 16 : s->capacity * 2;
+        if (!svec_move(s, grown)) return false;
+    }
+    s->index[s->nnz] = index;
+    s->value[s->nnz++] = value;
+    return true;
+}
+
+svector_t svec_from_dense(vector_t v)
+{
+    size_t nnz = 0;
+    for (size_t i = 0; i < v.size; i++) nnz += v.data[i] != 0.0f;
+    svector_t s = svec_alloc(v.size, nnz);
+    if (!s.allocator) return s;
+    for (size_t i = 0; i < v.size; i++) {
+        if (v.data[i] != 0.0f) {
+            s.index[s.nnz] = (uint32_t)i;
+            s.value[s.nnz++] = v.data[i];
+        }
+    }
+    return s;
+}
+
+svector_t svec_from_arrays(size_t size, const uint32_t *index, const float *value, size_t nnz)
+{
+    for (size_t k = 0; k < nnz; k++) {
+        if (index[k] >= size || (k > 0 && index[k] <= index[k - 1])) return SVEC_UNDEFINED;
+    }
+    svector_t s = svec_alloc(size, nnz);
+    if (!s.allocator) return s;
+    if (nnz > 0) {
+        memcpy(s.index, index, nnz * sizeof(uint32_t));
+        memcpy(s.value, value, nnz * sizeof(float));
+    }
+    s.nnz = nnz;
+    return s;
+}
+
+vector_t svec_to_dense(svector_t s)
+{
+    vector_t v = vector_create((unsigned int)s.size);
+    if (!v.data) return v;
+    for (size_t k = 0; k < s.nnz; k++) v.data[s.index[k]] = s.value[k];
+    return v;
+}
+
+/***************************************************KERNELS***************************************************/
+
+typedef struct {
+    const uint32_t *idx;
+    const float *val;
+    float *v;
+    float alpha;
+} svec_job_t;
+
+static double dot_dense_chunk(void *ctx, size_t begin, size_t end)
+{
+    const svec_job_t *j = ctx;
+    return svec_kernels()->dot_dense(j->idx + begin, j->val + begin, j->v, end - begin);
+}
+
+float svec_dot_dense(svector_t s, vector_t v)
+{
+    if (s.size != v.size) return 0.0f;
+    svec_job_t j = { s.index, s.value, v.data, 0.0f };
+    return (float)vec_parallel_reduce(s.nnz, dot_dense_chunk, &j);
+}
+
+static void scatter_add_chunk(void *ctx, size_t begin, size_t end)
+{
+    const svec_job_t *j = ctx;
+    svec_kernels()->scatter_add(j->v, j->idx + begin, j->val + begin, j->alpha, end - begin);
+}
+
+bool svec_scatter_add(vector_t dst, float alpha, svector_t s)
+{
+    if (s.size != dst.size) return false;
+    svec_job_t j = { s.index, s.value, dst.data, alpha };
+    vec_parallel_for(s.nnz, scatter_add_chunk, &j);
+    return true;
+}
+
+// first position in idx[lo, n) whose index is >= key: doubling steps, then bisection
+static size_t gallop(const uint32_t *idx, size_t lo, size_t n, uint32_t key)
+{
+    size_t step = 1, hi = lo;
+    while (hi < n && idx[hi] < key) {
+        lo = hi + 1;
+        hi += step;
+        step *= 2;
+    }
+    if (hi > n) hi = n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (idx[mid] < key) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+/*
+ * Matches are found in increasing index order either way, so galloping and
+ * merging put the same product in the same lane: same bits.
+ */
+float svec_dot(svector_t a, svector_t b)
+{
+    if (a.size != b.size) return 0.0f;
+    float lane[SVEC_LANES] = { 0 };
+    size_t m = 0, i = 0, j = 0;
+    if (a.nnz * SVEC_GALLOP <= b.nnz || b.nnz * SVEC_GALLOP <= a.nnz) {
+        bool a_short = a.nnz <= b.nnz;
+        const svector_t *s = a_short ? &a : &b, *l = a_short ? &b : &a;
+        for (; i < s->nnz; i++) {
+            j = gallop(l->index, j, l->nnz, s->index[i]);
+            if (j == l->nnz) break;
+            if (l->index[j] == s->index[i]) {
+                lane[m++ % SVEC_LANES] += s->value[i] * l->value[j];
+            }
+        }
+    } else {
+        while (i < a.nnz && j < b.nnz) {
+            if (a.index[i] < b.index[j]) i++;
+            else if (a.index[i] > b.index[j]) j++;
+            else lane[m++ % SVEC_LANES] += a.value[i++] * b.value[j++];
+        }
+    }
+    return combine_lanes(lane);
+}
+
+svector_t svec_add(svector_t a, svector_t b)
+{
+    if (a.size != b.size) return SVEC_UNDEFINED;
+    svector_t r = svec_alloc(a.size, a.nnz + b.nnz);
+    if (!r.allocator) return r;
+    size_t i = 0, j = 0, k = 0;
+    while (i < a.nnz && j < b.nnz) {
+        if (a.index[i] < b.index[j]) {
+            r.index[k] = a.index[i], r.value[k++] = a.value[i++];
+        } else if (a.index[i] > b.index[j]) {
+            r.index[k] = b.index[j], r.value[k++] = b.value[j++];
+        } else {
+            r.index[k] = a.index[i], r.value[k++] = a.value[i++] + b.value[j++];
+        }
+    }
+    for (; i < a.nnz; i++) r.index[k] = a.index[i], r.value[k++] = a.value[i];
+    for (; j < b.nnz; j++) r.index[k] = b.index[j], r.value[k++] = b.value[j];
+    r.nnz = k;
+    return r;
+}
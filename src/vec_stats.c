@@ -0,0 +1,265 @@
+#include <vec_stats.h>
+
+#if VEC_STATS
+#include <stdatomic.h>
+#if defined(VEC_PARALLEL_PTHREADS)
+    #include <pthread.h>
+#endif
+#if VEC_STATS_TIMING
+    #if defined(__x86_64__) || defined(__i386__)
+        #include <x86intrin.h>
+    #else
+        #include <time.h>
+    #endif
+#endif
+
+/*
+ * Only the owning thread writes its buffer, so a counter update is a relaxed
+ * load and store (plain moves on x86), never a locked add; the atomics only
+ * make the concurrent reads of a snapshot well defined. The one exception is
+ * the shared fallback, which any number of threads may write, and which gets
+ * atomic adds.
+ *
+ * Buffers stay on the list for good, so their counts outlive their thread.
+ * When a thread exits, a pthread key destructor marks its buffer idle and
+ * the next new thread takes it over instead of allocating, which bounds the
+ * list by the most threads ever counting at once. Without pthreads buffers
+ * are not recycled.
+ */
+struct vec_stats_row {
+    _Atomic uint64_t calls;
+    _Atomic uint64_t elements;
+    _Atomic uint64_t bytes_allocated;
+    _Atomic uint64_t bytes_freed;
+    _Atomic uint64_t ticks;
+};
+
+typedef struct vec_stats_buffer {
+    vec_stats_row_t rows[VEC_STATS_COUNT];
+    struct vec_stats_buffer *next;
+    atomic_bool idle;                                   // owner exited; free to take over
+} vec_stats_buffer_t;
+
+static _Atomic(vec_stats_buffer_t *) buffers = NULL;    // every thread's buffer, newest first
+static vec_stats_buffer_t shared;                       // for threads whose buffer could not be allocated
+static _Thread_local vec_stats_buffer_t *local = NULL;
+
+// Rows are only bumped by the thread that entered them, so `local` tells which buffer they are in
+static inline void bump(_Atomic uint64_t *c, uint64_t v)
+{
+    if (local == &shared) atomic_fetch_add_explicit(c, v, memory_order_relaxed);
+    else atomic_store_explicit(c, atomic_load_explicit(c, memory_order_relaxed) + v, memory_order_relaxed);
+}
+
+#if defined(VEC_PARALLEL_PTHREADS)
+static pthread_key_t exit_key;
+static pthread_once_t exit_key_once = PTHREAD_ONCE_INIT;
+static bool exit_key_ok = false;
+
+static void release(void *b)
+{
+    local = NULL;                                       // a later destructor that counts attaches afresh
+    atomic_store_explicit(&((vec_stats_buffer_t *)b)->idle, true, memory_order_release);
+}
+
+static void make_exit_key(void)
+{
+    exit_key_ok = pthread_key_create(&exit_key, release) == 0;
+}
+#endif
+
+// An idle buffer of an exited thread, now owned by the caller; NULL if none
+static vec_stats_buffer_t *adopt(void)
+{
+#if defined(VEC_PARALLEL_PTHREADS)
+    pthread_once(&exit_key_once, make_exit_key);
+    if (!exit_key_ok) return NULL;
+    vec_stats_buffer_t *b = atomic_load_explicit(&buffers, memory_order_acquire);
+    for (; b; b = b->next) {
+        bool idle = true;
+        if (atomic_load_explicit(&b->idle, memory_order_relaxed) &&
+            atomic_compare_exchange_strong_explicit(&b->idle, &idle, false,
+                                                    memory_order_acquire, memory_order_relaxed)) return b;
+    }
+#endif
+    return NULL;
+}
+
+// Have the buffer marked idle when the calling thread exits
+static void release_at_exit(vec_stats_buffer_t *b)
+{
+#if defined(VEC_PARALLEL_PTHREADS)
+    if (exit_key_ok) pthread_setspecific(exit_key, b);
+#else
+    (void)b;
+#endif
+}
+
+static vec_stats_buffer_t *attach(void)
+{
+    vec_stats_buffer_t *b = adopt();
+    if (!b) {
+        b = (vec_stats_buffer_t *)calloc(1, sizeof *b);
+        if (!b) return local = &shared;
+        b->next = atomic_load_explicit(&buffers, memory_order_relaxed);
+        while (!atomic_compare_exchange_weak_explicit(&buffers, &b->next, b,
+                                                      memory_order_release, memory_order_relaxed)) {
+        }
+    }
+    release_at_exit(b);
+    return local = b;
+}
+
+vec_stats_row_t *vec_stats_enter_(vec_stats_id_t id, uint64_t elements)
+{
+    vec_stats_row_t *row = &(local ? local : attach())->rows[id];
+    bump(&row->calls, 1);
+    bump(&row->elements, elements);
+    return row;
+}
+
+void vec_stats_bytes_(vec_stats_row_t *row, uint64_t allocated, uint64_t freed)
+{
+    if (allocated) bump(&row->bytes_allocated, allocated);
+    if (freed) bump(&row->bytes_freed, freed);
+}
+
+uint64_t vec_stats_ticks_(void)
+{
+#if !VEC_STATS_TIMING
+    return 0;
+#elif defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+void vec_stats_leave_(vec_stats_timer_t *t)
+{
+    bump(&t->row->ticks, vec_stats_ticks_() - t->start);
+}
+
+static void add_buffer(vec_stats_entry_t *out, vec_stats_buffer_t *b)
+{
+    for (int i = 0; i < VEC_STATS_COUNT; i++) {
+        vec_stats_row_t *r = &b->rows[i];
+        out[i].calls += atomic_load_explicit(&r->calls, memory_order_relaxed);
+        out[i].elements += atomic_load_explicit(&r->elements, memory_order_relaxed);
+        out[i].bytes_allocated += atomic_load_explicit(&r->bytes_allocated, memory_order_relaxed);
+        out[i].bytes_freed += atomic_load_explicit(&r->bytes_freed, memory_order_relaxed);
+        out[i].ticks += atomic_load_explicit(&r->ticks, memory_order_relaxed);
+    }
+}
+
+void vec_stats_snapshot(vec_stats_entry_t *out)
+{
+    memset(out, 0, VEC_STATS_COUNT * sizeof *out);
+    vec_stats_buffer_t *b = atomic_load_explicit(&buffers, memory_order_acquire);
+    for (; b; b = b->next) add_buffer(out, b);
+    add_buffer(out, &shared);
+}
+
+static void clear_buffer(vec_stats_buffer_t *b)
+{
+    for (int i = 0; i < VEC_STATS_COUNT; i++) {
+        vec_stats_row_t *r = &b->rows[i];
+        atomic_store_explicit(&r->calls, 0, memory_order_relaxed);
+        atomic_store_explicit(&r->elements, 0, memory_order_relaxed);
+        atomic_store_explicit(&r->bytes_allocated, 0, memory_order_relaxed);
+        atomic_store_explicit(&r->bytes_freed, 0, memory_order_relaxed);
+        atomic_store_explicit(&r->ticks, 0, memory_order_relaxed);
+    }
+}
+
+void vec_stats_reset(void)
+{
+    vec_stats_buffer_t *b = atomic_load_explicit(&buffers, memory_order_acquire);
+    for (; b; b = b->next) clear_buffer(b);
+    clear_buffer(&shared);
+}
+
+#else // !VEC_STATS
+
+void vec_stats_snapshot(vec_stats_entry_t *out)
+{
+    memset(out, 0, VEC_STATS_COUNT * sizeof *out);
+}
+
+void vec_stats_reset(void)
+{
+}
+
+#endif // VEC_STATS
+
+bool vec_stats_enabled(void)
+{
+    return VEC_STATS;
+}
+
+bool vec_stats_timing(void)
+{
+#if VEC_STATS && VEC_STATS_TIMING && defined(__GNUC__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+const char *vec_stats_tick_unit(void)
+{
+    if (!vec_stats_timing()) return "none";
+#if defined(__x86_64__) || defined(__i386__)
+    return "tsc";
+#else
+    return "ns";
+#endif
+}
+
+#define VEC_STATS_NAME_(name) #name,
+
+static const char *const names[VEC_STATS_COUNT] = { VEC_STATS_FUNCS(VEC_STATS_NAME_) };
+
+const char *vec_stats_name(vec_stats_id_t id)
+{
+    return (unsigned)id < VEC_STATS_COUNT ? names[id] : "?";
+}
+
+/*
+ * Rows with no calls are left out of both formats; the table is sorted by
+ * the order of VEC_STATS_FUNCS, not by cost, so runs diff cleanly.
+ */
+void vec_stats_dump(FILE *out, vec_stats_format_t format)
+{
+    vec_stats_entry_t e[VEC_STATS_COUNT];
+    vec_stats_snapshot(e);
+    if (format == VEC_STATS_JSON) {
+        fprintf(out, "{\"enabled\": %s, \"tick_unit\": \"%s\", \"functions\": {",
+                vec_stats_enabled() ? "true" : "false", vec_stats_tick_unit());
+        const char *sep = "";
+        for (int i = 0; i < VEC_STATS_COUNT; i++) {
+            if (!e[i].calls) continue;
+            fprintf(out, "%s\n  \"%s\": {\"calls\": %llu, \"elements\": %llu, \"bytes_allocated\": %llu, "
+                    "\"bytes_freed\": %llu, \"ticks\": %llu}", sep, names[i], e[i].calls, e[i].elements,
+                    e[i].bytes_allocated, e[i].bytes_freed, e[i].ticks);
+            sep = ",";
+        }
+        fprintf(out, "%s}}\n", *sep ? "\n" : "");
+        return;
+    }
+    if (!vec_stats_enabled()) {
+        fprintf(out, "vec_stats: not compiled in (build with VEC_STATS=1)\n");
+        return;
+    }
+    fprintf(out, "%-24s %12s %14s %14s %14s %16s\n", "function", "calls", "elements",
+            "bytes alloc", "bytes freed", vec_stats_timing() ? "ticks" : "");
+    for (int i = 0; i < VEC_STATS_COUNT; i++) {
+        if (!e[i].calls) continue;
+        fprintf(out, "%-24s %12llu %14llu %14llu %14llu", names[i], e[i].calls, e[i].elements,
+                e[i].bytes_allocated, e[i].bytes_freed);
+        if (vec_stats_timing()) fprintf(out, " %16llu", e[i].ticks);
+        fprintf(out, "\n");
+    }
+}
@@ -0,0 +1,467 @@
+#include <vec_stream.h>
+#include <vec_simd.h>
+#include <vec_parallel.h>
+#include <vec_file.h>
+#include <stdatomic.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define VEC_STREAM_POSIX 1
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+#if defined(VEC_PARALLEL_PTHREADS)
+    #include <pthread.h>
+#endif
+
+typedef enum {
+    SOURCE_FD,
+    SOURCE_CALLBACK,
+    SOURCE_VECTOR
+} source_kind_t;
+
+/*
+ * Buffered sources keep two chunk buffers. The reader thread fills them
+ * alternately; `ready[i]` is set once buffer i holds data (or the end of
+ * the stream, count 0) and cleared when the consumer hands it back on its
+ * next vec_stream_next call.
+ */
+struct vec_stream {
+    source_kind_t kind;
+    size_t chunk;
+    uint64_t position;
+    atomic_bool failed;         // set by the reader thread, polled by vec_stream_failed
+
+    // SOURCE_FD
+    int fd;
+    bool own_fd;
+    uint64_t offset;            // byte offset of the next read
+    uint64_t remaining;         // elements left to read
+    // SOURCE_CALLBACK
+    vec_stream_read_f read;
+    void *ctx;
+    bool drained;               // the producer returned 0
+    // SOURCE_VECTOR
+    const float *data;
+    size_t size;
+
+    float *buf[2];
+    size_t count[2];
+    bool ready[2];
+    int fill;                   // buffer the reader fills next
+    int take;                   // buffer the consumer takes next
+    bool held;                  // the consumer still holds buffer `take`
+#if defined(VEC_PARALLEL_PTHREADS)
+    bool threaded;
+    bool stop;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+#endif
+};
+
+/**
+ * @brief VEC_PARALLEL_CHUNK times the smallest power of two that reaches
+ *        `chunk` (VEC_STREAM_CHUNK for 0), so per-chunk reductions line up
+ *        with the vec_parallel_reduce cascade.
+ */
+static size_t round_chunk(size_t chunk)
+{
+    if (chunk == 0) chunk = VEC_STREAM_CHUNK;
+    size_t c = VEC_PARALLEL_CHUNK;
+    while (c < chunk) c *= 2;
+    return c;
+}
+
+/*******************************************************READ**************************************************/
+
+/**
+ * @brief Fill one whole chunk (less only at the end of the source).
+ *        Returns the element count, 0 once the source is exhausted; sets
+ *        s->failed on a read error.
+ */
+static size_t source_fill(vec_stream_t *s, float *dst)
+{
+    size_t n = 0;
+    if (atomic_load_explicit(&s->failed, memory_order_relaxed)) return 0;
+    if (s->kind == SOURCE_CALLBACK) {
+        while (n < s->chunk && !s->drained) {
+            size_t got = s->read(s->ctx, dst + n, s->chunk - n);
+            if (got == 0) s->drained = true;
+            n += got;
+        }
+        return n;
+    }
+#ifdef VEC_STREAM_POSIX
+    size_t want = s->remaining < s->chunk ? (size_t)s->remaining : s->chunk;
+    unsigned char *p = (unsigned char *)dst;
+    size_t bytes = 0, total = want * sizeof(float);
+    while (bytes < total) {
+        ssize_t got = pread(s->fd, p + bytes, total - bytes, (off_t)(s->offset + bytes));
+        if (got < 0) {
+            atomic_store_explicit(&s->failed, true, memory_order_relaxed);
+            break;
+        }
+        if (got == 0) break;                    // end of file
+        bytes += (size_t)got;
+    }
+    n = bytes / sizeof(float);
+    s->offset += n * sizeof(float);
+    s->remaining = n < want ? 0 : s->remaining - n;
+#else
+    (void)dst;
+    atomic_store_explicit(&s->failed, true, memory_order_relaxed);
+#endif
+    return n;
+}
+
+#if defined(VEC_PARALLEL_PTHREADS)
+
+static void *reader_main(void *arg)
+{
+    vec_stream_t *s = (vec_stream_t *)arg;
+    pthread_mutex_lock(&s->lock);
+    for (;;) {
+        while (s->ready[s->fill] && !s->stop) pthread_cond_wait(&s->cond, &s->lock);
+        if (s->stop) break;
+        int slot = s->fill;
+        pthread_mutex_unlock(&s->lock);
+
+        size_t n = source_fill(s, s->buf[slot]);
+
+        pthread_mutex_lock(&s->lock);
+        s->count[slot] = n;
+        s->ready[slot] = true;
+        s->fill ^= 1;
+        pthread_cond_broadcast(&s->cond);
+        if (n == 0) break;                      // end marker published
+    }
+    pthread_mutex_unlock(&s->lock);
+    return NULL;
+}
+
+#endif
+
+static vec_stream_t *stream_new(source_kind_t kind, size_t chunk)
+{
+    vec_stream_t *s = (vec_stream_t *)calloc(1, sizeof *s);
+    if (!s) return NULL;
+    s->kind = kind;
+    s->chunk = round_chunk(chunk);
+    s->fd = -1;
+    return s;
+}
+
+/**
+ * @brief Allocate the two buffers and start the reader. Falls back to
+ *        synchronous reads if the thread cannot be created.
+ */
+static vec_stream_t *stream_start(vec_stream_t *s)
+{
+    s->buf[0] = (float *)malloc(s->chunk * sizeof(float));
+    s->buf[1] = (float *)malloc(s->chunk * sizeof(float));
+    if (!s->buf[0] || !s->buf[1]) {
+        vec_stream_close(s);
+        return NULL;
+    }
+#if defined(VEC_PARALLEL_PTHREADS)
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->cond, NULL);
+    s->threaded = pthread_create(&s->thread, NULL, reader_main, s) == 0;
+#endif
+    return s;
+}
+
+/*******************************************************OPEN**************************************************/
+
+vec_stream_t *vec_stream_open_fd(int fd, uint64_t offset, uint64_t length, size_t chunk)
+{
+    vec_stream_t *s = stream_new(SOURCE_FD, chunk);
+    if (!s) return NULL;
+    s->fd = fd;
+    s->offset = offset;
+    s->remaining = length;
+#if defined(VEC_STREAM_POSIX) && defined(POSIX_FADV_SEQUENTIAL)
+    posix_fadvise(fd, (off_t)offset, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    return stream_start(s);
+}
+
+vec_stream_t *vec_stream_open_file(const char *path, size_t chunk)
+{
+#ifdef VEC_STREAM_POSIX
+    vec_file_header_t h;
+    if (vec_file_read_header(path, &h) != VEC_FILE_OK || h.dtype != VEC_DTYPE_F32) return NULL;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    vec_stream_t *s = vec_stream_open_fd(fd, h.data_offset, h.length, chunk);
+    if (!s) {
+        close(fd);
+        return NULL;
+    }
+    s->own_fd = true;
+    return s;
+#else
+    (void)path;
+    (void)chunk;
+    return NULL;
+#endif
+}
+
+vec_stream_t *vec_stream_open_callback(vec_stream_read_f read, void *ctx, size_t chunk)
+{
+    vec_stream_t *s = stream_new(SOURCE_CALLBACK, chunk);
+    if (!s) return NULL;
+    s->read = read;
+    s->ctx = ctx;
+    return stream_start(s);
+}
+
+vec_stream_t *vec_stream_open_vector(vector_t v, size_t chunk)
+{
+    vec_stream_t *s = stream_new(SOURCE_VECTOR, chunk);
+    if (!s) return NULL;
+    s->data = v.data;
+    s->size = v.data ? v.size : 0;
+    return s;
+}
+
+void vec_stream_close(vec_stream_t *s)
+{
+    if (!s) return;
+#if defined(VEC_PARALLEL_PTHREADS)
+    if (s->threaded) {
+        pthread_mutex_lock(&s->lock);
+        s->stop = true;
+        pthread_cond_broadcast(&s->cond);
+        pthread_mutex_unlock(&s->lock);
+        pthread_join(s->thread, NULL);
+    }
+    if (s->buf[0] && s->buf[1]) {
+        pthread_mutex_destroy(&s->lock);
+        pthread_cond_destroy(&s->cond);
+    }
+#endif
+#ifdef VEC_STREAM_POSIX
+    if (s->own_fd) close(s->fd);
+#endif
+    free(s->buf[0]);
+    free(s->buf[1]);
+    free(s);
+}
+
+/*******************************************************NEXT**************************************************/
+
+static size_t vector_next(vec_stream_t *s, const float **chunk)
+{
+    size_t begin = (size_t)s->position;
+    size_t n = begin < s->size ? s->size - begin : 0;
+    if (n > s->chunk) n = s->chunk;
+    *chunk = s->data + begin;
+#if defined(VEC_STREAM_POSIX) && defined(MADV_WILLNEED)
+    // ask for the following chunk now; page-granular, so round down
+    size_t ahead = begin + n < s->size ? s->size - (begin + n) : 0;
+    if (ahead > 0) {
+        const float *next = s->data + begin + n;
+        size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        size_t skew = (size_t)next & (page - 1);
+        size_t len = (ahead < s->chunk ? ahead : s->chunk) * sizeof(float) + skew;
+        madvise((void *)((size_t)next - skew), len, MADV_WILLNEED);
+    }
+#endif
+    return n;
+}
+
+size_t vec_stream_next(vec_stream_t *s, const float **chunk)
+{
+    size_t n;
+    if (s->kind == SOURCE_VECTOR) {
+        n = vector_next(s, chunk);
+        s->position += n;
+        return n;
+    }
+#if defined(VEC_PARALLEL_PTHREADS)
+    if (s->threaded) {
+        pthread_mutex_lock(&s->lock);
+        if (s->held) {                          // hand the previous buffer back
+            s->ready[s->take] = false;
+            s->take ^= 1;
+            s->held = false;
+            pthread_cond_broadcast(&s->cond);
+        }
+        while (!s->ready[s->take]) pthread_cond_wait(&s->cond, &s->lock);
+        n = s->count[s->take];
+        s->held = n > 0;
+        pthread_mutex_unlock(&s->lock);
+        *chunk = s->buf[s->take];
+        s->position += n;
+        return n;
+    }
+#endif
+    // synchronous fallback: one buffer is enough
+    n = source_fill(s, s->buf[0]);
+    *chunk = s->buf[0];
+    s->position += n;
+    return n;
+}
+
+size_t vec_stream_chunk(const vec_stream_t *s)
+{
+    return s->chunk;
+}
+
+uint64_t vec_stream_position(const vec_stream_t *s)
+{
+    return s->position;
+}
+
+bool vec_stream_failed(const vec_stream_t *s)
+{
+    return atomic_load_explicit(&s->failed, memory_order_relaxed);
+}
+
+/****************************************************REDUCTIONS***********************************************/
+
+/*
+ * Each chunk is reduced with vec_parallel_reduce, and the per-chunk results
+ * go through the same cascade, so a stream gives the bits of the one-shot
+ * vector_* reduction over the concatenated data.
+ */
+typedef struct {
+    const float *a;
+    const float *b;
+} stream_pair_t;
+
+static double sum_chunk(void *ctx, size_t begin, size_t end)
+{
+    const stream_pair_t *p = ctx;
+    return vec_kernels()->sum(p->a + begin, end - begin);
+}
+
+static double dot_chunk(void *ctx, size_t begin, size_t end)
+{
+    const stream_pair_t *p = ctx;
+    return vec_kernels()->dot(p->a + begin, p->b + begin, end - begin);
+}
+
+double vec_stream_sum(vec_stream_t *s)
+{
+    vec_cascade_t c = { .top = 0 };
+    const float *chunk;
+    size_t n;
+    while ((n = vec_stream_next(s, &chunk)) > 0) {
+        stream_pair_t p = { chunk, chunk };
+        vec_cascade_push(&c, vec_parallel_reduce(n, sum_chunk, &p));
+    }
+    return vec_cascade_finish(&c);
+}
+
+float vec_stream_dot(vec_stream_t *a, vec_stream_t *b)
+{
+    if (a->chunk != b->chunk) return 0.0f;
+    vec_cascade_t c = { .top = 0 };
+    for (;;) {
+        const float *ca, *cb;
+        size_t na = vec_stream_next(a, &ca), nb = na;
+        if (a == b) cb = ca;
+        else nb = vec_stream_next(b, &cb);
+        if (na != nb) return 0.0f;
+        if (na == 0) break;
+        stream_pair_t p = { ca, cb };
+        vec_cascade_push(&c, vec_parallel_reduce(na, dot_chunk, &p));
+    }
+    return (float)vec_cascade_finish(&c);
+}
+
+float vec_stream_magnitude(vec_stream_t *s)
+{
+    return sqrt_f(vec_stream_dot(s, s));
+}
+
+/****************************************************ELEMENT-WISE*********************************************/
+
+static vec_binary_kernel_f binary_kernel(vec_stream_op_t op)
+{
+    const vec_kernels_t *k = vec_kernels();
+    switch (op) {
+        case VEC_STREAM_ADD: return k->add;
+        case VEC_STREAM_SUB: return k->sub;
+        case VEC_STREAM_MUL: return k->mul;
+        default:             return k->div;
+    }
+}
+
+static vec_scalar_kernel_f scalar_kernel(vec_stream_op_t op)
+{
+    const vec_kernels_t *k = vec_kernels();
+    switch (op) {
+        case VEC_STREAM_ADD: return k->scalar_add;
+        case VEC_STREAM_SUB: return k->scalar_sub;
+        case VEC_STREAM_MUL: return k->scalar_mul;
+        default:             return k->scalar_div;
+    }
+}
+
+/**
+ * @brief The result chunk is computed into one output buffer of chunk size
+ *        and handed to `write` before the next chunk is read. Returns false
+ *        if the lengths differ, a read failed, or `write` gave up.
+ */
+bool vec_stream_binary(vec_stream_op_t op, vec_stream_t *a, vec_stream_t *b,
+                       vec_stream_write_f write, void *ctx)
+{
+    if (a->chunk != b->chunk || a == b) return false;
+    float *out = (float *)malloc(a->chunk * sizeof(float));
+    if (!out) return false;
+    vec_binary_kernel_f k = binary_kernel(op);
+    bool ok = true;
+    for (;;) {
+        const float *ca, *cb;
+        size_t na = vec_stream_next(a, &ca), nb = vec_stream_next(b, &cb);
+        if (na != nb) ok = false;
+        if (!ok || na == 0) break;
+        vec_parallel_binary(k, out, ca, cb, na);
+        ok = write(ctx, out, na);
+    }
+    free(out);
+    return ok && !vec_stream_failed(a) && !vec_stream_failed(b);
+}
+
+bool vec_stream_scalar(vec_stream_op_t op, vec_stream_t *a, float s,
+                       vec_stream_write_f write, void *ctx)
+{
+    float *out = (float *)malloc(a->chunk * sizeof(float));
+    if (!out) return false;
+    vec_scalar_kernel_f k = scalar_kernel(op);
+    bool ok = true;
+    const float *ca;
+    size_t n;
+    while (ok && (n = vec_stream_next(a, &ca)) > 0) {
+        vec_parallel_scalar(k, out, ca, s, n);
+        ok = write(ctx, out, n);
+    }
+    free(out);
+    return ok && !vec_stream_failed(a);
+}
+
+bool vec_stream_write_fd(void *ctx, const float *src, size_t n)
+{
+#ifdef VEC_STREAM_POSIX
+    int fd = *(const int *)ctx;
+    const unsigned char *p = (const unsigned char *)src;
+    size_t bytes = n * sizeof(float);
+    while (bytes > 0) {
+        ssize_t put = write(fd, p, bytes);
+        if (put <= 0) return false;
+        p += put;
+        bytes -= (size_t)put;
+    }
+    return true;
+#else
+    (void)ctx;
+    (void)src;
+    (void)n;
+    return false;
+#endif
+}
@@ -0,0 +1,272 @@
+#include <vec_view.h>
+#include <vec_simd.h>
+#include <vec_parallel.h>
+#include <math_batch.h>
+#include <limits.h>
+#include <stdatomic.h>
+
+const vec_view_t VIEW_UNDEFINED = {0, NULL, 0};
+const dvec_view_t DVIEW_UNDEFINED = {0, NULL, 0};
+
+#ifndef VEC_VIEW_BLOCK
+    #define VEC_VIEW_BLOCK 512      // elements gathered per step (stack buffers)
+#endif
+
+/**
+ * @brief True if offset + i*stride lies in [0, size) for every i < length.
+ *        Written so that no intermediate can overflow.
+ */
+static bool view_in_range(size_t size, size_t offset, size_t length, ptrdiff_t stride)
+{
+    if (length == 0) return true;
+    if (offset >= size) return false;
+    size_t steps = length - 1;
+    if (stride >= 0) return stride == 0 || steps <= (size - 1 - offset) / (size_t)stride;
+    return steps <= offset / ((size_t)0 - (size_t)stride);
+}
+
+typedef enum {
+    VIEW_COPY,
+    VIEW_BINARY,
+    VIEW_SCALAR,
+    VIEW_POW
+} view_kind_t;
+
+/*
+ * Everything below is generated once for float and once for double:
+ *
+ *   P      - name prefix (vec_view / dvec_view)
+ *   VIEW   - view type,  VEC - vector type, T - element type
+ *   KT     - kernel table type and KERNELS() the active table
+ *   BIN_F / SCA_F - binary / scalar kernel types
+ *   ALLOC, DEFAULT, VEC_UNDEF, VIEW_UNDEF - vec.c counterparts
+ *   POW_PLAN / POW_APPLY - pow_plan_t constructor and applier (math_batch.h)
+ *
+ * Element-wise operations run over the pool in VEC_PARALLEL_CHUNK chunks.
+ * Within a chunk, contiguous operands are passed to the kernel as they
+ * are; strided ones are gathered VEC_VIEW_BLOCK elements at a time, and a
+ * strided destination receives its block through the scatter kernel.
+ */
+#define VIEW_API(P, VIEW, VEC, T, KT, KERNELS, BIN_F, SCA_F, ALLOC, DEFAULT,       \
+                 VEC_UNDEF, VIEW_UNDEF, POW_PLAN, POW_APPLY)                        \
+                                                                                    \
+VIEW P(VEC v, size_t offset, size_t length, ptrdiff_t stride)                       \
+{                                                                                   \
+    if (!v.data || !view_in_range(v.size, offset, length, stride)) return VIEW_UNDEF; \
+    VIEW r = { length, length ? v.data + offset : v.data, stride };                 \
+    return r;                                                                       \
+}                                                                                   \
+                                                                                    \
+VIEW P##_slice(VIEW v, size_t offset, size_t length, ptrdiff_t step)                \
+{                                                                                   \
+    if (!v.data || !view_in_range(v.size, offset, length, step)) return VIEW_UNDEF; \
+    VIEW r = { length, length ? v.data + (ptrdiff_t)offset * v.stride : v.data,     \
+               v.stride * step };                                                   \
+    return r;                                                                       \
+}                                                                                   \
+                                                                                    \
+bool P##_is_contiguous(VIEW v)                                                      \
+{                                                                                   \
+    return v.stride == 1 || v.size <= 1;                                            \
+}                                                                                   \
+                                                                                    \
+typedef struct {                                                                    \
+    view_kind_t kind;                                                               \
+    VIEW dst, a, b;                                                                 \
+    BIN_F binary;                                                                   \
+    SCA_F scalar;                                                                   \
+    T s;                                                                            \
+    pow_plan_t plan;                                                                \
+} P##_op_t;                                                                         \
+                                                                                    \
+/* elements [i, i + n) of v, contiguous: in place or gathered into buf */           \
+static const T *P##_in(const KT *k, VIEW v, size_t i, size_t n, T *buf)             \
+{                                                                                   \
+    const T *p = v.data + (ptrdiff_t)i * v.stride;                                  \
+    if (P##_is_contiguous(v)) return p;                                             \
+    k->gather(buf, p, v.stride, n);                                                 \
+    return buf;                                                                     \
+}                                                                                   \
+                                                                                    \
+static void P##_copy_block(const KT *k, VIEW dst, VIEW src, size_t i, size_t n, T *buf) \
+{                                                                                   \
+    T *d = dst.data + (ptrdiff_t)i * dst.stride;                                    \
+    const T *s = src.data + (ptrdiff_t)i * src.stride;                              \
+    if (P##_is_contiguous(dst)) {                                                   \
+        k->gather(d, s, P##_is_contiguous(src) ? 1 : src.stride, n);                \
+    } else {                                                                        \
+        k->scatter(d, dst.stride, P##_in(k, src, i, n, buf), n);                    \
+    }                                                                               \
+}                                                                                   \
+                                                                                    \
+static void P##_op_chunk(void *ctx, size_t begin, size_t end)                       \
+{                                                                                   \
+    const P##_op_t *op = ctx;                                                       \
+    const KT *k = KERNELS();                                                        \
+    T ta[VEC_VIEW_BLOCK], tb[VEC_VIEW_BLOCK], td[VEC_VIEW_BLOCK];                   \
+    bool flat = P##_is_contiguous(op->dst) && P##_is_contiguous(op->a)              \
+             && (op->kind != VIEW_BINARY || P##_is_contiguous(op->b));              \
+    size_t block = flat ? end - begin : VEC_VIEW_BLOCK;                             \
+                                                                                    \
+    for (size_t i = begin; i < end; i += block) {                                   \
+        size_t n = end - i < block ? end - i : block;                               \
+        if (op->kind == VIEW_COPY) {                                                \
+            P##_copy_block(k, op->dst, op->a, i, n, ta);                            \
+            continue;                                                               \
+        }                                                                           \
+        const T *a = P##_in(k, op->a, i, n, ta);                                    \
+        T *d = P##_is_contiguous(op->dst) ? op->dst.data + i : td;                  \
+        switch (op->kind) {                                                         \
+            case VIEW_BINARY:                                                       \
+                op->binary(d, a, P##_in(k, op->b, i, n, tb), n);                    \
+                break;                                                              \
+            case VIEW_SCALAR:                                                       \
+                op->scalar(d, a, op->s, n);                                         \
+                break;                                                              \
+            default:                                                                \
+                POW_APPLY(&op->plan, d, a, n);                                      \
+                break;                                                              \
+        }                                                                           \
+        if (d == td) k->scatter(op->dst.data + (ptrdiff_t)i * op->dst.stride,       \
+                                op->dst.stride, td, n);                             \
+    }                                                                               \
+}                                                                                   \
+                                                                                    \
+/* new vector of v.size elements; VEC_UNDEF if the vector type can't hold it */     \
+static VEC P##_result(VIEW v)                                                       \
+{                                                                                   \
+    return v.size > UINT_MAX ? VEC_UNDEF : ALLOC((unsigned int)v.size);             \
+}                                                                                   \
+                                                                                    \
+static VIEW P##_whole(VEC v)                                                        \
+{                                                                                   \
+    VIEW r = { v.size, v.data, 1 };                                                 \
+    return r;                                                                       \
+}                                                                                   \
+                                                                                    \
+bool P##_assign(VIEW dst, VIEW src)                                                 \
+{                                                                                   \
+    if (dst.size != src.size) return false;                                         \
+    P##_op_t op = { .kind = VIEW_COPY, .dst = dst, .a = src };                      \
+    vec_parallel_for(dst.size, P##_op_chunk, &op);                                  \
+    return true;                                                                    \
+}                                                                                   \
+                                                                                    \
+VEC P##_copy(VIEW v)                                                                \
+{                                                                                   \
+    VEC r = P##_result(v);                                                          \
+    if (r.data) P##_assign(P##_whole(r), v);                                        \
+    return r;                                                                       \
+}                                                                                   \
+                                                                                    \
+typedef struct {                                                                    \
+    VIEW a, b;                                                                      \
+    atomic_bool differs;                                                            \
+} P##_equals_t;                                                                     \
+                                                                                    \
+static void P##_equals_chunk(void *ctx, size_t begin, size_t end)                   \
+{                                                                                   \
+    P##_equals_t *c = ctx;                                                          \
+    if (atomic_load_explicit(&c->differs, memory_order_relaxed)) return;            \
+    const T *a = c->a.data, *b = c->b.data;                                         \
+    for (size_t i = begin; i < end; i++) {                                          \
+        if (a[(ptrdiff_t)i * c->a.stride] != b[(ptrdiff_t)i * c->b.stride]) {       \
+            atomic_store_explicit(&c->differs, true, memory_order_relaxed);         \
+            return;                                                                 \
+        }                                                                           \
+    }                                                                               \
+}                                                                                   \
+                                                                                    \
+bool P##_equals(VIEW a, VIEW b)                                                     \
+{                                                                                   \
+    if (a.size != b.size) return false;                                             \
+    P##_equals_t c = { a, b, false };                                               \
+    vec_parallel_for(a.size, P##_equals_chunk, &c);                                 \
+    return !atomic_load(&c.differs);                                                \
+}                                                                                   \
+                                                                                    \
+static bool P##_binary_to(BIN_F kernel, VIEW dst, VIEW a, VIEW b)                   \
+{                                                                                   \
+    if (dst.size != a.size || a.size != b.size) return false;                       \
+    P##_op_t op = { .kind = VIEW_BINARY, .dst = dst, .a = a, .b = b, .binary = kernel }; \
+    vec_parallel_for(dst.size, P##_op_chunk, &op);                                  \
+    return true;                                                                    \
+}                                                                                   \
+                                                                                    \
+static bool P##_scalar_to(SCA_F kernel, VIEW dst, VIEW a, T s)                      \
+{                                                                                   \
+    if (dst.size != a.size) return false;                                           \
+    P##_op_t op = { .kind = VIEW_SCALAR, .dst = dst, .a = a, .scalar = kernel, .s = s }; \
+    vec_parallel_for(dst.size, P##_op_chunk, &op);                                  \
+    return true;                                                                    \
+}                                                                                   \
+                                                                                    \
+VIEW_BINARY_OP(P, VIEW, VEC, KERNELS, VEC_UNDEF, add)                               \
+VIEW_BINARY_OP(P, VIEW, VEC, KERNELS, VEC_UNDEF, sub)                               \
+VIEW_BINARY_OP(P, VIEW, VEC, KERNELS, VEC_UNDEF, mul)                               \
+VIEW_BINARY_OP(P, VIEW, VEC, KERNELS, VEC_UNDEF, div)                               \
+VIEW_SCALAR_OP(P, VIEW, VEC, T, KERNELS, add)                                       \
+VIEW_SCALAR_OP(P, VIEW, VEC, T, KERNELS, sub)                                       \
+VIEW_SCALAR_OP(P, VIEW, VEC, T, KERNELS, mul)                                       \
+                                                                                    \
+VEC P##_scalar_div(VIEW a, T s)                                                     \
+{                                                                                   \
+    if (s == 0) return a.size > UINT_MAX ? VEC_UNDEF : DEFAULT((unsigned int)a.size, INFINITY); \
+    VEC r = P##_result(a);                                                          \
+    if (r.data) P##_scalar_to(KERNELS()->scalar_div, P##_whole(r), a, s);           \
+    return r;                                                                       \
+}                                                                                   \
+                                                                                    \
+bool P##_scalar_div_to(VIEW dst, VIEW a, T s)                                       \
+{                                                                                   \
+    if (s == 0) return false;                                                       \
+    return P##_scalar_to(KERNELS()->scalar_div, dst, a, s);                         \
+}                                                                                   \
+                                                                                    \
+bool P##_pow_to(VIEW dst, VIEW a, T power)                                          \
+{                                                                                   \
+    if (dst.size != a.size) return false;                                           \
+    P##_op_t op = { .kind = VIEW_POW, .dst = dst, .a = a, .plan = POW_PLAN(power) }; \
+    vec_parallel_for(dst.size, P##_op_chunk, &op);                                  \
+    return true;                                                                    \
+}                                                                                   \
+                                                                                    \
+VEC P##_pow(VIEW a, T power)                                                        \
+{                                                                                   \
+    VEC r = P##_result(a);                                                          \
+    if (r.data) P##_pow_to(P##_whole(r), a, power);                                 \
+    return r;                                                                       \
+}
+
+#define VIEW_BINARY_OP(P, VIEW, VEC, KERNELS, VEC_UNDEF, name)                      \
+bool P##_##name##_to(VIEW dst, VIEW a, VIEW b)                                      \
+{                                                                                   \
+    return P##_binary_to(KERNELS()->name, dst, a, b);                               \
+}                                                                                   \
+VEC P##_##name(VIEW a, VIEW b)                                                      \
+{                                                                                   \
+    if (a.size != b.size) return VEC_UNDEF;                                         \
+    VEC r = P##_result(a);                                                          \
+    if (r.data) P##_binary_to(KERNELS()->name, P##_whole(r), a, b);                 \
+    return r;                                                                       \
+}
+
+#define VIEW_SCALAR_OP(P, VIEW, VEC, T, KERNELS, name)                              \
+bool P##_scalar_##name##_to(VIEW dst, VIEW a, T s)                                  \
+{                                                                                   \
+    return P##_scalar_to(KERNELS()->scalar_##name, dst, a, s);                      \
+}                                                                                   \
+VEC P##_scalar_##name(VIEW a, T s)                                                  \
+{                                                                                   \
+    VEC r = P##_result(a);                                                          \
+    if (r.data) P##_scalar_to(KERNELS()->scalar_##name, P##_whole(r), a, s);        \
+    return r;                                                                       \
+}
+
+VIEW_API(vec_view, vec_view_t, vector_t, float, vec_kernels_t, vec_kernels,
+         vec_binary_kernel_f, vec_scalar_kernel_f, vector_alloc, vector_default,
+         VEC_UNDEFINED, VIEW_UNDEFINED, pow_plan_f, pow_plan_apply_f)
+
+VIEW_API(dvec_view, dvec_view_t, dvector_t, double, vec_dkernels_t, vec_dkernels,
+         vec_dbinary_kernel_f, vec_dscalar_kernel_f, allocate_d, dvec_default,
+         DVEC_UNDEFINED, DVIEW_UNDEFINED, pow_plan_d, pow_plan_apply_d)
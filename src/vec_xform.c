@@ -0,0 +1,632 @@
+#include <vec_xform.h>
+#include <vec_simd.h>
+#include <vec_parallel.h>
+#include <math.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    #define VEC_SIMD_X86 1
+    #include <immintrin.h>
+#endif
+
+/*
+ * What a kernel does with the matrix:
+ *
+ *   XF_AFFINE     - rows 0-2 including the translation column (12 floats)
+ *   XF_PROJECTIVE - all four rows, then x', y', z' times 1 / w' (16 floats)
+ *   XF_LINEAR     - the upper 3x3 only (directions, normal matrices)
+ */
+typedef enum {
+    XF_AFFINE = 0,
+    XF_PROJECTIVE,
+    XF_LINEAR,
+    XF_KINDS
+} xf_kind_t;
+
+typedef void (*xf_soa_f)(const float *m, float *dx, float *dy, float *dz,
+                         const float *x, const float *y, const float *z, size_t n);
+typedef void (*xf_aos_f)(const float *m, float *dst, const float *src, size_t n);
+
+typedef struct {
+    xf_soa_f soa[XF_KINDS];
+    xf_aos_f aos[XF_KINDS];
+} xform_kernels_t;
+
+/*
+ * One template serves every level: the scalar level is a vector of width
+ * 1, so it runs the same operations in the same order as the SIMD ones and
+ * also serves as their tail. `kind` is a constant in every instantiation,
+ * so the branches fold away.
+ */
+#define XF_APPLY(isa)                                                               \
+static TARGET_##isa inline void apply_##isa(xf_kind_t kind, const VEC_##isa *mv,    \
+                                            VEC_##isa x, VEC_##isa y, VEC_##isa z, VEC_##isa *o) \
+{                                                                                   \
+    for (int r = 0; r < 3; r++) {                                                   \
+        o[r] = ADD_##isa(ADD_##isa(MUL_##isa(mv[4 * r], x), MUL_##isa(mv[4 * r + 1], y)), \
+                         MUL_##isa(mv[4 * r + 2], z));                              \
+        if (kind != XF_LINEAR) o[r] = ADD_##isa(o[r], mv[4 * r + 3]);               \
+    }                                                                               \
+    if (kind == XF_PROJECTIVE) {                                                    \
+        VEC_##isa w = ADD_##isa(ADD_##isa(ADD_##isa(MUL_##isa(mv[12], x), MUL_##isa(mv[13], y)), \
+                                          MUL_##isa(mv[14], z)), mv[15]);           \
+        VEC_##isa s = DIV_##isa(SET1_##isa(1.0f), w);                               \
+        for (int r = 0; r < 3; r++) o[r] = MUL_##isa(o[r], s);                      \
+    }                                                                               \
+}
+
+#define XF_KERNEL(isa, K, kind)                                                     \
+static TARGET_##isa void soa_##isa##_##K(const float *m, float *dx, float *dy, float *dz, \
+                                         const float *x, const float *y, const float *z, size_t n) \
+{                                                                                   \
+    VEC_##isa mv[16], o[3];                                                         \
+    for (int e = 0; e < (kind == XF_PROJECTIVE ? 16 : 12); e++) mv[e] = SET1_##isa(m[e]); \
+    size_t i = 0;                                                                   \
+    for (; i + W_##isa <= n; i += W_##isa) {                                        \
+        apply_##isa(kind, mv, LOADU_##isa(x + i), LOADU_##isa(y + i), LOADU_##isa(z + i), o); \
+        STOREU_##isa(dx + i, o[0]);                                                 \
+        STOREU_##isa(dy + i, o[1]);                                                 \
+        STOREU_##isa(dz + i, o[2]);                                                 \
+    }                                                                               \
+    TAIL_##isa(soa_scalar_##K(m, dx + i, dy + i, dz + i, x + i, y + i, z + i, n - i)); \
+}                                                                                   \
+static TARGET_##isa void aos_##isa##_##K(const float *m, float *dst, const float *src, size_t n) \
+{                                                                                   \
+    VEC_##isa mv[16], x, y, z, o[3];                                                \
+    for (int e = 0; e < (kind == XF_PROJECTIVE ? 16 : 12); e++) mv[e] = SET1_##isa(m[e]); \
+    size_t i = 0;                                                                   \
+    for (; i + W_##isa <= n; i += W_##isa) {                                        \
+        DEINT_##isa(src + 3 * i, x, y, z);                                          \
+        apply_##isa(kind, mv, x, y, z, o);                                          \
+        INTER_##isa(dst + 3 * i, o[0], o[1], o[2]);                                 \
+    }                                                                               \
+    TAIL_##isa(aos_scalar_##K(m, dst + 3 * i, src + 3 * i, n - i));                 \
+}
+
+#define XF_LEVEL(isa)                                                               \
+XF_APPLY(isa)                                                                       \
+XF_KERNEL(isa, affine, XF_AFFINE)                                                   \
+XF_KERNEL(isa, projective, XF_PROJECTIVE)                                           \
+XF_KERNEL(isa, linear, XF_LINEAR)                                                   \
+static const xform_kernels_t xform_kernels_##isa = {                                \
+    { soa_##isa##_affine, soa_##isa##_projective, soa_##isa##_linear },             \
+    { aos_##isa##_affine, aos_##isa##_projective, aos_##isa##_linear }              \
+};
+
+/****************************************************SCALAR***************************************************/
+
+#define TARGET_scalar
+#define VEC_scalar          float
+#define W_scalar            1
+#define LOADU_scalar(p)     (*(p))
+#define STOREU_scalar(p, v) (*(p) = (v))
+#define SET1_scalar(s)      (s)
+#define ADD_scalar(a, b)    ((a) + (b))
+#define MUL_scalar(a, b)    ((a) * (b))
+#define DIV_scalar(a, b)    ((a) / (b))
+#define DEINT_scalar(p, x, y, z)  ((x) = (p)[0], (y) = (p)[1], (z) = (p)[2])
+#define INTER_scalar(p, x, y, z)  ((p)[0] = (x), (p)[1] = (y), (p)[2] = (z))
+#define TAIL_scalar(call)
+
+XF_LEVEL(scalar)
+
+#ifdef VEC_SIMD_X86
+
+/*
+ * AoS in registers. W points are 3W floats in three registers; lane l of
+ * register r holds component (rW + l) % 3 of point (rW + l) / 3. For one
+ * component the lanes of r0, r1 and r2 that hold it are disjoint, so two
+ * blends gather all W values of it into one register and a permute puts
+ * them in point order (lane (3p + c) % W holds point p). Storing runs the
+ * same steps backwards.
+ */
+#define TARGET_avx2   __attribute__((target("avx2")))
+#define TARGET_avx512 __attribute__((target("avx512f")))
+
+#define VEC_avx2   __m256
+#define VEC_avx512 __m512
+#define W_avx2     8
+#define W_avx512   16
+
+#define LOADU_avx2(p)      _mm256_loadu_ps(p)
+#define STOREU_avx2(p, v)  _mm256_storeu_ps(p, v)
+#define SET1_avx2(s)       _mm256_set1_ps(s)
+#define ADD_avx2(a, b)     _mm256_add_ps(a, b)
+#define MUL_avx2(a, b)     _mm256_mul_ps(a, b)
+#define DIV_avx2(a, b)     _mm256_div_ps(a, b)
+#define TAIL_avx2(call)    call
+
+#define LOADU_avx512(p)     _mm512_loadu_ps(p)
+#define STOREU_avx512(p, v) _mm512_storeu_ps(p, v)
+#define SET1_avx512(s)      _mm512_set1_ps(s)
+#define ADD_avx512(a, b)    _mm512_add_ps(a, b)
+#define MUL_avx512(a, b)    _mm512_mul_ps(a, b)
+#define DIV_avx512(a, b)    _mm512_div_ps(a, b)
+#define TAIL_avx512(call)   call
+
+// lanes l with l % 3 == 0, 1, 2
+#define L0_avx2 0x49
+#define L1_avx2 0x92
+#define L2_avx2 0x24
+#define L0_avx512 0x9249
+#define L1_avx512 0x2492
+#define L2_avx512 0x4924
+
+static TARGET_avx2 inline void deint_avx2(const float *p, __m256 *x, __m256 *y, __m256 *z)
+{
+    __m256 r0 = _mm256_loadu_ps(p), r1 = _mm256_loadu_ps(p + 8), r2 = _mm256_loadu_ps(p + 16);
+    __m256 tx = _mm256_blend_ps(_mm256_blend_ps(r0, r1, L1_avx2), r2, L2_avx2);
+    __m256 ty = _mm256_blend_ps(_mm256_blend_ps(r0, r1, L2_avx2), r2, L0_avx2);
+    __m256 tz = _mm256_blend_ps(_mm256_blend_ps(r0, r1, L0_avx2), r2, L1_avx2);
+    *x = _mm256_permutevar8x32_ps(tx, _mm256_setr_epi32(0, 3, 6, 1, 4, 7, 2, 5));
+    *y = _mm256_permutevar8x32_ps(ty, _mm256_setr_epi32(1, 4, 7, 2, 5, 0, 3, 6));
+    *z = _mm256_permutevar8x32_ps(tz, _mm256_setr_epi32(2, 5, 0, 3, 6, 1, 4, 7));
+}
+
+static TARGET_avx2 inline void inter_avx2(float *p, __m256 x, __m256 y, __m256 z)
+{
+    __m256 tx = _mm256_permutevar8x32_ps(x, _mm256_setr_epi32(0, 3, 6, 1, 4, 7, 2, 5));
+    __m256 ty = _mm256_permutevar8x32_ps(y, _mm256_setr_epi32(5, 0, 3, 6, 1, 4, 7, 2));
+    __m256 tz = _mm256_permutevar8x32_ps(z, _mm256_setr_epi32(2, 5, 0, 3, 6, 1, 4, 7));
+    _mm256_storeu_ps(p, _mm256_blend_ps(_mm256_blend_ps(tx, ty, L1_avx2), tz, L2_avx2));
+    _mm256_storeu_ps(p + 8, _mm256_blend_ps(_mm256_blend_ps(tx, ty, L2_avx2), tz, L0_avx2));
+    _mm256_storeu_ps(p + 16, _mm256_blend_ps(_mm256_blend_ps(tx, ty, L0_avx2), tz, L1_avx2));
+}
+
+static TARGET_avx512 inline void deint_avx512(const float *p, __m512 *x, __m512 *y, __m512 *z)
+{
+    __m512 r0 = _mm512_loadu_ps(p), r1 = _mm512_loadu_ps(p + 16), r2 = _mm512_loadu_ps(p + 32);
+    __m512 tx = _mm512_mask_blend_ps(L1_avx512, _mm512_mask_blend_ps(L2_avx512, r0, r1), r2);
+    __m512 ty = _mm512_mask_blend_ps(L2_avx512, _mm512_mask_blend_ps(L0_avx512, r0, r1), r2);
+    __m512 tz = _mm512_mask_blend_ps(L0_avx512, _mm512_mask_blend_ps(L1_avx512, r0, r1), r2);
+    *x = _mm512_permutexvar_ps(_mm512_setr_epi32(0, 3, 6, 9, 12, 15, 2, 5, 8, 11, 14, 1, 4, 7, 10, 13), tx);
+    *y = _mm512_permutexvar_ps(_mm512_setr_epi32(1, 4, 7, 10, 13, 0, 3, 6, 9, 12, 15, 2, 5, 8, 11, 14), ty);
+    *z = _mm512_permutexvar_ps(_mm512_setr_epi32(2, 5, 8, 11, 14, 1, 4, 7, 10, 13, 0, 3, 6, 9, 12, 15), tz);
+}
+
+static TARGET_avx512 inline void inter_avx512(float *p, __m512 x, __m512 y, __m512 z)
+{
+    __m512 tx = _mm512_permutexvar_ps(_mm512_setr_epi32(0, 11, 6, 1, 12, 7, 2, 13, 8, 3, 14, 9, 4, 15, 10, 5), x);
+    __m512 ty = _mm512_permutexvar_ps(_mm512_setr_epi32(5, 0, 11, 6, 1, 12, 7, 2, 13, 8, 3, 14, 9, 4, 15, 10), y);
+    __m512 tz = _mm512_permutexvar_ps(_mm512_setr_epi32(10, 5, 0, 11, 6, 1, 12, 7, 2, 13, 8, 3, 14, 9, 4, 15), z);
+    _mm512_storeu_ps(p, _mm512_mask_blend_ps(L2_avx512, _mm512_mask_blend_ps(L1_avx512, tx, ty), tz));
+    _mm512_storeu_ps(p + 16, _mm512_mask_blend_ps(L1_avx512, _mm512_mask_blend_ps(L0_avx512, tx, ty), tz));
+    _mm512_storeu_ps(p + 32, _mm512_mask_blend_ps(L0_avx512, _mm512_mask_blend_ps(L2_avx512, tx, ty), tz));
+}
+
+#define DEINT_avx2(p, x, y, z)     deint_avx2(p, &(x), &(y), &(z))
+#define INTER_avx2(p, x, y, z)     inter_avx2(p, x, y, z)
+#define DEINT_avx512(p, x, y, z)   deint_avx512(p, &(x), &(y), &(z))
+#define INTER_avx512(p, x, y, z)   inter_avx512(p, x, y, z)
+
+XF_LEVEL(avx2)
+XF_LEVEL(avx512)
+
+#endif // VEC_SIMD_X86
+
+/****************************************************DISPATCH*************************************************/
+
+// SSE2 runs the scalar kernels: without permutes the AoS shuffles cost more than they save
+static const xform_kernels_t *xform_kernels(void)
+{
+#ifdef VEC_SIMD_X86
+    vec_isa_t isa = vec_isa_active();
+    if (isa >= VEC_ISA_AVX512) return &xform_kernels_avx512;
+    if (isa >= VEC_ISA_AVX2) return &xform_kernels_avx2;
+#endif
+    return &xform_kernels_scalar;
+}
+
+/****************************************************BATCHES**************************************************/
+
+typedef struct {
+    const float *m;
+    xf_soa_f soa;
+    xf_aos_f aos;
+    vec3_soa_t dst, src;
+    float *adst;
+    const float *asrc;
+} xform_job_t;
+
+static void soa_chunk(void *ctx, size_t begin, size_t end)
+{
+    const xform_job_t *j = ctx;
+    j->soa(j->m, j->dst.x + begin, j->dst.y + begin, j->dst.z + begin,
+           j->src.x + begin, j->src.y + begin, j->src.z + begin, end - begin);
+}
+
+static void aos_chunk(void *ctx, size_t begin, size_t end)
+{
+    const xform_job_t *j = ctx;
+    j->aos(j->m, j->adst + 3 * begin, j->asrc + 3 * begin, end - begin);
+}
+
+static void run_aos(const float *m, xf_kind_t kind, float *dst, const float *src, size_t n)
+{
+    xform_job_t j = { m, NULL, xform_kernels()->aos[kind], { NULL, NULL, NULL }, { NULL, NULL, NULL }, dst, src };
+    vec_parallel_for(n, aos_chunk, &j);
+}
+
+static void run_soa(const float *m, xf_kind_t kind, vec3_soa_t dst, vec3_soa_t src, size_t n)
+{
+    xform_job_t j = { m, xform_kernels()->soa[kind], NULL, dst, src, NULL, NULL };
+    vec_parallel_for(n, soa_chunk, &j);
+}
+
+bool mat4_is_affine(const float *m)
+{
+    return m[12] == 0.0f && m[13] == 0.0f && m[14] == 0.0f && m[15] == 1.0f;
+}
+
+/*
+ * Cofactors C[r][k] of m's upper 3x3, in double; returns the determinant.
+ * The inverse transpose is C / det, the inverse C^T / det.
+ */
+static double mat3_cofactors(const float *m, double *cof)
+{
+    double a = m[0], b = m[1], c = m[2];
+    double d = m[4], e = m[5], f = m[6];
+    double g = m[8], h = m[9], i = m[10];
+    cof[0] = e * i - f * h, cof[1] = f * g - d * i, cof[2] = d * h - e * g;
+    cof[3] = c * h - b * i, cof[4] = a * i - c * g, cof[5] = b * g - a * h;
+    cof[6] = b * f - c * e, cof[7] = c * d - a * f, cof[8] = a * e - b * d;
+    return a * cof[0] + b * cof[1] + c * cof[2];
+}
+
+bool mat3_normal_matrix(float *dst, const float *m)
+{
+    double cof[9];
+    double det = mat3_cofactors(m, cof);
+    if (det == 0.0 || !isfinite(det)) return false;
+    for (int r = 0; r < 3; r++) {
+        for (int k = 0; k < 3; k++) dst[4 * r + k] = (float)(cof[3 * r + k] / det);
+        dst[4 * r + 3] = 0.0f;
+    }
+    return true;
+}
+
+/*
+ * Affine m: [A t; 0 1]^-1 = [A^-1, -A^-1 t; 0 1], so only the 3x3 is
+ * inverted and the bottom row stays exact. Otherwise the full 4x4 adjugate
+ * from 2x2 sub-determinants of the top and bottom row pairs.
+ */
+bool mat4_inverse(float *dst, const float *m)
+{
+    double r[16];
+    if (mat4_is_affine(m)) {
+        double cof[9];
+        double det = mat3_cofactors(m, cof);
+        if (det == 0.0 || !isfinite(det)) return false;
+        for (int i = 0; i < 3; i++) {
+            for (int k = 0; k < 3; k++) r[4 * i + k] = cof[3 * k + i] / det;
+        }
+        for (int i = 0; i < 3; i++) {
+            r[4 * i + 3] = -(r[4 * i] * m[3] + r[4 * i + 1] * m[7] + r[4 * i + 2] * m[11]);
+        }
+        r[12] = r[13] = r[14] = 0.0, r[15] = 1.0;
+    } else {
+        double a[16];
+        for (int i = 0; i < 16; i++) a[i] = m[i];
+        double s0 = a[0] * a[5] - a[4] * a[1], s1 = a[0] * a[6] - a[4] * a[2];
+        double s2 = a[0] * a[7] - a[4] * a[3], s3 = a[1] * a[6] - a[5] * a[2];
+        double s4 = a[1] * a[7] - a[5] * a[3], s5 = a[2] * a[7] - a[6] * a[3];
+        double c0 = a[8] * a[13] - a[12] * a[9], c1 = a[8] * a[14] - a[12] * a[10];
+        double c2 = a[8] * a[15] - a[12] * a[11], c3 = a[9] * a[14] - a[13] * a[10];
+        double c4 = a[9] * a[15] - a[13] * a[11], c5 = a[10] * a[15] - a[14] * a[11];
+        double det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+        if (det == 0.0 || !isfinite(det)) return false;
+        r[0] = a[5] * c5 - a[6] * c4 + a[7] * c3;
+        r[1] = -a[1] * c5 + a[2] * c4 - a[3] * c3;
+        r[2] = a[13] * s5 - a[14] * s4 + a[15] * s3;
+        r[3] = -a[9] * s5 + a[10] * s4 - a[11] * s3;
+        r[4] = -a[4] * c5 + a[6] * c2 - a[7] * c1;
+        r[5] = a[0] * c5 - a[2] * c2 + a[3] * c1;
+        r[6] = -a[12] * s5 + a[14] * s2 - a[15] * s1;
+        r[7] = a[8] * s5 - a[10] * s2 + a[11] * s1;
+        r[8] = a[4] * c4 - a[5] * c2 + a[7] * c0;
+        r[9] = -a[0] * c4 + a[1] * c2 - a[3] * c0;
+        r[10] = a[12] * s4 - a[13] * s2 + a[15] * s0;
+        r[11] = -a[8] * s4 + a[9] * s2 - a[11] * s0;
+        r[12] = -a[4] * c3 + a[5] * c1 - a[6] * c0;
+        r[13] = a[0] * c3 - a[1] * c1 + a[2] * c0;
+        r[14] = -a[12] * s3 + a[13] * s1 - a[14] * s0;
+        r[15] = a[8] * s3 - a[9] * s1 + a[10] * s0;
+        for (int i = 0; i < 16; i++) r[i] /= det;
+    }
+    for (int i = 0; i < 16; i++) dst[i] = (float)r[i];
+    return true;
+}
+
+void vec3_transform_points(const float *m, float *dst, const float *src, size_t n)
+{
+    run_aos(m, mat4_is_affine(m) ? XF_AFFINE : XF_PROJECTIVE, dst, src, n);
+}
+
+void vec3_transform_points_affine(const float *m, float *dst, const float *src, size_t n)
+{
+    run_aos(m, XF_AFFINE, dst, src, n);
+}
+
+void vec3_transform_directions(const float *m, float *dst, const float *src, size_t n)
+{
+    run_aos(m, XF_LINEAR, dst, src, n);
+}
+
+bool vec3_transform_normals(const float *m, float *dst, const float *src, size_t n)
+{
+    float nm[12];
+    if (!mat3_normal_matrix(nm, m)) return false;
+    run_aos(nm, XF_LINEAR, dst, src, n);
+    return true;
+}
+
+void vec3_transform_points_soa(const float *m, vec3_soa_t dst, vec3_soa_t src, size_t n)
+{
+    run_soa(m, mat4_is_affine(m) ? XF_AFFINE : XF_PROJECTIVE, dst, src, n);
+}
+
+void vec3_transform_points_affine_soa(const float *m, vec3_soa_t dst, vec3_soa_t src, size_t n)
+{
+    run_soa(m, XF_AFFINE, dst, src, n);
+}
+
+void vec3_transform_directions_soa(const float *m, vec3_soa_t dst, vec3_soa_t src, size_t n)
+{
+    run_soa(m, XF_LINEAR, dst, src, n);
+}
+
+bool vec3_transform_normals_soa(const float *m, vec3_soa_t dst, vec3_soa_t src, size_t n)
+{
+    float nm[12];
+    if (!mat3_normal_matrix(nm, m)) return false;
+    run_soa(nm, XF_LINEAR, dst, src, n);
+    return true;
+}
+
+/***************************************************OBJECTS***************************************************/
+
+xform_t xform_make(const float *m)
+{
+    xform_t t = { 0 };
+    memcpy(t.m, m, sizeof t.m);
+    t.affine = mat4_is_affine(m);
+    t.normals = mat3_normal_matrix(t.normal, m);
+    t.invertible = mat4_inverse(t.inv, m);
+    if (t.invertible && t.affine) {
+        // the normal matrix of A^-1 is A^T, exactly
+        for (int r = 0; r < 3; r++) {
+            for (int k = 0; k < 3; k++) t.inv_normal[4 * r + k] = m[4 * k + r];
+        }
+        t.inv_normals = true;
+    } else if (t.invertible) {
+        t.inv_normals = mat3_normal_matrix(t.inv_normal, t.inv);
+    }
+    return t;
+}
+
+xform_t xform_make_affine(const float *m)
+{
+    float full[16] = { 0 };
+    memcpy(full, m, 12 * sizeof(float));
+    full[15] = 1.0f;
+    return xform_make(full);
+}
+
+xform_t xform_inverse(const xform_t *t)
+{
+    xform_t r = *t;
+    memcpy(r.m, t->inv, sizeof r.m);
+    memcpy(r.inv, t->m, sizeof r.inv);
+    memcpy(r.normal, t->inv_normal, sizeof r.normal);
+    memcpy(r.inv_normal, t->normal, sizeof r.inv_normal);
+    r.normals = t->inv_normals;
+    r.inv_normals = t->normals;
+    if (!t->invertible) memset(r.inv, 0, sizeof r.inv);
+    return r;
+}
+
+// dst = a * b in double, rounded once per element
+static void mat4_mul(float *dst, const float *a, const float *b)
+{
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            double s = 0.0;
+            for (int k = 0; k < 4; k++) s += (double)a[4 * i + k] * b[4 * k + j];
+            dst[4 * i + j] = (float)s;
+        }
+    }
+}
+
+xform_t xform_compose(const xform_t *a, const xform_t *b)
+{
+    xform_t t = { 0 };
+    mat4_mul(t.m, a->m, b->m);
+    t.affine = mat4_is_affine(t.m);
+    t.normals = mat3_normal_matrix(t.normal, t.m);
+    t.invertible = a->invertible && b->invertible;
+    if (t.invertible) {
+        mat4_mul(t.inv, b->inv, a->inv);
+        t.inv_normals = mat3_normal_matrix(t.inv_normal, t.inv);
+    }
+    return t;
+}
+
+// kernel kind and matrix for one op; NULL if the object lacks it
+static const float *xform_op_matrix(const xform_t *t, xform_op_t op, xf_kind_t *kind)
+{
+    switch (op) {
+    case XFORM_POINTS:
+        *kind = t->affine ? XF_AFFINE : XF_PROJECTIVE;
+        return t->m;
+    case XFORM_DIRECTIONS:
+        *kind = XF_LINEAR;
+        return t->m;
+    case XFORM_NORMALS:
+        *kind = XF_LINEAR;
+        return t->normals ? t->normal : NULL;
+    case XFORM_INVERSE_POINTS:
+        *kind = t->affine ? XF_AFFINE : XF_PROJECTIVE;
+        return t->invertible ? t->inv : NULL;
+    case XFORM_INVERSE_DIRECTIONS:
+        *kind = XF_LINEAR;
+        return t->invertible ? t->inv : NULL;
+    case XFORM_INVERSE_NORMALS:
+        *kind = XF_LINEAR;
+        return t->inv_normals ? t->inv_normal : NULL;
+    }
+    return NULL;
+}
+
+bool xform_apply(const xform_t *t, xform_op_t op, float *dst, const float *src, size_t n)
+{
+    xf_kind_t kind;
+    const float *m = xform_op_matrix(t, op, &kind);
+    if (!m) return false;
+    run_aos(m, kind, dst, src, n);
+    return true;
+}
+
+bool xform_apply_soa(const xform_t *t, xform_op_t op, vec3_soa_t dst, vec3_soa_t src, size_t n)
+{
+    xf_kind_t kind;
+    const float *m = xform_op_matrix(t, op, &kind);
+    if (!m) return false;
+    run_soa(m, kind, dst, src, n);
+    return true;
+}
+
+/**************************************************VEC.H FORMS**********************************************/
+
+/*
+ * The single-vector transforms declared in vec.h, as batches of one. A
+ * 3-element vector is a point (position), direction or normal as named;
+ * vec_transform / vec_transform_affine also take a 4-element homogeneous
+ * vector and return the plain matrix product (w passed through for the
+ * 3x4 form). Anything else gives VEC_UNDEFINED, as does a singular
+ * matrix where an inverse or normal matrix is needed. The inverse forms
+ * prepare an xform_t on every call; code that reuses a matrix should keep
+ * one instead.
+ */
+static vector_t transform_one(vector_t v, const float *m, xf_kind_t kind)
+{
+    if (v.size != 3 || !v.data) return VEC_UNDEFINED;
+    vector_t r = vector_alloc(3);
+    if (!r.data) return r;
+    xform_kernels_scalar.aos[kind](m, r.data, v.data, 1);
+    return r;
+}
+
+static vector_t transform_homogeneous(vector_t v, const float *m, bool affine)
+{
+    vector_t r = vector_alloc(4);
+    if (!r.data) return r;
+    for (int i = 0; i < 4; i++) {
+        if (affine && i == 3) {
+            r.data[3] = v.data[3];
+            break;
+        }
+        r.data[i] = m[4 * i] * v.data[0] + m[4 * i + 1] * v.data[1] + m[4 * i + 2] * v.data[2]
+                  + m[4 * i + 3] * v.data[3];
+    }
+    return r;
+}
+
+vector_t vec_transform(vector_t v, float *matrix)
+{
+    if (v.size == 4 && v.data) return transform_homogeneous(v, matrix, false);
+    return vec_transform_position(v, matrix);
+}
+
+vector_t vec_transform_position(vector_t v, float *matrix)
+{
+    return transform_one(v, matrix, mat4_is_affine(matrix) ? XF_AFFINE : XF_PROJECTIVE);
+}
+
+vector_t vec_transform_direction(vector_t v, float *matrix)
+{
+    return transform_one(v, matrix, XF_LINEAR);
+}
+
+vector_t vec_transform_normal(vector_t v, float *matrix)
+{
+    float nm[12];
+    if (!mat3_normal_matrix(nm, matrix)) return VEC_UNDEFINED;
+    return transform_one(v, nm, XF_LINEAR);
+}
+
+vector_t vec_transform_affine(vector_t v, float *matrix)
+{
+    if (v.size == 4 && v.data) return transform_homogeneous(v, matrix, true);
+    return vec_transform_affine_position(v, matrix);
+}
+
+vector_t vec_transform_affine_position(vector_t v, float *matrix)
+{
+    return transform_one(v, matrix, XF_AFFINE);
+}
+
+vector_t vec_transform_affine_direction(vector_t v, float *matrix)
+{
+    return transform_one(v, matrix, XF_LINEAR);
+}
+
+vector_t vec_transform_affine_normal(vector_t v, float *matrix)
+{
+    return vec_transform_normal(v, matrix);
+}
+
+static vector_t transform_inverse(vector_t v, const xform_t *t, xform_op_t op, bool affine)
+{
+    xf_kind_t kind;
+    const float *m = xform_op_matrix(t, op, &kind);
+    if (!m) return VEC_UNDEFINED;
+    if (v.size == 4 && v.data && op == XFORM_INVERSE_POINTS) return transform_homogeneous(v, m, affine);
+    return transform_one(v, m, kind);
+}
+
+vector_t vec_transform_inverse(vector_t v, float *matrix)
+{
+    xform_t t = xform_make(matrix);
+    return transform_inverse(v, &t, XFORM_INVERSE_POINTS, false);
+}
+
+vector_t vec_transform_inverse_position(vector_t v, float *matrix)
+{
+    if (v.size != 3) return VEC_UNDEFINED;
+    return vec_transform_inverse(v, matrix);
+}
+
+vector_t vec_transform_inverse_direction(vector_t v, float *matrix)
+{
+    xform_t t = xform_make(matrix);
+    return transform_inverse(v, &t, XFORM_INVERSE_DIRECTIONS, false);
+}
+
+vector_t vec_transform_inverse_normal(vector_t v, float *matrix)
+{
+    xform_t t = xform_make(matrix);
+    return transform_inverse(v, &t, XFORM_INVERSE_NORMALS, false);
+}
+
+vector_t vec_transform_inverse_affine(vector_t v, float *matrix)
+{
+    xform_t t = xform_make_affine(matrix);
+    return transform_inverse(v, &t, XFORM_INVERSE_POINTS, true);
+}
+
+vector_t vec_transform_inverse_affine_position(vector_t v, float *matrix)
+{
+    if (v.size != 3) return VEC_UNDEFINED;
+    return vec_transform_inverse_affine(v, matrix);
+}
+
+vector_t vec_transform_inverse_affine_direction(vector_t v, float *matrix)
+{
+    xform_t t = xform_make_affine(matrix);
+    return transform_inverse(v, &t, XFORM_INVERSE_DIRECTIONS, true);
+}
+
+vector_t vec_transform_inverse_affine_normal(vector_t v, float *matrix)
+{
+    xform_t t = xform_make_affine(matrix);
+    return transform_inverse(v, &t, XFORM_INVERSE_NORMALS, true);
+}
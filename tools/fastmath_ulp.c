@@ -0,0 +1,151 @@
+/*
+ * fastmath_ulp: measure the error and cost of each math_core.h accuracy tier.
+ *
+ * For every tier of log2/exp2/pow/inv_sqrt the tool sweeps float bit patterns
+ * over the function's domain (every pattern with --step 1, every N-th with
+ * --step N), compares against libm evaluated in double and rounded to float,
+ * and prints max/mean error in float ULPs plus ns per element.
+ *
+ *   fastmath_ulp [--step N]
+ */
+#include <math_core.h>   // cmath.h also provides the fixed-width integer types
+#include <math.h>
+#include <time.h>
+
+typedef float (*unary_f)(float);
+
+static float pow_y;     // exponent for the pow rows
+
+static float raw_pow(float x) { return fast_powf(x, pow_y); }
+static float poly_pow(float x) { return fast_powf_poly(x, pow_y); }
+static float precise_pow(float x) { return fast_powf_precise(x, pow_y); }
+
+static double ref_log2(double x) { return log2(x); }
+static double ref_exp2(double x) { return exp2(x); }
+static double ref_pow(double x) { return pow(x, pow_y); }
+static double ref_inv_sqrt(double x) { return 1.0 / sqrt(x); }
+
+typedef struct {
+    const char *name;
+    double (*ref)(double);
+    unary_f tier[3];
+    uint32_t lo, hi;    // inclusive bit-pattern range of the swept inputs
+} fn_row_t;
+
+static const char *tier_names[3] = { "raw", "poly", "precise" };
+
+static float bits_to_float(uint32_t b)
+{
+    float f;
+    memcpy(&f, &b, sizeof f);
+    return f;
+}
+
+/* distance between got and ref in units of the float spacing at ref */
+static double ulp_error(float got, double ref)
+{
+    if (got != got || ref != ref) return (got != got && ref != ref) ? 0.0 : INFINITY;
+    if (isinf(got) || isinf(ref)) return (double)got == ref ? 0.0 : INFINITY;
+    int e;
+    frexp(ref, &e);
+    if (e < -125) e = -125;     // subnormal spacing is fixed at 2^-149
+    return fabs((double)got - ref) / ldexp(1.0, e - 24);
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+#define BENCH_N (1u << 16)
+#define BENCH_REPS 64
+
+static double bench(unary_f f, const float *in)
+{
+    volatile float sink = 0.0f;
+    double best = INFINITY;
+    for (int r = 0; r < BENCH_REPS; r++) {
+        float acc = 0.0f;
+        double t0 = now_ns();
+        for (uint32_t i = 0; i < BENCH_N; i++) acc += f(in[i]);
+        double t = now_ns() - t0;
+        sink += acc;
+        if (t < best) best = t;
+    }
+    (void)sink;
+    return best / BENCH_N;
+}
+
+static void run_row(const fn_row_t *row, uint32_t step, float *bench_in)
+{
+    uint32_t span = row->hi - row->lo;
+    for (uint32_t i = 0; i < BENCH_N; i++)
+        bench_in[i] = bits_to_float(row->lo + (uint32_t)((uint64_t)span * i / BENCH_N));
+
+    for (int t = 0; t < 3; t++) {
+        double max_ulp = 0.0, sum_ulp = 0.0;
+        float worst = 0.0f;
+        uint64_t count = 0;
+        for (uint64_t b = row->lo; b <= row->hi; b += step) {
+            float x = bits_to_float((uint32_t)b);
+            double ref = (double)(float)row->ref(x);
+            double u = ulp_error(row->tier[t](x), ref);
+            if (u > max_ulp) {
+                max_ulp = u;
+                worst = x;
+            }
+            sum_ulp += u;
+            count++;
+        }
+        printf("%-10s %-8s %14.4g %14.4g %10.2f   (worst at x = %.9g)\n",
+               row->name, tier_names[t], max_ulp, sum_ulp / (double)count,
+               bench(row->tier[t], bench_in), worst);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t step = 97;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--step") == 0 && i + 1 < argc) {
+            step = (uint32_t)strtoul(argv[++i], NULL, 10);
+            if (step == 0) step = 1;
+        } else {
+            fprintf(stderr, "usage: %s [--step N]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    float *bench_in = malloc(BENCH_N * sizeof *bench_in);
+    if (!bench_in) return 1;
+
+    /* domains: log2 and inv_sqrt over all positive finite floats; exp2 over
+     * [-126, 127] so the reference stays a normal float; pow over [2^-20, 2^20] */
+    const fn_row_t rows[] = {
+        { "log2", ref_log2, { fast_log2f, fast_log2f_poly, fast_log2f_precise }, 0x00000001u, 0x7f7fffffu },
+        { "exp2", ref_exp2, { fast_exp2f, fast_exp2f_poly, fast_exp2f_precise }, 0x00000000u, 0x42fe0000u },
+        { "exp2", ref_exp2, { fast_exp2f, fast_exp2f_poly, fast_exp2f_precise }, 0x80000001u, 0xc2fc0000u },
+        { "inv_sqrt", ref_inv_sqrt, { fast_inv_sqrt, fast_inv_sqrt_poly, fast_inv_sqrt_precise }, 0x00800000u, 0x7f7fffffu },
+        { "pow", ref_pow, { raw_pow, poly_pow, precise_pow }, 0x35800000u, 0x49800000u },
+    };
+
+    printf("sweep step %u (float bit patterns)\n", step);
+    printf("%-10s %-8s %14s %14s %10s\n", "function", "tier", "max ulp", "mean ulp", "ns/elem");
+    for (size_t r = 0; r < sizeof rows / sizeof rows[0]; r++) {
+        if (strcmp(rows[r].name, "pow") == 0) {
+            static const float ys[] = { 0.5f, 2.2f, -1.5f };
+            for (size_t k = 0; k < sizeof ys / sizeof ys[0]; k++) {
+                pow_y = ys[k];
+                printf("pow y = %g\n", pow_y);
+                run_row(&rows[r], step, bench_in);
+            }
+        } else {
+            run_row(&rows[r], step, bench_in);
+        }
+    }
+
+    free(bench_in);
+    return 0;
+}
@@ -0,0 +1,822 @@
+/*
+ * vec_bench: throughput / latency microbenchmarks for vec.h, math_core.h and
+ * math_batch.h, written as JSON for comparison between builds.
+ *
+ * Every benchmark runs over a size sweep from L1-resident (256 elements) up
+ * to the first size whose per-stream footprint exceeds twice the last-level
+ * cache, in steps of 4x. For each size it reports:
+ *
+ *   warm  - repeated calls on hot data: min and median ns per call over
+ *           BENCH_SAMPLES samples of at least BENCH_SAMPLE_NS each
+ *   cold  - single calls after the caches were flushed by streaming over a
+ *           buffer of twice the LLC size
+ *   Gelem/s and GB/s from the median (bytes = elements x element size x
+ *   streams read or written)
+ *   allocation counts per call, taken from a counting allocator pushed on
+ *   the vec allocator stack; allocating variants include freeing the result
+ *   latency_ns - for the scalar math_core.h functions only: ns per call in a
+ *           dependent chain (each input depends on the previous result)
+ *
+ * Rows mixing 16-bit storage with float count each float stream as two
+ * 16-bit streams (dtype "f16" / "bf16").
+ *
+ * Scalar math functions are compute bound, so by default they stop at
+ * 2^20 elements (--math-max 0 sweeps them to the end as well).
+ *
+ *   vec_bench [--json FILE] [--filter SUBSTR] [--max-elems N] [--math-max N]
+ *             [--cold-reps N] [--threads N]
+ *
+ * --threads N starts the vec_parallel.h pool with N threads (0 = all CPUs)
+ * so the vec.h rows measure parallel scaling.
+ *
+ * Progress goes to stderr, JSON to FILE or stdout.
+ */
+#include <vec.h>
+#include <vec_alloc.h>
+#include <vec_simd.h>
+#include <vec_parallel.h>
+#include <vec_half.h>
+#include <vec_view.h>
+#include <math_core.h>
+#include <math_batch.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_MIN_ELEMS 256
+#define BENCH_SAMPLES 5
+#define BENCH_SAMPLE_NS 200000.0        // grow the inner loop to at least 0.2 ms
+#define BENCH_MAX_ITERS (1u << 24)
+#define BENCH_DEFAULT_LLC (32u << 20)   // when the OS does not report one
+
+/****************************************************DATA*****************************************************/
+
+typedef struct {
+    size_t cap;                 // elements in every buffer
+    float *fa, *fb, *fc, *fpristine;
+    double *da, *db, *dc;
+    int *ia;
+    half_t *ha, *hb;            // fa / fb rounded to half
+    bf16_t *ba, *bb;            // fa / fb rounded to bfloat16
+    vector_t va, vb;            // views of fa / fb resized per run (not owned)
+    dvector_t dva, dvb;         // views of da / db
+    hvector_t hva, hvb;         // views of ha / hb
+    bvector_t bva, bvb;         // views of ba / bb
+    float fsink;
+    double dsink;
+    fast_math_tier_t tier;      // for the *_tier rows, read per call so the switch is not folded
+} bench_data_t;
+
+typedef void (*bench_run_f)(bench_data_t *d, size_t n);
+
+typedef enum {
+    BENCH_VEC,                  // vec.h function, swept to the end
+    BENCH_MATH,                 // scalar math_core.h function mapped over an array
+    BENCH_FIXED3                // only meaningful at n = 3
+} bench_kind_t;
+
+/**
+ * @brief One benchmark entry.
+ *
+ * @members
+ *   name, variant - function and flavour ("alloc", "inplace", "scalar", ...)
+ *   dtype         - "f32", "f64", "i32", "f16" or "bf16"
+ *   streams       - arrays of n elements read or written per call
+ *   mutates       - the call writes its input, refresh it before each sample
+ *   run           - one call on the first n elements
+ *   chain         - dependent-chain version for latency, or NULL
+**/
+typedef struct {
+    const char *name;
+    const char *variant;
+    const char *dtype;
+    int streams;
+    bool mutates;
+    bench_kind_t kind;
+    bench_run_f run;
+    bench_run_f chain;
+} bench_t;
+
+static void set_views(bench_data_t *d, size_t n)
+{
+    d->va.size = n;
+    d->vb.size = n;
+    d->dva.size = (unsigned int)n;
+    d->dvb.size = (unsigned int)n;
+    d->hva.size = d->hvb.size = n;
+    d->bva.size = d->bvb.size = n;
+}
+
+/****************************************************VEC.H****************************************************/
+
+/* allocating variants free their result inside the timed call */
+#define BENCH_VEC_ALLOC(fn, expr)                                                   \
+static void run_##fn(bench_data_t *d, size_t n)                                     \
+{                                                                                   \
+    set_views(d, n);                                                                \
+    vector_t r = (expr);                                                            \
+    vector_free(&r);                                                                \
+}
+
+#define BENCH_VEC_INPLACE(fn, stmt)                                                 \
+static void run_##fn(bench_data_t *d, size_t n)                                     \
+{                                                                                   \
+    set_views(d, n);                                                                \
+    stmt;                                                                           \
+}
+
+#define BENCH_DVEC_ALLOC(fn, expr)                                                  \
+static void run_##fn(bench_data_t *d, size_t n)                                     \
+{                                                                                   \
+    set_views(d, n);                                                                \
+    dvector_t r = (expr);                                                           \
+    free_dvector(&r);                                                               \
+}
+
+#define BENCH_HALF_ALLOC(fn, V, VT, expr)                                           \
+static void run_##fn(bench_data_t *d, size_t n)                                     \
+{                                                                                   \
+    set_views(d, n);                                                                \
+    VT r = (expr);                                                                  \
+    V##_free(&r);                                                                   \
+}
+
+BENCH_VEC_ALLOC(vector_alloc, vector_alloc((unsigned int)n))
+BENCH_VEC_ALLOC(vector_create, vector_create((unsigned int)n))
+BENCH_VEC_ALLOC(vector_from_array, vector_from_array((unsigned int)n, d->fa))
+BENCH_VEC_ALLOC(vector_copy, vector_copy(d->va))
+BENCH_VEC_ALLOC(vector_default, vector_default((unsigned int)n, 1.5f))
+BENCH_VEC_ALLOC(vector_scalar_add, vector_scalar_add(d->va, 1e-3f))
+BENCH_VEC_ALLOC(vector_scalar_sub, vector_scalar_sub(d->va, 1e-3f))
+BENCH_VEC_ALLOC(vector_scalar_mul, vector_scalar_mul(d->va, 1.0000001f))
+BENCH_VEC_ALLOC(vector_scalar_div, vector_scalar_div(d->va, 1.0000001f))
+BENCH_VEC_ALLOC(vector_pow, vector_pow(d->va, -1.0f))
+BENCH_VEC_ALLOC(vector_pow_int, vector_pow(d->va, 7.0f))
+BENCH_VEC_ALLOC(vector_pow_half, vector_pow(d->va, 2.5f))
+BENCH_VEC_ALLOC(vector_pow_general, vector_pow(d->va, 2.2f))
+BENCH_VEC_ALLOC(vector_add, vector_add(d->va, d->vb))
+BENCH_VEC_ALLOC(vector_sub, vector_sub(d->va, d->vb))
+BENCH_VEC_ALLOC(vector_mul, vector_mul(d->va, d->vb))
+BENCH_VEC_ALLOC(vector_div, vector_div(d->va, d->vb))
+BENCH_VEC_ALLOC(vector_cross, vector_cross(d->va, d->vb))
+
+BENCH_VEC_INPLACE(vector_scalar_add_inplace, vector_scalar_add_inplace(&d->va, 1e-3f))
+BENCH_VEC_INPLACE(vector_scalar_sub_inplace, vector_scalar_sub_inplace(&d->va, 1e-3f))
+BENCH_VEC_INPLACE(vector_scalar_mul_inplace, vector_scalar_mul_inplace(&d->va, 1.0000001f))
+BENCH_VEC_INPLACE(vector_scalar_div_inplace, vector_scalar_div_inplace(&d->va, 1.0000001f))
+BENCH_VEC_INPLACE(vector_pow_inplace, vector_pow_inplace(&d->va, -1.0f))     // x -> 1/x stays in range
+BENCH_VEC_INPLACE(vector_add_inplace, vector_add_inplace(&d->va, d->vb))
+BENCH_VEC_INPLACE(vector_sub_inplace, vector_sub_inplace(&d->va, d->vb))
+BENCH_VEC_INPLACE(vector_mul_inplace, vector_mul_inplace(&d->va, d->vb))
+BENCH_VEC_INPLACE(vector_div_inplace, vector_div_inplace(&d->va, d->vb))
+BENCH_VEC_INPLACE(vector_equals, d->fsink += (float)vector_equals(d->va, d->va))
+BENCH_VEC_INPLACE(vector_dot, d->fsink += vector_dot(d->va, d->vb))
+BENCH_VEC_INPLACE(vector_magnitude, d->fsink += vector_magnitude(d->va))
+BENCH_VEC_INPLACE(vector_dot_compensated, d->fsink += vector_dot_ex(d->va, d->vb, VEC_REDUCE_COMPENSATED))
+BENCH_VEC_INPLACE(vector_dot_scaled, d->fsink += vector_dot_ex(d->va, d->vb, VEC_REDUCE_SCALED))
+BENCH_VEC_INPLACE(vector_magnitude_compensated, d->fsink += vector_magnitude_ex(d->va, VEC_REDUCE_COMPENSATED))
+BENCH_VEC_INPLACE(vector_magnitude_scaled, d->fsink += vector_magnitude_ex(d->va, VEC_REDUCE_SCALED))
+BENCH_VEC_INPLACE(vector_sum, d->fsink += (float)vector_sum(d->va))
+BENCH_VEC_INPLACE(vector_capacity, d->fsink += (float)vector_capacity(d->va))
+
+/*
+ * Growth: every call builds a vector from nothing out of fa and frees it;
+ * append goes in 64-element pieces so it grows as often as push would over
+ * n / 64 elements. shrink starts from a reserve of 2n.
+ */
+#define BENCH_GROW(P, VT, T, UNDEF, FREE, src)                                      \
+static void run_##P##_reserve(bench_data_t *d, size_t n)                            \
+{                                                                                   \
+    VT v = UNDEF;                                                                   \
+    d->fsink += (float)P##_reserve(&v, n);                                          \
+    FREE(&v);                                                                       \
+}                                                                                   \
+static void run_##P##_push(bench_data_t *d, size_t n)                               \
+{                                                                                   \
+    VT v = UNDEF;                                                                   \
+    for (size_t i = 0; i < n; i++) P##_push(&v, (src)[i]);                          \
+    FREE(&v);                                                                       \
+}                                                                                   \
+static void run_##P##_append(bench_data_t *d, size_t n)                             \
+{                                                                                   \
+    VT v = UNDEF;                                                                   \
+    for (size_t i = 0; i < n; i += 64) P##_append(&v, (src) + i, MIN((size_t)64, n - i)); \
+    FREE(&v);                                                                       \
+}                                                                                   \
+static void run_##P##_shrink(bench_data_t *d, size_t n)                             \
+{                                                                                   \
+    VT v = UNDEF;                                                                   \
+    if (P##_reserve(&v, 2 * n)) {                                                   \
+        memcpy(v.data, (src), n * sizeof(T));                                       \
+        v.size = (unsigned int)n;                                                   \
+        P##_shrink(&v);                                                             \
+    }                                                                               \
+    FREE(&v);                                                                       \
+}
+
+BENCH_GROW(vector, vector_t, float, VEC_UNDEFINED, vector_free, d->fa)
+BENCH_GROW(dvec, dvector_t, double, DVEC_UNDEFINED, free_dvector, d->da)
+
+BENCH_DVEC_ALLOC(allocate_d, allocate_d((unsigned int)n))
+BENCH_DVEC_ALLOC(dvec_create, dvec_create((unsigned int)n))
+BENCH_DVEC_ALLOC(dvec_create_from_array, dvec_create_from_array((unsigned int)n, d->da))
+BENCH_DVEC_ALLOC(dvec_copy, dvec_copy(d->dva))
+BENCH_DVEC_ALLOC(dvec_default, dvec_default((unsigned int)n, 1.5))
+BENCH_DVEC_ALLOC(dvec_scalar_add, dvec_scalar_add(d->dva, 1e-3))
+BENCH_DVEC_ALLOC(dvec_scalar_sub, dvec_scalar_sub(d->dva, 1e-3))
+BENCH_DVEC_ALLOC(dvec_scalar_mul, dvec_scalar_mul(d->dva, 1.0000001))
+BENCH_DVEC_ALLOC(dvec_scalar_div, dvec_scalar_div(d->dva, 1.0000001))
+BENCH_DVEC_ALLOC(dvec_pow, dvec_pow(d->dva, -1.0))
+BENCH_DVEC_ALLOC(dvec_add, dvec_add(d->dva, d->dvb))
+BENCH_DVEC_ALLOC(dvec_sub, dvec_sub(d->dva, d->dvb))
+BENCH_DVEC_ALLOC(dvec_mul, dvec_mul(d->dva, d->dvb))
+BENCH_DVEC_ALLOC(dvec_div, dvec_div(d->dva, d->dvb))
+BENCH_DVEC_ALLOC(dvec_cross, dvec_cross(d->dva, d->dvb))
+
+BENCH_VEC_INPLACE(dvec_scalar_add_inplace, dvec_scalar_add_inplace(&d->dva, 1e-3))
+BENCH_VEC_INPLACE(dvec_scalar_sub_inplace, dvec_scalar_sub_inplace(&d->dva, 1e-3))
+BENCH_VEC_INPLACE(dvec_scalar_mul_inplace, dvec_scalar_mul_inplace(&d->dva, 1.0000001))
+BENCH_VEC_INPLACE(dvec_scalar_div_inplace, dvec_scalar_div_inplace(&d->dva, 1.0000001))
+BENCH_VEC_INPLACE(dvec_pow_inplace, dvec_pow_inplace(&d->dva, -1.0))
+BENCH_VEC_INPLACE(dvec_add_inplace, dvec_add_inplace(&d->dva, d->dvb))
+BENCH_VEC_INPLACE(dvec_sub_inplace, dvec_sub_inplace(&d->dva, d->dvb))
+BENCH_VEC_INPLACE(dvec_mul_inplace, dvec_mul_inplace(&d->dva, d->dvb))
+BENCH_VEC_INPLACE(dvec_div_inplace, dvec_div_inplace(&d->dva, d->dvb))
+BENCH_VEC_INPLACE(dvec_equals, d->dsink += (double)dvec_equals(d->dva, d->dva))
+BENCH_VEC_INPLACE(dvec_dot, d->dsink += dvec_dot(d->dva, d->dvb))
+BENCH_VEC_INPLACE(dvec_magnitude, d->dsink += dvec_magnitude(d->dva))
+BENCH_VEC_INPLACE(dvec_dot_compensated, d->dsink += dvec_dot_ex(d->dva, d->dvb, VEC_REDUCE_COMPENSATED))
+BENCH_VEC_INPLACE(dvec_magnitude_compensated, d->dsink += dvec_magnitude_ex(d->dva, VEC_REDUCE_COMPENSATED))
+BENCH_VEC_INPLACE(dvec_magnitude_scaled, d->dsink += dvec_magnitude_ex(d->dva, VEC_REDUCE_SCALED))
+BENCH_VEC_INPLACE(dvec_sum, d->dsink += dvec_sum(d->dva))
+BENCH_VEC_INPLACE(dvec_capacity, d->dsink += (double)dvec_capacity(d->dva))
+
+/****************************************************VEC_VIEW.H***********************************************/
+
+/* every other element of the first n, so the reductions take the gather path */
+BENCH_VEC_INPLACE(vec_view_sum_ex, d->fsink += (float)vec_view_sum_ex(vec_view(d->va, 0, n / 2, 2), NULL))
+BENCH_VEC_INPLACE(vec_view_dot_ex, d->fsink += vec_view_dot_ex(vec_view(d->va, 0, n / 2, 2),
+                                                               vec_view(d->vb, 1, n / 2, 2), VEC_REDUCE_FAST, NULL))
+BENCH_VEC_INPLACE(vec_view_magnitude_ex, d->fsink += vec_view_magnitude_ex(vec_view(d->va, 0, n / 2, 2),
+                                                                           VEC_REDUCE_COMPENSATED, NULL))
+BENCH_VEC_INPLACE(dvec_view_sum_ex, d->dsink += dvec_view_sum_ex(dvec_view(d->dva, 0, n / 2, 2), NULL))
+BENCH_VEC_INPLACE(dvec_view_dot_ex, d->dsink += dvec_view_dot_ex(dvec_view(d->dva, 0, n / 2, 2),
+                                                                 dvec_view(d->dvb, 1, n / 2, 2), VEC_REDUCE_FAST, NULL))
+
+/****************************************************VEC_HALF.H***********************************************/
+
+BENCH_HALF_ALLOC(hvec_add, hvec, hvector_t, hvec_add(d->hva, d->hvb))
+BENCH_HALF_ALLOC(hvec_scale, hvec, hvector_t, hvec_scale(d->hva, 1.0001f))
+BENCH_VEC_INPLACE(hvec_dot, d->fsink += hvec_dot(d->hva, d->hvb))
+BENCH_VEC_INPLACE(hvec_dot_vector, d->fsink += hvec_dot_vector(d->hva, d->vb))
+BENCH_VEC_INPLACE(hvec_magnitude, d->fsink += hvec_magnitude(d->hva))
+BENCH_HALF_ALLOC(bvec_add, bvec, bvector_t, bvec_add(d->bva, d->bvb))
+BENCH_HALF_ALLOC(bvec_scale, bvec, bvector_t, bvec_scale(d->bva, 1.0001f))
+BENCH_VEC_INPLACE(bvec_dot, d->fsink += bvec_dot(d->bva, d->bvb))
+BENCH_VEC_INPLACE(bvec_dot_vector, d->fsink += bvec_dot_vector(d->bva, d->vb))
+BENCH_VEC_INPLACE(bvec_magnitude, d->fsink += bvec_magnitude(d->bva))
+
+static void run_half_from_float_array(bench_data_t *d, size_t n) { half_from_float_array(d->hb, d->fa, n); }
+static void run_half_to_float_array(bench_data_t *d, size_t n) { half_to_float_array(d->fc, d->ha, n); }
+static void run_bf16_from_float_array(bench_data_t *d, size_t n) { bf16_from_float_array(d->bb, d->fa, n); }
+static void run_bf16_to_float_array(bench_data_t *d, size_t n) { bf16_to_float_array(d->fc, d->ba, n); }
+
+/**************************************************MATH_CORE.H************************************************/
+
+/*
+ * Throughput: dst[i] = f(src[i]). Latency: acc = f(src[i] + acc * 0), which
+ * keeps the value but makes every call wait for the previous one (the
+ * multiply cannot be folded without -ffast-math). Inputs are in [0.5, 1.5]
+ * so every function stays finite.
+ */
+// both results of fast_sincosf_poly, so neither can be dropped
+static inline float sincos_sum(float x)
+{
+    float s, c;
+    fast_sincosf_poly(x, &s, &c);
+    return s + c;
+}
+
+#define BENCH_MATH_F(fn, call)                                                      \
+static void run_##fn(bench_data_t *d, size_t n)                                     \
+{                                                                                   \
+    for (size_t i = 0; i < n; i++) { float x = d->fa[i]; d->fc[i] = (call); }       \
+}                                                                                   \
+static void chain_##fn(bench_data_t *d, size_t n)                                   \
+{                                                                                   \
+    float acc = 0.0f;                                                               \
+    for (size_t i = 0; i < n; i++) { float x = d->fa[i] + acc * 0.0f; acc = (call); } \
+    d->fsink += acc;                                                                \
+}
+
+#define BENCH_MATH_D(fn, call)                                                      \
+static void run_##fn(bench_data_t *d, size_t n)                                     \
+{                                                                                   \
+    for (size_t i = 0; i < n; i++) { double x = d->da[i]; d->dc[i] = (call); }      \
+}                                                                                   \
+static void chain_##fn(bench_data_t *d, size_t n)                                   \
+{                                                                                   \
+    double acc = 0.0;                                                               \
+    for (size_t i = 0; i < n; i++) { double x = d->da[i] + acc * 0.0; acc = (call); } \
+    d->dsink += acc;                                                                \
+}
+
+static void run_pow_i(bench_data_t *d, size_t n)
+{
+    for (size_t i = 0; i < n; i++) d->ia[i] = pow_i(d->ia[i] & 7, 7);
+}
+
+BENCH_MATH_F(pow_fi, pow_fi(x, 7))
+BENCH_MATH_F(fast_inv_sqrt, fast_inv_sqrt(x))
+BENCH_MATH_F(fast_sqrt, fast_sqrt(x))
+BENCH_MATH_F(fast_log2f, fast_log2f(x))
+BENCH_MATH_F(fast_exp2f, fast_exp2f(x))
+BENCH_MATH_F(fast_powf, fast_powf(x, 2.2f))
+BENCH_MATH_F(sqrt_f, sqrt_f(x))
+BENCH_MATH_F(sqrt_exact_f, sqrt_exact_f(x))
+BENCH_MATH_F(cbrt_f, cbrt_f(x))
+BENCH_MATH_F(hypot_f, hypot_f(x, 0.75f))
+BENCH_MATH_F(fast_log2f_poly, fast_log2f_poly(x))
+BENCH_MATH_F(fast_exp2f_poly, fast_exp2f_poly(x))
+BENCH_MATH_F(fast_powf_poly, fast_powf_poly(x, 2.2f))
+BENCH_MATH_F(fast_inv_sqrt_poly, fast_inv_sqrt_poly(x))
+BENCH_MATH_F(fast_log2f_precise, fast_log2f_precise(x))
+BENCH_MATH_F(fast_exp2f_precise, fast_exp2f_precise(x))
+BENCH_MATH_F(fast_powf_precise, fast_powf_precise(x, 2.2f))
+BENCH_MATH_F(fast_inv_sqrt_precise, fast_inv_sqrt_precise(x))
+BENCH_MATH_F(fast_log2f_tier, fast_log2f_tier(x, d->tier))
+BENCH_MATH_F(fast_exp2f_tier, fast_exp2f_tier(x, d->tier))
+BENCH_MATH_F(fast_powf_tier, fast_powf_tier(x, 2.2f, d->tier))
+BENCH_MATH_F(fast_inv_sqrt_tier, fast_inv_sqrt_tier(x, d->tier))
+BENCH_MATH_F(log2_f, log2_f(x))
+BENCH_MATH_F(exp2_f, exp2_f(x))
+BENCH_MATH_F(pow_f, pow_f(x, 2.2f))
+BENCH_MATH_F(inv_sqrt_f, inv_sqrt_f(x))
+BENCH_MATH_F(fast_sinf_poly, fast_sinf_poly(x))
+BENCH_MATH_F(fast_cosf_poly, fast_cosf_poly(x))
+BENCH_MATH_F(fast_sincosf_poly, sincos_sum(x))
+
+BENCH_MATH_D(pow_di, pow_di(x, 7))
+BENCH_MATH_D(fast_inv_sqrtd, fast_inv_sqrtd(x))
+BENCH_MATH_D(fast_sqrtd, fast_sqrtd(x))
+BENCH_MATH_D(fast_log2d, fast_log2d(x))
+BENCH_MATH_D(fast_exp2d, fast_exp2d(x))
+BENCH_MATH_D(fast_powd, fast_powd(x, 2.2))
+BENCH_MATH_D(sqrt_d, sqrt_d(x))
+BENCH_MATH_D(sqrt_exact_d, sqrt_exact_d(x))
+BENCH_MATH_D(cbrt_d, cbrt_d(x))
+BENCH_MATH_D(hypot_d, hypot_d(x, 0.75))
+BENCH_MATH_D(fast_log2d_precise, fast_log2d_precise(x))
+BENCH_MATH_D(fast_exp2d_precise, fast_exp2d_precise(x))
+BENCH_MATH_D(fast_powd_precise, fast_powd_precise(x, 2.2))
+
+/**************************************************MATH_BATCH.H***********************************************/
+
+static void run_fast_inv_sqrt_array(bench_data_t *d, size_t n) { fast_inv_sqrt_array(d->fc, d->fa, n); }
+static void run_fast_sqrt_array(bench_data_t *d, size_t n) { fast_sqrt_array(d->fc, d->fa, n); }
+static void run_fast_log2f_array(bench_data_t *d, size_t n) { fast_log2f_array(d->fc, d->fa, n); }
+static void run_fast_exp2f_array(bench_data_t *d, size_t n) { fast_exp2f_array(d->fc, d->fa, n); }
+static void run_fast_powf_array(bench_data_t *d, size_t n) { fast_powf_array(d->fc, d->fa, 2.2f, n); }
+static void run_cbrt_f_array(bench_data_t *d, size_t n) { cbrt_f_array(d->fc, d->fa, n); }
+static void run_hypot_f_array(bench_data_t *d, size_t n) { hypot_f_array(d->fc, d->fa, d->fb, n); }
+static void run_fast_inv_sqrtd_array(bench_data_t *d, size_t n) { fast_inv_sqrtd_array(d->dc, d->da, n); }
+static void run_fast_sqrtd_array(bench_data_t *d, size_t n) { fast_sqrtd_array(d->dc, d->da, n); }
+static void run_fast_log2d_array(bench_data_t *d, size_t n) { fast_log2d_array(d->dc, d->da, n); }
+static void run_fast_exp2d_array(bench_data_t *d, size_t n) { fast_exp2d_array(d->dc, d->da, n); }
+static void run_fast_powd_array(bench_data_t *d, size_t n) { fast_powd_array(d->dc, d->da, 2.2, n); }
+static void run_cbrt_d_array(bench_data_t *d, size_t n) { cbrt_d_array(d->dc, d->da, n); }
+static void run_hypot_d_array(bench_data_t *d, size_t n) { hypot_d_array(d->dc, d->da, d->db, n); }
+static void run_fast_log2f_poly_array(bench_data_t *d, size_t n) { fast_log2f_poly_array(d->fc, d->fa, n); }
+static void run_fast_exp2f_poly_array(bench_data_t *d, size_t n) { fast_exp2f_poly_array(d->fc, d->fa, n); }
+static void run_fast_powf_poly_array(bench_data_t *d, size_t n) { fast_powf_poly_array(d->fc, d->fa, 2.2f, n); }
+static void run_sqrt_exact_f_array(bench_data_t *d, size_t n) { sqrt_exact_f_array(d->fc, d->fa, n); }
+static void run_sqrt_exact_d_array(bench_data_t *d, size_t n) { sqrt_exact_d_array(d->dc, d->da, n); }
+static void run_fast_sincosf_poly_array(bench_data_t *d, size_t n)
+{
+    fast_sincosf_poly_array(d->fc, (float *)d->dc, d->fa, n);  // dc has room for 2 * cap floats
+}
+static void run_pow_f_array(bench_data_t *d, size_t n) { pow_f_array(d->fc, d->fa, 2.5f, n); }
+static void run_pow_d_array(bench_data_t *d, size_t n) { pow_d_array(d->dc, d->da, 2.5, n); }
+
+/****************************************************TABLE****************************************************/
+
+#define VEC_A(fn, streams) { #fn, "alloc", "f32", streams, false, BENCH_VEC, run_##fn, NULL }
+#define VEC_I(fn, base, streams) { #base, "inplace", "f32", streams, true, BENCH_VEC, run_##fn, NULL }
+#define VEC_Q(fn, streams) { #fn, "query", "f32", streams, false, BENCH_VEC, run_##fn, NULL }
+#define DVEC_A(fn, streams) { #fn, "alloc", "f64", streams, false, BENCH_VEC, run_##fn, NULL }
+#define DVEC_I(fn, base, streams) { #base, "inplace", "f64", streams, true, BENCH_VEC, run_##fn, NULL }
+#define DVEC_Q(fn, streams) { #fn, "query", "f64", streams, false, BENCH_VEC, run_##fn, NULL }
+#define GROW(fn, dt, streams) { #fn, "grow", dt, streams, false, BENCH_VEC, run_##fn, NULL }
+#define VIEW_Q(fn, dt, streams) { #fn, "stride2", dt, streams, false, BENCH_VEC, run_##fn, NULL }
+#define HALF_A(fn, dt, streams) { #fn, "alloc", dt, streams, false, BENCH_VEC, run_##fn, NULL }
+#define HALF_Q(fn, dt, streams) { #fn, "query", dt, streams, false, BENCH_VEC, run_##fn, NULL }
+#define HALF_B(fn, dt, streams) { #fn, "batch", dt, streams, false, BENCH_VEC, run_##fn, NULL }
+#define MATH_F(fn, streams) { #fn, "scalar", "f32", streams, false, BENCH_MATH, run_##fn, chain_##fn }
+#define TIER_F(fn) { #fn, "poly", "f32", 2, false, BENCH_MATH, run_##fn, chain_##fn }
+#define MATH_D(fn, streams) { #fn, "scalar", "f64", streams, false, BENCH_MATH, run_##fn, chain_##fn }
+#define BATCH_F(fn, streams) { #fn, "batch", "f32", streams, false, BENCH_VEC, run_##fn, NULL }
+#define BATCH_D(fn, streams) { #fn, "batch", "f64", streams, false, BENCH_VEC, run_##fn, NULL }
+
+static const bench_t benches[] = {
+    VEC_A(vector_alloc, 0),
+    VEC_A(vector_create, 1),
+    VEC_A(vector_from_array, 2),
+    VEC_A(vector_copy, 2),
+    VEC_A(vector_default, 1),
+    VEC_Q(vector_equals, 2),
+    VEC_A(vector_scalar_add, 2),
+    VEC_I(vector_scalar_add_inplace, vector_scalar_add, 2),
+    VEC_A(vector_scalar_sub, 2),
+    VEC_I(vector_scalar_sub_inplace, vector_scalar_sub, 2),
+    VEC_A(vector_scalar_mul, 2),
+    VEC_I(vector_scalar_mul_inplace, vector_scalar_mul, 2),
+    VEC_A(vector_scalar_div, 2),
+    VEC_I(vector_scalar_div_inplace, vector_scalar_div, 2),
+    VEC_A(vector_pow, 2),
+    VEC_I(vector_pow_inplace, vector_pow, 2),
+    { "vector_pow", "y=7", "f32", 2, false, BENCH_VEC, run_vector_pow_int, NULL },
+    { "vector_pow", "y=2.5", "f32", 2, false, BENCH_VEC, run_vector_pow_half, NULL },
+    { "vector_pow", "y=2.2", "f32", 2, false, BENCH_VEC, run_vector_pow_general, NULL },
+    VEC_A(vector_add, 3),
+    VEC_I(vector_add_inplace, vector_add, 3),
+    VEC_A(vector_sub, 3),
+    VEC_I(vector_sub_inplace, vector_sub, 3),
+    VEC_A(vector_mul, 3),
+    VEC_I(vector_mul_inplace, vector_mul, 3),
+    VEC_A(vector_div, 3),
+    VEC_I(vector_div_inplace, vector_div, 3),
+    VEC_Q(vector_dot, 2),
+    VEC_Q(vector_magnitude, 1),
+    { "vector_dot_ex", "compensated", "f32", 2, false, BENCH_VEC, run_vector_dot_compensated, NULL },
+    { "vector_dot_ex", "scaled", "f32", 2, false, BENCH_VEC, run_vector_dot_scaled, NULL },
+    { "vector_magnitude_ex", "compensated", "f32", 1, false, BENCH_VEC, run_vector_magnitude_compensated, NULL },
+    { "vector_magnitude_ex", "scaled", "f32", 1, false, BENCH_VEC, run_vector_magnitude_scaled, NULL },
+    { "vector_cross", "alloc", "f32", 3, false, BENCH_FIXED3, run_vector_cross, NULL },
+    VEC_Q(vector_sum, 1),
+    VEC_Q(vector_capacity, 0),
+    GROW(vector_reserve, "f32", 0), GROW(vector_push, "f32", 2), GROW(vector_append, "f32", 2),
+    GROW(vector_shrink, "f32", 3),
+    DVEC_A(allocate_d, 0),
+    DVEC_A(dvec_create, 1),
+    DVEC_A(dvec_create_from_array, 2),
+    DVEC_A(dvec_copy, 2),
+    DVEC_A(dvec_default, 1),
+    DVEC_Q(dvec_equals, 2),
+    DVEC_A(dvec_scalar_add, 2),
+    DVEC_I(dvec_scalar_add_inplace, dvec_scalar_add, 2),
+    DVEC_A(dvec_scalar_sub, 2),
+    DVEC_I(dvec_scalar_sub_inplace, dvec_scalar_sub, 2),
+    DVEC_A(dvec_scalar_mul, 2),
+    DVEC_I(dvec_scalar_mul_inplace, dvec_scalar_mul, 2),
+    DVEC_A(dvec_scalar_div, 2),
+    DVEC_I(dvec_scalar_div_inplace, dvec_scalar_div, 2),
+    DVEC_A(dvec_pow, 2),
+    DVEC_I(dvec_pow_inplace, dvec_pow, 2),
+    DVEC_A(dvec_add, 3),
+    DVEC_I(dvec_add_inplace, dvec_add, 3),
+    DVEC_A(dvec_sub, 3),
+    DVEC_I(dvec_sub_inplace, dvec_sub, 3),
+    DVEC_A(dvec_mul, 3),
+    DVEC_I(dvec_mul_inplace, dvec_mul, 3),
+    DVEC_A(dvec_div, 3),
+    DVEC_I(dvec_div_inplace, dvec_div, 3),
+    DVEC_Q(dvec_dot, 2),
+    DVEC_Q(dvec_magnitude, 1),
+    { "dvec_dot_ex", "compensated", "f64", 2, false, BENCH_VEC, run_dvec_dot_compensated, NULL },
+    { "dvec_magnitude_ex", "compensated", "f64", 1, false, BENCH_VEC, run_dvec_magnitude_compensated, NULL },
+    { "dvec_magnitude_ex", "scaled", "f64", 1, false, BENCH_VEC, run_dvec_magnitude_scaled, NULL },
+    DVEC_Q(dvec_sum, 1),
+    { "dvec_cross", "alloc", "f64", 3, false, BENCH_FIXED3, run_dvec_cross, NULL },
+    DVEC_Q(dvec_capacity, 0),
+    GROW(dvec_reserve, "f64", 0), GROW(dvec_push, "f64", 2), GROW(dvec_append, "f64", 2),
+    GROW(dvec_shrink, "f64", 3),
+    VIEW_Q(vec_view_sum_ex, "f32", 1), VIEW_Q(vec_view_dot_ex, "f32", 2),
+    VIEW_Q(vec_view_magnitude_ex, "f32", 1),
+    VIEW_Q(dvec_view_sum_ex, "f64", 1), VIEW_Q(dvec_view_dot_ex, "f64", 2),
+    HALF_A(hvec_add, "f16", 3), HALF_A(hvec_scale, "f16", 2), HALF_Q(hvec_dot, "f16", 2),
+    HALF_Q(hvec_dot_vector, "f16", 3), HALF_Q(hvec_magnitude, "f16", 1),
+    HALF_B(half_from_float_array, "f16", 3), HALF_B(half_to_float_array, "f16", 3),
+    HALF_A(bvec_add, "bf16", 3), HALF_A(bvec_scale, "bf16", 2), HALF_Q(bvec_dot, "bf16", 2),
+    HALF_Q(bvec_dot_vector, "bf16", 3), HALF_Q(bvec_magnitude, "bf16", 1),
+    HALF_B(bf16_from_float_array, "bf16", 3), HALF_B(bf16_to_float_array, "bf16", 3),
+
+    { "pow_i", "scalar", "i32", 1, true, BENCH_MATH, run_pow_i, NULL },
+    MATH_F(pow_fi, 2), MATH_F(fast_inv_sqrt, 2), MATH_F(fast_sqrt, 2), MATH_F(fast_log2f, 2),
+    MATH_F(fast_exp2f, 2), MATH_F(fast_powf, 2), MATH_F(sqrt_f, 2), MATH_F(sqrt_exact_f, 2),
+    MATH_F(cbrt_f, 2), MATH_F(hypot_f, 2),
+    MATH_F(fast_log2f_poly, 2), MATH_F(fast_exp2f_poly, 2), MATH_F(fast_powf_poly, 2),
+    MATH_F(fast_inv_sqrt_poly, 2), MATH_F(fast_log2f_precise, 2), MATH_F(fast_exp2f_precise, 2),
+    MATH_F(fast_powf_precise, 2), MATH_F(fast_inv_sqrt_precise, 2),
+    TIER_F(fast_log2f_tier), TIER_F(fast_exp2f_tier), TIER_F(fast_powf_tier), TIER_F(fast_inv_sqrt_tier),
+    MATH_F(log2_f, 2), MATH_F(exp2_f, 2), MATH_F(pow_f, 2), MATH_F(inv_sqrt_f, 2),
+    MATH_F(fast_sinf_poly, 2), MATH_F(fast_cosf_poly, 2), MATH_F(fast_sincosf_poly, 2),
+    MATH_D(pow_di, 2), MATH_D(fast_inv_sqrtd, 2), MATH_D(fast_sqrtd, 2), MATH_D(fast_log2d, 2),
+    MATH_D(fast_exp2d, 2), MATH_D(fast_powd, 2), MATH_D(sqrt_d, 2), MATH_D(sqrt_exact_d, 2),
+    MATH_D(cbrt_d, 2), MATH_D(hypot_d, 2),
+    MATH_D(fast_log2d_precise, 2), MATH_D(fast_exp2d_precise, 2), MATH_D(fast_powd_precise, 2),
+
+    BATCH_F(fast_inv_sqrt_array, 2), BATCH_F(fast_sqrt_array, 2), BATCH_F(fast_log2f_array, 2),
+    BATCH_F(fast_exp2f_array, 2), BATCH_F(fast_powf_array, 2), BATCH_F(cbrt_f_array, 2),
+    BATCH_F(hypot_f_array, 3),
+    BATCH_F(fast_log2f_poly_array, 2), BATCH_F(fast_exp2f_poly_array, 2), BATCH_F(fast_powf_poly_array, 2),
+    BATCH_F(sqrt_exact_f_array, 2), BATCH_F(fast_sincosf_poly_array, 3), BATCH_F(pow_f_array, 2),
+    BATCH_D(fast_inv_sqrtd_array, 2), BATCH_D(fast_sqrtd_array, 2), BATCH_D(fast_log2d_array, 2),
+    BATCH_D(fast_exp2d_array, 2), BATCH_D(fast_powd_array, 2), BATCH_D(cbrt_d_array, 2),
+    BATCH_D(hypot_d_array, 3), BATCH_D(sqrt_exact_d_array, 2), BATCH_D(pow_d_array, 2),
+};
+
+/*************************************************ALLOCATIONS*************************************************/
+
+typedef struct {
+    size_t allocs, frees, bytes;
+} alloc_counts_t;
+
+static void *counting_alloc(void *ctx, size_t bytes)
+{
+    alloc_counts_t *c = ctx;
+    c->allocs++;
+    c->bytes += bytes;
+    return malloc(bytes);
+}
+
+static void counting_free(void *ctx, void *ptr, size_t bytes)
+{
+    (void)bytes;
+    ((alloc_counts_t *)ctx)->frees++;
+    free(ptr);
+}
+
+/****************************************************TIMING***************************************************/
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static unsigned char *flush_buf;
+static size_t flush_bytes;
+
+/* touch every line of a buffer twice the LLC size so the next call starts cold */
+static void flush_caches(void)
+{
+    for (size_t i = 0; i < flush_bytes; i += 64) flush_buf[i]++;
+}
+
+static void refresh(const bench_t *b, bench_data_t *d, size_t n)
+{
+    if (!b->mutates) return;
+    memcpy(d->fa, d->fpristine, n * sizeof(float));
+    for (size_t i = 0; i < n; i++) d->ia[i] = (int)i, d->da[i] = d->fpristine[i];
+}
+
+static double time_iters(bench_run_f run, bench_data_t *d, size_t n, size_t iters)
+{
+    double t0 = now_ns();
+    for (size_t k = 0; k < iters; k++) run(d, n);
+    return now_ns() - t0;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+typedef struct {
+    size_t iters;               // calls per warm sample
+    double warm_min, warm_median;
+    double cold_min, cold_median;
+    double latency;             // ns per call in a dependent chain, < 0 if n/a
+    alloc_counts_t counts;      // over all warm calls
+    size_t warm_calls;
+} bench_result_t;
+
+static bench_result_t measure(const bench_t *b, bench_data_t *d, size_t n, int cold_reps,
+                              alloc_counts_t *counts)
+{
+    bench_result_t r;
+    double samples[BENCH_SAMPLES];
+    double cold[64];
+
+    /* calibrate: grow the inner loop until one sample takes BENCH_SAMPLE_NS */
+    r.iters = 1;
+    for (;;) {
+        refresh(b, d, n);
+        if (time_iters(b->run, d, n, r.iters) >= BENCH_SAMPLE_NS || r.iters >= BENCH_MAX_ITERS) break;
+        r.iters *= 2;
+    }
+
+    *counts = (alloc_counts_t){ 0, 0, 0 };
+    for (int s = 0; s < BENCH_SAMPLES; s++) {
+        refresh(b, d, n);
+        samples[s] = time_iters(b->run, d, n, r.iters) / (double)r.iters;
+    }
+    r.counts = *counts;
+    r.warm_calls = r.iters * BENCH_SAMPLES;
+    qsort(samples, BENCH_SAMPLES, sizeof samples[0], cmp_double);
+    r.warm_min = samples[0];
+    r.warm_median = samples[BENCH_SAMPLES / 2];
+
+    for (int s = 0; s < cold_reps; s++) {
+        refresh(b, d, n);
+        flush_caches();
+        cold[s] = time_iters(b->run, d, n, 1);
+    }
+    qsort(cold, (size_t)cold_reps, sizeof cold[0], cmp_double);
+    r.cold_min = cold[0];
+    r.cold_median = cold[cold_reps / 2];
+
+    r.latency = -1.0;
+    if (b->chain) {
+        double best = INFINITY;
+        for (int s = 0; s < BENCH_SAMPLES; s++) {
+            double t = time_iters(b->chain, d, n, r.iters) / (double)(r.iters * n);
+            if (t < best) best = t;
+        }
+        r.latency = best;
+    }
+    return r;
+}
+
+/*****************************************************JSON****************************************************/
+
+static size_t dtype_size(const char *dtype)
+{
+    if (strcmp(dtype, "f16") == 0 || strcmp(dtype, "bf16") == 0) return sizeof(half_t);
+    return strcmp(dtype, "f64") == 0 ? sizeof(double) : sizeof(float);
+}
+
+static void json_timing(FILE *out, const char *label, double min_ns, double median_ns,
+                        size_t n, size_t bytes)
+{
+    fprintf(out, "\"%s\": {\"min_ns\": %.1f, \"median_ns\": %.1f, \"gelem_s\": %.4f, \"gb_s\": %.4f}",
+            label, min_ns, median_ns, (double)n / median_ns, (double)bytes / median_ns);
+}
+
+static void json_result(FILE *out, const bench_t *b, size_t n, const bench_result_t *r, bool first)
+{
+    size_t bytes = n * dtype_size(b->dtype) * (size_t)b->streams;
+    double calls = (double)r->warm_calls;
+    fprintf(out, "%s\n    {\"name\": \"%s\", \"variant\": \"%s\", \"dtype\": \"%s\", \"n\": %zu, "
+                 "\"bytes_per_call\": %zu, \"iters\": %zu,\n     ",
+            first ? "" : ",", b->name, b->variant, b->dtype, n, bytes, r->iters);
+    json_timing(out, "warm", r->warm_min, r->warm_median, n, bytes);
+    fprintf(out, ",\n     ");
+    json_timing(out, "cold", r->cold_min, r->cold_median, n, bytes);
+    fprintf(out, ",\n     ");
+    if (r->latency >= 0.0) fprintf(out, "\"latency_ns\": %.3f, ", r->latency);
+    fprintf(out, "\"allocs_per_call\": %.3f, \"frees_per_call\": %.3f, \"alloc_bytes_per_call\": %.1f}",
+            (double)r->counts.allocs / calls, (double)r->counts.frees / calls,
+            (double)r->counts.bytes / calls);
+}
+
+static size_t cache_size(int level)
+{
+    long v = -1;
+#if defined(_SC_LEVEL1_DCACHE_SIZE) && defined(_SC_LEVEL2_CACHE_SIZE) && defined(_SC_LEVEL3_CACHE_SIZE)
+    v = sysconf(level == 1 ? _SC_LEVEL1_DCACHE_SIZE : level == 2 ? _SC_LEVEL2_CACHE_SIZE : _SC_LEVEL3_CACHE_SIZE);
+#else
+    (void)level;
+#endif
+    return v > 0 ? (size_t)v : 0;
+}
+
+/*****************************************************MAIN****************************************************/
+
+static bool alloc_data(bench_data_t *d, size_t cap)
+{
+    memset(d, 0, sizeof *d);
+    d->cap = cap;
+    d->tier = FAST_MATH_POLY;
+    d->fa = malloc(cap * sizeof(float));
+    d->fb = malloc(cap * sizeof(float));
+    d->fc = malloc(cap * sizeof(float));
+    d->fpristine = malloc(cap * sizeof(float));
+    d->da = malloc(cap * sizeof(double));
+    d->db = malloc(cap * sizeof(double));
+    d->dc = malloc(cap * sizeof(double));
+    d->ia = malloc(cap * sizeof(int));
+    d->ha = malloc(cap * sizeof(half_t));
+    d->hb = malloc(cap * sizeof(half_t));
+    d->ba = malloc(cap * sizeof(bf16_t));
+    d->bb = malloc(cap * sizeof(bf16_t));
+    if (!d->fa || !d->fb || !d->fc || !d->fpristine || !d->da || !d->db || !d->dc || !d->ia) return false;
+    if (!d->ha || !d->hb || !d->ba || !d->bb) return false;
+
+    for (size_t i = 0; i < cap; i++) {
+        float a = 0.5f + (float)(i * 2654435761u % 1000u) / 1000.0f;  // [0.5, 1.5)
+        d->fa[i] = d->fpristine[i] = a;
+        d->fb[i] = (i & 1) ? 1.0f + 0x1p-20f : 1.0f - 0x1p-20f;      // products stay bounded
+        d->fc[i] = 0.0f;
+        d->da[i] = a;
+        d->db[i] = d->fb[i];
+        d->dc[i] = 0.0;
+        d->ia[i] = (int)i;
+        d->ha[i] = half_from_float(a);
+        d->hb[i] = half_from_float(d->fb[i]);
+        d->ba[i] = bf16_from_float(a);
+        d->bb[i] = bf16_from_float(d->fb[i]);
+    }
+    d->va = (vector_t){ .data = d->fa };
+    d->vb = (vector_t){ .data = d->fb };
+    d->dva = (dvector_t){ .data = d->da };
+    d->dvb = (dvector_t){ .data = d->db };
+    d->hva = (hvector_t){ .data = d->ha };
+    d->hvb = (hvector_t){ .data = d->hb };
+    d->bva = (bvector_t){ .data = d->ba };
+    d->bvb = (bvector_t){ .data = d->bb };
+    return true;
+}
+
+static void free_data(bench_data_t *d)
+{
+    free(d->fa); free(d->fb); free(d->fc); free(d->fpristine);
+    free(d->da); free(d->db); free(d->dc); free(d->ia);
+    free(d->ha); free(d->hb); free(d->ba); free(d->bb);
+}
+
+int main(int argc, char **argv)
+{
+    const char *json_path = NULL, *filter = NULL;
+    size_t max_elems = 0, math_max = 1u << 20;
+    int cold_reps = 3;
+    int threads = -1;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_arg = i + 1 < argc;
+        if (strcmp(argv[i], "--json") == 0 && has_arg) json_path = argv[++i];
+        else if (strcmp(argv[i], "--filter") == 0 && has_arg) filter = argv[++i];
+        else if (strcmp(argv[i], "--max-elems") == 0 && has_arg) max_elems = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--math-max") == 0 && has_arg) math_max = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--cold-reps") == 0 && has_arg) cold_reps = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && has_arg) threads = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "usage: %s [--json FILE] [--filter SUBSTR] [--max-elems N] "
+                            "[--math-max N] [--cold-reps N] [--threads N]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (threads >= 0 && !vec_parallel_init((unsigned int)threads)) {
+        fprintf(stderr, "vec_bench: could not start %d threads\n", threads);
+        return 1;
+    }
+    if (cold_reps < 1) cold_reps = 1;
+    if (cold_reps > 64) cold_reps = 64;
+
+    size_t l1 = cache_size(1), l2 = cache_size(2), llc = cache_size(3);
+    if (llc == 0) llc = l2 ? l2 : BENCH_DEFAULT_LLC;
+    if (max_elems == 0) {
+        max_elems = BENCH_MIN_ELEMS;
+        while (max_elems * sizeof(float) <= 2 * llc) max_elems *= 4;
+    }
+    if (max_elems < BENCH_MIN_ELEMS) max_elems = BENCH_MIN_ELEMS;
+    if (math_max == 0 || math_max > max_elems) math_max = max_elems;
+
+    bench_data_t data;
+    flush_bytes = 2 * llc;
+    flush_buf = calloc(flush_bytes, 1);
+    if (!flush_buf || !alloc_data(&data, max_elems)) {
+        fprintf(stderr, "vec_bench: out of memory for %zu elements\n", max_elems);
+        return 1;
+    }
+
+    FILE *out = json_path ? fopen(json_path, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "vec_bench: cannot open %s\n", json_path);
+        return 1;
+    }
+
+    alloc_counts_t counts = { 0, 0, 0 };
+    vec_allocator_t counting = { counting_alloc, counting_free, &counts };
+
+    fprintf(out, "{\n  \"schema\": 1,\n  \"isa\": \"%s\",\n  \"threads\": %u,\n"
+                 "  \"cache_bytes\": {\"l1d\": %zu, \"l2\": %zu, \"llc\": %zu},\n"
+                 "  \"samples\": %d, \"cold_reps\": %d, \"max_elems\": %zu, \"math_max_elems\": %zu,\n"
+                 "  \"results\": [",
+            vec_isa_name(vec_isa_active()), vec_parallel_threads(), l1, l2, llc, BENCH_SAMPLES, cold_reps, max_elems, math_max);
+
+    bool first = true;
+    VEC_ALLOCATOR_SCOPE(&counting) {
+        for (size_t k = 0; k < sizeof benches / sizeof benches[0]; k++) {
+            const bench_t *b = &benches[k];
+            if (filter && !strstr(b->name, filter)) continue;
+            size_t limit = b->kind == BENCH_MATH ? math_max : max_elems;
+            for (size_t n = BENCH_MIN_ELEMS; n <= limit; n *= 4) {
+                size_t size = b->kind == BENCH_FIXED3 ? 3 : n;
+                fprintf(stderr, "%-28s %-8s n=%zu\n", b->name, b->variant, size);
+                bench_result_t r = measure(b, &data, size, cold_reps, &counts);
+                json_result(out, b, size, &r, first);
+                first = false;
+                if (b->kind == BENCH_FIXED3) break;
+            }
+        }
+    }
+
+    fprintf(out, "\n  ],\n  \"sink\": %g\n}\n", (double)data.fsink + data.dsink);
+    if (json_path) fclose(out);
+    free_data(&data);
+    free(flush_buf);
+    vec_parallel_shutdown();
+    return 0;
+}